@@ -0,0 +1,29 @@
+# Fails unless the static data (.data and .bss) of every object file is below
+# LIMIT bytes together.
+#   cmake -DSIZE=<size tool> -DOBJECTS=<file;...> -DLIMIT=<bytes>
+#         -P check_footprint.cmake
+foreach(variable SIZE OBJECTS LIMIT)
+  if(NOT DEFINED ${variable})
+    message(FATAL_ERROR "check_footprint.cmake: ${variable} is not set")
+  endif()
+endforeach()
+
+set(total 0)
+foreach(object ${OBJECTS})
+  execute_process(COMMAND ${SIZE} -A ${object}
+      OUTPUT_VARIABLE sections
+      RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${SIZE} -A ${object} exited with ${result}")
+  endif()
+  string(REGEX MATCHALL "\n\\.(data|bss)[ \t]+[0-9]+" lines "${sections}")
+  foreach(line ${lines})
+    string(REGEX REPLACE ".*[ \t]" "" bytes "${line}")
+    math(EXPR total "${total} + ${bytes}")
+  endforeach()
+endforeach()
+
+if(NOT total LESS LIMIT)
+  message(FATAL_ERROR "${total} bytes of static data, the limit is ${LIMIT}")
+endif()
+message(STATUS "${total} bytes of static data, below ${LIMIT}")
@@ -0,0 +1,33 @@
+# Runs zlcd_test_band and zlcd_test_band_frameless with the same arguments and
+# fails unless both pass and print the same panel RAM digests, so the band
+# renderer gives the same LCD with and without the frame compiled in.
+#   cmake -DTEST=<path> -DTEST_FRAMELESS=<path> -DARGS=<argument;...>
+#         -P compare_band.cmake
+foreach(variable TEST TEST_FRAMELESS ARGS)
+  if(NOT DEFINED ${variable})
+    message(FATAL_ERROR "compare_band.cmake: ${variable} is not set")
+  endif()
+endforeach()
+
+foreach(build full frameless)
+  if(build STREQUAL "full")
+    set(program ${TEST})
+  else()
+    set(program ${TEST_FRAMELESS})
+  endif()
+  execute_process(COMMAND ${program} ${ARGS}
+      OUTPUT_VARIABLE ${build}_output
+      RESULT_VARIABLE ${build}_result)
+  if(NOT ${build}_result EQUAL 0)
+    message(FATAL_ERROR "${program} exited with ${${build}_result}:\n"
+        "${${build}_output}")
+  endif()
+endforeach()
+
+if(NOT full_output STREQUAL frameless_output)
+  message(FATAL_ERROR "the digests differ\nzlcd_test_band:\n${full_output}\n"
+      "zlcd_test_band_frameless:\n${frameless_output}")
+endif()
+string(REGEX MATCHALL "ram_hash" scenes "${full_output}")
+list(LENGTH scenes count)
+message(STATUS "${count} scenes match")
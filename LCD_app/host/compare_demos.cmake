@@ -0,0 +1,51 @@
+# Runs zlcd_host_demo and zlcd_host_demo_native over the same workload and
+# fails unless both print the same table (wire_hash and ram_hash included)
+# and write the same PPM files.
+#   cmake -DDEMO=<path> -DDEMO_NATIVE=<path> -DOUTPUT=<directory>
+#         -DARGS=<mode;...> -P compare_demos.cmake
+foreach(variable DEMO DEMO_NATIVE OUTPUT ARGS)
+  if(NOT DEFINED ${variable})
+    message(FATAL_ERROR "compare_demos.cmake: ${variable} is not set")
+  endif()
+endforeach()
+
+list(POP_FRONT ARGS mode)
+foreach(build demo native)
+  set(directory ${OUTPUT}/${build})
+  file(REMOVE_RECURSE ${directory})
+  file(MAKE_DIRECTORY ${directory})
+  if(build STREQUAL "demo")
+    set(program ${DEMO})
+  else()
+    set(program ${DEMO_NATIVE})
+  endif()
+  execute_process(COMMAND ${program} ${mode} ${directory} ${ARGS}
+      OUTPUT_VARIABLE ${build}_output
+      RESULT_VARIABLE ${build}_result)
+  if(NOT ${build}_result EQUAL 0)
+    message(FATAL_ERROR "${program} exited with ${${build}_result}:\n"
+        "${${build}_output}")
+  endif()
+endforeach()
+
+if(NOT demo_output STREQUAL native_output)
+  message(FATAL_ERROR "the tables differ\nzlcd_host_demo:\n${demo_output}\n"
+      "zlcd_host_demo_native:\n${native_output}")
+endif()
+
+file(GLOB frames RELATIVE ${OUTPUT}/demo ${OUTPUT}/demo/*.ppm)
+if(NOT frames)
+  message(FATAL_ERROR "no PPM files in ${OUTPUT}/demo")
+endif()
+foreach(frame ${frames})
+  file(SHA256 ${OUTPUT}/demo/${frame} demo_digest)
+  if(NOT EXISTS ${OUTPUT}/native/${frame})
+    message(FATAL_ERROR "${frame} is missing from the native run")
+  endif()
+  file(SHA256 ${OUTPUT}/native/${frame} native_digest)
+  if(NOT demo_digest STREQUAL native_digest)
+    message(FATAL_ERROR "${frame} differs between the builds")
+  endif()
+endforeach()
+list(LENGTH frames count)
+message(STATUS "${count} steps match")
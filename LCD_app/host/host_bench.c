@@ -0,0 +1,148 @@
+#include "fonts.h"           // lvgl compatible fonts here
+#include "images.h"          // lvgl compatible images here
+#include "zynq_lcd_bench.h"  // benchmark matrix
+#include "zynq_lcd_st7789.h" // custom driver
+
+#include "mock_bsp.h"
+#include "st7789_emulator.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*************************************************
+  host benchmark: the matrix from zynq_lcd_bench.c
+  against the emulated panel
+**************************************************/
+
+static st7789_emu panel;
+
+static void hook_gpio_write(void *context, u32 value) {
+  st7789_emu_gpio(context, value);
+}
+
+static void hook_spi_begin(void *context) { st7789_emu_spi_begin(context); }
+
+static void hook_spi_write(void *context, const u8 *bytes, u32 num_bytes) {
+  st7789_emu_spi_write(context, bytes, num_bytes);
+}
+
+static void hook_spi_end(void *context) { st7789_emu_spi_end(context); }
+
+// host time includes decoding every byte in the emulator
+static uint64_t read_nanoseconds(void *context) {
+  (void)context;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static bool read_bus_counters(void *context, uint64_t *bytes,
+                              uint64_t *commands) {
+  const st7789_emu_stats *stats = &((const st7789_emu *)context)->stats;
+  *bytes = stats->commands + stats->parameter_bytes + stats->pixel_bytes;
+  *commands = stats->commands;
+  return true;
+}
+
+static int usage(const char *program) {
+  printf("usage: %s [polled|dma|fifo|async] [iterations] [software|madctl] "
+         "[rgb565|rgb444|rgb444_dither] [copy|double|triple|hashed]\n",
+         program);
+  return 2;
+}
+
+int main(int argc, char **argv) {
+  ZLCD_config config = ZLCD_create_config(ZLCD_PORTRAIT_ORIENTATION, BLACK);
+  uint32_t iterations = 21;
+  if (argc > 1) {
+    if (strcmp(argv[1], "polled") == 0) {
+      config.transmit_mode = ZLCD_TRANSMIT_POLLED;
+    } else if (strcmp(argv[1], "dma") == 0) {
+      config.transmit_mode = ZLCD_TRANSMIT_DMA;
+    } else if (strcmp(argv[1], "fifo") == 0) {
+      config.transmit_mode = ZLCD_TRANSMIT_FIFO;
+    } else if (strcmp(argv[1], "async") == 0) {
+      config.async_refresh = true;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (argc > 2) {
+    iterations = (uint32_t)strtoul(argv[2], NULL, 10);
+  }
+  if (argc > 3) {
+    if (strcmp(argv[3], "software") == 0) {
+      config.rotation_mode = ZLCD_ROTATE_SOFTWARE;
+    } else if (strcmp(argv[3], "madctl") == 0) {
+      config.rotation_mode = ZLCD_ROTATE_MADCTL;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (argc > 4) {
+    if (strcmp(argv[4], "rgb565") == 0) {
+      config.pixel_format = ZLCD_PIXEL_RGB565;
+    } else if (strcmp(argv[4], "rgb444") == 0) {
+      config.pixel_format = ZLCD_PIXEL_RGB444;
+    } else if (strcmp(argv[4], "rgb444_dither") == 0) {
+      config.pixel_format = ZLCD_PIXEL_RGB444_DITHERED;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (argc > 5) {
+    if (strcmp(argv[5], "copy") == 0) {
+      config.buffer_mode = ZLCD_BUFFER_COPY;
+    } else if (strcmp(argv[5], "double") == 0) {
+      config.buffer_mode = ZLCD_BUFFER_DOUBLE;
+    } else if (strcmp(argv[5], "triple") == 0) {
+      config.buffer_mode = ZLCD_BUFFER_TRIPLE;
+    } else if (strcmp(argv[5], "hashed") == 0) {
+      config.buffer_mode = ZLCD_BUFFER_HASHED;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (argc > 6) {
+    return usage(argv[0]);
+  }
+
+  st7789_emu_init(&panel);
+  mock_bsp_hooks hooks = {.gpio_write = hook_gpio_write,
+                          .spi_begin = hook_spi_begin,
+                          .spi_write = hook_spi_write,
+                          .spi_end = hook_spi_end,
+                          .context = &panel};
+  mock_bsp_set_hooks(&hooks);
+  if (ZLCD_init_with_config(&config) != ZLCD_SUCCESS) {
+    printf("ZLCD init failed\n");
+    return 1;
+  }
+
+  static const ZLCD_bench_font fonts[] = {
+      {"simple_font_8", &simple_font_8},
+      {"simple_font_12", &simple_font_12},
+      {"old_london_20", &old_london_20},
+      {"kiwi_soda_25", &kiwi_soda_25},
+      {"printf_font", &printf_font},
+  };
+  ZLCD_image image_1 = lvgl_image_to_ZLCD(&img_1, 0, 0);
+  ZLCD_image image_2 = lvgl_image_to_ZLCD(&img_2, 0, 0);
+  ZLCD_image image_3 = lvgl_image_to_ZLCD(&shrek_grin, 0, 0);
+  const ZLCD_bench_image images[] = {
+      {"img_1", &image_1}, {"img_2", &image_2}, {"shrek_grin", &image_3}};
+
+  ZLCD_bench_config bench = {.read_cycles = read_nanoseconds,
+                             .cycle_unit = "host_ns",
+                             .read_bus_counters = read_bus_counters,
+                             .context = &panel,
+                             .fonts = fonts,
+                             .num_fonts = sizeof(fonts) / sizeof(fonts[0]),
+                             .images = images,
+                             .num_images = sizeof(images) / sizeof(images[0]),
+                             .iterations = iterations};
+  return ZLCD_bench_run(&bench) == ZLCD_SUCCESS ? 0 : 1;
+}
@@ -0,0 +1,433 @@
+#include "fonts.h"           // lvgl compatible fonts here
+#include "images.h"          // lvgl compatible images here
+#include "zynq_lcd_amp.h"
+#include "zynq_lcd_band.h"
+#include "zynq_lcd_indexed.h"
+#include "zynq_lcd_layer.h"
+#include "zynq_lcd_st7789.h" // custom driver
+#include "zynq_lcd_transport.h"
+
+#include "mock_bsp.h"
+#include "st7789_emulator.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*************************************************
+  host demo: runs the driver against the emulated
+  panel and reports the bytes on the wire
+**************************************************/
+
+static st7789_emu panel;
+static ZLCD_config config;
+static const char *output_directory = ".";
+static unsigned frame_number;
+// steps that printed a WARNING or could not be dumped, the exit status
+static unsigned failed_steps;
+
+static void hook_gpio_write(void *context, u32 value) {
+  st7789_emu_gpio(context, value);
+}
+
+static void hook_spi_begin(void *context) { st7789_emu_spi_begin(context); }
+
+static void hook_spi_write(void *context, const u8 *bytes, u32 num_bytes) {
+  st7789_emu_spi_write(context, bytes, num_bytes);
+}
+
+static void hook_spi_end(void *context) { st7789_emu_spi_end(context); }
+
+/*
+"sim": the driver talks to the emulator through its own transport instead of
+the mocked BSP, wrapped in a capture transport that has to count the same
+*/
+static uint32_t sim_gpio_values;
+static ZLCD_capture capture;
+
+static ZLCD_RETURN_STATUS sim_init(void *context) {
+  sim_gpio_values = 0;
+  st7789_emu_gpio(context, sim_gpio_values);
+  return ZLCD_SUCCESS;
+}
+
+static void sim_begin(void *context) { st7789_emu_spi_begin(context); }
+
+static void sim_write(void *context, const uint8_t *bytes, size_t num_bytes) {
+  st7789_emu_spi_write(context, bytes, num_bytes);
+}
+
+static void sim_end(void *context) { st7789_emu_spi_end(context); }
+
+static void sim_set_pin(void *context, ZLCD_PIN pin, bool level) {
+  uint32_t bit =
+      pin == ZLCD_PIN_DC ? ST7789_EMU_GPIO_DC : ST7789_EMU_GPIO_RESET;
+  if (level) {
+    sim_gpio_values |= 1U << bit;
+  } else {
+    sim_gpio_values &= ~(1U << bit);
+  }
+  st7789_emu_gpio(context, sim_gpio_values);
+}
+
+// counted by the mock like every other wait, so the demos print the same
+static void sim_delay_ms(void *context, uint32_t milliseconds) {
+  (void)context;
+  msleep(milliseconds);
+}
+
+static const ZLCD_transport sim_transport = {
+    sim_init, sim_begin, sim_write, sim_end, sim_set_pin, sim_delay_ms, &panel};
+
+/*
+"amp": a second thread plays CPU1 and pumps the queue through the built in FIFO
+transport, the driver on the main thread never touches the mocked hardware
+*/
+static ZLCD_amp_queue amp_queue;
+static pthread_t cpu1_thread;
+static atomic_bool cpu1_stop;
+
+static void *cpu1_main(void *argument) {
+  (void)argument;
+  const ZLCD_transport *transport =
+      ZLCD_get_builtin_transport(ZLCD_TRANSMIT_FIFO);
+  if (ZLCD_amp_pump_start(&amp_queue, transport) != ZLCD_SUCCESS) {
+    return NULL;
+  }
+  while (!atomic_load(&cpu1_stop)) {
+    if (!ZLCD_amp_pump_once(&amp_queue, transport)) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+// CPU0's part of the boot order in zynq_lcd_amp.h
+static bool start_cpu1(void) {
+  ZLCD_amp_queue_init(&amp_queue);
+  if (pthread_create(&cpu1_thread, NULL, cpu1_main, NULL) != 0) {
+    return false;
+  }
+  // wait here, the driver's own wait would show up in the msleep total
+  while (!atomic_load(&amp_queue.ready)) {
+    sched_yield();
+  }
+  return true;
+}
+
+// sends whatever was drawn with update_now == false the configured way
+static ZLCD_RETURN_STATUS host_refresh(void) {
+  if (!config.async_refresh) {
+    return ZLCD_refresh_display();
+  }
+  ZLCD_RETURN_STATUS status = ZLCD_refresh_display_async(NULL, NULL);
+  if (status != ZLCD_SUCCESS) {
+    return status;
+  }
+  return ZLCD_wait_refresh();
+}
+
+static void print_stats_header(void) {
+  printf("%-28s %9s %9s %9s %9s %9s %9s %10s %10s\n", "operation",
+         "transfers", "dc_toggle", "commands", "params", "pixels_B", "total_B",
+         "wire_hash", "ram_hash");
+}
+
+/*
+Prints what name cost on the wire since the last call and dumps the panel to
+<output_directory>/NN_name.ppm.
+*/
+static void report(const char *name) {
+  if (config.async_refresh) {
+    ZLCD_wait_refresh();
+  }
+  bool failed = false;
+  const st7789_emu_stats *stats = &panel.stats;
+  uint64_t total =
+      stats->commands + stats->parameter_bytes + stats->pixel_bytes;
+  printf("%-28s %9llu %9llu %9llu %9llu %9llu %9llu 0x%08x 0x%08x\n", name,
+         (unsigned long long)stats->transfers,
+         (unsigned long long)stats->dc_toggles,
+         (unsigned long long)stats->commands,
+         (unsigned long long)stats->parameter_bytes,
+         (unsigned long long)stats->pixel_bytes, (unsigned long long)total,
+         (unsigned)stats->wire_hash, (unsigned)st7789_emu_ram_hash(&panel));
+#if ZLCD_STATS_ENABLED
+  // the driver's own counters have to agree with what the panel saw
+  ZLCD_stats driver;
+  bool counted = ZLCD_get_stats(&driver) == ZLCD_SUCCESS;
+  if (counted &&
+      (driver.spi_bytes != total || driver.command_bytes != stats->commands ||
+       driver.dc_toggles != stats->dc_toggles)) {
+    printf("  WARNING: driver counted %llu bytes, %llu commands and %llu DC "
+           "toggles\n",
+           (unsigned long long)driver.spi_bytes,
+           (unsigned long long)driver.command_bytes,
+           (unsigned long long)driver.dc_toggles);
+    failed = true;
+  }
+  // the "ZLCD:" lines the verify mode printed for this step
+  if (counted && driver.verify_misses != 0) {
+    printf("  WARNING: %u changes were not marked dirty\n",
+           (unsigned)driver.verify_misses);
+    failed = true;
+  }
+#endif
+  if (config.transport != NULL) {
+    const ZLCD_capture_stats *captured = &capture.stats;
+    if (captured->frames != stats->transfers ||
+        captured->command_bytes != stats->commands ||
+        captured->data_bytes != total - stats->commands ||
+        captured->dc_toggles != stats->dc_toggles) {
+      printf("  WARNING: capture counted %llu frames, %llu command bytes, %llu "
+             "data bytes and %llu DC toggles\n",
+             (unsigned long long)captured->frames,
+             (unsigned long long)captured->command_bytes,
+             (unsigned long long)captured->data_bytes,
+             (unsigned long long)captured->dc_toggles);
+      failed = true;
+    }
+    ZLCD_capture_reset_stats(&capture);
+  }
+  if (stats->unknown_commands != 0 || stats->ignored_bytes != 0) {
+    printf("  WARNING: %llu unknown commands, %llu ignored bytes\n",
+           (unsigned long long)stats->unknown_commands,
+           (unsigned long long)stats->ignored_bytes);
+    failed = true;
+  }
+
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%02u_%s.ppm", output_directory,
+           frame_number++, name);
+  if (!st7789_emu_write_ppm(&panel, path, true)) {
+    printf("  failed to write %s\n", path);
+    failed = true;
+  }
+  failed_steps += failed;
+  st7789_emu_reset_stats(&panel);
+#if ZLCD_STATS_ENABLED
+  ZLCD_reset_stats();
+#endif
+}
+
+static int usage(const char *program) {
+  printf("usage: %s [polled|dma|fifo|async|dma_async|sim|amp] "
+         "[output directory] [software|madctl] [rgb565|rgb444|rgb444_dither] "
+         "[copy|double|triple|hashed]\n",
+         program);
+  return 2;
+}
+
+int main(int argc, char **argv) {
+  config = ZLCD_create_config(ZLCD_PORTRAIT_ORIENTATION, BLACK);
+  if (argc > 1) {
+    if (strcmp(argv[1], "polled") == 0) {
+      config.transmit_mode = ZLCD_TRANSMIT_POLLED;
+    } else if (strcmp(argv[1], "dma") == 0) {
+      config.transmit_mode = ZLCD_TRANSMIT_DMA;
+    } else if (strcmp(argv[1], "fifo") == 0) {
+      config.transmit_mode = ZLCD_TRANSMIT_FIFO;
+    } else if (strcmp(argv[1], "async") == 0) {
+      config.async_refresh = true;
+    } else if (strcmp(argv[1], "dma_async") == 0) {
+      config.transmit_mode = ZLCD_TRANSMIT_DMA;
+      config.async_refresh = true;
+    } else if (strcmp(argv[1], "sim") == 0) {
+      ZLCD_capture_init(&capture, &sim_transport);
+      config.transport = &capture.transport;
+    } else if (strcmp(argv[1], "amp") == 0) {
+      config.amp_queue = &amp_queue;
+      config.async_refresh = true;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (argc > 2) {
+    output_directory = argv[2];
+  }
+  if (argc > 3) {
+    if (strcmp(argv[3], "software") == 0) {
+      config.rotation_mode = ZLCD_ROTATE_SOFTWARE;
+    } else if (strcmp(argv[3], "madctl") == 0) {
+      config.rotation_mode = ZLCD_ROTATE_MADCTL;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (argc > 4) {
+    if (strcmp(argv[4], "rgb565") == 0) {
+      config.pixel_format = ZLCD_PIXEL_RGB565;
+    } else if (strcmp(argv[4], "rgb444") == 0) {
+      config.pixel_format = ZLCD_PIXEL_RGB444;
+    } else if (strcmp(argv[4], "rgb444_dither") == 0) {
+      config.pixel_format = ZLCD_PIXEL_RGB444_DITHERED;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (argc > 5) {
+    if (strcmp(argv[5], "copy") == 0) {
+      config.buffer_mode = ZLCD_BUFFER_COPY;
+    } else if (strcmp(argv[5], "double") == 0) {
+      config.buffer_mode = ZLCD_BUFFER_DOUBLE;
+    } else if (strcmp(argv[5], "triple") == 0) {
+      config.buffer_mode = ZLCD_BUFFER_TRIPLE;
+    } else if (strcmp(argv[5], "hashed") == 0) {
+      config.buffer_mode = ZLCD_BUFFER_HASHED;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (argc > 6) {
+    return usage(argv[0]);
+  }
+
+  st7789_emu_init(&panel);
+  mock_bsp_hooks hooks = {.gpio_write = hook_gpio_write,
+                          .spi_begin = hook_spi_begin,
+                          .spi_write = hook_spi_write,
+                          .spi_end = hook_spi_end,
+                          .context = &panel};
+  mock_bsp_set_hooks(&hooks);
+
+  if (config.amp_queue != NULL && !start_cpu1()) {
+    printf("failed to start the CPU1 thread\n");
+    return 1;
+  }
+  print_stats_header();
+  if (ZLCD_init_with_config(&config) != ZLCD_SUCCESS) {
+    printf("ZLCD init failed\n");
+    return 1;
+  }
+  report("init");
+  // every refresh also looks for changes the drawing functions did not mark
+  ZLCD_set_refresh_mode(ZLCD_REFRESH_VERIFY);
+
+  ZLCD_draw_filled_rectangle(ZLCD_create_coordinate(0, 0), 172, 320, 6, RED,
+                             BLUE, false);
+  host_refresh();
+  report("full_screen_rectangle");
+
+  ZLCD_set_pixel_xy(20, 20, WHITE, false);
+  host_refresh();
+  report("single_pixel");
+
+  ZLCD_print_string_xy("ZLCD on the host", 10, 40, WHITE, &simple_font_12,
+                       false);
+  host_refresh();
+  report("string");
+
+  ZLCD_draw_filled_circle_xy(86, 200, 40, WHITE, YELLOW, false);
+  host_refresh();
+  report("filled_circle");
+
+  ZLCD_image image = lvgl_image_to_ZLCD(&img_1, 0, 0);
+  ZLCD_draw_image(ZLCD_create_coordinate(0, 0), &image, false);
+  host_refresh();
+  report("image");
+
+  host_refresh();
+  report("unchanged_refresh");
+
+  // marked again, but nothing differs from what the LCD shows
+  ZLCD_draw_image(ZLCD_create_coordinate(0, 0), &image, false);
+  host_refresh();
+  report("redrawn_image");
+
+  ZLCD_set_orientation(ZLCD_INVERTED_LANDSCAPE_ORIENTATION);
+  ZLCD_clear();
+  ZLCD_print_wrapped_string_on_background_xy(
+      "Hello from the ST7789 emulator", 10, 30, 0, 30, WHITE, NAVY_GREEN,
+      &kiwi_soda_25, false);
+  host_refresh();
+  report("landscape_text");
+
+  // image and line paths in the rotated orientations
+  ZLCD_set_orientation(ZLCD_LANDSCAPE_ORIENTATION);
+  ZLCD_draw_image(ZLCD_create_coordinate(40, 20), &image, false);
+  host_refresh();
+  report("landscape_image");
+
+  ZLCD_set_orientation(ZLCD_INVERTED_PORTRAIT_ORIENTATION);
+  ZLCD_draw_unfilled_rectangle_xy(5, 5, 150, 100, 3, ORANGE, false);
+  ZLCD_draw_line_xy(0, 300, 171, 120, CYAN, false);
+  host_refresh();
+  report("inverted_portrait_lines");
+
+  // the scroll area moves up 16 rows, only the rows exposed at its bottom go out
+  ZLCD_set_orientation(ZLCD_PORTRAIT_ORIENTATION);
+  ZLCD_scroll_define(20, 20);
+  ZLCD_scroll_to(16);
+  ZLCD_draw_filled_rectangle_xy(0, 284, 172, 16, 1, GREEN, NAVY_GREEN, false);
+  host_refresh();
+  report("hardware_scroll");
+
+  // solid fills with update_now are streamed straight to the LCD
+  ZLCD_set_background_colour(NAVY_GREEN);
+  ZLCD_draw_background();
+  ZLCD_draw_filled_rectangle_xy(10, 40, 120, 60, 2, WHITE, BLUE, true);
+  report("immediate_fill");
+
+  // a display list drawn band by band, the GRAM is left as it is
+  static ZLCD_band_item band_items[4];
+  ZLCD_display_list list;
+  ZLCD_display_list_init(&list, band_items, 4, NAVY_GREEN);
+  for (uint16_t i = 0; i < 2; i++) {
+    ZLCD_display_list_clear(&list, NAVY_GREEN);
+    ZLCD_band_rectangle(&list, 10, 40, 120, 60, 2, WHITE, true, BLUE);
+    ZLCD_band_string(&list, "ZLCD bands", 10, 130, WHITE, &simple_font_12);
+    ZLCD_band_circle(&list, 86, 200 + i * 40, 40, WHITE, true, YELLOW);
+    ZLCD_band_image(&list, 0, 290, &image);
+    ZLCD_band_render(&list, NULL);
+    // the second time only the bands the circle moved through go out
+    report(i == 0 ? "band_frame" : "band_moved_circle");
+  }
+
+  // the same drawn one byte per pixel, then the blue entry turned red
+  const rgb565 colours[4] = {NAVY_GREEN, WHITE, BLUE, YELLOW};
+  ZLCD_indexed_load_palette(0, colours, 4, false);
+  ZLCD_indexed_begin(0);
+  ZLCD_indexed_rectangle(10, 40, 120, 60, 2, 1, true, 2);
+  ZLCD_indexed_string("ZLCD indexed", 10, 130, 1, &simple_font_12);
+  ZLCD_indexed_circle(86, 240, 40, 1, true, 3);
+  ZLCD_indexed_present(NULL);
+  report("indexed_frame");
+  // only the rows of the blue fill go out again
+  ZLCD_indexed_set_palette(2, RED, true);
+  ZLCD_indexed_present(NULL);
+  report("indexed_palette");
+
+  // a keyed, half transparent frame composed over the image, then moved
+  static rgb565 hud[48 * 32];
+  for (uint16_t i = 0; i < 48 * 32; i++) {
+    uint16_t x = i % 48, y = i / 48;
+    hud[i] = (x < 4 || x >= 44 || y < 4 || y >= 28) ? WHITE : MAGENTA;
+  }
+  const ZLCD_surface background = {(const rgb565 *)image.map, image.width,
+                                    image.height, image.width};
+  const ZLCD_surface frame = {hud, 48, 32, 48};
+  ZLCD_layer_attach(0, &background, 0, 0);
+  ZLCD_layer_attach(1, &frame, 20, 20);
+  ZLCD_layer_set_key(1, true, MAGENTA);
+  ZLCD_layer_set_alpha(1, 192);
+  ZLCD_layer_compose(NULL, true);
+  report("layer_compose");
+  // only where the frame was and is now is composed and sent
+  ZLCD_layer_move(1, 60, 100);
+  ZLCD_layer_compose(NULL, true);
+  report("layer_moved");
+
+  printf("msleep total: %lu ms\n", mock_bsp_slept_ms());
+  if (config.amp_queue != NULL) {
+    atomic_store(&cpu1_stop, true);
+    pthread_join(cpu1_thread, NULL);
+  }
+  if (failed_steps != 0) {
+    printf("%u steps failed\n", failed_steps);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,256 @@
+#include "zynq_lcd_st7789.h" // custom driver
+#include "zynq_lcd_vsync.h"
+
+#include "mock_bsp.h"
+#include "st7789_emulator.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xiltimer.h>
+
+/*************************************************
+  host vsync check: refreshes against a panel that
+  scans in (virtual) time, counts the torn ones
+**************************************************/
+
+/*
+The emulated clock only moves with the bytes on the bus, with every look at
+the time (a poll of the spinning driver) and with the rendering simulated
+between refreshes, so every run gives the same counts. 50 MHz SPI and the
+driver's porch and frame rate settings (24 porch lines, about 59 Hz).
+*/
+#define VSYNC_BYTE_NS 160U
+#define VSYNC_LINE_NS 49000U
+#define VSYNC_BLANK_LINES 24U
+#define VSYNC_POLL_NS 100U
+
+static st7789_emu panel;
+static ZLCD_VSYNC_MODE vsync_mode = ZLCD_VSYNC_OFF;
+// the irq thread sends async refreshes while the main thread looks at the time
+static pthread_mutex_t panel_lock;
+// next frame whose TE edge has not been handed to ZLCD_vsync_te_edge() yet
+static uint64_t next_edge_frame;
+// time ZLCD_vsync_te_edge() sees while it is being called
+static _Thread_local bool in_edge;
+static _Thread_local uint64_t edge_ns;
+
+static void hook_gpio_write(void *context, u32 value) {
+  pthread_mutex_lock(&panel_lock);
+  st7789_emu_gpio(context, value);
+  pthread_mutex_unlock(&panel_lock);
+}
+
+static u32 hook_gpio2_read(void *context) {
+  pthread_mutex_lock(&panel_lock);
+  bool te = st7789_emu_te(context);
+  pthread_mutex_unlock(&panel_lock);
+  return te ? 1U << ZLCD_TE_GPIO_BIT : 0U;
+}
+
+static void hook_spi_begin(void *context) {
+  pthread_mutex_lock(&panel_lock);
+  st7789_emu_spi_begin(context);
+  pthread_mutex_unlock(&panel_lock);
+}
+
+static void hook_spi_write(void *context, const u8 *bytes, u32 num_bytes) {
+  pthread_mutex_lock(&panel_lock);
+  st7789_emu_spi_write(context, bytes, num_bytes);
+  pthread_mutex_unlock(&panel_lock);
+}
+
+static void hook_spi_end(void *context) {
+  pthread_mutex_lock(&panel_lock);
+  st7789_emu_spi_end(context);
+  pthread_mutex_unlock(&panel_lock);
+}
+
+static u64 ns_to_ticks(uint64_t nanoseconds) {
+  return nanoseconds / 1000000000U * COUNTS_PER_SECOND +
+         nanoseconds % 1000000000U * COUNTS_PER_SECOND / 1000000000U;
+}
+
+/*
+ZLCD_VSYNC_TE_EDGES: the TE interrupt, raised late for the edges that went by
+while nobody looked at the time (during a transfer). The handler sees the time
+of its edge, as an interrupt taken right away would.
+*/
+static void deliver_te_edges(st7789_emu *emu) {
+  uint64_t frame_ns =
+      (uint64_t)(VSYNC_BLANK_LINES + ST7789_EMU_RAM_HEIGHT) * VSYNC_LINE_NS;
+  for (;;) {
+    pthread_mutex_lock(&panel_lock);
+    uint64_t frame = st7789_emu_frame(emu);
+    bool te_on = emu->te_on;
+    uint64_t edge = next_edge_frame;
+    if (edge <= frame) {
+      next_edge_frame = frame + 1U;
+    }
+    pthread_mutex_unlock(&panel_lock);
+    if (edge > frame) {
+      return;
+    }
+    if (te_on) {
+      // edges missed before the last one are only counted by the driver
+      in_edge = true;
+      edge_ns = frame * frame_ns;
+      ZLCD_vsync_te_edge();
+      in_edge = false;
+    }
+  }
+}
+
+static u64 hook_time(void *context) {
+  if (in_edge) {
+    return ns_to_ticks(edge_ns);
+  }
+  st7789_emu *emu = context;
+  pthread_mutex_lock(&panel_lock);
+  st7789_emu_advance(emu, VSYNC_POLL_NS);
+  uint64_t now = emu->time_ns;
+  pthread_mutex_unlock(&panel_lock);
+  if (vsync_mode == ZLCD_VSYNC_TE_EDGES) {
+    deliver_te_edges(emu);
+  }
+  return ns_to_ticks(now);
+}
+
+static int usage(const char *program) {
+  printf("usage: %s [polled|dma|fifo|async] [off|gpio|edges] [frames]\n",
+         program);
+  return 2;
+}
+
+/*
+one animation frame: a bar sweeping across over the background, every eighth
+frame the whole screen changes colour (a refresh as long as a panel frame)
+*/
+static void render(uint32_t frame) {
+  uint16_t width = 172;
+  uint16_t bar = 24;
+  uint16_t x = (uint16_t)(frame * 7U % (width - bar));
+  if (frame % 8U == 0) {
+    rgb565 background = (frame / 8U) % 2U ? ZLCD_RGB_to_rgb565(0x203040)
+                                           : ZLCD_RGB_to_rgb565(0x402010);
+    ZLCD_draw_filled_rectangle_xy(0, 0, width, 320, 0, background, background,
+                                  false);
+  }
+  ZLCD_draw_filled_rectangle_xy(x, 0, bar, 320, 2,
+                                ZLCD_RGB_to_rgb565(0xFFFFFF),
+                                ZLCD_RGB_to_rgb565(0x30C060), false);
+  // the render itself, 2 to 6 ms, not a multiple of the panel frame
+  pthread_mutex_lock(&panel_lock);
+  st7789_emu_advance(&panel, 2000000U + (uint64_t)(frame * 7919U % 4000U) *
+                                             1000U);
+  pthread_mutex_unlock(&panel_lock);
+}
+
+int main(int argc, char **argv) {
+  ZLCD_config config = ZLCD_create_config(ZLCD_PORTRAIT_ORIENTATION, BLACK);
+  uint32_t frames = 120;
+  if (argc > 1) {
+    if (strcmp(argv[1], "polled") == 0) {
+      config.transmit_mode = ZLCD_TRANSMIT_POLLED;
+    } else if (strcmp(argv[1], "dma") == 0) {
+      config.transmit_mode = ZLCD_TRANSMIT_DMA;
+    } else if (strcmp(argv[1], "fifo") == 0) {
+      config.transmit_mode = ZLCD_TRANSMIT_FIFO;
+    } else if (strcmp(argv[1], "async") == 0) {
+      config.async_refresh = true;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (argc > 2) {
+    if (strcmp(argv[2], "off") == 0) {
+      vsync_mode = ZLCD_VSYNC_OFF;
+    } else if (strcmp(argv[2], "gpio") == 0) {
+      vsync_mode = ZLCD_VSYNC_TE_GPIO;
+    } else if (strcmp(argv[2], "edges") == 0) {
+      vsync_mode = ZLCD_VSYNC_TE_EDGES;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (argc > 3) {
+    frames = (uint32_t)strtoul(argv[3], NULL, 10);
+  }
+  if (argc > 4) {
+    return usage(argv[0]);
+  }
+  config.vsync_mode = vsync_mode;
+
+  pthread_mutexattr_t attributes;
+  pthread_mutexattr_init(&attributes);
+  pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&panel_lock, &attributes);
+  st7789_emu_init(&panel);
+  st7789_emu_timing timing = {.byte_ns = VSYNC_BYTE_NS,
+                              .line_ns = VSYNC_LINE_NS,
+                              .blank_lines = VSYNC_BLANK_LINES};
+  st7789_emu_set_timing(&panel, &timing);
+  mock_bsp_hooks hooks = {.gpio_write = hook_gpio_write,
+                          .gpio2_read = hook_gpio2_read,
+                          .spi_begin = hook_spi_begin,
+                          .spi_write = hook_spi_write,
+                          .spi_end = hook_spi_end,
+                          .time = hook_time,
+                          .context = &panel};
+  mock_bsp_set_hooks(&hooks);
+  if (ZLCD_init_with_config(&config) != ZLCD_SUCCESS) {
+    printf("ZLCD init failed\n");
+    return 1;
+  }
+  ZLCD_refresh_display();
+  ZLCD_reset_stats();
+
+  uint32_t refreshes = 0, torn = 0, shared = 0;
+  uint64_t previous_last = 0;
+  uint64_t start_ns = panel.time_ns;
+  for (uint32_t frame = 0; frame < frames; frame++) {
+    render(frame);
+    pthread_mutex_lock(&panel_lock);
+    st7789_emu_reset_stats(&panel);
+    pthread_mutex_unlock(&panel_lock);
+    if (config.async_refresh) {
+      ZLCD_refresh_display_async(NULL, NULL);
+      ZLCD_wait_refresh();
+    } else {
+      ZLCD_refresh_display();
+    }
+    pthread_mutex_lock(&panel_lock);
+    st7789_emu_stats stats = panel.stats;
+    pthread_mutex_unlock(&panel_lock);
+    if (stats.timed_pixels == 0) {
+      continue;
+    }
+    // shown over two panel frames, or in the same one as the refresh before
+    torn += stats.first_frame != stats.last_frame;
+    shared += refreshes != 0 && stats.first_frame <= previous_last;
+    previous_last = stats.last_frame;
+    refreshes++;
+  }
+  uint64_t elapsed_ns = panel.time_ns - start_ns;
+
+  printf("refreshes,torn,shared_frames,panel_frames,vsync_wait_us,"
+         "vsync_unfit\n");
+  ZLCD_stats driver;
+  if (ZLCD_get_stats(&driver) != ZLCD_SUCCESS) {
+    memset(&driver, 0, sizeof(driver));
+  }
+  printf("%u,%u,%u,%llu,%llu,%u\n", refreshes, torn, shared,
+         (unsigned long long)(elapsed_ns /
+                              ((VSYNC_BLANK_LINES + ST7789_EMU_RAM_HEIGHT) *
+                               (uint64_t)VSYNC_LINE_NS)),
+         (unsigned long long)driver.vsync_wait_us, driver.vsync_unfit);
+  // synchronised, every refresh has to show whole in a panel frame of its own
+  if (vsync_mode != ZLCD_VSYNC_OFF && (torn != 0 || shared != 0)) {
+    printf("FAILED: %u torn and %u sharing a panel frame of %u refreshes\n",
+           torn, shared, refreshes);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef SLEEP_H
+#define SLEEP_H
+/*
+Only msleep() is provided, usleep() and sleep() would clash with the C library
+on the host. Nothing actually waits, see mock_bsp_slept_ms().
+*/
+
+void msleep(unsigned long mseconds);
+
+#endif // SLEEP_H
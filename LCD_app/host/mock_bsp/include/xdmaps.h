@@ -0,0 +1,90 @@
+#ifndef XDMAPS_H
+#define XDMAPS_H
+/*
+PL330 stand-in. XDmaPs_Start() runs a channel program of the caller's own
+(UserDmaProg) on the interrupt thread of the mocked SPI controller: DMAMOV,
+DMALD/DMAST, loops, DMAADDH, DMAWFE/DMASEV and barriers, with the stores to the
+SPI0 TX FIFO register handed on like TXD writes and word stores to the SPI0
+interrupt enable register like IER writes. Several channels run side by side,
+a DMAWFE parks its channel until the event comes. Events with their INTEN bit
+set raise the channel interrupts connected with XSetupInterruptSystem(), the
+others wake a DMAWFE. The debug registers take DMASEV and DMAKILL. A program
+that waits for an event nobody can signal any more, signals one that is still
+pending or stores more than the TX FIFO has room for stops the host program.
+*/
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+#define XDMAPS_CHANNELS_PER_DEV 8U
+
+#define XDMAPS_INTEN_OFFSET 0x020U
+#define XDMAPS_INTSTATUS_OFFSET 0x028U
+#define XDMAPS_INTCLR_OFFSET 0x02cU
+#define XDMAPS_DBGSTATUS_OFFSET 0xD00U
+#define XDMAPS_DBGCMD_OFFSET 0xD04U
+#define XDMAPS_DBGINST0_OFFSET 0xD08U
+#define XDMAPS_DBGINST1_OFFSET 0xD0CU
+#define XDMAPS_DBGSTATUS_BUSY 0x01U
+
+#define XDmaPs_DBGINST0(b1, b0, ch, dbg_th)                                    \
+  (((b1) << 24) | ((b0) << 16) | (((ch) & 0x7) << 8) | ((dbg_th & 0x1)))
+
+typedef struct {
+  char *Name;
+  UINTPTR BaseAddress;
+  u32 IntrId[9]; // abort, then the events (channels) 0 to 7
+  UINTPTR IntrParent;
+} XDmaPs_Config;
+
+typedef struct {
+  unsigned int SrcBurstSize;
+  unsigned int SrcBurstLen;
+  unsigned int SrcInc;
+  unsigned int DstBurstSize;
+  unsigned int DstBurstLen;
+  unsigned int DstInc;
+} XDmaPs_ChanCtrl;
+
+typedef struct {
+  UINTPTR SrcAddr;
+  UINTPTR DstAddr;
+  unsigned int Length;
+} XDmaPs_BD;
+
+typedef struct {
+  XDmaPs_ChanCtrl ChanCtrl;
+  XDmaPs_BD BD;
+  void *UserDmaProg;
+  int UserDmaProgLength;
+} XDmaPs_Cmd;
+
+typedef void (*XDmaPsDoneHandler)(unsigned int Channel, XDmaPs_Cmd *DmaCmd,
+                                  void *CallbackRef);
+
+typedef struct {
+  XDmaPsDoneHandler DoneHandler;
+  void *DoneRef;
+  XDmaPs_Cmd *volatile DmaCmdToHw;
+} XDmaPs_ChannelData;
+
+typedef struct {
+  XDmaPs_Config Config;
+  u32 IsReady;
+  XDmaPs_ChannelData Chans[XDMAPS_CHANNELS_PER_DEV];
+} XDmaPs;
+
+XDmaPs_Config *XDmaPs_LookupConfig(UINTPTR BaseAddress);
+int XDmaPs_CfgInitialize(XDmaPs *InstPtr, XDmaPs_Config *Config,
+                         UINTPTR EffectiveAddr);
+int XDmaPs_Start(XDmaPs *InstPtr, unsigned int Channel, XDmaPs_Cmd *Cmd,
+                 int HoldDmaProg);
+int XDmaPs_IsActive(XDmaPs *InstPtr, unsigned int Channel);
+int XDmaPs_SetDoneHandler(XDmaPs *InstPtr, unsigned Channel,
+                          XDmaPsDoneHandler DoneHandler, void *CallbackRef);
+void XDmaPs_DoneISR_0(XDmaPs *InstPtr);
+void XDmaPs_DoneISR_1(XDmaPs *InstPtr);
+u32 XDmaPs_ReadReg(UINTPTR BaseAddress, u32 RegOffset);
+void XDmaPs_WriteReg(UINTPTR BaseAddress, u32 RegOffset, u32 RegisterValue);
+
+#endif // XDMAPS_H
@@ -0,0 +1,37 @@
+#ifndef XGPIO_H
+#define XGPIO_H
+/*
+AXI GPIO stand-in. Channel 1 writes (and writes of its data register) are
+forwarded to the gpio_write hook (the LCD DC, reset and backlight pins), reads
+return the last value written. Channel 2 is inputs only, read from the
+gpio2_read hook (TE).
+*/
+
+#include "xgpio_l.h"
+#include "xil_types.h"
+#include "xstatus.h"
+
+typedef struct {
+  char *Name;
+  UINTPTR BaseAddress;
+  int InterruptPresent;
+  int IsDual;
+} XGpio_Config;
+
+typedef struct {
+  UINTPTR BaseAddress;
+  u32 IsReady;
+  int InterruptPresent;
+  int IsDual;
+} XGpio;
+
+int XGpio_Initialize(XGpio *InstancePtr, UINTPTR BaseAddress);
+XGpio_Config *XGpio_LookupConfig(UINTPTR BaseAddress);
+int XGpio_CfgInitialize(XGpio *InstancePtr, XGpio_Config *Config,
+                        UINTPTR EffectiveAddr);
+void XGpio_SetDataDirection(XGpio *InstancePtr, unsigned Channel,
+                            u32 DirectionMask);
+u32 XGpio_DiscreteRead(XGpio *InstancePtr, unsigned Channel);
+void XGpio_DiscreteWrite(XGpio *InstancePtr, unsigned Channel, u32 Mask);
+
+#endif // XGPIO_H
@@ -0,0 +1,13 @@
+#ifndef XGPIO_L_H
+#define XGPIO_L_H
+// only the data registers are modelled, see xgpio.h
+
+#include "xil_types.h"
+
+#define XGPIO_DATA_OFFSET 0x0U
+#define XGPIO_DATA2_OFFSET 0x8U
+
+void XGpio_WriteReg(UINTPTR BaseAddress, u32 RegOffset, u32 Data);
+u32 XGpio_ReadReg(UINTPTR BaseAddress, u32 RegOffset);
+
+#endif // XGPIO_L_H
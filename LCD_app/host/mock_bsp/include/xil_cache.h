@@ -0,0 +1,14 @@
+#ifndef XIL_CACHE_H
+#define XIL_CACHE_H
+/*
+The host has one coherent view of memory, maintenance by address range is a
+no-op. Only what the ZLCD driver uses is declared.
+*/
+
+#include "xil_types.h"
+
+void Xil_DCacheFlushRange(INTPTR adr, u32 len);
+void Xil_DCacheInvalidateRange(INTPTR adr, u32 len);
+void Xil_ICacheInvalidateRange(INTPTR adr, u32 len);
+
+#endif // XIL_CACHE_H
@@ -0,0 +1,13 @@
+#ifndef XIL_CACHE_L_H
+#define XIL_CACHE_L_H
+/*
+Line and single level maintenance, a no-op like xil_cache.h. Only what the
+ZLCD driver uses is declared.
+*/
+
+#include "xil_types.h"
+
+void Xil_DCacheStoreLine(u32 adr);
+void Xil_L1DCacheInvalidateRange(u32 adr, u32 len);
+
+#endif // XIL_CACHE_L_H
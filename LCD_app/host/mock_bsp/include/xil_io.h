@@ -0,0 +1,14 @@
+#ifndef XIL_IO_H
+#define XIL_IO_H
+/*
+Register access. The PL310 L2 cache controller registers are a register file
+in mock_bsp.c (the cache is on, nothing locked), any other address is plain
+host memory.
+*/
+
+#include "xil_types.h"
+
+u32 Xil_In32(UINTPTR Addr);
+void Xil_Out32(UINTPTR Addr, u32 Value);
+
+#endif // XIL_IO_H
@@ -0,0 +1,11 @@
+#ifndef XIL_MMU_H
+#define XIL_MMU_H
+// no translation table on the host, attributes are accepted and ignored
+
+#include "xil_types.h"
+
+#define NORM_NONCACHE 0x11DE2 /* Normal Non-cacheable */
+
+void Xil_SetTlbAttributes(INTPTR Addr, u32 attrib);
+
+#endif // XIL_MMU_H
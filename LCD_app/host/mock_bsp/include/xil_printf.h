@@ -0,0 +1,10 @@
+#ifndef XIL_PRINTF_H
+#define XIL_PRINTF_H
+// the real header pulls in string.h too and the driver relies on it
+
+#include <stdio.h>
+#include <string.h>
+
+#define xil_printf printf
+
+#endif // XIL_PRINTF_H
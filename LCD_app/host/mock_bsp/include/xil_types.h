@@ -0,0 +1,31 @@
+#ifndef XIL_TYPES_H
+#define XIL_TYPES_H
+/****************************************************************************
+Host stand-in for the Xilinx BSP basic types. UINTPTR is pointer sized here so
+addresses handed to the mocked DMA engine survive on a 64-bit host.
+*****************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef uintptr_t UINTPTR;
+typedef intptr_t INTPTR;
+
+#ifndef TRUE
+#define TRUE 1U
+#endif
+#ifndef FALSE
+#define FALSE 0U
+#endif
+
+#define XIL_COMPONENT_IS_READY 0x11111111U
+
+#endif // XIL_TYPES_H
@@ -0,0 +1,14 @@
+#ifndef XILTIMER_H
+#define XILTIMER_H
+// the global timer is backed by CLOCK_MONOTONIC on the host
+
+#include "xil_types.h"
+#include "xparameters.h"
+
+#define COUNTS_PER_SECOND (XPAR_CPU_CORE_CLOCK_FREQ_HZ / 2)
+
+typedef u64 XTime;
+
+void XTime_GetTime(XTime *Xtime_Global);
+
+#endif // XILTIMER_H
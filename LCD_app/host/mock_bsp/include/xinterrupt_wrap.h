@@ -0,0 +1,16 @@
+#ifndef XINTERRUPT_WRAP_H
+#define XINTERRUPT_WRAP_H
+/*
+There is no GIC on the host. The handlers are remembered by IntrId and run from
+the mocked SPI controller's interrupt thread, for interrupt mode transfers and
+the PL330 (see xdmaps.h).
+*/
+
+#include "xil_types.h"
+
+#define XINTERRUPT_DEFAULT_PRIORITY 0xA0U
+
+int XSetupInterruptSystem(void *DriverInstance, void *IntrHandler, u32 IntrId,
+                          UINTPTR IntcParent, u16 Priority);
+
+#endif // XINTERRUPT_WRAP_H
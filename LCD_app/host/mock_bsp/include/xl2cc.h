@@ -0,0 +1,9 @@
+#ifndef XL2CC_H
+#define XL2CC_H
+// PL310 L2 cache controller, only what the ZLCD driver uses. The base address
+// comes from xparameters_ps.h in the BSP
+
+#define XPS_L2CC_BASEADDR 0xF8F02000U
+#define XPS_L2CC_CNTRL_OFFSET 0x0100U
+
+#endif // XL2CC_H
@@ -0,0 +1,18 @@
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+// the peripherals of the LCD_platform hardware design the driver refers to
+
+#define XPAR_AXI_GPIO_0_BASEADDR 0x41200000
+#define XPAR_XGPIO_0_BASEADDR 0x41200000
+
+#define XPAR_SPI0_BASEADDR 0xe0006000
+#define XPAR_SPI0_SPI_CLK_FREQ_HZ 0xbebc200
+#define XPAR_SPI0_INTERRUPTS 0x401a
+#define XPAR_SPI0_INTERRUPT_PARENT 0xf8f01000
+#define XPAR_XSPIPS_0_BASEADDR 0xe0006000
+
+#define XPAR_XDMAPS_0_BASEADDR 0xf8003000
+
+#define XPAR_CPU_CORE_CLOCK_FREQ_HZ 666666687
+
+#endif // XPARAMETERS_H
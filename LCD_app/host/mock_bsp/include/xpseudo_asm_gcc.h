@@ -0,0 +1,9 @@
+#ifndef XPSEUDO_ASM_GCC_H
+#define XPSEUDO_ASM_GCC_H
+// no coprocessor or barrier instructions on the host
+
+#define dsb()
+#define dmb()
+#define isb()
+
+#endif // XPSEUDO_ASM_GCC_H
@@ -0,0 +1,81 @@
+#ifndef XSPIPS_H
+#define XSPIPS_H
+/*
+PS SPI stand-in. A polled transfer is handed to the spi hooks right away. An
+interrupt mode transfer is handed on from a separate "interrupt" thread which
+then runs the handler installed with XSetupInterruptSystem(), so the driver's
+asynchronous paths really do run concurrently with the caller.
+*/
+
+#include "xil_types.h"
+#include "xspips_hw.h"
+#include "xstatus.h"
+
+#define XSPIPS_MASTER_OPTION 0x00000001U
+#define XSPIPS_CLK_ACTIVE_LOW_OPTION 0x00000002U
+#define XSPIPS_CLK_PHASE_1_OPTION 0x00000004U
+#define XSPIPS_DECODE_SSELECT_OPTION 0x00000008U
+#define XSPIPS_FORCE_SSELECT_OPTION 0x00000010U
+#define XSPIPS_MANUAL_START_OPTION 0x00000020U
+
+#define XSPIPS_CLK_PRESCALE_4 0x01U
+
+typedef void (*XSpiPs_StatusHandler)(const void *CallBackRef, u32 StatusEvent,
+                                     u32 ByteCount);
+
+typedef struct {
+  char *Name;
+  u32 BaseAddress;
+  u32 InputClockHz;
+  u16 IntrId;
+  UINTPTR IntrParent;
+} XSpiPs_Config;
+
+typedef struct {
+  XSpiPs_Config Config;
+  u32 IsReady;
+
+  u8 *SendBufferPtr;
+  u8 *RecvBufferPtr;
+  u32 RequestedBytes;
+  u32 RemainingBytes;
+  volatile u32 IsBusy;
+  u32 SlaveSelect;
+
+  XSpiPs_StatusHandler StatusHandler;
+  void *StatusRef;
+
+  u32 Options; // the real driver keeps these in the CR register
+} XSpiPs;
+
+XSpiPs_Config *XSpiPs_LookupConfig(u32 BaseAddress);
+s32 XSpiPs_CfgInitialize(XSpiPs *InstancePtr, const XSpiPs_Config *ConfigPtr,
+                         u32 EffectiveAddr);
+s32 XSpiPs_Transfer(XSpiPs *InstancePtr, u8 *SendBufPtr, u8 *RecvBufPtr,
+                    u32 ByteCount);
+s32 XSpiPs_PolledTransfer(XSpiPs *InstancePtr, u8 *SendBufPtr,
+                          u8 *RecvBufPtr, u32 ByteCount);
+void XSpiPs_SetStatusHandler(XSpiPs *InstancePtr, void *CallBackRef,
+                             XSpiPs_StatusHandler FuncPointer);
+void XSpiPs_InterruptHandler(XSpiPs *InstancePtr);
+s32 XSpiPs_SetOptions(XSpiPs *InstancePtr, u32 Options);
+u32 XSpiPs_GetOptions(const XSpiPs *InstancePtr);
+s32 XSpiPs_SetClkPrescaler(const XSpiPs *InstancePtr, u8 Prescaler);
+u8 XSpiPs_GetClkPrescaler(const XSpiPs *InstancePtr);
+s32 XSpiPs_SetDelays(const XSpiPs *InstancePtr, u8 DelayNss, u8 DelayBtwn,
+                     u8 DelayAfter, u8 DelayInit);
+
+// chip select is asserted between Enable and Disable for the DMA path
+void XSpiPs_Enable(XSpiPs *InstancePtr);
+void XSpiPs_Disable(XSpiPs *InstancePtr);
+
+#define XSpiPs_IsManualChipSelect(InstancePtr)                                 \
+  (((XSpiPs_GetOptions(InstancePtr) & XSPIPS_FORCE_SSELECT_OPTION) != 0U)     \
+       ? TRUE                                                                  \
+       : FALSE)
+
+#define XSpiPs_SetTXWatermark(InstancePtr, RegisterValue)                      \
+  XSpiPs_WriteReg((InstancePtr)->Config.BaseAddress, XSPIPS_TXWR_OFFSET,       \
+                  (RegisterValue))
+
+#endif // XSPIPS_H
@@ -0,0 +1,37 @@
+#ifndef XSPIPS_HW_H
+#define XSPIPS_HW_H
+/*
+SPI0 register map. Bytes written to TXD are handed on right away and the status
+register always reports room in the TX FIFO, so an enabled TXOW interrupt is
+always pending. Every byte written (by the CPU or the PL330) also "shifts in"
+one byte, read back through RXD, up to the 128 the RX FIFO holds.
+*/
+
+#include "xil_types.h"
+
+#define XSPIPS_CR_OFFSET 0x00U
+#define XSPIPS_SR_OFFSET 0x04U
+#define XSPIPS_IER_OFFSET 0x08U
+#define XSPIPS_IDR_OFFSET 0x0CU
+#define XSPIPS_IMR_OFFSET 0x10U
+#define XSPIPS_ER_OFFSET 0x14U
+#define XSPIPS_TXD_OFFSET 0x1CU
+#define XSPIPS_RXD_OFFSET 0x20U
+#define XSPIPS_TXWR_OFFSET 0x28U
+
+#define XSPIPS_CR_SSCTRL_MASK 0x00003C00U
+#define XSPIPS_CR_SSCTRL_SHIFT 10U
+#define XSPIPS_CR_SSCTRL_MAXIMUM 0xFU
+
+#define XSPIPS_IXR_RXNEMPTY_MASK 0x00000010U
+#define XSPIPS_IXR_TXOW_MASK 0x00000004U
+#define XSPIPS_IXR_RXOVR_MASK 0x00000001U
+
+#define XSPIPS_ER_ENABLE_MASK 0x00000001U
+
+#define XSPIPS_FIFO_DEPTH 128U
+
+u32 XSpiPs_ReadReg(UINTPTR BaseAddress, u32 RegOffset);
+void XSpiPs_WriteReg(UINTPTR BaseAddress, u32 RegOffset, u32 RegisterValue);
+
+#endif // XSPIPS_HW_H
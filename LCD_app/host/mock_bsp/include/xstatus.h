@@ -0,0 +1,13 @@
+#ifndef XSTATUS_H
+#define XSTATUS_H
+// the status codes the ZLCD driver looks at, same values as the real BSP
+
+#include "xil_types.h"
+
+#define XST_SUCCESS 0L
+#define XST_FAILURE 1L
+#define XST_DEVICE_BUSY 21L
+#define XST_SPI_MODE_FAULT 1151
+#define XST_SPI_TRANSFER_DONE 1152
+
+#endif // XSTATUS_H
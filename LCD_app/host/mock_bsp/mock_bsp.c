@@ -0,0 +1,968 @@
+#include "mock_bsp.h"
+#include <pthread.h>
+#include <sleep.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xdmaps.h>
+#include <xgpio.h>
+#include <xil_cache.h>
+#include <xil_cache_l.h>
+#include <xil_io.h>
+#include <xil_mmu.h>
+#include <xiltimer.h>
+#include <xinterrupt_wrap.h>
+#include <xl2cc.h>
+#include <xparameters.h>
+#include <xspips.h>
+#include <xstatus.h>
+
+/*************************************************
+  mocked Xilinx BSP for off-target ZLCD builds
+**************************************************/
+
+static mock_bsp_hooks hooks;
+static unsigned long slept_ms;
+// the latest XTime_GetTime() result, what the driver knows of the time
+static _Atomic XTime time_seen;
+// PL310 registers, 4 KB of them. Only the control register (enabled) is set
+static u32 l2cc_registers[0x1000 / sizeof(u32)] = {
+    [XPS_L2CC_CNTRL_OFFSET / sizeof(u32)] = 0x1U};
+
+void mock_bsp_set_hooks(const mock_bsp_hooks *new_hooks) {
+  if (new_hooks == NULL) {
+    hooks = (mock_bsp_hooks){0};
+    return;
+  }
+  hooks = *new_hooks;
+}
+
+unsigned long mock_bsp_slept_ms(void) { return slept_ms; }
+
+void msleep(unsigned long mseconds) { slept_ms += mseconds; }
+
+void XTime_GetTime(XTime *Xtime_Global) {
+  if (hooks.time != NULL) {
+    *Xtime_Global = hooks.time(hooks.context);
+  } else {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    *Xtime_Global = (XTime)now.tv_sec * COUNTS_PER_SECOND +
+                    (XTime)now.tv_nsec * (COUNTS_PER_SECOND / 1000) / 1000000;
+  }
+  atomic_store(&time_seen, *Xtime_Global);
+}
+
+void Xil_DCacheFlushRange(INTPTR adr, u32 len) {
+  (void)adr;
+  (void)len;
+}
+
+void Xil_DCacheInvalidateRange(INTPTR adr, u32 len) {
+  (void)adr;
+  (void)len;
+}
+
+void Xil_ICacheInvalidateRange(INTPTR adr, u32 len) {
+  (void)adr;
+  (void)len;
+}
+
+void Xil_DCacheStoreLine(u32 adr) { (void)adr; }
+
+void Xil_L1DCacheInvalidateRange(u32 adr, u32 len) {
+  (void)adr;
+  (void)len;
+}
+
+u32 Xil_In32(UINTPTR Addr) {
+  if (Addr - XPS_L2CC_BASEADDR < sizeof(l2cc_registers)) {
+    return l2cc_registers[(Addr - XPS_L2CC_BASEADDR) / sizeof(u32)];
+  }
+  return *(volatile u32 *)Addr;
+}
+
+void Xil_Out32(UINTPTR Addr, u32 Value) {
+  if (Addr - XPS_L2CC_BASEADDR < sizeof(l2cc_registers)) {
+    l2cc_registers[(Addr - XPS_L2CC_BASEADDR) / sizeof(u32)] = Value;
+    return;
+  }
+  *(volatile u32 *)Addr = Value;
+}
+
+void Xil_SetTlbAttributes(INTPTR Addr, u32 attrib) {
+  (void)Addr;
+  (void)attrib;
+}
+
+static void mock_bsp_spi_begin(void) {
+  if (hooks.spi_begin != NULL) {
+    hooks.spi_begin(hooks.context);
+  }
+}
+
+static void mock_bsp_spi_write(const u8 *bytes, u32 num_bytes) {
+  if (hooks.spi_write != NULL && bytes != NULL && num_bytes != 0) {
+    hooks.spi_write(hooks.context, bytes, num_bytes);
+  }
+}
+
+static void mock_bsp_spi_end(void) {
+  if (hooks.spi_end != NULL) {
+    hooks.spi_end(hooks.context);
+  }
+}
+
+/*************************************************
+  AXI GPIO
+**************************************************/
+
+// dual, channel 2 carries TE for ZLCD_VSYNC_TE_GPIO
+static XGpio_Config gpio_config = {.Name = "axi_gpio_0",
+                                   .BaseAddress = XPAR_AXI_GPIO_0_BASEADDR,
+                                   .IsDual = 1};
+static u32 gpio_data;
+// the AXI GPIO 0 bit of ZLCD_PIN_DC
+#define MOCK_BSP_GPIO_DC 0x1U
+
+static void mock_bsp_spi_check_idle(const char *what);
+
+XGpio_Config *XGpio_LookupConfig(UINTPTR BaseAddress) {
+  return BaseAddress == gpio_config.BaseAddress ? &gpio_config : NULL;
+}
+
+int XGpio_CfgInitialize(XGpio *InstancePtr, XGpio_Config *Config,
+                        UINTPTR EffectiveAddr) {
+  if (InstancePtr == NULL || Config == NULL) {
+    return XST_FAILURE;
+  }
+  InstancePtr->BaseAddress = EffectiveAddr;
+  InstancePtr->InterruptPresent = Config->InterruptPresent;
+  InstancePtr->IsDual = Config->IsDual;
+  InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+  return XST_SUCCESS;
+}
+
+int XGpio_Initialize(XGpio *InstancePtr, UINTPTR BaseAddress) {
+  XGpio_Config *config = XGpio_LookupConfig(BaseAddress);
+  if (config == NULL) {
+    return XST_FAILURE;
+  }
+  return XGpio_CfgInitialize(InstancePtr, config, config->BaseAddress);
+}
+
+void XGpio_SetDataDirection(XGpio *InstancePtr, unsigned Channel,
+                            u32 DirectionMask) {
+  (void)InstancePtr;
+  (void)Channel;
+  (void)DirectionMask;
+}
+
+static u32 mock_bsp_gpio2_read(void) {
+  return hooks.gpio2_read != NULL ? hooks.gpio2_read(hooks.context) : 0;
+}
+
+u32 XGpio_DiscreteRead(XGpio *InstancePtr, unsigned Channel) {
+  (void)InstancePtr;
+  return Channel == 1 ? gpio_data : mock_bsp_gpio2_read();
+}
+
+void XGpio_DiscreteWrite(XGpio *InstancePtr, unsigned Channel, u32 Mask) {
+  (void)InstancePtr;
+  if (Channel != 1) {
+    return;
+  }
+  if ((gpio_data ^ Mask) & MOCK_BSP_GPIO_DC) {
+    mock_bsp_spi_check_idle("DC toggled");
+  }
+  gpio_data = Mask;
+  if (hooks.gpio_write != NULL) {
+    hooks.gpio_write(hooks.context, Mask);
+  }
+}
+
+void XGpio_WriteReg(UINTPTR BaseAddress, u32 RegOffset, u32 Data) {
+  if (BaseAddress == gpio_config.BaseAddress &&
+      RegOffset == XGPIO_DATA_OFFSET) {
+    XGpio_DiscreteWrite(NULL, 1, Data);
+  }
+}
+
+u32 XGpio_ReadReg(UINTPTR BaseAddress, u32 RegOffset) {
+  if (BaseAddress != gpio_config.BaseAddress) {
+    return 0;
+  }
+  return RegOffset == XGPIO_DATA2_OFFSET ? mock_bsp_gpio2_read() : gpio_data;
+}
+
+/*************************************************
+  PS SPI
+**************************************************/
+
+static XSpiPs_Config spi_config = {.Name = "spi0",
+                                   .BaseAddress = XPAR_SPI0_BASEADDR,
+                                   .InputClockHz = XPAR_SPI0_SPI_CLK_FREQ_HZ,
+                                   .IntrId = XPAR_SPI0_INTERRUPTS,
+                                   .IntrParent = XPAR_SPI0_INTERRUPT_PARENT};
+
+XSpiPs_Config *XSpiPs_LookupConfig(u32 BaseAddress) {
+  return BaseAddress == spi_config.BaseAddress ? &spi_config : NULL;
+}
+
+s32 XSpiPs_CfgInitialize(XSpiPs *InstancePtr, const XSpiPs_Config *ConfigPtr,
+                         u32 EffectiveAddr) {
+  if (InstancePtr == NULL || ConfigPtr == NULL) {
+    return XST_FAILURE;
+  }
+  if (InstancePtr->IsBusy) {
+    return XST_DEVICE_BUSY;
+  }
+  *InstancePtr = (XSpiPs){0};
+  InstancePtr->Config = *ConfigPtr;
+  InstancePtr->Config.BaseAddress = EffectiveAddr;
+  InstancePtr->SlaveSelect = XSPIPS_CR_SSCTRL_MASK;
+  InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+  return XST_SUCCESS;
+}
+
+s32 XSpiPs_SetOptions(XSpiPs *InstancePtr, u32 Options) {
+  if (InstancePtr->IsBusy) {
+    return XST_DEVICE_BUSY;
+  }
+  InstancePtr->Options = Options;
+  return XST_SUCCESS;
+}
+
+u32 XSpiPs_GetOptions(const XSpiPs *InstancePtr) {
+  return InstancePtr->Options;
+}
+
+s32 XSpiPs_SetDelays(const XSpiPs *InstancePtr, u8 DelayNss, u8 DelayBtwn,
+                     u8 DelayAfter, u8 DelayInit) {
+  (void)DelayNss;
+  (void)DelayBtwn;
+  (void)DelayAfter;
+  (void)DelayInit;
+  return InstancePtr->IsBusy ? XST_DEVICE_BUSY : XST_SUCCESS;
+}
+
+void XSpiPs_SetStatusHandler(XSpiPs *InstancePtr, void *CallBackRef,
+                             XSpiPs_StatusHandler FuncPointer) {
+  InstancePtr->StatusHandler = FuncPointer;
+  InstancePtr->StatusRef = CallBackRef;
+}
+
+void XSpiPs_Enable(XSpiPs *InstancePtr) {
+  (void)InstancePtr;
+  mock_bsp_spi_begin();
+}
+
+void XSpiPs_Disable(XSpiPs *InstancePtr) {
+  (void)InstancePtr;
+  mock_bsp_spi_check_idle("chip select released");
+  mock_bsp_spi_end();
+}
+
+/*
+Interrupts connected with XSetupInterruptSystem(), by IntrId. They only ever
+run on irq_thread, one at a time, like the handlers of one GIC priority.
+*/
+#define MOCK_BSP_MAX_INTERRUPTS 8U
+static struct {
+  u32 id;
+  void (*handler)(void *instance);
+  void *instance;
+} interrupts[MOCK_BSP_MAX_INTERRUPTS];
+static size_t num_interrupts;
+
+static void mock_bsp_interrupt(u32 id) {
+  for (size_t i = 0; i < num_interrupts; i++) {
+    if (interrupts[i].id == id) {
+      interrupts[i].handler(interrupts[i].instance);
+      return;
+    }
+  }
+}
+
+static void mock_bsp_fail(const char *what, unsigned value) {
+  fprintf(stderr, "mock BSP: ");
+  fprintf(stderr, what, value);
+  fprintf(stderr, "\n");
+  abort();
+}
+
+/*
+Interrupt mode transfers and DMA programs are parked here and picked up by
+irq_thread, which plays the part of the interrupts firing
+*/
+static pthread_mutex_t irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t irq_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t irq_thread;
+static bool irq_thread_running;
+static XSpiPs *pending_spi;
+static bool pending_dma; // a channel was started, see mock_bsp_dma_schedule()
+
+// bytes shifted in so far and not read back yet, past 128 they are lost
+static u32 rx_fifo_level;
+static bool rx_overflow;
+/*
+The last byte of a DMA transfer is still in the shift register when the TX
+FIFO runs empty, its RX byte comes in at rx_late_time (0 until the TXOW
+interrupt that reports the empty FIFO). The host is far slower than the bus,
+so it only counts as in once the driver has read a time past it. Until every RX byte of
+the transfer has been read back (rx_stale) a byte the CPU writes into TXD would
+be counted against one of them.
+*/
+static bool rx_late;
+static XTime rx_late_time;
+static bool rx_stale;
+static _Atomic u32 spi_interrupt_mask; // IMR
+static u32 spi_tx_watermark = 1;
+static u8 spi_prescaler;
+// bytes the PL330 may still store into the TX FIFO, see mock_bsp_spi_levels()
+static u32 dma_tx_room;
+
+static void mock_bsp_rx_in(u32 num_bytes) {
+  if (num_bytes > XSPIPS_FIFO_DEPTH - rx_fifo_level) {
+    rx_fifo_level = XSPIPS_FIFO_DEPTH;
+    rx_overflow = true;
+  } else {
+    rx_fifo_level += num_bytes;
+  }
+}
+
+static void mock_bsp_spi_shift(const u8 *bytes, u32 num_bytes) {
+  mock_bsp_spi_write(bytes, num_bytes);
+  mock_bsp_rx_in(num_bytes);
+}
+
+// the end of a DMA transfer, its last byte has not gone out yet
+static void mock_bsp_spi_shift_last(void) {
+  rx_late = true;
+  rx_late_time = 0;
+  rx_stale = true;
+  if (rx_fifo_level != 0) {
+    rx_fifo_level--;
+  }
+}
+
+// the TX FIFO is reported empty, the last byte takes 8 SPI clocks from here
+static void mock_bsp_spi_tx_empty(void) {
+  if (!rx_late || rx_late_time != 0) {
+    return;
+  }
+  XTime now;
+  XTime_GetTime(&now);
+  u64 divider = 2ULL << spi_prescaler;
+  rx_late_time = now + (8U * divider * COUNTS_PER_SECOND +
+                        spi_config.InputClockHz - 1U) /
+                           spi_config.InputClockHz;
+}
+
+static void mock_bsp_spi_settle(void) {
+  if (rx_late && rx_late_time != 0 &&
+      atomic_load(&time_seen) >= rx_late_time) {
+    rx_late = false;
+    mock_bsp_rx_in(1);
+  }
+}
+
+// DC and chip select may only change once nothing is left of a transfer
+static void mock_bsp_spi_check_idle(const char *what) {
+  mock_bsp_spi_settle();
+  if (rx_late || rx_fifo_level != 0) {
+    fprintf(stderr, "mock BSP: %s %s\n", what,
+            rx_late ? "while the last DMA byte was being shifted out"
+                    : "with RX bytes left");
+    abort();
+  }
+}
+
+s32 XSpiPs_SetClkPrescaler(const XSpiPs *InstancePtr, u8 Prescaler) {
+  if (InstancePtr->IsBusy) {
+    return XST_DEVICE_BUSY;
+  }
+  spi_prescaler = Prescaler;
+  return XST_SUCCESS;
+}
+
+u8 XSpiPs_GetClkPrescaler(const XSpiPs *InstancePtr) {
+  (void)InstancePtr;
+  return spi_prescaler;
+}
+
+u32 XSpiPs_ReadReg(UINTPTR BaseAddress, u32 RegOffset) {
+  (void)BaseAddress;
+  switch (RegOffset) {
+  case XSPIPS_SR_OFFSET:
+    mock_bsp_spi_settle();
+    // TX FIFO always below the watermark
+    return XSPIPS_IXR_TXOW_MASK |
+           (rx_fifo_level != 0 ? XSPIPS_IXR_RXNEMPTY_MASK : 0) |
+           (rx_overflow ? XSPIPS_IXR_RXOVR_MASK : 0);
+  case XSPIPS_IMR_OFFSET:
+    return atomic_load(&spi_interrupt_mask);
+  case XSPIPS_RXD_OFFSET:
+    mock_bsp_spi_settle();
+    if (rx_fifo_level != 0) {
+      rx_fifo_level--;
+    }
+    rx_stale = rx_stale && (rx_late || rx_fifo_level != 0);
+    return 0;
+  default:
+    return 0;
+  }
+}
+
+void XSpiPs_WriteReg(UINTPTR BaseAddress, u32 RegOffset, u32 RegisterValue) {
+  (void)BaseAddress;
+  switch (RegOffset) {
+  case XSPIPS_TXD_OFFSET: {
+    if (rx_stale) {
+      mock_bsp_fail("TXD written before the RX bytes of a DMA transfer were "
+                    "read back",
+                    0);
+    }
+    u8 byte = (u8)RegisterValue;
+    mock_bsp_spi_shift(&byte, 1);
+    break;
+  }
+  case XSPIPS_SR_OFFSET:
+    if (RegisterValue & XSPIPS_IXR_RXOVR_MASK) {
+      rx_overflow = false;
+    }
+    break;
+  case XSPIPS_IER_OFFSET:
+    // may be what a DMAWFE on irq_thread waits for
+    pthread_mutex_lock(&irq_lock);
+    atomic_fetch_or(&spi_interrupt_mask, RegisterValue);
+    pthread_cond_broadcast(&irq_cond);
+    pthread_mutex_unlock(&irq_lock);
+    break;
+  case XSPIPS_IDR_OFFSET:
+    atomic_fetch_and(&spi_interrupt_mask, ~RegisterValue);
+    break;
+  case XSPIPS_TXWR_OFFSET:
+    spi_tx_watermark = RegisterValue;
+    break;
+  default:
+    break;
+  }
+}
+
+/*
+The TX FIFO never holds anything, so an enabled TXOW interrupt fires until its
+handler turns it off. A DMA program may then store as much as the FIFO would
+have room for on the board, where it is only known to be below the watermark.
+*/
+static void mock_bsp_spi_levels(void) {
+  for (unsigned i = 0;
+       atomic_load(&spi_interrupt_mask) & XSPIPS_IXR_TXOW_MASK; i++) {
+    if (i == 1000) {
+      mock_bsp_fail("the TXOW interrupt is never turned off", 0);
+    }
+    dma_tx_room = spi_tx_watermark != 0
+                      ? XSPIPS_FIFO_DEPTH - (spi_tx_watermark - 1)
+                      : 0;
+    if (spi_tx_watermark == 1) {
+      mock_bsp_spi_tx_empty();
+    }
+    mock_bsp_interrupt(spi_config.IntrId);
+  }
+}
+
+s32 XSpiPs_PolledTransfer(XSpiPs *InstancePtr, u8 *SendBufPtr,
+                          u8 *RecvBufPtr, u32 ByteCount) {
+  if (InstancePtr == NULL || SendBufPtr == NULL || ByteCount == 0) {
+    return XST_FAILURE;
+  }
+  if (InstancePtr->IsBusy) {
+    return XST_DEVICE_BUSY;
+  }
+  InstancePtr->IsBusy = TRUE;
+  mock_bsp_spi_begin();
+  mock_bsp_spi_write(SendBufPtr, ByteCount);
+  mock_bsp_spi_end();
+  if (RecvBufPtr != NULL) {
+    memset(RecvBufPtr, 0, ByteCount);
+  }
+  InstancePtr->IsBusy = FALSE;
+  return XST_SUCCESS;
+}
+
+s32 XSpiPs_Transfer(XSpiPs *InstancePtr, u8 *SendBufPtr, u8 *RecvBufPtr,
+                    u32 ByteCount) {
+  if (InstancePtr == NULL || SendBufPtr == NULL || ByteCount == 0) {
+    return XST_FAILURE;
+  }
+  if (InstancePtr->IsBusy) {
+    return XST_DEVICE_BUSY;
+  }
+  InstancePtr->IsBusy = TRUE;
+  InstancePtr->SendBufferPtr = SendBufPtr;
+  InstancePtr->RecvBufferPtr = RecvBufPtr;
+  InstancePtr->RequestedBytes = ByteCount;
+  InstancePtr->RemainingBytes = ByteCount;
+
+  pthread_mutex_lock(&irq_lock);
+  pending_spi = InstancePtr;
+  pthread_cond_broadcast(&irq_cond);
+  pthread_mutex_unlock(&irq_lock);
+  return XST_SUCCESS;
+}
+
+void XSpiPs_InterruptHandler(XSpiPs *InstancePtr) {
+  if (InstancePtr->StatusHandler != NULL) {
+    InstancePtr->StatusHandler(InstancePtr->StatusRef, XST_SPI_TRANSFER_DONE,
+                               InstancePtr->RequestedBytes);
+  }
+}
+
+static void mock_bsp_dma_schedule(void);
+
+static void *mock_bsp_irq_thread(void *argument) {
+  (void)argument;
+  for (;;) {
+    pthread_mutex_lock(&irq_lock);
+    while (pending_spi == NULL && !pending_dma) {
+      pthread_cond_wait(&irq_cond, &irq_lock);
+    }
+    XSpiPs *spi = pending_spi;
+    bool dma = pending_dma;
+    pending_spi = NULL;
+    pending_dma = false;
+    pthread_mutex_unlock(&irq_lock);
+
+    if (dma) {
+      mock_bsp_dma_schedule();
+    }
+    if (spi == NULL) {
+      continue;
+    }
+    mock_bsp_spi_begin();
+    mock_bsp_spi_write(spi->SendBufferPtr, spi->RequestedBytes);
+    mock_bsp_spi_end();
+    if (spi->RecvBufferPtr != NULL) {
+      memset(spi->RecvBufferPtr, 0, spi->RequestedBytes);
+    }
+    spi->RemainingBytes = 0;
+    // like the real handler the device is idle again before the callback runs
+    spi->IsBusy = FALSE;
+    mock_bsp_interrupt(spi_config.IntrId);
+  }
+  return NULL;
+}
+
+int XSetupInterruptSystem(void *DriverInstance, void *IntrHandler, u32 IntrId,
+                          UINTPTR IntcParent, u16 Priority) {
+  (void)IntcParent;
+  (void)Priority;
+  if (DriverInstance == NULL || IntrHandler == NULL) {
+    return XST_FAILURE;
+  }
+  pthread_mutex_lock(&irq_lock);
+  size_t slot = 0;
+  while (slot < num_interrupts && interrupts[slot].id != IntrId) {
+    slot++;
+  }
+  if (slot == MOCK_BSP_MAX_INTERRUPTS) {
+    pthread_mutex_unlock(&irq_lock);
+    return XST_FAILURE;
+  }
+  interrupts[slot].id = IntrId;
+  interrupts[slot].handler = (void (*)(void *))IntrHandler;
+  interrupts[slot].instance = DriverInstance;
+  if (slot == num_interrupts) {
+    num_interrupts++;
+  }
+  if (!irq_thread_running) {
+    if (pthread_create(&irq_thread, NULL, mock_bsp_irq_thread, NULL) != 0) {
+      pthread_mutex_unlock(&irq_lock);
+      return XST_FAILURE;
+    }
+    pthread_detach(irq_thread);
+    irq_thread_running = true;
+  }
+  pthread_mutex_unlock(&irq_lock);
+  return XST_SUCCESS;
+}
+
+/*************************************************
+  PL330 DMA
+**************************************************/
+
+static XDmaPs_Config dma_config = {
+    .Name = "dmac_s",
+    .BaseAddress = XPAR_XDMAPS_0_BASEADDR,
+    .IntrId = {0x400d, 0x400e, 0x400f, 0x4010, 0x4011, 0x4028, 0x4029, 0x402a,
+               0x402b},
+    .IntrParent = 0xf8f01000};
+
+static struct {
+  u32 interrupt_enable; // INTEN, the other events wake a DMAWFE
+  u32 interrupt_status; // INTSTATUS
+  u32 events;           // signalled and not waited for yet
+  u32 debug_instruction;
+} dmac;
+
+// a channel thread, it runs until it waits for an event or ends
+typedef struct {
+  XDmaPs *dma;
+  const u8 *program;
+  size_t length;
+  size_t pc;
+  u32 sar, dar, ccr;
+  u32 loop[2];
+  // loaded and not stored yet, the PL330's MFIFO
+  u8 data[16 * 16];
+  size_t loaded;
+  bool active;  // started, not ended or killed
+  int waiting;  // the event of the DMAWFE it is parked in, -1 if it can run
+  bool to_fifo; // stored into the TX FIFO, its end is the end of a transfer
+} mock_dma_channel;
+
+static mock_dma_channel channels[XDMAPS_CHANNELS_PER_DEV];
+
+XDmaPs_Config *XDmaPs_LookupConfig(UINTPTR BaseAddress) {
+  return BaseAddress == dma_config.BaseAddress ? &dma_config : NULL;
+}
+
+int XDmaPs_CfgInitialize(XDmaPs *InstPtr, XDmaPs_Config *Config,
+                         UINTPTR EffectiveAddr) {
+  if (InstPtr == NULL || Config == NULL) {
+    return XST_FAILURE;
+  }
+  *InstPtr = (XDmaPs){0};
+  InstPtr->Config = *Config;
+  InstPtr->Config.BaseAddress = EffectiveAddr;
+  InstPtr->IsReady = XIL_COMPONENT_IS_READY;
+  return XST_SUCCESS;
+}
+
+int XDmaPs_Start(XDmaPs *InstPtr, unsigned int Channel, XDmaPs_Cmd *Cmd,
+                 int HoldDmaProg) {
+  (void)HoldDmaProg;
+  if (InstPtr == NULL || Cmd == NULL || InstPtr->IsReady == 0 ||
+      Channel >= XDMAPS_CHANNELS_PER_DEV) {
+    return XST_FAILURE;
+  }
+  if (Cmd->UserDmaProg == NULL || Cmd->UserDmaProgLength <= 0) {
+    return XST_FAILURE; // only programs of the caller's own are modelled
+  }
+  if (XDmaPs_IsActive(InstPtr, Channel)) {
+    return XST_DEVICE_BUSY;
+  }
+  InstPtr->Chans[Channel].DmaCmdToHw = Cmd;
+  // as the real driver, the channel's event is its done interrupt
+  dmac.interrupt_enable |= 1U << Channel;
+
+  pthread_mutex_lock(&irq_lock);
+  if (channels[Channel].active) {
+    pthread_mutex_unlock(&irq_lock);
+    mock_bsp_fail("channel %u started while its thread still runs", Channel);
+  }
+  channels[Channel] = (mock_dma_channel){
+      .dma = InstPtr,
+      .program = Cmd->UserDmaProg,
+      .length = (size_t)Cmd->UserDmaProgLength,
+      .active = true,
+      .waiting = -1};
+  dma_tx_room = 0;
+  pending_dma = true;
+  pthread_cond_broadcast(&irq_cond);
+  pthread_mutex_unlock(&irq_lock);
+  return XST_SUCCESS;
+}
+
+int XDmaPs_IsActive(XDmaPs *InstPtr, unsigned int Channel) {
+  return InstPtr->Chans[Channel].DmaCmdToHw != NULL;
+}
+
+int XDmaPs_SetDoneHandler(XDmaPs *InstPtr, unsigned Channel,
+                          XDmaPsDoneHandler DoneHandler, void *CallbackRef) {
+  if (InstPtr == NULL || Channel >= XDMAPS_CHANNELS_PER_DEV) {
+    return XST_FAILURE;
+  }
+  InstPtr->Chans[Channel].DoneHandler = DoneHandler;
+  InstPtr->Chans[Channel].DoneRef = CallbackRef;
+  return XST_SUCCESS;
+}
+
+static void mock_bsp_dma_done(XDmaPs *InstPtr, unsigned channel_number) {
+  u32 bit = 1U << channel_number;
+  if ((dmac.interrupt_status & bit) == 0) {
+    return;
+  }
+  dmac.interrupt_status &= ~bit;
+  XDmaPs_ChannelData *channel = &InstPtr->Chans[channel_number];
+  XDmaPs_Cmd *command = channel->DmaCmdToHw;
+  if (command == NULL) {
+    return;
+  }
+  channel->DmaCmdToHw = NULL;
+  if (channel->DoneHandler != NULL) {
+    channel->DoneHandler(channel_number, command, channel->DoneRef);
+  }
+}
+
+void XDmaPs_DoneISR_0(XDmaPs *InstPtr) { mock_bsp_dma_done(InstPtr, 0); }
+
+void XDmaPs_DoneISR_1(XDmaPs *InstPtr) { mock_bsp_dma_done(InstPtr, 1); }
+
+static void mock_bsp_dma_event(unsigned event) {
+  u32 bit = 1U << event;
+  if (dmac.interrupt_enable & bit) {
+    dmac.interrupt_status |= bit;
+    mock_bsp_interrupt(dma_config.IntrId[event + 1]);
+    if (dmac.interrupt_status & bit) {
+      mock_bsp_fail("the interrupt of event %u was not cleared", event);
+    }
+    return;
+  }
+  pthread_mutex_lock(&irq_lock);
+  // a channel parked in its DMAWFE goes on, otherwise the event is latched
+  for (unsigned i = 0; i < XDMAPS_CHANNELS_PER_DEV; i++) {
+    if (channels[i].active && channels[i].waiting == (int)event) {
+      channels[i].waiting = -1;
+      pthread_mutex_unlock(&irq_lock);
+      return;
+    }
+  }
+  bool again = (dmac.events & bit) != 0;
+  dmac.events |= bit;
+  pthread_mutex_unlock(&irq_lock);
+  if (again) {
+    mock_bsp_fail("event %u signalled again before a DMAWFE took it", event);
+  }
+}
+
+u32 XDmaPs_ReadReg(UINTPTR BaseAddress, u32 RegOffset) {
+  (void)BaseAddress;
+  switch (RegOffset) {
+  case XDMAPS_INTEN_OFFSET:
+    return dmac.interrupt_enable;
+  case XDMAPS_INTSTATUS_OFFSET:
+    return dmac.interrupt_status;
+  default:
+    return 0; // the debug interface is never busy
+  }
+}
+
+void XDmaPs_WriteReg(UINTPTR BaseAddress, u32 RegOffset, u32 RegisterValue) {
+  (void)BaseAddress;
+  switch (RegOffset) {
+  case XDMAPS_INTEN_OFFSET:
+    dmac.interrupt_enable = RegisterValue;
+    break;
+  case XDMAPS_INTCLR_OFFSET:
+    dmac.interrupt_status &= ~RegisterValue;
+    break;
+  case XDMAPS_DBGINST0_OFFSET:
+    dmac.debug_instruction = RegisterValue;
+    break;
+  case XDMAPS_DBGCMD_OFFSET: {
+    // DMASEV on the manager thread or DMAKILL of a channel thread
+    u32 opcode = (dmac.debug_instruction >> 16) & 0xFFU;
+    bool channel_thread = (dmac.debug_instruction & 0x1U) != 0;
+    if (opcode == 0x34U && !channel_thread) {
+      mock_bsp_dma_event((dmac.debug_instruction >> 27) & 0x1FU);
+    } else if (opcode == 0x01U && channel_thread) {
+      pthread_mutex_lock(&irq_lock);
+      channels[(dmac.debug_instruction >> 8) & 0x7U].active = false;
+      pthread_mutex_unlock(&irq_lock);
+    } else {
+      mock_bsp_fail("debug instruction 0x%08x is not modelled",
+                    dmac.debug_instruction);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+static u32 mock_bsp_dma_imm32(const u8 *bytes) {
+  return (u32)bytes[0] | (u32)bytes[1] << 8 | (u32)bytes[2] << 16 |
+         (u32)bytes[3] << 24;
+}
+
+// runs channel number until it parks in a DMAWFE or ends
+static void mock_bsp_dma_execute(unsigned number) {
+  mock_dma_channel *ch = &channels[number];
+  const u8 *program = ch->program;
+  UINTPTR tx_fifo = spi_config.BaseAddress + XSPIPS_TXD_OFFSET;
+  UINTPTR enable = spi_config.BaseAddress + XSPIPS_IER_OFFSET;
+
+  for (;;) {
+    size_t pc = ch->pc;
+    if (pc >= ch->length) {
+      mock_bsp_fail("the program runs past its end at %u", (unsigned)pc);
+    }
+    u8 op = program[pc];
+    u32 ccr = ch->ccr;
+    if (op == 0x00) { // DMAEND
+      break;
+    } else if (op == 0x04) { // DMALD
+      size_t n = (((ccr >> 4) & 0xFU) + 1U) << ((ccr >> 1) & 0x7U);
+      if (ch->loaded + n > sizeof(ch->data)) {
+        mock_bsp_fail("DMALD of %u bytes overflows the MFIFO", (unsigned)n);
+      }
+      memcpy(&ch->data[ch->loaded], (const u8 *)(UINTPTR)ch->sar, n);
+      ch->loaded += n;
+      ch->sar += (ccr & 0x1U) ? (u32)n : 0;
+      ch->pc += 1;
+    } else if (op == 0x08) { // DMAST
+      size_t n = (((ccr >> 18) & 0xFU) + 1U) << ((ccr >> 15) & 0x7U);
+      if (n > ch->loaded || (ccr & (1U << 14))) {
+        mock_bsp_fail("DMAST at %u is not a fixed address store of loaded "
+                      "data",
+                      (unsigned)pc);
+      }
+      if (ch->dar == (u32)enable && n == 4 && ((ccr >> 15) & 0x7U) == 2) {
+        XSpiPs_WriteReg(spi_config.BaseAddress, XSPIPS_IER_OFFSET,
+                        mock_bsp_dma_imm32(ch->data));
+      } else if (ch->dar == (u32)tx_fifo && ((ccr >> 15) & 0x7U) == 0) {
+        if (n > dma_tx_room) {
+          mock_bsp_fail("DMAST at %u overruns the TX FIFO", (unsigned)pc);
+        }
+        dma_tx_room -= (u32)n;
+        mock_bsp_spi_shift(ch->data, (u32)n);
+        ch->to_fifo = true;
+      } else {
+        mock_bsp_fail("DMAST at %u is neither byte wide into the TX FIFO nor "
+                      "a word into the interrupt enable register",
+                      (unsigned)pc);
+      }
+      memmove(ch->data, &ch->data[n], ch->loaded - n);
+      ch->loaded -= n;
+      ch->pc += 1;
+    } else if (op == 0x12 || op == 0x13 || op == 0x18) { // RMB, WMB, NOP
+      ch->pc += 1;
+    } else if ((op & 0xFDU) == 0x20) { // DMALP
+      ch->loop[(op >> 1) & 0x1U] = program[pc + 1];
+      ch->pc += 2;
+    } else if ((op & 0xFBU) == 0x38) { // DMALPEND
+      unsigned counter = (op >> 2) & 0x1U;
+      if (ch->loop[counter] != 0) {
+        ch->loop[counter]--;
+        ch->pc -= program[pc + 1];
+      } else {
+        ch->pc += 2;
+      }
+    } else if (op == 0x34) { // DMASEV
+      ch->pc += 2;
+      mock_bsp_dma_event(program[pc + 1] >> 3);
+    } else if (op == 0x36) { // DMAWFE, parks the channel unless latched
+      unsigned event = program[pc + 1] >> 3;
+      ch->pc += 2;
+      pthread_mutex_lock(&irq_lock);
+      bool latched = (dmac.events & (1U << event)) != 0;
+      dmac.events &= ~(1U << event);
+      if (!latched) {
+        ch->waiting = (int)event;
+      }
+      pthread_mutex_unlock(&irq_lock);
+      if (!latched) {
+        return;
+      }
+    } else if (op == 0x54 || op == 0x56) { // DMAADDH to SAR or DAR
+      u32 value = (u32)program[pc + 1] | (u32)program[pc + 2] << 8;
+      *(op == 0x54 ? &ch->sar : &ch->dar) += value;
+      ch->pc += 3;
+    } else if (op == 0xBC) { // DMAMOV
+      u32 value = mock_bsp_dma_imm32(&program[pc + 2]);
+      switch (program[pc + 1]) {
+      case 0:
+        ch->sar = value;
+        break;
+      case 1:
+        ch->ccr = value;
+        break;
+      case 2:
+        ch->dar = value;
+        break;
+      default:
+        mock_bsp_fail("DMAMOV to register %u", program[pc + 1]);
+      }
+      ch->pc += 6;
+    } else {
+      mock_bsp_fail("instruction 0x%02x is not modelled", op);
+    }
+  }
+  if (ch->loaded != 0 || XDmaPs_IsActive(ch->dma, number)) {
+    mock_bsp_fail("channel %u ended with data left or without its done "
+                  "interrupt",
+                  number);
+  }
+  bool to_fifo = ch->to_fifo;
+  pthread_mutex_lock(&irq_lock);
+  ch->active = false;
+  pthread_mutex_unlock(&irq_lock);
+  if (to_fifo) {
+    mock_bsp_spi_shift_last();
+    // the interrupts the end of the program turned on
+    mock_bsp_spi_levels();
+  }
+}
+
+/*
+Runs the started channels until none is left. When they all wait for an event
+the interrupts that are due run. With nothing due the main thread may still
+turn the SPI interrupt on (after XDmaPs_Start() returned), anything else is a
+program that hangs on the board.
+*/
+static void mock_bsp_dma_schedule(void) {
+  for (;;) {
+    bool active = false, ran = false;
+    for (unsigned i = 0; i < XDMAPS_CHANNELS_PER_DEV; i++) {
+      pthread_mutex_lock(&irq_lock);
+      bool runnable = channels[i].active && channels[i].waiting < 0;
+      pthread_mutex_unlock(&irq_lock);
+      if (runnable) {
+        mock_bsp_dma_execute(i);
+        ran = true;
+      }
+    }
+    int waiting = -1;
+    pthread_mutex_lock(&irq_lock);
+    for (unsigned i = 0; i < XDMAPS_CHANNELS_PER_DEV; i++) {
+      active |= channels[i].active;
+      if (channels[i].active && waiting < 0) {
+        waiting = channels[i].waiting;
+      }
+    }
+    pthread_mutex_unlock(&irq_lock);
+    if (!active) {
+      return;
+    }
+    if (ran) {
+      continue;
+    }
+    mock_bsp_spi_levels();
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 5;
+    pthread_mutex_lock(&irq_lock);
+    int waited = 0;
+    for (;;) {
+      bool runnable = false;
+      for (unsigned i = 0; i < XDMAPS_CHANNELS_PER_DEV; i++) {
+        runnable |= channels[i].active && channels[i].waiting < 0;
+      }
+      if (runnable ||
+          (atomic_load(&spi_interrupt_mask) & XSPIPS_IXR_TXOW_MASK) ||
+          waited != 0) {
+        break;
+      }
+      waited = pthread_cond_timedwait(&irq_cond, &irq_lock, &deadline);
+    }
+    pthread_mutex_unlock(&irq_lock);
+    if (waited != 0) {
+      mock_bsp_fail("DMAWFE of event %u is never woken up", (unsigned)waiting);
+    }
+  }
+}
@@ -0,0 +1,29 @@
+#ifndef MOCK_BSP_H
+#define MOCK_BSP_H
+/****************************************************************************
+Host stand-in for the parts of the Xilinx standalone BSP the ZLCD driver uses.
+Everything that would reach the AXI GPIO pins or the SPI0 bus is handed to the
+hooks below instead, normally an ST7789 emulator (see st7789_emulator.h).
+*****************************************************************************/
+
+#include <xil_types.h>
+
+typedef struct {
+  void (*gpio_write)(void *context, u32 value);
+  u32 (*gpio2_read)(void *context); // AXI GPIO channel 2 inputs, 0 if NULL
+  // one chip select framed SPI transfer, the bytes may come in several calls
+  void (*spi_begin)(void *context);
+  void (*spi_write)(void *context, const u8 *bytes, u32 num_bytes);
+  void (*spi_end)(void *context);
+  // XTime_GetTime() in COUNTS_PER_SECOND ticks, CLOCK_MONOTONIC if NULL
+  u64 (*time)(void *context);
+  void *context;
+} mock_bsp_hooks;
+
+// hooks may be NULL, whatever is sent is then dropped
+void mock_bsp_set_hooks(const mock_bsp_hooks *hooks);
+
+// total time the driver asked msleep() for, nothing actually waits
+unsigned long mock_bsp_slept_ms(void);
+
+#endif // MOCK_BSP_H
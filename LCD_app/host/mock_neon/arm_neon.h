@@ -0,0 +1,220 @@
+#ifndef MOCK_ARM_NEON_H
+#define MOCK_ARM_NEON_H
+/****************************************************************************
+Host stand-in for <arm_neon.h>, covering the intrinsics the ZLCD kernels use.
+The vector types are GCC vector extensions with the lanes in the same order,
+so a kernel source built with -D__ARM_NEON and this directory on the include
+path computes what it computes on the Cortex-A9, only slower. Only for the
+host tests that check the NEON kernels against their scalar versions.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t uint8x8_t __attribute__((vector_size(8)));
+typedef uint8_t uint8x16_t __attribute__((vector_size(16)));
+typedef uint16_t uint16x8_t __attribute__((vector_size(16)));
+typedef uint32_t uint32x4_t __attribute__((vector_size(16)));
+
+typedef struct {
+  uint8x8_t val[4];
+} uint8x8x4_t;
+typedef struct {
+  uint8x16_t val[2];
+} uint8x16x2_t;
+typedef struct {
+  uint8x16_t val[3];
+} uint8x16x3_t;
+typedef struct {
+  uint8x16_t val[4];
+} uint8x16x4_t;
+
+/*************************************************
+  loads and stores
+**************************************************/
+
+static inline uint8x8_t vld1_u8(const uint8_t *p) {
+  uint8x8_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint8x16_t vld1q_u8(const uint8_t *p) {
+  uint8x16_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint16x8_t vld1q_u16(const uint16_t *p) {
+  uint16x8_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint32x4_t vld1q_u32(const uint32_t *p) {
+  uint32x4_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void vst1q_u8(uint8_t *p, uint8x16_t v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+static inline void vst1q_u16(uint16_t *p, uint16x8_t v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+static inline void vst1q_u32(uint32_t *p, uint32x4_t v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+// de-interleaving load, element i of val[k] is p[4 * i + k]
+static inline uint8x16x4_t vld4q_u8(const uint8_t *p) {
+  uint8x16x4_t v;
+  for (int i = 0; i < 16; i++) {
+    for (int k = 0; k < 4; k++) {
+      v.val[k][i] = p[4 * i + k];
+    }
+  }
+  return v;
+}
+
+// interleaving store, p[2 * i + k] is element i of val[k]
+static inline void vst2q_u8(uint8_t *p, uint8x16x2_t v) {
+  for (int i = 0; i < 16; i++) {
+    for (int k = 0; k < 2; k++) {
+      p[2 * i + k] = v.val[k][i];
+    }
+  }
+}
+
+static inline void vst3q_u8(uint8_t *p, uint8x16x3_t v) {
+  for (int i = 0; i < 16; i++) {
+    for (int k = 0; k < 3; k++) {
+      p[3 * i + k] = v.val[k][i];
+    }
+  }
+}
+
+/*************************************************
+  lane-wise arithmetic, wrapping like the hardware
+**************************************************/
+
+static inline uint8x8_t vdup_n_u8(uint8_t value) {
+  return (uint8x8_t){0} + value;
+}
+
+static inline uint8x16_t vdupq_n_u8(uint8_t value) {
+  return (uint8x16_t){0} + value;
+}
+
+static inline uint16x8_t vdupq_n_u16(uint16_t value) {
+  return (uint16x8_t){0} + value;
+}
+
+static inline uint32x4_t vdupq_n_u32(uint32_t value) {
+  return (uint32x4_t){0} + value;
+}
+
+static inline uint8x16_t vaddq_u8(uint8x16_t a, uint8x16_t b) { return a + b; }
+static inline uint8x8_t vsub_u8(uint8x8_t a, uint8x8_t b) { return a - b; }
+static inline uint8x16_t vandq_u8(uint8x16_t a, uint8x16_t b) { return a & b; }
+static inline uint8x16_t vorrq_u8(uint8x16_t a, uint8x16_t b) { return a | b; }
+
+static inline uint8x16_t vminq_u8(uint8x16_t a, uint8x16_t b) {
+  uint8x16_t a_smaller = (uint8x16_t)(a < b);
+  return (a & a_smaller) | (b & ~a_smaller);
+}
+
+static inline uint16x8_t vandq_u16(uint16x8_t a, uint16x8_t b) {
+  return a & b;
+}
+
+static inline uint16x8_t vorrq_u16(uint16x8_t a, uint16x8_t b) {
+  return a | b;
+}
+
+// a and not b
+static inline uint16x8_t vbicq_u16(uint16x8_t a, uint16x8_t b) {
+  return a & ~b;
+}
+
+static inline uint16x8_t vmulq_u16(uint16x8_t a, uint16x8_t b) {
+  return a * b;
+}
+
+// a + b * c
+static inline uint16x8_t vmlaq_u16(uint16x8_t a, uint16x8_t b, uint16x8_t c) {
+  return a + b * c;
+}
+
+// all ones where equal
+static inline uint16x8_t vceqq_u16(uint16x8_t a, uint16x8_t b) {
+  return (uint16x8_t)(a == b);
+}
+
+// bits of a where mask is set, of b elsewhere
+static inline uint16x8_t vbslq_u16(uint16x8_t mask, uint16x8_t a,
+                                   uint16x8_t b) {
+  return (mask & a) | (~mask & b);
+}
+
+static inline uint32x4_t veorq_u32(uint32x4_t a, uint32x4_t b) {
+  return a ^ b;
+}
+
+static inline uint32x4_t vmulq_n_u32(uint32x4_t a, uint32_t b) { return a * b; }
+
+// the shift counts are immediates on the hardware, constants here as well
+#define vshlq_n_u8(a, n) ((uint8x16_t)((a) << (n)))
+#define vshrq_n_u8(a, n) ((uint8x16_t)((a) >> (n)))
+#define vshlq_n_u16(a, n) ((uint16x8_t)((a) << (n)))
+#define vshrq_n_u16(a, n) ((uint16x8_t)((a) >> (n)))
+#define vshrq_n_u32(a, n) ((uint32x4_t)((a) >> (n)))
+
+static inline uint32x4_t vreinterpretq_u32_u8(uint8x16_t v) {
+  return (uint32x4_t)v;
+}
+
+/*************************************************
+  halves and table lookups
+**************************************************/
+
+static inline uint8x8_t vget_low_u8(uint8x16_t v) {
+  uint8x8_t half;
+  memcpy(&half, &v, sizeof(half));
+  return half;
+}
+
+static inline uint8x8_t vget_high_u8(uint8x16_t v) {
+  uint8x8_t half;
+  memcpy(&half, (const uint8_t *)&v + sizeof(half), sizeof(half));
+  return half;
+}
+
+static inline uint8x16_t vcombine_u8(uint8x8_t low, uint8x8_t high) {
+  uint8x16_t v;
+  memcpy(&v, &low, sizeof(low));
+  memcpy((uint8_t *)&v + sizeof(low), &high, sizeof(high));
+  return v;
+}
+
+// element i is byte index[i] of the 32 byte table, or fallback[i] past its end
+static inline uint8x8_t vtbx4_u8(uint8x8_t fallback, uint8x8x4_t table,
+                                 uint8x8_t index) {
+  uint8x8_t v = fallback;
+  for (int i = 0; i < 8; i++) {
+    if (index[i] < 32) {
+      v[i] = table.val[index[i] / 8][index[i] % 8];
+    }
+  }
+  return v;
+}
+
+// vtbx4_u8() with 0 past the end of the table
+static inline uint8x8_t vtbl4_u8(uint8x8x4_t table, uint8x8_t index) {
+  return vtbx4_u8(vdup_n_u8(0), table, index);
+}
+
+#endif // MOCK_ARM_NEON_H
@@ -0,0 +1,404 @@
+#include "st7789_emulator.h"
+#include <stdio.h>
+#include <string.h>
+
+/*************************************************
+  ST7789 controller model for host builds
+**************************************************/
+
+#define ST7789_MADCTL_MY 0x80U
+#define ST7789_MADCTL_MX 0x40U
+#define ST7789_MADCTL_MV 0x20U
+#define ST7789_MADCTL_BGR 0x08U
+
+#define ST7789_EMU_FNV_OFFSET 2166136261U
+#define ST7789_EMU_FNV_PRIME 16777619U
+
+// state after a hardware reset or SWRESET (0x01), the panel RAM is kept
+static void st7789_emu_reset_registers(st7789_emu *emu) {
+  emu->sleeping = true;
+  emu->display_on = false;
+  emu->inverted = false;
+  emu->madctl = 0x00;
+  emu->colmod = 0x66; // 18 bit is the power on default
+  emu->col_start = 0;
+  emu->col_end = ST7789_EMU_RAM_WIDTH - 1;
+  emu->row_start = 0;
+  emu->row_end = ST7789_EMU_RAM_HEIGHT - 1;
+  emu->scroll_top = 0;
+  emu->scroll_height = ST7789_EMU_RAM_HEIGHT;
+  emu->scroll_bottom = 0;
+  emu->scroll_start = 0;
+  emu->command = -1;
+  emu->num_parameters = 0;
+  emu->pointer_col = 0;
+  emu->pointer_row = 0;
+  emu->num_pixel_bytes = 0;
+  emu->te_on = false;
+}
+
+void st7789_emu_init(st7789_emu *emu) {
+  memset(emu, 0, sizeof(*emu));
+  st7789_emu_reset_registers(emu);
+  st7789_emu_reset_stats(emu);
+}
+
+void st7789_emu_reset_stats(st7789_emu *emu) {
+  memset(&emu->stats, 0, sizeof(emu->stats));
+  emu->stats.wire_hash = ST7789_EMU_FNV_OFFSET;
+}
+
+void st7789_emu_set_timing(st7789_emu *emu, const st7789_emu_timing *timing) {
+  emu->timing = *timing;
+  emu->time_ns = 0;
+}
+
+void st7789_emu_advance(st7789_emu *emu, uint64_t nanoseconds) {
+  emu->time_ns += nanoseconds;
+}
+
+static uint64_t st7789_emu_frame_ns(const st7789_emu *emu) {
+  return (uint64_t)(emu->timing.blank_lines + ST7789_EMU_RAM_HEIGHT) *
+         emu->timing.line_ns;
+}
+
+uint64_t st7789_emu_frame(const st7789_emu *emu) {
+  uint64_t frame_ns = st7789_emu_frame_ns(emu);
+  return frame_ns != 0 ? emu->time_ns / frame_ns : 0;
+}
+
+bool st7789_emu_te(const st7789_emu *emu) {
+  uint64_t frame_ns = st7789_emu_frame_ns(emu);
+  return emu->te_on && frame_ns != 0 &&
+         emu->time_ns % frame_ns <
+             (uint64_t)emu->timing.blank_lines * emu->timing.line_ns;
+}
+
+// line the panel shows RAM row y on, the inverse of the scrolling below
+static uint16_t st7789_emu_line_of_row(const st7789_emu *emu, uint16_t y) {
+  uint32_t top = emu->scroll_top;
+  uint32_t height = emu->scroll_height;
+  if (height != 0 && top + height <= ST7789_EMU_RAM_HEIGHT && y >= top &&
+      y < top + height && emu->scroll_start >= top &&
+      emu->scroll_start < top + height) {
+    return (uint16_t)(top + (y - emu->scroll_start + height) % height);
+  }
+  return y;
+}
+
+// first frame whose scan of RAM row y starts after now
+static void st7789_emu_time_pixel(st7789_emu *emu, uint16_t y) {
+  uint64_t frame_ns = st7789_emu_frame_ns(emu);
+  if (frame_ns == 0) {
+    return;
+  }
+  uint64_t scan_ns = (uint64_t)(emu->timing.blank_lines +
+                                st7789_emu_line_of_row(emu, y)) *
+                     emu->timing.line_ns;
+  uint64_t frame = emu->time_ns <= scan_ns
+                       ? 0
+                       : (emu->time_ns - scan_ns + frame_ns - 1) / frame_ns;
+  st7789_emu_stats *stats = &emu->stats;
+  if (stats->timed_pixels++ == 0) {
+    stats->first_frame = frame;
+    stats->last_frame = frame;
+  } else if (frame < stats->first_frame) {
+    stats->first_frame = frame;
+  } else if (frame > stats->last_frame) {
+    stats->last_frame = frame;
+  }
+}
+
+void st7789_emu_gpio(st7789_emu *emu, uint32_t value) {
+  bool dc = (value >> ST7789_EMU_GPIO_DC) & 0x1;
+  bool in_reset = ((value >> ST7789_EMU_GPIO_RESET) & 0x1) == 0; // active low
+  if (dc != emu->dc) {
+    emu->stats.dc_toggles++;
+    emu->dc = dc;
+  }
+  if (emu->in_reset && !in_reset) {
+    st7789_emu_reset_registers(emu);
+  }
+  emu->in_reset = in_reset;
+}
+
+void st7789_emu_spi_begin(st7789_emu *emu) { emu->stats.transfers++; }
+
+// command and parameters travel in separate transfers, nothing to do here
+void st7789_emu_spi_end(st7789_emu *emu) { (void)emu; }
+
+/*
+The write pointer walks the CASET/RASET window in the MADCTL address space.
+MV exchanges the column and row counters, MX and MY then mirror the physical
+column and row, which is how the datasheet's rotation table comes out.
+*/
+static void st7789_emu_store_pixel(st7789_emu *emu, uint8_t red,
+                                   uint8_t green, uint8_t blue) {
+  uint16_t x = emu->pointer_col;
+  uint16_t y = emu->pointer_row;
+  if (emu->madctl & ST7789_MADCTL_MV) {
+    uint16_t temp = x;
+    x = y;
+    y = temp;
+  }
+  if (x < ST7789_EMU_RAM_WIDTH && y < ST7789_EMU_RAM_HEIGHT) {
+    if (emu->madctl & ST7789_MADCTL_MX) {
+      x = ST7789_EMU_RAM_WIDTH - 1 - x;
+    }
+    if (emu->madctl & ST7789_MADCTL_MY) {
+      y = ST7789_EMU_RAM_HEIGHT - 1 - y;
+    }
+    if (emu->madctl & ST7789_MADCTL_BGR) {
+      uint8_t temp = red;
+      red = blue;
+      blue = temp;
+    }
+    emu->ram[y][x][0] = red;
+    emu->ram[y][x][1] = green;
+    emu->ram[y][x][2] = blue;
+    st7789_emu_time_pixel(emu, y);
+  }
+  emu->stats.pixels++;
+
+  // past the end of the window the pointer wraps back to its start
+  if (emu->pointer_col >= emu->col_end) {
+    emu->pointer_col = emu->col_start;
+    emu->pointer_row =
+        emu->pointer_row >= emu->row_end ? emu->row_start : emu->pointer_row + 1;
+  } else {
+    emu->pointer_col++;
+  }
+}
+
+static uint8_t st7789_emu_expand(uint8_t value, unsigned bits) {
+  return (uint8_t)((value << (8 - bits)) | (value >> (2 * bits - 8)));
+}
+
+static void st7789_emu_pixel_byte(st7789_emu *emu, uint8_t byte) {
+  emu->stats.pixel_bytes++;
+  emu->pixel_bytes[emu->num_pixel_bytes++] = byte;
+  const uint8_t *b = emu->pixel_bytes;
+
+  switch (emu->colmod & 0x07) {
+  case 0x05: // RGB565, 2 bytes per pixel
+    if (emu->num_pixel_bytes < 2) {
+      return;
+    }
+    st7789_emu_store_pixel(emu, st7789_emu_expand(b[0] >> 3, 5),
+                           st7789_emu_expand(((b[0] & 0x07) << 3) | b[1] >> 5,
+                                             6),
+                           st7789_emu_expand(b[1] & 0x1F, 5));
+    break;
+  case 0x03: // RGB444, 3 bytes for 2 pixels
+    if (emu->num_pixel_bytes < 3) {
+      return;
+    }
+    st7789_emu_store_pixel(emu, (b[0] >> 4) * 17, (b[0] & 0x0F) * 17,
+                           (b[1] >> 4) * 17);
+    st7789_emu_store_pixel(emu, (b[1] & 0x0F) * 17, (b[2] >> 4) * 17,
+                           (b[2] & 0x0F) * 17);
+    break;
+  default: // RGB666, 3 bytes per pixel with the 6 bits at the top
+    if (emu->num_pixel_bytes < 3) {
+      return;
+    }
+    st7789_emu_store_pixel(emu, st7789_emu_expand(b[0] >> 2, 6),
+                           st7789_emu_expand(b[1] >> 2, 6),
+                           st7789_emu_expand(b[2] >> 2, 6));
+    break;
+  }
+  emu->num_pixel_bytes = 0;
+}
+
+static uint16_t st7789_emu_parameter16(const st7789_emu *emu, size_t index) {
+  return (uint16_t)(emu->parameters[index] << 8 | emu->parameters[index + 1]);
+}
+
+// applies a command once all of its parameters have arrived
+static void st7789_emu_parameter_byte(st7789_emu *emu, uint8_t byte) {
+  emu->stats.parameter_bytes++;
+  if (emu->num_parameters >= sizeof(emu->parameters)) {
+    return;
+  }
+  emu->parameters[emu->num_parameters++] = byte;
+
+  switch (emu->command) {
+  case 0x2A: // CASET
+    if (emu->num_parameters == 4) {
+      emu->col_start = st7789_emu_parameter16(emu, 0);
+      emu->col_end = st7789_emu_parameter16(emu, 2);
+    }
+    break;
+  case 0x2B: // RASET
+    if (emu->num_parameters == 4) {
+      emu->row_start = st7789_emu_parameter16(emu, 0);
+      emu->row_end = st7789_emu_parameter16(emu, 2);
+    }
+    break;
+  case 0x33: // VSCRDEF
+    if (emu->num_parameters == 6) {
+      emu->scroll_top = st7789_emu_parameter16(emu, 0);
+      emu->scroll_height = st7789_emu_parameter16(emu, 2);
+      emu->scroll_bottom = st7789_emu_parameter16(emu, 4);
+    }
+    break;
+  case 0x36: // MADCTL
+    emu->madctl = byte;
+    break;
+  case 0x37: // VSCSAD
+    if (emu->num_parameters == 2) {
+      emu->scroll_start = st7789_emu_parameter16(emu, 0);
+    }
+    break;
+  case 0x3A: // COLMOD
+    emu->colmod = byte;
+    break;
+  default:
+    break; // power, gamma and porch settings do not change the picture
+  }
+}
+
+static void st7789_emu_command_byte(st7789_emu *emu, uint8_t command) {
+  emu->stats.commands++;
+  emu->command = command;
+  emu->num_parameters = 0;
+  emu->num_pixel_bytes = 0;
+
+  switch (command) {
+  case 0x00: // NOP
+    break;
+  case 0x01: // SWRESET
+    st7789_emu_reset_registers(emu);
+    break;
+  case 0x10: // SLPIN
+    emu->sleeping = true;
+    break;
+  case 0x11: // SLPOUT
+    emu->sleeping = false;
+    break;
+  case 0x20: // INVOFF
+    emu->inverted = false;
+    break;
+  case 0x21: // INVON
+    emu->inverted = true;
+    break;
+  case 0x28: // DISPOFF
+    emu->display_on = false;
+    break;
+  case 0x29: // DISPON
+    emu->display_on = true;
+    break;
+  case 0x2C: // RAMWR
+    emu->pointer_col = emu->col_start;
+    emu->pointer_row = emu->row_start;
+    break;
+  case 0x3C: // RAMWRC carries on from wherever the last write stopped
+    break;
+  case 0x34: // TEOFF
+    emu->te_on = false;
+    break;
+  case 0x35: // TEON, the mode parameter only adds the horizontal pulses
+    emu->te_on = true;
+    break;
+  case 0x12: // PTLON
+  case 0x13: // NORON
+  case 0x2A: // CASET
+  case 0x2B: // RASET
+  case 0x33: // VSCRDEF
+  case 0x36: // MADCTL
+  case 0x37: // VSCSAD
+  case 0x38: // IDMOFF
+  case 0x39: // IDMON
+  case 0x3A: // COLMOD
+  case 0x44: // STE
+  case 0x51: // WRDISBV
+  case 0xB2: // PORCTRL
+  case 0xB7: // GCTRL
+  case 0xBB: // VCOMS
+  case 0xC0: // LCMCTRL
+  case 0xC2: // VDVVRHEN
+  case 0xC3: // VRHS
+  case 0xC4: // VDVS
+  case 0xC6: // FRCTRL2
+  case 0xD0: // PWCTRL1
+  case 0xE0: // PVGAMCTRL
+  case 0xE1: // NVGAMCTRL
+    break;
+  default:
+    emu->stats.unknown_commands++;
+    break;
+  }
+}
+
+void st7789_emu_spi_write(st7789_emu *emu, const uint8_t *bytes,
+                          size_t num_bytes) {
+  for (size_t i = 0; i < num_bytes; i++) {
+    emu->time_ns += emu->timing.byte_ns; // the byte is in once it is shifted
+    emu->stats.wire_hash =
+        (emu->stats.wire_hash ^ (bytes[i] | ((uint32_t)emu->dc << 8))) *
+        ST7789_EMU_FNV_PRIME;
+    if (emu->in_reset) {
+      emu->stats.ignored_bytes++;
+      continue;
+    }
+    if (!emu->dc) {
+      st7789_emu_command_byte(emu, bytes[i]);
+    } else if (emu->command == 0x2C || emu->command == 0x3C) {
+      st7789_emu_pixel_byte(emu, bytes[i]);
+    } else if (emu->command >= 0) {
+      st7789_emu_parameter_byte(emu, bytes[i]);
+    } else {
+      emu->stats.ignored_bytes++;
+    }
+  }
+}
+
+uint32_t st7789_emu_shown_pixel(const st7789_emu *emu, uint16_t x,
+                                uint16_t y) {
+  if (x >= ST7789_EMU_RAM_WIDTH || y >= ST7789_EMU_RAM_HEIGHT ||
+      emu->sleeping || !emu->display_on) {
+    return 0x000000;
+  }
+  // vertical scrolling only moves the lines of the scroll area
+  uint32_t top = emu->scroll_top;
+  uint32_t height = emu->scroll_height;
+  if (height != 0 && top + height <= ST7789_EMU_RAM_HEIGHT && y >= top &&
+      y < top + height && emu->scroll_start >= top &&
+      emu->scroll_start < top + height) {
+    y = (uint16_t)(top + (y - top + emu->scroll_start - top) % height);
+  }
+  const uint8_t *rgb = emu->ram[y][x];
+  uint32_t colour = (uint32_t)rgb[0] << 16 | (uint32_t)rgb[1] << 8 | rgb[2];
+  // the IPS glass shows inverted colours unless INVON is set
+  return emu->inverted ? colour : ~colour & 0xFFFFFF;
+}
+
+uint32_t st7789_emu_ram_hash(const st7789_emu *emu) {
+  const uint8_t *bytes = &emu->ram[0][0][0];
+  uint32_t hash = ST7789_EMU_FNV_OFFSET;
+  for (size_t i = 0; i < sizeof(emu->ram); i++) {
+    hash = (hash ^ bytes[i]) * ST7789_EMU_FNV_PRIME;
+  }
+  return hash;
+}
+
+bool st7789_emu_write_ppm(const st7789_emu *emu, const char *path,
+                          bool visible_only) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  uint16_t x_start = visible_only ? ST7789_EMU_VISIBLE_X_OFFSET : 0;
+  uint16_t width =
+      visible_only ? ST7789_EMU_VISIBLE_WIDTH : ST7789_EMU_RAM_WIDTH;
+  fprintf(file, "P6\n%u %u\n255\n", width, ST7789_EMU_RAM_HEIGHT);
+  for (uint16_t y = 0; y < ST7789_EMU_RAM_HEIGHT; y++) {
+    for (uint16_t x = x_start; x < x_start + width; x++) {
+      uint32_t colour = st7789_emu_shown_pixel(emu, x, y);
+      uint8_t rgb[3] = {(uint8_t)(colour >> 16), (uint8_t)(colour >> 8),
+                        (uint8_t)colour};
+      fwrite(rgb, 1, sizeof(rgb), file);
+    }
+  }
+  return fclose(file) == 0;
+}
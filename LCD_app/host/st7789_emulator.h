@@ -0,0 +1,127 @@
+#ifndef ST7789_EMULATOR_H
+#define ST7789_EMULATOR_H
+/****************************************************************************
+Model of an ST7789 controller as seen from its SPI and DC pins. Decodes the
+commands the ZLCD driver uses into a 240x320 panel RAM, can dump what the
+172x320 ST7789VW glass shows to a PPM file and counts every byte on the wire.
+*****************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ST7789_EMU_RAM_WIDTH 240U
+#define ST7789_EMU_RAM_HEIGHT 320U
+// the ST7789VW glass only shows RAM columns 34 to 205
+#define ST7789_EMU_VISIBLE_X_OFFSET 34U
+#define ST7789_EMU_VISIBLE_WIDTH 172U
+
+// pins on the AXI GPIO channel, same bits as the driver's LCD_DC/LCD_RESET
+#define ST7789_EMU_GPIO_DC 0U
+#define ST7789_EMU_GPIO_RESET 1U
+
+/*
+Optional panel timing, see st7789_emu_set_timing(). The emulator then keeps a
+clock that every SPI byte moves on, scans its lines one frame after another
+(the vertical blank first) and, after TEON, drives TE high during the blank.
+*/
+typedef struct {
+  uint32_t byte_ns;     // one byte on the SPI bus
+  uint32_t line_ns;     // scanning one line
+  uint16_t blank_lines; // porches, the frame starts with them
+} st7789_emu_timing;
+
+typedef struct {
+  uint64_t transfers;       // chip select framed SPI transfers
+  uint64_t dc_toggles;      // changes of the DC pin
+  uint64_t commands;        // bytes sent with DC low
+  uint64_t parameter_bytes; // bytes sent with DC high, other than pixels
+  uint64_t pixel_bytes;     // bytes sent with DC high after RAMWR/RAMWRC
+  uint64_t pixels;          // pixels written into the panel RAM
+  uint64_t unknown_commands;
+  uint64_t ignored_bytes; // data with no command, or sent during reset
+  // FNV-1a over every byte and its DC level, equal hashes mean equal streams
+  uint32_t wire_hash;
+  /*
+  with timing: first and last frame that the pixels written show up in, a
+  group of writes (a refresh) tore if they differ. Valid if timed_pixels != 0
+  */
+  uint64_t timed_pixels;
+  uint64_t first_frame, last_frame;
+} st7789_emu_stats;
+
+typedef struct {
+  // 8 bits per channel, as the panel would show it with inversion off
+  uint8_t ram[ST7789_EMU_RAM_HEIGHT][ST7789_EMU_RAM_WIDTH][3];
+
+  bool dc;       // DC pin, true = data
+  bool in_reset; // reset pin held low
+  bool sleeping;
+  bool display_on;
+  bool inverted;
+
+  uint8_t madctl;
+  uint8_t colmod;
+  uint16_t col_start, col_end; // CASET, in the MADCTL (logical) space
+  uint16_t row_start, row_end; // RASET
+  uint16_t scroll_top, scroll_height, scroll_bottom; // VSCRDEF
+  uint16_t scroll_start;                              // VSCSAD
+
+  // command decoding
+  int command;      // -1 before the first command
+  uint8_t parameters[16];
+  size_t num_parameters;
+  uint16_t pointer_col, pointer_row; // RAM write pointer (logical)
+  uint8_t pixel_bytes[3];            // partly received pixel data
+  size_t num_pixel_bytes;
+
+  bool te_on; // TEON
+  st7789_emu_timing timing; // all 0 when not timed
+  uint64_t time_ns;
+
+  st7789_emu_stats stats;
+} st7789_emu;
+
+// power on state, panel RAM cleared to black
+void st7789_emu_init(st7789_emu *emu);
+
+// new value of the whole AXI GPIO channel (DC, reset, backlight)
+void st7789_emu_gpio(st7789_emu *emu, uint32_t value);
+
+// chip select asserted / released around one SPI transfer
+void st7789_emu_spi_begin(st7789_emu *emu);
+void st7789_emu_spi_end(st7789_emu *emu);
+void st7789_emu_spi_write(st7789_emu *emu, const uint8_t *bytes,
+                          size_t num_bytes);
+
+/*
+What the panel shows at glass position x, y (0 <= x < 240, 0 <= y < 320) as
+0xRRGGBB, with scrolling, inversion, sleep and display off applied.
+*/
+uint32_t st7789_emu_shown_pixel(const st7789_emu *emu, uint16_t x, uint16_t y);
+
+/*
+Writes what the panel shows to a binary PPM. With visible_only only the 172
+columns of the ST7789VW glass are written, otherwise the whole 240 wide RAM.
+Returns false if the file could not be written.
+*/
+bool st7789_emu_write_ppm(const st7789_emu *emu, const char *path,
+                          bool visible_only);
+
+// FNV-1a over the whole panel RAM, equal hashes mean equal RAM contents
+uint32_t st7789_emu_ram_hash(const st7789_emu *emu);
+
+// counters since init or the last reset of stats
+void st7789_emu_reset_stats(st7789_emu *emu);
+
+// turns the panel timing on (clock at 0, frame 0 starting)
+void st7789_emu_set_timing(st7789_emu *emu, const st7789_emu_timing *timing);
+
+// time passing without anything on the bus
+void st7789_emu_advance(st7789_emu *emu, uint64_t nanoseconds);
+
+// the frame being scanned and the level of the TE pin right now
+uint64_t st7789_emu_frame(const st7789_emu *emu);
+bool st7789_emu_te(const st7789_emu *emu);
+
+#endif // ST7789_EMULATOR_H
@@ -0,0 +1,288 @@
+#include "zynq_lcd_async.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <xstatus.h>
+
+/*************************************************
+  host test: async refresh engine, its steps and
+  every way a refresh can fail, on fake hooks
+**************************************************/
+
+#define TEST_MAX_ISSUED 16U
+
+// what the hooks were asked to do, in order
+typedef struct {
+  bool data; // DC level before the transfer
+  const uint8_t *bytes;
+  uint8_t first_byte;
+  size_t num_bytes;
+  size_t rows, stride;
+} test_issue;
+
+static test_issue issued[TEST_MAX_ISSUED];
+static size_t num_issued;
+static bool dc_level;
+static size_t dc_changes;
+// the transfer with this index (1 based) is refused, 0 for none
+static size_t refuse_transfer;
+static int queue_status;
+static size_t queued_steps;
+
+static unsigned callbacks;
+static ZLCD_RETURN_STATUS callback_status;
+
+static ZLCD_async_engine engine;
+
+static void hook_set_dc(void *context, bool data) {
+  (void)context;
+  dc_changes += data != dc_level;
+  dc_level = data;
+}
+
+static int note_issue(const uint8_t *bytes, size_t num_bytes, size_t rows,
+                      size_t stride) {
+  if (num_issued >= TEST_MAX_ISSUED) {
+    return XST_FAILURE;
+  }
+  issued[num_issued] = (test_issue){.data = dc_level,
+                                    .bytes = bytes,
+                                    .first_byte = bytes[0],
+                                    .num_bytes = num_bytes,
+                                    .rows = rows,
+                                    .stride = stride};
+  num_issued++;
+  return num_issued == refuse_transfer ? XST_DEVICE_BUSY : XST_SUCCESS;
+}
+
+static int hook_start_transfer(void *context, const uint8_t *bytes,
+                               size_t num_bytes) {
+  (void)context;
+  return note_issue(bytes, num_bytes, 1, 0);
+}
+
+static int hook_start_rows(void *context, const uint8_t *first_row,
+                           size_t row_bytes, size_t rows, size_t stride) {
+  (void)context;
+  return note_issue(first_row, row_bytes, rows, stride);
+}
+
+static int hook_start_queue(void *context, const ZLCD_async_step *steps,
+                            size_t num_steps) {
+  (void)context;
+  (void)steps;
+  queued_steps = num_steps;
+  return queue_status;
+}
+
+static void refresh_done(ZLCD_RETURN_STATUS status, void *user_data) {
+  (void)user_data;
+  callbacks++;
+  callback_status = status;
+}
+
+// a fresh engine on the hooks, nothing issued, nothing called back
+static void setup(bool with_rows, bool with_queue) {
+  memset(&engine, 0, sizeof(engine));
+  engine.set_dc = hook_set_dc;
+  engine.start_transfer = hook_start_transfer;
+  engine.start_rows = with_rows ? hook_start_rows : NULL;
+  engine.start_queue = with_queue ? hook_start_queue : NULL;
+  ZLCD_async_reset(&engine);
+  num_issued = 0;
+  dc_level = true;
+  dc_changes = 0;
+  refuse_transfer = 0;
+  queue_status = XST_SUCCESS;
+  queued_steps = 0;
+  callbacks = 0;
+  callback_status = ZLCD_SUCCESS;
+}
+
+static bool expect(const char *name, bool condition, const char *what) {
+  if (!condition) {
+    printf("%s: %s\n", name, what);
+  }
+  return condition;
+}
+
+/*
+After a refresh has ended: exactly one callback with status, the engine idle
+with the same status and issues transfers started
+*/
+static unsigned expect_end(const char *name, ZLCD_RETURN_STATUS status,
+                           size_t issues) {
+  unsigned failures = 0;
+  failures += !expect(name, callbacks == 1, "not called back exactly once");
+  failures += !expect(name, callback_status == status, "wrong callback status");
+  failures += !expect(name, !engine.busy, "engine still busy");
+  failures += !expect(name, engine.status == status, "wrong engine status");
+  if (num_issued != issues) {
+    printf("%s: %zu transfers started, expected %zu\n", name, num_issued,
+           issues);
+    failures++;
+  }
+  return failures;
+}
+
+static const uint8_t window[4] = {0x00, 0x22, 0x00, 0xCD};
+
+// CASET and its parameters from a stack buffer, then a row of pixels
+static void push_window(const uint8_t *pixels, size_t num_bytes) {
+  uint8_t command = 0x2A;
+  uint8_t parameters[4];
+  memcpy(parameters, window, sizeof(parameters));
+  (void)ZLCD_async_push(&engine, true, &command, 1);
+  (void)ZLCD_async_push(&engine, false, parameters, sizeof(parameters));
+  (void)ZLCD_async_push(&engine, false, pixels, num_bytes);
+  // the stack copies must not be referenced
+  memset(parameters, 0xEE, sizeof(parameters));
+  command = 0xEE;
+}
+
+int main(void) {
+  static uint8_t pixels[64];
+  unsigned failures = 0;
+  for (size_t i = 0; i < sizeof(pixels); i++) {
+    pixels[i] = (uint8_t)(i + 1U);
+  }
+
+  // one step per "transfer done" interrupt, DC set before each
+  setup(false, false);
+  push_window(pixels, sizeof(pixels));
+  failures += !expect("steps", ZLCD_async_start(&engine, refresh_done, NULL) ==
+                                   ZLCD_SUCCESS,
+                      "start failed");
+  failures += !expect("steps", engine.busy && num_issued == 1 && callbacks == 0,
+                      "not waiting for the first step");
+  ZLCD_async_step_done(&engine, XST_SUCCESS);
+  ZLCD_async_step_done(&engine, XST_SUCCESS);
+  ZLCD_async_step_done(&engine, XST_SUCCESS);
+  failures += expect_end("steps", ZLCD_SUCCESS, 3);
+  failures += !expect("steps",
+                      !issued[0].data && issued[0].first_byte == 0x2A &&
+                          issued[1].data && issued[1].num_bytes == 4 &&
+                          memcmp(issued[1].bytes, window, 4) == 0 &&
+                          issued[2].data &&
+                          issued[2].bytes == pixels &&
+                          issued[2].num_bytes == sizeof(pixels),
+                      "wrong transfers");
+  failures += !expect("steps", dc_changes == 2, "DC not toggled twice");
+
+  // an interrupt with nothing in flight starts nothing
+  ZLCD_async_step_done(&engine, XST_SUCCESS);
+  failures += expect_end("spurious", ZLCD_SUCCESS, 3);
+
+  // a second start while one is running is refused, the first goes on
+  setup(false, false);
+  push_window(pixels, sizeof(pixels));
+  (void)ZLCD_async_start(&engine, refresh_done, NULL);
+  failures += !expect("busy",
+                      ZLCD_async_start(&engine, NULL, NULL) == ZLCD_FAILURE,
+                      "second start accepted");
+  for (unsigned i = 0; i < 3; i++) {
+    ZLCD_async_step_done(&engine, XST_SUCCESS);
+  }
+  failures += expect_end("busy", ZLCD_SUCCESS, 3);
+
+  // a step ends in a mode fault (XST_FAILURE from the status handler)
+  setup(false, false);
+  push_window(pixels, sizeof(pixels));
+  (void)ZLCD_async_start(&engine, refresh_done, NULL);
+  ZLCD_async_step_done(&engine, XST_SUCCESS);
+  ZLCD_async_step_done(&engine, XST_FAILURE);
+  ZLCD_async_step_done(&engine, XST_SUCCESS);
+  failures += expect_end("step error", ZLCD_FAILURE, 2);
+
+  // XSpiPs_Transfer() refuses a later step
+  setup(false, false);
+  push_window(pixels, sizeof(pixels));
+  refuse_transfer = 3;
+  (void)ZLCD_async_start(&engine, refresh_done, NULL);
+  ZLCD_async_step_done(&engine, XST_SUCCESS);
+  ZLCD_async_step_done(&engine, XST_SUCCESS);
+  failures += expect_end("refused", ZLCD_FAILURE, 3);
+
+  // or the first one, which ZLCD_async_start() reports as well
+  setup(false, false);
+  push_window(pixels, sizeof(pixels));
+  refuse_transfer = 1;
+  failures += !expect("refused first",
+                      ZLCD_async_start(&engine, refresh_done, NULL) ==
+                          ZLCD_FAILURE,
+                      "start did not fail");
+  failures += expect_end("refused first", ZLCD_FAILURE, 1);
+
+  // a queue that overflowed sends nothing, and a reset clears it
+  setup(false, false);
+  size_t pushed = 0;
+  while (ZLCD_async_push(&engine, false, pixels, sizeof(pixels))) {
+    pushed++;
+  }
+  failures += !expect("overflow",
+                      pushed == ZLCD_ASYNC_MAX_STEPS && engine.overflow,
+                      "queue length or flag wrong");
+  failures += !expect("overflow",
+                      ZLCD_async_start(&engine, refresh_done, NULL) ==
+                          ZLCD_FAILURE,
+                      "start did not fail");
+  failures += expect_end("overflow", ZLCD_FAILURE, 0);
+  ZLCD_async_reset(&engine);
+  callbacks = 0;
+  push_window(pixels, sizeof(pixels));
+  (void)ZLCD_async_start(&engine, refresh_done, NULL);
+  for (unsigned i = 0; i < 3; i++) {
+    ZLCD_async_step_done(&engine, XST_SUCCESS);
+  }
+  failures += expect_end("after overflow", ZLCD_SUCCESS, 3);
+
+  // nothing to send ends at once
+  setup(false, false);
+  failures += !expect("empty",
+                      ZLCD_async_start(&engine, refresh_done, NULL) ==
+                          ZLCD_SUCCESS,
+                      "start failed");
+  failures += expect_end("empty", ZLCD_SUCCESS, 0);
+
+  // rows in one step with start_rows, refused without it
+  failures += !expect("rows",
+                      !ZLCD_async_push_rows(&engine, pixels, 16, 4, 16),
+                      "rows pushed without start_rows");
+  setup(true, false);
+  failures += !expect("rows", ZLCD_async_push_rows(&engine, pixels, 12, 4, 16),
+                      "rows not pushed");
+  (void)ZLCD_async_start(&engine, refresh_done, NULL);
+  ZLCD_async_step_done(&engine, XST_SUCCESS);
+  failures += expect_end("rows", ZLCD_SUCCESS, 1);
+  failures += !expect("rows",
+                      issued[0].rows == 4 && issued[0].stride == 16 &&
+                          issued[0].num_bytes == 12,
+                      "wrong rows transfer");
+
+  // the whole queue handed over at once, and refused
+  setup(false, true);
+  push_window(pixels, sizeof(pixels));
+  (void)ZLCD_async_start(&engine, refresh_done, NULL);
+  failures += !expect("queue",
+                      engine.busy && queued_steps == 3 && num_issued == 0,
+                      "queue not handed over");
+  ZLCD_async_finish(&engine, ZLCD_SUCCESS);
+  failures += expect_end("queue", ZLCD_SUCCESS, 0);
+  setup(false, true);
+  push_window(pixels, sizeof(pixels));
+  queue_status = XST_FAILURE;
+  failures += !expect("queue refused",
+                      ZLCD_async_start(&engine, refresh_done, NULL) ==
+                          ZLCD_FAILURE,
+                      "start did not fail");
+  failures += expect_end("queue refused", ZLCD_FAILURE, 0);
+
+  if (failures != 0) {
+    printf("%u checks failed\n", failures);
+    return 1;
+  }
+  printf("async engine steps and failures as expected\n");
+  return 0;
+}
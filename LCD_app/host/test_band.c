@@ -0,0 +1,152 @@
+#include "fonts.h"
+#include "images.h"
+#include "zynq_lcd_band.h"
+#include "zynq_lcd_st7789.h"
+
+#include "mock_bsp.h"
+#include "st7789_emulator.h"
+#include <stdio.h>
+#include <string.h>
+
+/*************************************************
+  host test: the band renderer against the GRAM,
+  built with and without a frame
+**************************************************/
+
+/*
+Renders the same scenes in every orientation with ZLCD_band_render() and prints
+the panel RAM digest after each. With a frame every scene is drawn again with
+the driver functions of the same name and refreshed, which has to leave the
+panel RAM byte for byte the same. compare_band.cmake checks that the frameless
+build (ZLCD_MAX_FRAME_BUFFERS 0) prints the same digests.
+*/
+
+static st7789_emu panel;
+
+static void hook_gpio_write(void *context, u32 value) {
+  st7789_emu_gpio(context, value);
+}
+
+static void hook_spi_begin(void *context) { st7789_emu_spi_begin(context); }
+
+static void hook_spi_write(void *context, const u8 *bytes, u32 num_bytes) {
+  st7789_emu_spi_write(context, bytes, num_bytes);
+}
+
+static void hook_spi_end(void *context) { st7789_emu_spi_end(context); }
+
+static const ZLCD_ORIENTATION orientations[] = {
+    ZLCD_PORTRAIT_ORIENTATION, ZLCD_INVERTED_PORTRAIT_ORIENTATION,
+    ZLCD_LANDSCAPE_ORIENTATION, ZLCD_INVERTED_LANDSCAPE_ORIENTATION};
+
+static const char *const orientation_names[] = {
+    "portrait", "inverted_portrait", "landscape", "inverted_landscape"};
+
+// the 40x40 bottom right corner of img_1
+static ZLCD_image image;
+
+// everything stays inside the 172x172 all orientations share
+static void band_scene(ZLCD_display_list *list, uint16_t circle_y) {
+  ZLCD_display_list_clear(list, NAVY_GREEN);
+  ZLCD_band_rectangle(list, 10, 10, 100, 50, 3, WHITE, true, BLUE);
+  ZLCD_band_rectangle(list, 60, 40, 90, 30, 2, RED, false, BLACK);
+  ZLCD_band_line(list, 0, 171, 171, 60, YELLOW);
+  ZLCD_band_string(list, "ZLCD bands", 10, 90, WHITE, &simple_font_12);
+  ZLCD_band_circle(list, 120, circle_y, 30, WHITE, true, ORANGE);
+  ZLCD_band_circle(list, 40, 140, 20, LIGHT_BLUE, false, BLACK);
+  ZLCD_band_image(list, 5, 125, &image);
+}
+
+#if !ZLCD_FRAMELESS
+// band_scene() drawn into the GRAM and refreshed
+static ZLCD_RETURN_STATUS gram_scene(uint16_t circle_y) {
+  ZLCD_frame_layout layout;
+  if (ZLCD_get_frame_layout(&layout) != ZLCD_SUCCESS) {
+    return ZLCD_FAILURE;
+  }
+  ZLCD_draw_filled_rectangle_xy(0, 0, layout.width, layout.height, 1,
+                                NAVY_GREEN, NAVY_GREEN, false);
+  ZLCD_draw_filled_rectangle_xy(10, 10, 100, 50, 3, WHITE, BLUE, false);
+  ZLCD_draw_unfilled_rectangle_xy(60, 40, 90, 30, 2, RED, false);
+  ZLCD_draw_line_xy(0, 171, 171, 60, YELLOW, false);
+  ZLCD_print_string_xy("ZLCD bands", 10, 90, WHITE, &simple_font_12, false);
+  ZLCD_draw_filled_circle_xy(120, circle_y, 30, WHITE, ORANGE, false);
+  ZLCD_draw_unfilled_circle_xy(40, 140, 20, LIGHT_BLUE, false);
+  ZLCD_draw_image(ZLCD_create_coordinate(5, 125), &image, false);
+  return ZLCD_refresh_display();
+}
+#endif
+
+int main(int argc, char **argv) {
+  ZLCD_config config = ZLCD_create_config(ZLCD_PORTRAIT_ORIENTATION, BLACK);
+  if (argc > 1 && strcmp(argv[1], "madctl") == 0) {
+    config.rotation_mode = ZLCD_ROTATE_MADCTL;
+  } else if (argc > 1 && strcmp(argv[1], "software") != 0) {
+    printf("usage: %s [software|madctl] [rgb565|rgb444|rgb444_dither]\n",
+           argv[0]);
+    return 2;
+  }
+  if (argc > 2 && strcmp(argv[2], "rgb444") == 0) {
+    config.pixel_format = ZLCD_PIXEL_RGB444;
+  } else if (argc > 2 && strcmp(argv[2], "rgb444_dither") == 0) {
+    config.pixel_format = ZLCD_PIXEL_RGB444_DITHERED;
+  } else if (argc > 2 && strcmp(argv[2], "rgb565") != 0) {
+    printf("unknown pixel format %s\n", argv[2]);
+    return 2;
+  }
+
+  st7789_emu_init(&panel);
+  mock_bsp_hooks hooks = {.gpio_write = hook_gpio_write,
+                          .spi_begin = hook_spi_begin,
+                          .spi_write = hook_spi_write,
+                          .spi_end = hook_spi_end,
+                          .context = &panel};
+  mock_bsp_set_hooks(&hooks);
+  if (ZLCD_init_with_config(&config) != ZLCD_SUCCESS) {
+    printf("ZLCD init failed\n");
+    return 1;
+  }
+  image = lvgl_image_to_ZLCD(&img_1, 132, 280);
+
+  static ZLCD_band_item items[8];
+  ZLCD_display_list list;
+  ZLCD_display_list_init(&list, items, 8, NAVY_GREEN);
+  unsigned failures = 0;
+  // bytes past 127 have no glyph, whatever the signedness of char
+  if (ZLCD_band_string(&list, "caf\xc3\xa9", 10, 10, WHITE,
+                       &simple_font_12) == ZLCD_SUCCESS ||
+      list.num_items != 0) {
+    printf("a string outside 32-127 was added to the display list\n");
+    failures++;
+  }
+  for (size_t i = 0; i < sizeof(orientations) / sizeof(orientations[0]);
+       i++) {
+    ZLCD_set_orientation(orientations[i]);
+    // the second scene only moves the filled circle down
+    for (uint16_t circle_y = 120; circle_y <= 140; circle_y += 20) {
+      band_scene(&list, circle_y);
+      if (ZLCD_band_render(&list, NULL) != ZLCD_SUCCESS) {
+        printf("%s: ZLCD_band_render failed\n", orientation_names[i]);
+        return 1;
+      }
+      uint32_t band_hash = st7789_emu_ram_hash(&panel);
+      printf("%-18s circle_y %u ram_hash 0x%08x\n", orientation_names[i],
+             circle_y, (unsigned)band_hash);
+#if !ZLCD_FRAMELESS
+      if (gram_scene(circle_y) != ZLCD_SUCCESS) {
+        printf("%s: drawing into the GRAM failed\n", orientation_names[i]);
+        return 1;
+      }
+      uint32_t gram_hash = st7789_emu_ram_hash(&panel);
+      if (gram_hash != band_hash) {
+        printf("%s circle_y %u: the GRAM left ram_hash 0x%08x\n",
+               orientation_names[i], circle_y, (unsigned)gram_hash);
+        failures++;
+      }
+      // the refresh wrote the LCD behind the band renderer's back
+      ZLCD_band_forget();
+#endif
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
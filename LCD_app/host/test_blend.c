@@ -0,0 +1,116 @@
+#include "zynq_lcd_blend.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*************************************************
+  host test: layer blend kernels, NEON (mock_neon)
+  and scalar, against the blend formula
+**************************************************/
+
+#define TEST_SPANS 3000U
+#define TEST_MAX_COUNT 320U
+// pixels after the blended ones that must stay untouched
+#define TEST_GUARD_PIXELS 4U
+#define TEST_GUARD 0xA5A5U
+
+static const uint8_t alphas[] = {0, 1, 128, 254, 255};
+
+static uint32_t random_state = 0x2545F491U;
+
+static uint32_t random_next(void) {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+// the header's formula, one channel at a time
+static uint16_t expected_pixel(uint16_t s, uint16_t d, uint8_t alpha,
+                               bool keyed, uint16_t key) {
+  if (keyed && s == key) {
+    return d;
+  }
+  if (alpha == UINT8_MAX) {
+    return s;
+  }
+  unsigned a = (alpha + 4U) >> 3;
+  unsigned r = ((s >> 11) * a + (d >> 11) * (32U - a)) >> 5;
+  unsigned g = (((s >> 5) & 0x3FU) * a + ((d >> 5) & 0x3FU) * (32U - a)) >> 5;
+  unsigned b = ((s & 0x1FU) * a + (d & 0x1FU) * (32U - a)) >> 5;
+  return (uint16_t)(r << 11 | g << 5 | b);
+}
+
+/*
+One span through both kernels from the same destination: every pixel is the
+formula's and nothing after count was written.
+*/
+static bool check_span(const uint16_t *src, const uint16_t *dst, size_t count,
+                       uint8_t alpha, bool keyed, uint16_t key) {
+  static uint16_t neon[TEST_MAX_COUNT + TEST_GUARD_PIXELS];
+  static uint16_t scalar[TEST_MAX_COUNT + TEST_GUARD_PIXELS];
+  for (size_t i = 0; i < count + TEST_GUARD_PIXELS; i++) {
+    neon[i] = i < count ? dst[i] : TEST_GUARD;
+    scalar[i] = neon[i];
+  }
+  ZLCD_blend_span(neon, src, count, alpha, keyed, key);
+  ZLCD_blend_span_scalar(scalar, src, count, alpha, keyed, key);
+  for (size_t i = 0; i < count; i++) {
+    uint16_t expected = expected_pixel(src[i], dst[i], alpha, keyed, key);
+    if (neon[i] != expected || scalar[i] != expected) {
+      printf("%zu pixels alpha %u keyed %d: pixel %zu 0x%04x over 0x%04x is "
+             "0x%04x (scalar 0x%04x), expected 0x%04x\n",
+             count, alpha, keyed, i, src[i], dst[i], neon[i], scalar[i],
+             expected);
+      return false;
+    }
+  }
+  for (size_t i = count; i < count + TEST_GUARD_PIXELS; i++) {
+    if (neon[i] != TEST_GUARD || scalar[i] != TEST_GUARD) {
+      printf("%zu pixels alpha %u keyed %d: wrote past the span\n", count,
+             alpha, keyed);
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(void) {
+  static uint16_t src[TEST_MAX_COUNT];
+  static uint16_t dst[TEST_MAX_COUNT];
+  unsigned failures = 0;
+  for (unsigned span = 0; span < TEST_SPANS && failures <= 10U; span++) {
+    // every count up to a few NEON passes and their tails, then random ones
+    size_t count = span <= 4U * 8U + 7U ? span : random_next() % TEST_MAX_COUNT;
+    // an unaligned start, as where a layer begins inside the scratch row
+    size_t offset = random_next() % 8U;
+    count = count < TEST_MAX_COUNT - offset ? count : TEST_MAX_COUNT - offset;
+    uint16_t key = (uint16_t)random_next();
+    for (size_t i = 0; i < count; i++) {
+      // about a quarter of the source is the key
+      src[offset + i] =
+          random_next() % 4U == 0U ? key : (uint16_t)random_next();
+      dst[offset + i] = (uint16_t)random_next();
+    }
+    // the extremes, where a channel sum is largest
+    if (span % 16U == 0U) {
+      memset(&src[offset], 0xFF, count * sizeof(src[0]));
+      memset(&dst[offset], span % 32U == 0U ? 0xFF : 0x00,
+             count * sizeof(dst[0]));
+    }
+    for (size_t k = 0; k < sizeof(alphas) / sizeof(alphas[0]); k++) {
+      for (int keyed = 0; keyed <= 1; keyed++) {
+        failures += !check_span(&src[offset], &dst[offset], count, alphas[k],
+                                keyed, key);
+      }
+    }
+  }
+  if (failures != 0) {
+    printf("%u spans failed\n", failures);
+    return 1;
+  }
+  printf("%u spans blended as the formula gives\n", TEST_SPANS);
+  return 0;
+}
@@ -0,0 +1,408 @@
+#include "mock_bsp.h"
+#include "zynq_lcd_dma.h"
+#include "zynq_lcd_fifo.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <xparameters.h>
+#include <xspips_hw.h>
+
+/*************************************************
+  host test: PL330 channel programs of the DMA
+  transport, decoded, then sent over the mock BSP
+**************************************************/
+
+#define TEST_FIFO_ADDRESS (XPAR_SPI0_BASEADDR + XSPIPS_TXD_OFFSET)
+#define TEST_ENABLE_ADDRESS (XPAR_SPI0_BASEADDR + XSPIPS_IER_OFFSET)
+#define TEST_SOURCE_BYTES (256U * 1024U)
+#define TEST_MAX_CHUNKS 8192U
+
+// static, so below 4 GB with the -no-pie host build
+static uint8_t source[TEST_SOURCE_BYTES];
+static uint8_t sent[TEST_SOURCE_BYTES];
+static size_t sent_bytes;
+static unsigned frames;
+static uint8_t program[ZLCD_DMA_PROGRAM_BYTES];
+
+// what running a program did, in the order it did it
+typedef struct {
+  size_t chunks[TEST_MAX_CHUNKS]; // bytes between each pace wait and its event
+  size_t num_chunks;
+  size_t bytes;
+  bool done; // the last chunk raised the channel's event, then DMAEND
+} test_run;
+
+static bool fail(const char *name, const char *what, size_t at) {
+  printf("%s: %s (at %zu)\n", name, what, at);
+  return false;
+}
+
+/*
+Runs program the way the PL330 would, with the pace event always given. Every
+byte the stores write has to be the next one of the rows, and the FIFO is
+never sent more than one chunk per pace.
+*/
+static bool run_program(const char *name, const uint8_t *code, size_t length,
+                        const uint8_t *expected, size_t expected_bytes,
+                        test_run *run) {
+  uint32_t registers[3] = {0};
+  unsigned counter[2] = {0};
+  uint8_t burst[16];
+  size_t burst_length = 0;
+  bool waited = false;
+  memset(run, 0, sizeof(*run));
+  for (size_t pc = 0, steps = 0; pc < length; steps++) {
+    if (steps > 10000000U) {
+      return fail(name, "the program does not end", pc);
+    }
+    uint8_t op = code[pc];
+    uint32_t ccr = registers[1];
+    size_t beats = ((ccr >> 4) & 0xFU) + 1U;
+    if (op == 0x00U) {
+      if (!run->done || pc + 1 != length) {
+        return fail(name, "DMAEND before the done event", pc);
+      }
+      return true;
+    } else if (op == 0xBCU) {
+      if (code[pc + 1] > 2U) {
+        return fail(name, "DMAMOV to an unknown register", pc);
+      }
+      uint32_t value = 0;
+      for (unsigned i = 0; i < 4; i++) {
+        value |= (uint32_t)code[pc + 2 + i] << (8 * i);
+      }
+      registers[code[pc + 1]] = value;
+      pc += 6;
+    } else if (op == 0x04U) {
+      // incrementing byte reads, SBsize 0 and SI set
+      if ((ccr & 0xFU) != 0x1U || !waited) {
+        return fail(name, "DMALD is not paced incrementing bytes", pc);
+      }
+      if ((uintptr_t)registers[0] < (uintptr_t)source ||
+          (uintptr_t)registers[0] + beats >
+              (uintptr_t)source + sizeof(source)) {
+        return fail(name, "DMALD outside the source", pc);
+      }
+      memcpy(burst, (const uint8_t *)(uintptr_t)registers[0], beats);
+      burst_length = beats;
+      registers[0] += (uint32_t)beats;
+      pc++;
+    } else if (op == 0x08U) {
+      // fixed byte writes into the FIFO, DI clear, DBsize 0, DBlen = SBlen
+      if (((ccr >> 14) & 0xFU) != 0U || ((ccr >> 18) & 0xFU) + 1U != beats ||
+          registers[2] != TEST_FIFO_ADDRESS || burst_length != beats) {
+        return fail(name, "DMAST is not a fixed byte write to TXD", pc);
+      }
+      if (run->bytes + beats > expected_bytes ||
+          memcmp(expected + run->bytes, burst, beats) != 0) {
+        return fail(name, "DMAST of the wrong bytes", run->bytes);
+      }
+      run->bytes += beats;
+      run->chunks[run->num_chunks] += beats;
+      if (run->chunks[run->num_chunks] > ZLCD_DMA_CHUNK_BYTES) {
+        return fail(name, "more than a chunk for one pace", run->num_chunks);
+      }
+      burst_length = 0;
+      pc++;
+    } else if (op == 0x13U) {
+      pc++;
+    } else if (op == 0x36U) {
+      if (code[pc + 1] != ZLCD_DMA_PACE_EVENT << 3 || waited || run->done) {
+        return fail(name, "DMAWFE not for the pace event", pc);
+      }
+      waited = true;
+      pc += 2;
+    } else if (op == 0x34U) {
+      unsigned event = code[pc + 1] >> 3;
+      if (!waited || code[pc - 1] != 0x13U ||
+          (event != ZLCD_DMA_REARM_EVENT && event != ZLCD_DMA_CHANNEL)) {
+        return fail(name, "DMASEV without a chunk before it", pc);
+      }
+      waited = false;
+      run->done = event == ZLCD_DMA_CHANNEL;
+      if (++run->num_chunks >= TEST_MAX_CHUNKS) {
+        return fail(name, "too many chunks", pc);
+      }
+      pc += 2;
+    } else if ((op & 0xFDU) == 0x20U) {
+      counter[(op >> 1) & 1U] = code[pc + 1];
+      pc += 2;
+    } else if ((op & 0xFBU) == 0x38U) {
+      unsigned lc = (op >> 2) & 1U;
+      if (counter[lc] != 0) {
+        counter[lc]--;
+        pc -= code[pc + 1];
+      } else {
+        pc += 2;
+      }
+    } else if (op == 0x54U) {
+      registers[0] += (uint32_t)code[pc + 1] | (uint32_t)code[pc + 2] << 8;
+      pc += 3;
+    } else {
+      return fail(name, "unexpected instruction", pc);
+    }
+  }
+  return fail(name, "the program runs off its end", length);
+}
+
+/*
+One program: the stores give the rows in order, in chunks of
+ZLCD_DMA_CHUNK_BYTES except for the last one of a run (rows that follow each
+other without a gap are one), and only the very last chunk ends the transfer.
+*/
+static bool check_program(const char *name, size_t offset, size_t row_bytes,
+                          size_t rows, size_t stride) {
+  static uint8_t expected[TEST_SOURCE_BYTES];
+  static test_run run;
+  size_t length = ZLCD_dma_build_program(
+      program, sizeof(program), (UINTPTR)&source[offset], row_bytes, rows,
+      stride, TEST_FIFO_ADDRESS);
+  if (length == 0) {
+    return fail(name, "no program", 0);
+  }
+  size_t expected_bytes = 0;
+  for (size_t row = 0; row < rows; row++) {
+    memcpy(expected + expected_bytes, &source[offset + row * stride],
+           row_bytes);
+    expected_bytes += row_bytes;
+  }
+  if (!run_program(name, program, length, expected, expected_bytes, &run)) {
+    return false;
+  }
+  if (run.bytes != expected_bytes || !run.done) {
+    return fail(name, "not every byte was sent", run.bytes);
+  }
+  size_t run_bytes = stride == row_bytes ? row_bytes * rows : row_bytes;
+  size_t runs = stride == row_bytes ? 1 : rows;
+  size_t per_run = ZLCD_dma_chunk_count(run_bytes);
+  if (run.num_chunks != per_run * runs) {
+    return fail(name, "wrong number of chunks", run.num_chunks);
+  }
+  for (size_t i = 0; i < run.num_chunks; i++) {
+    size_t in_run = i % per_run;
+    size_t want = in_run + 1 < per_run
+                      ? ZLCD_DMA_CHUNK_BYTES
+                      : run_bytes - in_run * ZLCD_DMA_CHUNK_BYTES;
+    if (run.chunks[i] != want) {
+      return fail(name, "wrong chunk length", i);
+    }
+  }
+  return true;
+}
+
+/*
+The rearm channel's program: rearms times it waits for the rearm event and
+copies the mask word into the interrupt enable register, then it raises its
+own done event and ends.
+*/
+static bool check_rearm_program(size_t rearms) {
+  static const uint32_t mask = 0x4U;
+  char name[64];
+  snprintf(name, sizeof(name), "%zu rearms", rearms);
+  size_t length = ZLCD_dma_build_rearm_program(
+      program, sizeof(program), rearms, (UINTPTR)&mask, TEST_ENABLE_ADDRESS);
+  if (length == 0 || length > 64) {
+    return fail(name, "no program or one too long for the transfer", length);
+  }
+  uint32_t registers[3] = {0};
+  unsigned counter[2] = {0};
+  size_t done = 0;
+  bool waited = false, loaded = false;
+  for (size_t pc = 0; pc < length;) {
+    uint8_t op = program[pc];
+    if (op == 0xBCU) {
+      uint32_t value = 0;
+      for (unsigned i = 0; i < 4; i++) {
+        value |= (uint32_t)program[pc + 2 + i] << (8 * i);
+      }
+      registers[program[pc + 1] % 3U] = value;
+      pc += 6;
+    } else if (op == 0x36U) {
+      if (program[pc + 1] != ZLCD_DMA_REARM_EVENT << 3 || waited) {
+        return fail(name, "DMAWFE not for the rearm event", pc);
+      }
+      waited = true;
+      pc += 2;
+    } else if (op == 0x04U) {
+      // one word from the mask, SI clear
+      if (!waited || registers[1] != ((2U << 1) | (2U << 15)) ||
+          registers[0] != (uint32_t)(UINTPTR)&mask) {
+        return fail(name, "DMALD is not the mask word after a wait", pc);
+      }
+      loaded = true;
+      pc++;
+    } else if (op == 0x08U) {
+      if (!loaded || registers[2] != TEST_ENABLE_ADDRESS) {
+        return fail(name, "DMAST is not the mask into the enable register",
+                    pc);
+      }
+      waited = loaded = false;
+      done++;
+      pc++;
+    } else if ((op & 0xFDU) == 0x20U) {
+      counter[(op >> 1) & 1U] = program[pc + 1];
+      pc += 2;
+    } else if ((op & 0xFBU) == 0x38U) {
+      unsigned lc = (op >> 2) & 1U;
+      if (counter[lc] != 0) {
+        counter[lc]--;
+        pc -= program[pc + 1];
+      } else {
+        pc += 2;
+      }
+    } else if (op == 0x34U) {
+      if (program[pc + 1] != ZLCD_DMA_REARM_CHANNEL << 3 ||
+          program[pc + 2] != 0x00U || pc + 3 != length) {
+        return fail(name, "the program does not end with its done event", pc);
+      }
+      if (done != rearms) {
+        return fail(name, "wrong number of rearms", done);
+      }
+      return true;
+    } else {
+      return fail(name, "unexpected instruction", pc);
+    }
+  }
+  return fail(name, "the program runs off its end", length);
+}
+
+static bool check_programs(void) {
+  static const size_t lengths[] = {
+      1,     15,    16,    17,    63,    64,    65,    111,
+      112,   113,   127,   128,   224,   225,   1000,  16383,
+      16384, 16385, 16448, 28672, 3 * 16384 + 5, 110080};
+  bool ok = true;
+  char name[64];
+  for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+    snprintf(name, sizeof(name), "%zu bytes", lengths[i]);
+    ok &= check_program(name, 3, lengths[i], 1, lengths[i]);
+  }
+  // windows narrower than the frame, the frame's stride between their rows
+  ok &= check_program("back to back rows", 0, 344, 320, 344);
+  ok &= check_program("strided rows", 7, 100, 20, 344);
+  ok &= check_program("one chunk rows", 0, ZLCD_DMA_CHUNK_BYTES, 320, 344);
+  ok &= check_program("partial chunk rows", 1, 200, 320, 640);
+  ok &= check_program("two rows", 0, 130, 2, 200);
+  ok &= check_program("long rows", 0, 16384, 2, 20000);
+  ok &= check_program("many rows", 0, 65, 600, 300);
+
+  // what the PL330 can't do is refused rather than sent wrong
+  if (ZLCD_dma_build_program(program, sizeof(program), (UINTPTR)source,
+                             257 * ZLCD_DMA_CHUNK_BYTES, 2, 30000,
+                             TEST_FIFO_ADDRESS) != 0 ||
+      ZLCD_dma_build_program(program, sizeof(program), (UINTPTR)source, 64, 2,
+                             64 + 0x10000, TEST_FIFO_ADDRESS) != 0 ||
+      ZLCD_dma_build_program(program, sizeof(program), (UINTPTR)source, 64, 2,
+                             32, TEST_FIFO_ADDRESS) != 0 ||
+      ZLCD_dma_build_program(program, 8, (UINTPTR)source, 64, 1, 64,
+                             TEST_FIFO_ADDRESS) != 0 ||
+      ZLCD_dma_build_program(program, sizeof(program), 0xFFFFFFF0U, 64, 1, 64,
+                             TEST_FIFO_ADDRESS) != 0) {
+    printf("a program the PL330 can't run was built\n");
+    ok = false;
+  }
+  if (ZLCD_dma_chunk_count(0) != 0 || ZLCD_dma_chunk_count(1) != 1 ||
+      ZLCD_dma_chunk_count(ZLCD_DMA_CHUNK_BYTES) != 1 ||
+      ZLCD_dma_chunk_count(ZLCD_DMA_CHUNK_BYTES + 1) != 2) {
+    printf("ZLCD_dma_chunk_count() is off\n");
+    ok = false;
+  }
+
+  static const size_t rearms[] = {1, 2, 255, 256, 257, 982, 65535, 65536};
+  for (size_t i = 0; i < sizeof(rearms) / sizeof(rearms[0]); i++) {
+    ok &= check_rearm_program(rearms[i]);
+  }
+  uint32_t mask = 0;
+  if (ZLCD_dma_build_rearm_program(program, sizeof(program), 0,
+                                   (UINTPTR)&mask, TEST_ENABLE_ADDRESS) != 0 ||
+      ZLCD_dma_build_rearm_program(program, sizeof(program), 65537,
+                                   (UINTPTR)&mask, TEST_ENABLE_ADDRESS) != 0) {
+    printf("a rearm program the PL330 can't run was built\n");
+    ok = false;
+  }
+  return ok;
+}
+
+static void hook_spi_begin(void *context) {
+  (void)context;
+  frames++;
+}
+
+static void hook_spi_write(void *context, const u8 *bytes, u32 num_bytes) {
+  (void)context;
+  if (sent_bytes + num_bytes <= sizeof(sent)) {
+    memcpy(sent + sent_bytes, bytes, num_bytes);
+  }
+  sent_bytes += num_bytes;
+}
+
+static void hook_spi_end(void *context) { (void)context; }
+
+// the same rows through the mock XDmaPs and SPI0, one chip select frame each
+static bool check_transfers(void) {
+  static XSpiPs spi;
+  static XDmaPs dma;
+  static ZLCD_dma_transfer transfer;
+  mock_bsp_hooks hooks = {.spi_begin = hook_spi_begin,
+                          .spi_write = hook_spi_write,
+                          .spi_end = hook_spi_end};
+  mock_bsp_set_hooks(&hooks);
+  XSpiPs_Config *config = XSpiPs_LookupConfig(XPAR_SPI0_BASEADDR);
+  XSpiPs_CfgInitialize(&spi, config, config->BaseAddress);
+  XSpiPs_SetOptions(&spi, XSPIPS_MASTER_OPTION | XSPIPS_FORCE_SSELECT_OPTION);
+  XSpiPs_SetClkPrescaler(&spi, XSPIPS_CLK_PRESCALE_4);
+  if (ZLCD_dma_init(&transfer, &dma, &spi, XPAR_XDMAPS_0_BASEADDR) !=
+      XST_SUCCESS) {
+    printf("ZLCD_dma_init() failed\n");
+    return false;
+  }
+
+  bool ok = true;
+  sent_bytes = 0;
+  frames = 0;
+  if (ZLCD_dma_send(&transfer, source + 5, 110080) != XST_SUCCESS ||
+      ZLCD_dma_busy(&transfer) || sent_bytes != 110080 || frames != 1 ||
+      memcmp(sent, source + 5, sent_bytes) != 0) {
+    printf("ZLCD_dma_send() of a frame went wrong (%zu bytes)\n", sent_bytes);
+    ok = false;
+  }
+  /*
+  one interrupt per chunk, then both channels' done interrupts and the one
+  for the empty FIFO
+  */
+  size_t interrupts = ZLCD_dma_chunk_count(110080) + 3;
+  if (transfer.interrupts != interrupts) {
+    printf("a frame took %u interrupts rather than %zu\n",
+           (unsigned)transfer.interrupts, interrupts);
+    ok = false;
+  }
+
+  sent_bytes = 0;
+  frames = 0;
+  ZLCD_fifo_begin(&spi);
+  int status = ZLCD_dma_write_rows(&transfer, source + 11, 200, 100, 344);
+  // a FIFO write straight after, in the same frame
+  ZLCD_fifo_write(&spi, source, 3);
+  ZLCD_fifo_end(&spi);
+  bool same = status == XST_SUCCESS && sent_bytes == 200 * 100 + 3;
+  for (size_t row = 0; same && row < 100; row++) {
+    same = memcmp(sent + row * 200, source + 11 + row * 344, 200) == 0;
+  }
+  if (!same || memcmp(sent + 200 * 100, source, 3) != 0 || frames != 1) {
+    printf("ZLCD_dma_write_rows() went wrong (%zu bytes)\n", sent_bytes);
+    ok = false;
+  }
+  return ok;
+}
+
+int main(void) {
+  for (size_t i = 0; i < sizeof(source); i++) {
+    source[i] = (uint8_t)(i * 131U + (i >> 8) * 7U);
+  }
+  bool ok = check_programs();
+  ok &= check_transfers();
+  printf("%s\n", ok ? "dma ok" : "dma FAILED");
+  return ok ? 0 : 1;
+}
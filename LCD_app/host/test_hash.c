@@ -0,0 +1,254 @@
+// white box: the test writes the GRAM behind the drawing functions' back
+#include "zynq_lcd_st7789.c"
+
+#include "mock_bsp.h"
+#include "st7789_emulator.h"
+#include "zynq_lcd_indexed.h"
+
+/*************************************************
+  host test: tile digests (NEON and scalar), the
+  verify mode finding unmarked changes and rows
+  written past the GRAM
+**************************************************/
+
+#define TEST_STRIDE_BYTES 64U // the tiles sit in a wider buffer
+#define TEST_TILES 4000U
+#define TEST_CHANGES_PER_WORD 16U
+
+static uint32_t random_state = 0x2545F491U;
+
+static uint32_t random_next(void) {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+static void random_fill(uint8_t *bytes, size_t num_bytes) {
+  for (size_t i = 0; i < num_bytes; i++) {
+    bytes[i] = (uint8_t)random_next();
+  }
+}
+
+// both kernels on the same tile, they have to agree
+static bool hash_both(const uint8_t *tile, uint16_t width, uint16_t height,
+                      uint32_t *digest) {
+  *digest = ZLCD_hash_tile(tile, TEST_STRIDE_BYTES, width, height);
+  uint32_t scalar =
+      ZLCD_hash_tile_scalar(tile, TEST_STRIDE_BYTES, width, height);
+  if (*digest != scalar) {
+    printf("%ux%u tile: ZLCD_hash_tile 0x%08x, ZLCD_hash_tile_scalar 0x%08x\n",
+           width, height, (unsigned)*digest, (unsigned)scalar);
+    return false;
+  }
+  return true;
+}
+
+/*
+Random tiles of every even width and height up to the tile size: both kernels
+agree, and changing any single word (pixel pair) to another value, one flipped
+bit or a random one, always changes the digest.
+*/
+static unsigned test_digests(void) {
+  static uint8_t tile[ZLCD_HASH_TILE_SIZE * TEST_STRIDE_BYTES];
+  unsigned failures = 0;
+  for (unsigned n = 0; n < TEST_TILES && failures < 10U; n++) {
+    uint16_t width = (uint16_t)(2U + random_next() % 8U * 2U);
+    uint16_t height = (uint16_t)(1U + random_next() % ZLCD_HASH_TILE_SIZE);
+    random_fill(tile, sizeof(tile));
+    uint32_t digest;
+    if (!hash_both(tile, width, height, &digest)) {
+      failures++;
+      continue;
+    }
+    // the single word changes, on every 16th tile to keep the run short
+    if (n % 16U != 0U) {
+      continue;
+    }
+    for (uint16_t y = 0; y < height; y++) {
+      for (uint16_t word = 0; word < width / 2U; word++) {
+        uint8_t *bytes = &tile[y * TEST_STRIDE_BYTES + word * 4U];
+        uint32_t old_word;
+        memcpy(&old_word, bytes, sizeof(old_word));
+        for (unsigned k = 0; k < 32U + TEST_CHANGES_PER_WORD; k++) {
+          uint32_t new_word =
+              k < 32U ? old_word ^ (1U << k) : random_next() | 1U;
+          if (new_word == old_word) {
+            continue;
+          }
+          memcpy(bytes, &new_word, sizeof(new_word));
+          uint32_t changed;
+          if (!hash_both(tile, width, height, &changed)) {
+            failures++;
+          } else if (changed == digest) {
+            printf("%ux%u tile: word %u of row %u 0x%08x -> 0x%08x kept "
+                   "digest 0x%08x\n",
+                   width, height, word, y, (unsigned)old_word,
+                   (unsigned)new_word, (unsigned)digest);
+            failures++;
+          }
+        }
+        memcpy(bytes, &old_word, sizeof(old_word));
+      }
+    }
+  }
+  return failures;
+}
+
+static st7789_emu panel;
+
+static void hook_gpio_write(void *context, u32 value) {
+  st7789_emu_gpio(context, value);
+}
+
+static void hook_spi_begin(void *context) { st7789_emu_spi_begin(context); }
+
+static void hook_spi_write(void *context, const u8 *bytes, u32 num_bytes) {
+  st7789_emu_spi_write(context, bytes, num_bytes);
+}
+
+static void hook_spi_end(void *context) { st7789_emu_spi_end(context); }
+
+// what the glass shows at frame pixel x, y of the portrait orientation
+static uint32_t shown(uint16_t x, uint16_t y) {
+  return st7789_emu_shown_pixel(&panel, ST7789_EMU_VISIBLE_X_OFFSET + x, y);
+}
+
+/*
+A pixel changed in the GRAM without being marked: the verify mode refresh has
+to count it, send it and leave nothing for the refresh after it.
+*/
+static unsigned test_verify(ZLCD_BUFFER_MODE buffer_mode) {
+  st7789_emu_init(&panel);
+  mock_bsp_hooks hooks = {.gpio_write = hook_gpio_write,
+                          .spi_begin = hook_spi_begin,
+                          .spi_write = hook_spi_write,
+                          .spi_end = hook_spi_end,
+                          .context = &panel};
+  mock_bsp_set_hooks(&hooks);
+  ZLCD_config config = ZLCD_create_config(ZLCD_PORTRAIT_ORIENTATION, BLACK);
+  config.buffer_mode = buffer_mode;
+  if (ZLCD_init_with_config(&config) != ZLCD_SUCCESS ||
+      ZLCD_set_refresh_mode(ZLCD_REFRESH_VERIFY) != ZLCD_SUCCESS) {
+    printf("ZLCD init failed\n");
+    return 1;
+  }
+  ZLCD_draw_filled_rectangle_xy(0, 0, 172, 320, 1, BLUE, BLUE, false);
+  ZLCD_set_pixel_xy(10, 10, YELLOW, false);
+  ZLCD_refresh_display();
+  ZLCD_reset_stats();
+
+  const uint16_t x = 101, y = 150;
+  ZLCD_gram_store(((size_t)y * current_kernels->frame_width + x) *
+                      sizeof(rgb565),
+                  YELLOW);
+  unsigned failures = 0;
+  if (shown(x, y) == shown(10, 10)) {
+    printf("the unmarked pixel is on the panel before the refresh\n");
+    failures++;
+  }
+  ZLCD_refresh_display();
+  ZLCD_stats stats;
+  ZLCD_get_stats(&stats);
+#if ZLCD_STATS_ENABLED
+  if (stats.verify_misses != 1) {
+    printf("verify counted %u unmarked changes, expected 1\n",
+           (unsigned)stats.verify_misses);
+    failures++;
+  }
+#endif
+  if (shown(x, y) != shown(10, 10)) {
+    printf("the unmarked pixel was not sent\n");
+    failures++;
+  }
+  st7789_emu_reset_stats(&panel);
+  ZLCD_refresh_display();
+  if (panel.stats.pixel_bytes != 0) {
+    printf("the refresh after it sent %llu pixel bytes\n",
+           (unsigned long long)panel.stats.pixel_bytes);
+    failures++;
+  }
+  return failures;
+}
+
+/*
+ZLCD_plan_refresh() gives the full count with a short list and leaves the dirty
+state so that the refresh after it sends the same windows
+*/
+static unsigned test_plan(void) {
+  // two areas far apart are two windows
+  ZLCD_draw_filled_rectangle_xy(5, 20, 30, 10, 1, RED, RED, false);
+  ZLCD_draw_filled_rectangle_xy(100, 250, 40, 20, 1, GREEN, GREEN, false);
+  static ZLCD_plan_entry entries[ZLCD_HEIGHT];
+  ZLCD_plan_entry first;
+  size_t num_entries = ZLCD_plan_refresh(entries, ZLCD_HEIGHT);
+  size_t again = ZLCD_plan_refresh(&first, 1);
+  unsigned failures = 0;
+  if (num_entries < 2 || again != num_entries ||
+      memcmp(&first, &entries[0], sizeof(first)) != 0) {
+    printf("plans of %zu and %zu windows differ\n", num_entries, again);
+    failures++;
+  }
+  ZLCD_refresh_display();
+  if (shown(6, 21) == shown(0, 0) || shown(101, 251) == shown(0, 0)) {
+    printf("the refresh after the plan did not send it\n");
+    failures++;
+  }
+  return failures;
+}
+
+/*
+ZLCD_indexed_present() writes the LCD without writing the GRAM, and the refresh
+after it sends the GRAM's rows again
+*/
+static unsigned test_overwritten(void) {
+  ZLCD_draw_filled_rectangle_xy(20, 40, 60, 60, 1, YELLOW, YELLOW, false);
+  ZLCD_refresh_display();
+  uint32_t gram_hash = st7789_emu_ram_hash(&panel);
+  static uint8_t current[ZLCD_WIDTH * ZLCD_HEIGHT * sizeof(rgb565)];
+  static uint8_t previous[ZLCD_WIDTH * ZLCD_HEIGHT * sizeof(rgb565)];
+  memcpy(current, GRAM_current, sizeof(current));
+  memcpy(previous, GRAM_previous, sizeof(previous));
+
+  const rgb565 colours[2] = {BLACK, WHITE};
+  ZLCD_indexed_load_palette(0, colours, 2, false);
+  ZLCD_indexed_begin(0);
+  ZLCD_indexed_rectangle(30, 100, 100, 50, 1, 1, true, 1);
+  ZLCD_indexed_present(NULL);
+  unsigned failures = 0;
+  if (memcmp(current, GRAM_current, sizeof(current)) != 0 ||
+      memcmp(previous, GRAM_previous, sizeof(previous)) != 0) {
+    printf("presenting the canvas wrote the GRAM\n");
+    failures++;
+  }
+  if (st7789_emu_ram_hash(&panel) == gram_hash) {
+    printf("the canvas is not on the panel\n");
+    failures++;
+  }
+  ZLCD_refresh_display();
+  if (st7789_emu_ram_hash(&panel) != gram_hash) {
+    printf("the refresh after the canvas did not send the GRAM again\n");
+    failures++;
+  }
+  return failures;
+}
+
+int main(int argc, char **argv) {
+  ZLCD_BUFFER_MODE buffer_mode = ZLCD_BUFFER_HASHED;
+  if (argc > 1 && strcmp(argv[1], "copy") == 0) {
+    buffer_mode = ZLCD_BUFFER_COPY;
+  } else if (argc > 1 && strcmp(argv[1], "hashed") != 0) {
+    printf("usage: %s [copy|hashed]\n", argv[0]);
+    return 2;
+  }
+  unsigned failures = test_digests();
+  failures += test_verify(buffer_mode);
+  failures += test_plan();
+  failures += test_overwritten();
+  if (failures != 0) {
+    printf("%u checks failed\n", failures);
+    return 1;
+  }
+  printf("digests and verify mode ok\n");
+  return 0;
+}
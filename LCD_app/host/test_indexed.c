@@ -0,0 +1,79 @@
+// white box: the expansion kernels are static
+#include "zynq_lcd_indexed.c"
+
+#include <stdio.h>
+
+/*************************************************
+  host test: palette expansion, NEON (mock_neon)
+  and scalar, against the palette itself
+**************************************************/
+
+#define TEST_ROWS 2000U
+// pixels after the expanded ones that must stay untouched
+#define TEST_GUARD_PIXELS 4U
+#define TEST_GUARD 0xA5A5U
+
+static uint32_t random_state = 0x2545F491U;
+
+static uint32_t random_next(void) {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+// a row of count indexes from both kernels, every pixel checked in wire order
+static unsigned check_row(const uint8_t *src, size_t count) {
+  static ZLCD_fill_pixel neon[ZLCD_INDEXED_MAX_WIDTH + TEST_GUARD_PIXELS];
+  static ZLCD_fill_pixel scalar[ZLCD_INDEXED_MAX_WIDTH + TEST_GUARD_PIXELS];
+  for (size_t i = 0; i < count + TEST_GUARD_PIXELS; i++) {
+    neon[i] = TEST_GUARD;
+    scalar[i] = TEST_GUARD;
+  }
+  ZLCD_indexed_expand(neon, src, count);
+  ZLCD_indexed_expand_scalar(scalar, src, count);
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t *bytes = (const uint8_t *)&neon[i];
+    rgb565 colour = (rgb565)(bytes[0] << 8 | bytes[1]);
+    if (colour != palette[src[i]] || neon[i] != scalar[i]) {
+      printf("%zu pixels: pixel %zu of index %u is 0x%04x (scalar 0x%04x), "
+             "expected 0x%04x\n",
+             count, i, src[i], colour, scalar[i], palette[src[i]]);
+      return 1;
+    }
+  }
+  for (size_t i = count; i < count + TEST_GUARD_PIXELS; i++) {
+    if (neon[i] != TEST_GUARD || scalar[i] != TEST_GUARD) {
+      printf("%zu pixels: pixel %zu past the end was written\n", count, i);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(void) {
+  for (unsigned i = 0; i < ZLCD_INDEXED_COLOURS; i++) {
+    ZLCD_indexed_store_palette((uint8_t)i, (rgb565)random_next());
+  }
+  static uint8_t src[ZLCD_INDEXED_MAX_WIDTH];
+  unsigned failures = 0;
+  // every index in order, so each part of the tables is hit
+  for (size_t i = 0; i < ZLCD_INDEXED_MAX_WIDTH; i++) {
+    src[i] = (uint8_t)i;
+  }
+  failures += check_row(src, ZLCD_INDEXED_MAX_WIDTH);
+  // random rows of every length up to the widest frame row, tails included
+  for (unsigned row = 0; row < TEST_ROWS; row++) {
+    size_t count = random_next() % (ZLCD_INDEXED_MAX_WIDTH + 1U);
+    for (size_t i = 0; i < count; i++) {
+      src[i] = (uint8_t)random_next();
+    }
+    failures += check_row(src, count);
+  }
+  if (failures != 0) {
+    printf("%u rows failed\n", failures);
+    return 1;
+  }
+  printf("palette expansion ok\n");
+  return 0;
+}
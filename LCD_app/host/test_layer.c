@@ -0,0 +1,216 @@
+// white box: the test looks at the damage list before every compose
+#include "zynq_lcd_layer.c"
+
+#include "mock_bsp.h"
+#include "st7789_emulator.h"
+
+#include <stdio.h>
+
+/*************************************************
+  host test: layer compositor damage and the
+  composed pixels on the emulated panel
+**************************************************/
+
+#define TEST_WIDTH 172U
+#define TEST_HEIGHT 320U
+#define TEST_KEY RED
+
+static st7789_emu panel;
+
+static void hook_gpio_write(void *context, u32 value) {
+  st7789_emu_gpio(context, value);
+}
+
+static void hook_spi_begin(void *context) { st7789_emu_spi_begin(context); }
+
+static void hook_spi_write(void *context, const u8 *bytes, u32 num_bytes) {
+  st7789_emu_spi_write(context, bytes, num_bytes);
+}
+
+static void hook_spi_end(void *context) { st7789_emu_spi_end(context); }
+
+// a 40x30 gradient in a 48 pixel stride, and a 20x20 square with a keyed ring
+static rgb565 opaque_pixels[30 * 48];
+static rgb565 keyed_pixels[20 * 20];
+static const ZLCD_surface opaque = {opaque_pixels, 40, 30, 48};
+static const ZLCD_surface keyed = {keyed_pixels, 20, 20, 20};
+
+static void make_surfaces(void) {
+  for (uint16_t y = 0; y < opaque.height; y++) {
+    for (uint16_t x = 0; x < opaque.stride; x++) {
+      opaque_pixels[y * opaque.stride + x] =
+          x < opaque.width ? ZLCD_construct_rgb565(x * 6, y * 8, 200) : WHITE;
+    }
+  }
+  for (uint16_t y = 0; y < keyed.height; y++) {
+    for (uint16_t x = 0; x < keyed.width; x++) {
+      bool ring = x < 3 || y < 3 || x >= keyed.width - 3 ||
+                  y >= keyed.height - 3;
+      keyed_pixels[y * keyed.stride + x] = ring ? TEST_KEY : YELLOW;
+    }
+  }
+}
+
+/*
+The damage list has to hold exactly these rectangles, in any order. Checked
+before the compose, which empties it
+*/
+static unsigned expect_damage(const char *step, const ZLCD_layer_rect *rects,
+                              uint8_t num_rects) {
+  bool matched[ZLCD_MAX_DAMAGE] = {false};
+  unsigned failures = num_damage != num_rects || damage_all;
+  for (uint8_t i = 0; i < num_rects && !failures; i++) {
+    bool found = false;
+    for (uint8_t d = 0; d < num_damage && !found; d++) {
+      found = !matched[d] && damage[d].x0 == rects[i].x0 &&
+              damage[d].y0 == rects[i].y0 && damage[d].x1 == rects[i].x1 &&
+              damage[d].y1 == rects[i].y1;
+      matched[d] = found;
+    }
+    failures += !found;
+  }
+  if (failures != 0) {
+    printf("%s: %u damage rectangles, expected %u:\n", step, num_damage,
+           num_rects);
+    for (uint8_t d = 0; d < num_damage; d++) {
+      printf("  (%d, %d) to (%d, %d)\n", damage[d].x0, damage[d].y0,
+             damage[d].x1, damage[d].y1);
+    }
+  }
+  return failures;
+}
+
+/*
+Composes and compares every pixel of the panel RAM with the layers blended
+over the background row by row with the scalar kernel
+*/
+static unsigned compose_and_check(const char *step, uint16_t rectangles,
+                                  uint32_t pixels) {
+  ZLCD_layer_stats stats;
+  if (ZLCD_layer_compose(&stats, true) != ZLCD_SUCCESS) {
+    printf("%s: ZLCD_layer_compose failed\n", step);
+    return 1;
+  }
+  unsigned failures = 0;
+  if (stats.rectangles != rectangles || stats.pixels != pixels) {
+    printf("%s: composed %u rectangles, %u pixels, expected %u, %u\n", step,
+           stats.rectangles, (unsigned)stats.pixels, rectangles,
+           (unsigned)pixels);
+    failures++;
+  }
+  static rgb565 row[TEST_WIDTH];
+  for (uint16_t y = 0; y < TEST_HEIGHT && failures == 0; y++) {
+    for (uint16_t x = 0; x < TEST_WIDTH; x++) {
+      row[x] = layer_background;
+    }
+    for (uint8_t i = 0; i < ZLCD_MAX_LAYERS; i++) {
+      const ZLCD_layer_state *l = &layers[i];
+      int32_t surface_y = (int32_t)y - l->y;
+      if (!l->attached || !l->visible || surface_y < 0 ||
+          surface_y >= l->surface.height) {
+        continue;
+      }
+      int32_t x0 = l->x > 0 ? l->x : 0;
+      int32_t x1 = (int32_t)l->x + l->surface.width - 1;
+      x1 = x1 < (int32_t)TEST_WIDTH - 1 ? x1 : (int32_t)TEST_WIDTH - 1;
+      if (x0 <= x1) {
+        ZLCD_blend_span_scalar(
+            &row[x0],
+            &l->surface.pixels[surface_y * l->surface.stride + (x0 - l->x)],
+            x1 - x0 + 1, l->alpha, l->keyed, l->key);
+      }
+    }
+    for (uint16_t x = 0; x < TEST_WIDTH; x++) {
+      const uint8_t *rgb = panel.ram[y][ST7789_EMU_VISIBLE_X_OFFSET + x];
+      rgb565 shown = (rgb565)((rgb[0] >> 3) << 11 | (rgb[1] >> 2) << 5 |
+                              rgb[2] >> 3);
+      if (shown != row[x]) {
+        printf("%s: pixel (%u, %u) is 0x%04x, expected 0x%04x\n", step, x, y,
+               shown, row[x]);
+        failures++;
+        break;
+      }
+    }
+  }
+  return failures;
+}
+
+int main(void) {
+  st7789_emu_init(&panel);
+  mock_bsp_hooks hooks = {.gpio_write = hook_gpio_write,
+                          .spi_begin = hook_spi_begin,
+                          .spi_write = hook_spi_write,
+                          .spi_end = hook_spi_end,
+                          .context = &panel};
+  mock_bsp_set_hooks(&hooks);
+  ZLCD_config config = ZLCD_create_config(ZLCD_PORTRAIT_ORIENTATION, BLACK);
+  if (ZLCD_init_with_config(&config) != ZLCD_SUCCESS) {
+    printf("ZLCD init failed\n");
+    return 1;
+  }
+  make_surfaces();
+  unsigned failures = 0;
+
+  // the first compose covers the whole screen, whatever was damaged
+  ZLCD_layer_set_background(NAVY_GREEN);
+  ZLCD_layer_attach(0, &opaque, 10, 20);
+  ZLCD_layer_attach(1, &keyed, 30, 30);
+  ZLCD_layer_set_alpha(1, 128);
+  ZLCD_layer_set_key(1, true, TEST_KEY);
+  failures += compose_and_check("first", 1, TEST_WIDTH * TEST_HEIGHT);
+
+  // where it was and where it is, too far apart to be merged
+  static const ZLCD_layer_rect moved[] = {{10, 20, 49, 49}, {50, 60, 89, 89}};
+  ZLCD_layer_move(0, 50, 60);
+  failures += expect_damage("move", moved, 2);
+  failures += compose_and_check("move", 2, 2U * 40U * 30U);
+
+  // a move onto an overlapping spot is one rectangle around both
+  static const ZLCD_layer_rect overlapped[] = {{50, 60, 99, 99}};
+  ZLCD_layer_move(0, 60, 70);
+  failures += expect_damage("overlap", overlapped, 1);
+  failures += compose_and_check("overlap", 1, 50U * 40U);
+
+  // hidden, the layer under it and the background show again
+  static const ZLCD_layer_rect square[] = {{30, 30, 49, 49}};
+  ZLCD_layer_set_visible(1, false);
+  failures += expect_damage("hide", square, 1);
+  failures += compose_and_check("hide", 1, 20U * 20U);
+
+  // and shown again
+  ZLCD_layer_set_visible(1, true);
+  failures += expect_damage("show", square, 1);
+  failures += compose_and_check("show", 1, 20U * 20U);
+
+  // keyed on another colour, the ring shows and the inside goes
+  ZLCD_layer_set_key(1, true, YELLOW);
+  failures += expect_damage("re-key", square, 1);
+  failures += compose_and_check("re-key", 1, 20U * 20U);
+
+  // the same key again changes nothing
+  ZLCD_layer_set_key(1, true, YELLOW);
+  failures += expect_damage("same key", NULL, 0);
+  failures += compose_and_check("same key", 0, 0);
+
+  // off the bottom left corner, only the part on the screen is damaged
+  static const ZLCD_layer_rect off_screen[] = {{60, 70, 99, 99},
+                                               {0, 300, 29, 319}};
+  ZLCD_layer_move(0, -10, 300);
+  failures += expect_damage("off screen", off_screen, 2);
+  failures += compose_and_check("off screen", 2, 40U * 30U + 30U * 20U);
+
+  // detached, and the key off: both go back to what is under them
+  static const ZLCD_layer_rect detached[] = {{0, 300, 29, 319},
+                                             {30, 30, 49, 49}};
+  ZLCD_layer_detach(0);
+  ZLCD_layer_set_key(1, false, 0);
+  failures += expect_damage("detach", detached, 2);
+  failures += compose_and_check("detach", 2, 30U * 20U + 20U * 20U);
+
+  if (failures != 0) {
+    printf("%u checks failed\n", failures);
+    return 1;
+  }
+  printf("damage and composed pixels as expected\n");
+  return 0;
+}
@@ -0,0 +1,152 @@
+#include "zynq_lcd_pack.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*************************************************
+  host test: RGB444 packing, plain and dithered,
+  NEON (mock_neon) and scalar, decoded back
+**************************************************/
+
+#define TEST_ROWS 2000U
+#define TEST_MAX_WIDTH 320U
+// bytes after the packed ones that must stay untouched
+#define TEST_GUARD_BYTES 8U
+#define TEST_GUARD 0xA5U
+
+typedef void (*pack_function)(uint8_t *dst, const uint8_t *src, size_t count);
+typedef void (*dithered_function)(uint8_t *dst, const uint8_t *src,
+                                  size_t count, uint16_t x, uint16_t y);
+
+static const uint8_t bayer4[4][4] = {
+    {0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+
+static uint32_t random_state = 0x2545F491U;
+
+static uint32_t random_next(void) {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+/*
+A channel of bits bits down to 4, rounded up where the dropped fraction plus
+the threshold (in 16ths) reaches one, 15 at most. Without dither the threshold
+is 0 and the bits are simply dropped.
+*/
+static uint8_t expected_channel(unsigned value, unsigned bits,
+                                unsigned threshold) {
+  unsigned dropped = bits - 4U;
+  unsigned result = value >> dropped;
+  unsigned fraction16 = (value & ((1U << dropped) - 1U)) << (4U - dropped);
+  if (fraction16 + threshold >= 16U && result < 15U) {
+    result++;
+  }
+  return (uint8_t)result;
+}
+
+// pixel i of a wire order (MSB first) RGB565 row as R, G, B of 4 bits
+static void expected_pixel(const uint8_t *src, size_t i, unsigned threshold,
+                           uint8_t rgb[3]) {
+  unsigned pixel = (unsigned)src[2 * i] << 8 | src[2 * i + 1];
+  rgb[0] = expected_channel(pixel >> 11, 5, threshold);
+  rgb[1] = expected_channel((pixel >> 5) & 0x3FU, 6, threshold);
+  rgb[2] = expected_channel(pixel & 0x1FU, 5, threshold);
+}
+
+// pixel i of the packed stream, R0G0 B0R1 G1B1 for every pair
+static void decoded_pixel(const uint8_t *packed, size_t i, uint8_t rgb[3]) {
+  const uint8_t *pair = &packed[i / 2U * 3U];
+  unsigned bits = (unsigned)pair[0] << 16 | (unsigned)pair[1] << 8 | pair[2];
+  unsigned shift = (i & 1U) ? 0U : 12U;
+  rgb[0] = (uint8_t)((bits >> (shift + 8U)) & 0x0FU);
+  rgb[1] = (uint8_t)((bits >> (shift + 4U)) & 0x0FU);
+  rgb[2] = (uint8_t)((bits >> shift) & 0x0FU);
+}
+
+/*
+Checks one packed row: every pixel of the pairs decodes to the expected one and
+nothing after ZLCD_PACK_RGB444_BYTES(width) was written. An odd last pixel is
+not packed, the driver only sends even widths.
+*/
+static bool check_row(const char *name, const uint8_t *src,
+                      const uint8_t *packed, size_t width, bool dither,
+                      uint16_t x, uint16_t y) {
+  size_t pairs = width / 2U;
+  for (size_t i = 0; i < pairs * 2U; i++) {
+    unsigned threshold = dither ? bayer4[y & 3U][(x + i) & 3U] : 0U;
+    uint8_t expected[3], decoded[3];
+    expected_pixel(src, i, threshold, expected);
+    decoded_pixel(packed, i, decoded);
+    if (memcmp(expected, decoded, sizeof(expected)) != 0) {
+      printf("%s: width %zu x %u y %u pixel %zu 0x%02x%02x packed to "
+             "%x%x%x, expected %x%x%x\n",
+             name, width, x, y, i, src[2 * i], src[2 * i + 1], decoded[0],
+             decoded[1], decoded[2], expected[0], expected[1], expected[2]);
+      return false;
+    }
+  }
+  for (size_t i = 0; i < TEST_GUARD_BYTES; i++) {
+    if (packed[ZLCD_PACK_RGB444_BYTES(width) + i] != TEST_GUARD) {
+      printf("%s: width %zu wrote past its %zu bytes\n", name, width,
+             (size_t)ZLCD_PACK_RGB444_BYTES(width));
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(void) {
+  static const struct {
+    const char *name;
+    pack_function pack;
+  } plain[] = {{"ZLCD_pack_rgb444", ZLCD_pack_rgb444},
+               {"ZLCD_pack_rgb444_scalar", ZLCD_pack_rgb444_scalar}};
+  static const struct {
+    const char *name;
+    dithered_function pack;
+  } dithered[] = {
+      {"ZLCD_pack_rgb444_dithered", ZLCD_pack_rgb444_dithered},
+      {"ZLCD_pack_rgb444_dithered_scalar", ZLCD_pack_rgb444_dithered_scalar}};
+
+  static uint8_t src[TEST_MAX_WIDTH * 2U];
+  static uint8_t packed[ZLCD_PACK_RGB444_BYTES(TEST_MAX_WIDTH) +
+                        TEST_GUARD_BYTES];
+  unsigned failures = 0;
+  for (unsigned row = 0; row < TEST_ROWS; row++) {
+    // every width up to a few NEON passes and their tails, then random ones
+    size_t width = row <= 2U * 32U + 3U ? row : random_next() % TEST_MAX_WIDTH;
+    width += width == 0U;
+    uint16_t x = (uint16_t)(random_next() % (TEST_MAX_WIDTH / 2U) * 2U);
+    uint16_t y = (uint16_t)(random_next() % TEST_MAX_WIDTH);
+    for (size_t i = 0; i < width * 2U; i++) {
+      src[i] = (uint8_t)random_next();
+    }
+    // the extremes, where the dither has to clamp at 15
+    if (row % 8U == 0U) {
+      memset(src, row % 16U == 0U ? 0xFF : 0x00, width * 2U);
+    }
+    for (size_t k = 0; k < sizeof(plain) / sizeof(plain[0]); k++) {
+      memset(packed, TEST_GUARD, sizeof(packed));
+      plain[k].pack(packed, src, width);
+      failures += !check_row(plain[k].name, src, packed, width, false, x, y);
+    }
+    for (size_t k = 0; k < sizeof(dithered) / sizeof(dithered[0]); k++) {
+      memset(packed, TEST_GUARD, sizeof(packed));
+      dithered[k].pack(packed, src, width, x, y);
+      failures += !check_row(dithered[k].name, src, packed, width, true, x, y);
+    }
+    if (failures > 10U) {
+      break;
+    }
+  }
+  if (failures != 0) {
+    printf("%u rows failed\n", failures);
+    return 1;
+  }
+  printf("%u rows packed the same as decoded\n", TEST_ROWS);
+  return 0;
+}
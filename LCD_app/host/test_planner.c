@@ -0,0 +1,224 @@
+#include "zynq_lcd_planner.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*************************************************
+  host test: refresh window planner, hand built
+  dirty rows against the exact windows planned
+**************************************************/
+
+#define TEST_MAX_ENTRIES 8U
+
+static uint16_t x_start[ZLCD_HEIGHT];
+static uint16_t x_end[ZLCD_HEIGHT];
+
+// nothing known about the controller, as after init or a foreign command
+static ZLCD_plan_state unknown_state(uint8_t bits_per_pixel) {
+  ZLCD_plan_state state = {.col_start = ZLCD_PLAN_UNKNOWN,
+                           .col_end = ZLCD_PLAN_UNKNOWN,
+                           .row_start = ZLCD_PLAN_UNKNOWN,
+                           .pointer_row = ZLCD_PLAN_UNKNOWN,
+                           .width = ZLCD_WIDTH,
+                           .height = ZLCD_HEIGHT,
+                           .bits_per_pixel = bits_per_pixel};
+  return state;
+}
+
+// the window set up on the controller, and where its write pointer stopped
+static ZLCD_plan_state window_state(uint16_t col_start, uint16_t col_end,
+                                    uint16_t row_start, uint16_t pointer_row) {
+  ZLCD_plan_state state = unknown_state(16);
+  state.col_start = col_start;
+  state.col_end = col_end;
+  state.row_start = row_start;
+  state.pointer_row = pointer_row;
+  return state;
+}
+
+static void clear_rows(void) {
+  memset(x_start, 0, sizeof(x_start));
+  memset(x_end, 0, sizeof(x_end));
+}
+
+// pixels x0 to x1 of the rows y0 to y1 changed
+static void mark_rows(uint16_t y0, uint16_t y1, uint16_t x0, uint16_t x1) {
+  for (uint16_t y = y0; y <= y1; y++) {
+    x_start[y] = x0;
+    x_end[y] = x1 + 1U;
+  }
+}
+
+static bool same_state(const ZLCD_plan_state *a, const ZLCD_plan_state *b) {
+  return a->col_start == b->col_start && a->col_end == b->col_end &&
+         a->row_start == b->row_start && a->pointer_row == b->pointer_row;
+}
+
+/*
+Plans the marked rows from state and compares every entry, and the state the
+plan leaves behind, with the expected ones.
+*/
+static unsigned check_plan(const char *name, ZLCD_plan_state state,
+                           size_t max_entries, const ZLCD_plan_entry *expected,
+                           size_t num_expected,
+                           const ZLCD_plan_state *expected_state) {
+  ZLCD_plan_entry entries[TEST_MAX_ENTRIES];
+  size_t num_entries = ZLCD_plan_windows(x_start, x_end, 0, ZLCD_HEIGHT,
+                                         &state, entries, max_entries);
+  bool matches = num_entries == num_expected;
+  for (size_t i = 0; i < num_entries && matches; i++) {
+    matches = entries[i].x0 == expected[i].x0 &&
+              entries[i].x1 == expected[i].x1 &&
+              entries[i].y0 == expected[i].y0 &&
+              entries[i].y1 == expected[i].y1 &&
+              entries[i].continue_write == expected[i].continue_write;
+  }
+  unsigned failures = 0;
+  if (!matches) {
+    printf("%s: %zu entries, expected %zu:\n", name, num_entries,
+           num_expected);
+    for (size_t i = 0; i < num_entries; i++) {
+      printf("  (%u, %u) to (%u, %u)%s\n", entries[i].x0, entries[i].y0,
+             entries[i].x1, entries[i].y1,
+             entries[i].continue_write ? " RAMWRC" : "");
+    }
+    failures++;
+  }
+  if (!same_state(&state, expected_state)) {
+    printf("%s: left columns %u to %u, rows from %u, pointer at %u\n", name,
+           state.col_start, state.col_end, state.row_start, state.pointer_row);
+    failures++;
+  }
+  return failures;
+}
+
+static unsigned check_cost(const char *name, const ZLCD_plan_state *state,
+                           ZLCD_plan_entry entry, uint32_t expected) {
+  uint32_t cost = ZLCD_plan_entry_cost(state, &entry);
+  if (cost != expected) {
+    printf("%s: costs %u, expected %u\n", name, (unsigned)cost,
+           (unsigned)expected);
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  unsigned failures = 0;
+  const ZLCD_plan_state unknown = unknown_state(16);
+  const ZLCD_plan_state packed = unknown_state(12);
+
+  /*
+  With the default costs a command is 11 byte times and CASET or RASET with
+  their parameters 25. Every window then pays a DC toggle (2), 8 per transfer
+  and its pixel bytes.
+  */
+  const ZLCD_plan_state known = window_state(20, 29, 5, ZLCD_PLAN_UNKNOWN);
+  failures += check_cost("both known", &known,
+                         (ZLCD_plan_entry){20, 29, 5, 5, false},
+                         11U + 2U + 8U + 20U);
+  failures += check_cost("new columns", &known,
+                         (ZLCD_plan_entry){0, 9, 5, 5, false},
+                         11U + 25U + 2U + 8U + 20U);
+  failures += check_cost("new rows", &known,
+                         (ZLCD_plan_entry){20, 29, 6, 6, false},
+                         11U + 25U + 2U + 8U + 20U);
+  failures += check_cost("nothing known", &unknown,
+                         (ZLCD_plan_entry){20, 29, 10, 13, false},
+                         11U + 50U + 2U + 4U * 8U + 80U);
+  failures += check_cost("continued", &known,
+                         (ZLCD_plan_entry){20, 29, 6, 7, true},
+                         11U + 2U + 2U * 8U + 40U);
+  // full width rows are contiguous, one transfer
+  failures += check_cost("full width", &unknown,
+                         (ZLCD_plan_entry){0, ZLCD_WIDTH - 1U, 0, 1, false},
+                         11U + 50U + 2U + 8U + 2U * ZLCD_WIDTH * 2U);
+  // packed rows are one transfer of 1.5 bytes a pixel
+  failures += check_cost("packed", &packed,
+                         (ZLCD_plan_entry){20, 29, 10, 13, false},
+                         11U + 50U + 2U + 8U + 60U);
+
+  // rows next to each other: 119 merged against 91 + 41 split
+  static const ZLCD_plan_entry merged[] = {{20, 29, 10, 13, false}};
+  const ZLCD_plan_state after_merged = window_state(20, 29, 10, 14);
+  clear_rows();
+  mark_rows(10, 13, 20, 29);
+  failures += check_plan("merge", unknown, TEST_MAX_ENTRIES, merged, 1,
+                         &after_merged);
+
+  // far apart: the second window keeps the columns and only sends RASET
+  static const ZLCD_plan_entry split[] = {{20, 29, 10, 10, false},
+                                          {20, 29, 200, 200, false}};
+  const ZLCD_plan_state after_split = window_state(20, 29, 200, 201);
+  clear_rows();
+  mark_rows(10, 10, 20, 29);
+  mark_rows(200, 200, 20, 29);
+  failures += check_plan("split", unknown, TEST_MAX_ENTRIES, split, 2,
+                         &after_split);
+
+  // the same rows with room for one entry only: one window over the gap
+  static const ZLCD_plan_entry forced[] = {{20, 29, 10, 200, false}};
+  const ZLCD_plan_state after_forced = window_state(20, 29, 10, 201);
+  failures += check_plan("forced merge", unknown, 1, forced, 1, &after_forced);
+
+  // and with two entries for three rows, the last two share one
+  static const ZLCD_plan_entry forced_last[] = {{20, 29, 10, 10, false},
+                                                {20, 29, 100, 200, false}};
+  const ZLCD_plan_state after_forced_last = window_state(20, 29, 100, 201);
+  mark_rows(100, 100, 20, 29);
+  failures += check_plan("forced last merge", unknown, 2, forced_last, 2,
+                         &after_forced_last);
+
+  // the pointer stopped where the rows go on: RAMWRC, window left as it was
+  static const ZLCD_plan_entry continued[] = {{20, 29, 50, 51, true}};
+  const ZLCD_plan_state after_continued = window_state(20, 29, 0, 52);
+  const ZLCD_plan_state stopped = window_state(20, 29, 0, 50);
+  clear_rows();
+  mark_rows(50, 51, 20, 29);
+  failures += check_plan("continue", stopped, TEST_MAX_ENTRIES, continued, 1,
+                         &after_continued);
+
+  // other columns are a new window even with the pointer in place
+  static const ZLCD_plan_entry widened[] = {{10, 29, 50, 51, false}};
+  const ZLCD_plan_state after_widened = window_state(10, 29, 50, 52);
+  mark_rows(50, 51, 10, 29);
+  failures += check_plan("widened", stopped, TEST_MAX_ENTRIES, widened, 1,
+                         &after_widened);
+
+  // the pointer wraps after the last row, so it is not known any more
+  static const ZLCD_plan_entry bottom[] = {
+      {0, ZLCD_WIDTH - 1U, ZLCD_HEIGHT - 2U, ZLCD_HEIGHT - 1U, false}};
+  const ZLCD_plan_state after_bottom = window_state(
+      0, ZLCD_WIDTH - 1U, ZLCD_HEIGHT - 2U, ZLCD_PLAN_UNKNOWN);
+  clear_rows();
+  mark_rows(ZLCD_HEIGHT - 2U, ZLCD_HEIGHT - 1U, 0, ZLCD_WIDTH - 1U);
+  failures += check_plan("bottom", unknown, TEST_MAX_ENTRIES, bottom, 1,
+                         &after_bottom);
+
+  /*
+  Two rows of 10 pixels with two clean rows between them. At 16 bpp the merge
+  (175) sends three more transfers and loses to the split (91 + 66), packed
+  the gap is only 30 bytes and merging (131) beats splitting (86 + 61).
+  */
+  static const ZLCD_plan_entry gap_split[] = {{20, 29, 10, 10, false},
+                                              {20, 29, 13, 13, false}};
+  const ZLCD_plan_state after_gap_split = window_state(20, 29, 13, 14);
+  static const ZLCD_plan_entry gap_merged[] = {{20, 29, 10, 13, false}};
+  const ZLCD_plan_state after_gap_merged = window_state(20, 29, 10, 14);
+  clear_rows();
+  mark_rows(10, 10, 20, 29);
+  mark_rows(13, 13, 20, 29);
+  failures += check_plan("gap at 16 bpp", unknown, TEST_MAX_ENTRIES, gap_split,
+                         2, &after_gap_split);
+  failures += check_plan("gap packed", packed, TEST_MAX_ENTRIES, gap_merged, 1,
+                         &after_gap_merged);
+
+  if (failures != 0) {
+    printf("%u checks failed\n", failures);
+    return 1;
+  }
+  printf("windows planned as expected\n");
+  return 0;
+}
@@ -0,0 +1,222 @@
+#include "mock_bsp.h"
+#include "st7789_emulator.h"
+#include "zynq_lcd_st7789.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*************************************************
+  host test: hardware scrolling, the glass of the
+  emulated panel against a model of the frame
+**************************************************/
+
+#define TEST_TOP_FIXED 20U
+#define TEST_BOTTOM_FIXED 40U
+#define TEST_AREA (ZLCD_HEIGHT - TEST_TOP_FIXED - TEST_BOTTOM_FIXED)
+#define TEST_AREA_END (ZLCD_HEIGHT - TEST_BOTTOM_FIXED)
+
+static st7789_emu panel;
+
+static void hook_gpio_write(void *context, u32 value) {
+  st7789_emu_gpio(context, value);
+}
+
+static void hook_spi_begin(void *context) { st7789_emu_spi_begin(context); }
+
+static void hook_spi_write(void *context, const u8 *bytes, u32 num_bytes) {
+  st7789_emu_spi_write(context, bytes, num_bytes);
+}
+
+static void hook_spi_end(void *context) { st7789_emu_spi_end(context); }
+
+// what the glass should show, in rows of the portrait frame
+static rgb565 frame[ZLCD_HEIGHT][ZLCD_WIDTH];
+static uint16_t scroll_top = 0;
+static uint16_t scroll_height = ZLCD_HEIGHT;
+static uint16_t scroll_offset = 0;
+static ZLCD_frame_layout layout;
+
+/*
+Draws colour over every screen pixel that lands in the frame rows row0 to
+row1, in whatever orientation, and notes it in the model
+*/
+static void draw_frame_rows(uint16_t row0, uint16_t row1, rgb565 colour) {
+  for (uint16_t y = 0; y < layout.height; y++) {
+    for (uint16_t x = 0; x < layout.width; x++) {
+      int32_t p = layout.origin + x * layout.x_step + y * layout.y_step;
+      uint16_t row = (uint16_t)(p / layout.frame_width);
+      uint16_t column = (uint16_t)(p % layout.frame_width);
+      if (row < row0 || row > row1) {
+        continue;
+      }
+      // a few pixels off the row colour so that columns are checked too
+      rgb565 pixel = (row * 3U + column) % 29U == 0U ? WHITE : colour;
+      (void)ZLCD_set_pixel_xy(x, y, pixel, false);
+      frame[row][column] = pixel;
+    }
+  }
+}
+
+// the panel moves the rows of the area up, the model follows
+static void scroll_model(uint16_t offset) {
+  static rgb565 area[ZLCD_HEIGHT][ZLCD_WIDTH];
+  uint16_t delta =
+      (uint16_t)((offset + scroll_height - scroll_offset) % scroll_height);
+  memcpy(area, frame[scroll_top], scroll_height * sizeof(area[0]));
+  for (uint16_t r = 0; r < scroll_height; r++) {
+    memcpy(frame[scroll_top + r], area[(r + delta) % scroll_height],
+           sizeof(area[0]));
+  }
+  scroll_offset = offset;
+}
+
+/*
+Every pixel of the glass has to be the model's, and the step must have sent
+exactly pixels pixels (the emulator's count since the last check)
+*/
+static unsigned check_glass(const char *step, uint64_t pixels) {
+  unsigned failures = 0;
+  if (panel.stats.pixels != pixels) {
+    printf("%s: %llu pixels sent, expected %llu\n", step,
+           (unsigned long long)panel.stats.pixels,
+           (unsigned long long)pixels);
+    failures++;
+  }
+  for (uint16_t y = 0; y < ZLCD_HEIGHT && failures == 0; y++) {
+    for (uint16_t x = 0; x < ZLCD_WIDTH; x++) {
+      uint32_t rgb =
+          st7789_emu_shown_pixel(&panel, ST7789_EMU_VISIBLE_X_OFFSET + x, y);
+      rgb565 shown = (rgb565)((rgb >> 19 & 0x1FU) << 11 |
+                              (rgb >> 10 & 0x3FU) << 5 | (rgb >> 3 & 0x1FU));
+      if (shown != frame[y][x]) {
+        printf("%s: glass (%u, %u) is 0x%04x, expected 0x%04x\n", step, x, y,
+               shown, frame[y][x]);
+        failures++;
+        break;
+      }
+    }
+  }
+  st7789_emu_reset_stats(&panel);
+  return failures;
+}
+
+static unsigned scroll_and_check(const char *step, uint16_t offset) {
+  if (ZLCD_scroll_to(offset) != ZLCD_SUCCESS) {
+    printf("%s: ZLCD_scroll_to(%u) failed\n", step, offset);
+    return 1;
+  }
+  scroll_model(offset);
+  // one VSCSAD and not a single pixel
+  unsigned failures = check_glass(step, 0);
+  (void)ZLCD_refresh_display();
+  return failures + check_glass(step, 0);
+}
+
+// a new area starts at offset 0, so the old one scrolls back first
+static unsigned define_and_check(const char *step, uint16_t top_fixed_rows,
+                                 uint16_t bottom_fixed_rows) {
+  if (ZLCD_scroll_define(top_fixed_rows, bottom_fixed_rows) != ZLCD_SUCCESS) {
+    printf("%s: ZLCD_scroll_define failed\n", step);
+    return 1;
+  }
+  scroll_model(0);
+  scroll_top = top_fixed_rows;
+  scroll_height = ZLCD_HEIGHT - top_fixed_rows - bottom_fixed_rows;
+  unsigned failures = check_glass(step, 0);
+  (void)ZLCD_refresh_display();
+  return failures + check_glass(step, 0);
+}
+
+static unsigned refresh_and_check(const char *step, uint64_t pixels) {
+  if (ZLCD_refresh_display() != ZLCD_SUCCESS) {
+    printf("%s: ZLCD_refresh_display failed\n", step);
+    return 1;
+  }
+  return check_glass(step, pixels);
+}
+
+int main(int argc, char **argv) {
+  ZLCD_ORIENTATION orientation = ZLCD_PORTRAIT_ORIENTATION;
+  ZLCD_ROTATION_MODE rotation_mode = ZLCD_ROTATE_SOFTWARE;
+  if (argc > 1 && strcmp(argv[1], "inverted_portrait") == 0) {
+    orientation = ZLCD_INVERTED_PORTRAIT_ORIENTATION;
+  } else if (argc > 1 && strcmp(argv[1], "landscape") == 0) {
+    orientation = ZLCD_LANDSCAPE_ORIENTATION;
+  } else if (argc > 1 && strcmp(argv[1], "inverted_landscape") == 0) {
+    orientation = ZLCD_INVERTED_LANDSCAPE_ORIENTATION;
+  } else if (argc > 1 && strcmp(argv[1], "madctl") == 0) {
+    rotation_mode = ZLCD_ROTATE_MADCTL;
+  } else if (argc > 1 && strcmp(argv[1], "portrait") != 0) {
+    printf("usage: %s [portrait|inverted_portrait|landscape|"
+           "inverted_landscape|madctl]\n",
+           argv[0]);
+    return 1;
+  }
+
+  st7789_emu_init(&panel);
+  mock_bsp_hooks hooks = {.gpio_write = hook_gpio_write,
+                          .spi_begin = hook_spi_begin,
+                          .spi_write = hook_spi_write,
+                          .spi_end = hook_spi_end,
+                          .context = &panel};
+  mock_bsp_set_hooks(&hooks);
+  ZLCD_config config = ZLCD_create_config(orientation, BLACK);
+  config.rotation_mode = rotation_mode;
+  if (ZLCD_init_with_config(&config) != ZLCD_SUCCESS ||
+      ZLCD_get_frame_layout(&layout) != ZLCD_SUCCESS) {
+    printf("ZLCD init failed\n");
+    return 1;
+  }
+  unsigned failures = 0;
+
+  // a colour for every frame row, all of them sent once
+  for (uint16_t row = 0; row < ZLCD_HEIGHT; row++) {
+    draw_frame_rows(row, row, (rgb565)(row * 199U + 0x0841U));
+  }
+  st7789_emu_reset_stats(&panel);
+  failures += refresh_and_check("drawn", (uint64_t)ZLCD_WIDTH * ZLCD_HEIGHT);
+
+  failures += define_and_check("defined", TEST_TOP_FIXED, TEST_BOTTOM_FIXED);
+  failures += scroll_and_check("scrolled", 50);
+
+  // the rows that came back round at the bottom of the area, and only those
+  draw_frame_rows(TEST_AREA_END - 50U, TEST_AREA_END - 1U, RED);
+  failures += refresh_and_check("bottom redrawn", 50U * ZLCD_WIDTH);
+
+  // past the end of the ring, where the refresh has to split its windows
+  failures += scroll_and_check("wrapped", 200);
+  draw_frame_rows(70, 90, GREEN);
+  failures += refresh_and_check("across the wrap", 21U * ZLCD_WIDTH);
+
+  // the fixed rows are not moved
+  draw_frame_rows(5, 5, BLUE);
+  draw_frame_rows(ZLCD_HEIGHT - 5U, ZLCD_HEIGHT - 5U, YELLOW);
+  failures += refresh_and_check("fixed rows", 2U * ZLCD_WIDTH);
+
+  // drawing not sent yet moves with its rows and goes out after the scroll
+  draw_frame_rows(150, 155, BLUE);
+  if (ZLCD_scroll_to(100) != ZLCD_SUCCESS) {
+    printf("pending: ZLCD_scroll_to(100) failed\n");
+    return 1;
+  }
+  scroll_model(100);
+  failures += refresh_and_check("pending", 6U * ZLCD_WIDTH);
+
+  failures += scroll_and_check("back", 0);
+  failures += scroll_and_check("last", TEST_AREA - 1U);
+
+  // the whole screen as the area, from where the last one was left
+  failures += define_and_check("redefined", 0, 0);
+  failures += scroll_and_check("whole screen", 123);
+  draw_frame_rows(0, 9, NAVY_GREEN);
+  failures += refresh_and_check("whole screen top", 10U * ZLCD_WIDTH);
+
+  if (failures != 0) {
+    printf("%u checks failed\n", failures);
+    return 1;
+  }
+  printf("scrolled glass as expected\n");
+  return 0;
+}
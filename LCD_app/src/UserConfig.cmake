@@ -31,6 +31,23 @@ set(USER_INCLUDE_DIRECTORIES
 set(USER_COMPILE_SOURCES
 "main.c"
 "zynq_lcd_st7789.c"
+"zynq_lcd_dma.c"
+"zynq_lcd_fifo.c"
+"zynq_lcd_transport.c"
+"zynq_lcd_async.c"
+"zynq_lcd_amp.c"
+"zynq_lcd_planner.c"
+"zynq_lcd_bench.c"
+"zynq_lcd_stats.c"
+"zynq_lcd_fill.c"
+"zynq_lcd_pack.c"
+"zynq_lcd_vsync.c"
+"zynq_lcd_hash.c"
+"zynq_lcd_band.c"
+"zynq_lcd_place.c"
+"zynq_lcd_indexed.c"
+"zynq_lcd_blend.c"
+"zynq_lcd_layer.c"
 )
 
 # -----------------------------------------
@@ -62,7 +79,7 @@ set(USER_COMPILE_WARNINGS_INHIBIT_ALL )
 set(USER_COMPILE_OPTIMIZATION_LEVEL -O0)
 
 # Other flags related to optimization
-set(USER_COMPILE_OPTIMIZATION_OTHER_FLAGS )
+set(USER_COMPILE_OPTIMIZATION_OTHER_FLAGS -mfpu=neon-vfpv3)
 
 # -----------------------------------------
 
@@ -24,10 +24,13 @@ the array of metadata structs (glyph_dsc_t*). The names should match
 for each pair of arrays to make working with ZLCD_fonts easy and simple.
 the second array needs to be an array of type glyph_dsc.
 
+Put ZLCD_FONT_DATA after both array names, ZLCD_FONT_MEMORY then decides
+where they live (see zynq_lcd_place.h).
+
 */
 
 // size 8 simple ZLCD_font
-static const uint8_t glyph_bitmap_8[] = {
+static const uint8_t glyph_bitmap_8[] ZLCD_FONT_DATA = {
     /* U+0020 " " */
     0x0,
 
@@ -314,7 +317,7 @@ static const uint8_t glyph_bitmap_8[] = {
     0x4b
 };
 
-static const glyph_dsc_t glyph_dsc_8[] = {
+static const glyph_dsc_t glyph_dsc_8[] ZLCD_FONT_DATA = {
     {.bitmap_index = 0, .adv_w = 0, .box_w = 0, .box_h = 0, .ofs_x = 0, .ofs_y = 0} /* id = 0 reserved */,
     {.bitmap_index = 0, .adv_w = 75, .box_w = 1, .box_h = 1, .ofs_x = 0, .ofs_y = 0},
     {.bitmap_index = 1, .adv_w = 75, .box_w = 1, .box_h = 6, .ofs_x = 2, .ofs_y = 0},
@@ -423,7 +426,7 @@ const ZLCD_font simple_font_8 = {
 };
 
 // size 12 simple ZLCD_font
-static const uint8_t glyph_bitmap_12[] = {
+static const uint8_t glyph_bitmap_12[] ZLCD_FONT_DATA = {
     /* U+0020 " " */
     0x0,
 
@@ -710,7 +713,7 @@ static const uint8_t glyph_bitmap_12[] = {
     0x76, 0x60
 };
 
-static const glyph_dsc_t glyph_dsc_12[] = {
+static const glyph_dsc_t glyph_dsc_12[] ZLCD_FONT_DATA = {
     {.bitmap_index = 0, .adv_w = 0, .box_w = 0, .box_h = 0, .ofs_x = 0, .ofs_y = 0} /* id = 0 reserved */,
     {.bitmap_index = 0, .adv_w = 113, .box_w = 1, .box_h = 1, .ofs_x = 0, .ofs_y = 0},
     {.bitmap_index = 1, .adv_w = 113, .box_w = 1, .box_h = 8, .ofs_x = 2, .ofs_y = 1},
@@ -819,7 +822,7 @@ const ZLCD_font simple_font_12 = {
 };
 
 // size 20 "mideval london" ZLCD_font
-static const uint8_t glyph_bitmap_OL_20[] = {
+static const uint8_t glyph_bitmap_OL_20[] ZLCD_FONT_DATA = {
     /* U+0020 " " */
     0x0,
 
@@ -1232,7 +1235,7 @@ static const uint8_t glyph_bitmap_OL_20[] = {
     0x8, 0xff, 0xd1, 0xbd, 0x0
 };
 
-static const glyph_dsc_t glyph_dsc_OL_20[] = {
+static const glyph_dsc_t glyph_dsc_OL_20[] ZLCD_FONT_DATA = {
     {.bitmap_index = 0, .adv_w = 0, .box_w = 0, .box_h = 0, .ofs_x = 0, .ofs_y = 0} /* id = 0 reserved */,
     {.bitmap_index = 0, .adv_w = 103, .box_w = 1, .box_h = 1, .ofs_x = 0, .ofs_y = 0},
     {.bitmap_index = 1, .adv_w = 58, .box_w = 3, .box_h = 14, .ofs_x = 0, .ofs_y = 0},
@@ -1339,7 +1342,7 @@ const ZLCD_font old_london_20 = {
 };
 
 // size 25 "Kiwi Soda" ZLCD_font
-static const uint8_t glyph_bitmap_KS_25[] = {
+static const uint8_t glyph_bitmap_KS_25[] ZLCD_FONT_DATA = {
     /* U+0020 " " */
     0x0,
 
@@ -1814,7 +1817,7 @@ static const uint8_t glyph_bitmap_KS_25[] = {
     0x38, 0xe7, 0x1f, 0xfb, 0xe3, 0xec, 0x7c
 };
 
-static const lv_font_fmt_txt_glyph_dsc_t glyph_dsc_KS_25[] = {
+static const lv_font_fmt_txt_glyph_dsc_t glyph_dsc_KS_25[] ZLCD_FONT_DATA = {
     {.bitmap_index = 0, .adv_w = 0, .box_w = 0, .box_h = 0, .ofs_x = 0, .ofs_y = 0} /* id = 0 reserved */,
     {.bitmap_index = 0, .adv_w = 125, .box_w = 1, .box_h = 1, .ofs_x = 0, .ofs_y = 0},
     {.bitmap_index = 1, .adv_w = 100, .box_w = 5, .box_h = 17, .ofs_x = 0, .ofs_y = 0},
@@ -8,6 +8,22 @@
 #include <xparameters.h>
 #include <xscutimer.h>
 
+#if ZLCD_FRAMELESS
+#include "zynq_lcd_band.h" // the screen is drawn band by band
+#endif
+
+#ifdef ZLCD_BENCHMARK
+#if ZLCD_FRAMELESS
+#error "the benchmark draws into the frame, ZLCD_MAX_FRAME_BUFFERS can't be 0"
+#endif
+#include "zynq_lcd_bench.h" // benchmark matrix
+#include <xpseudo_asm_gcc.h>
+#include <xreg_cortexa9.h>
+#endif
+
+// the SCU private timer is clocked at half the CPU clock
+#define TIMER_TICKS_PER_US ((double)XPAR_CPU_CORE_CLOCK_FREQ_HZ / 2000000.0)
+
 #define TIME_SECTION(start, end, func_call)                                    \
   do {                                                                         \
     start = get_timer_value();                                                 \
@@ -39,6 +55,75 @@ static void setup_timer() {
   XScuTimer_Start(&TimerInstance);
 };
 
+#ifdef ZLCD_BENCHMARK
+/*
+The PMU cycle counter (PMCCNTR) counts CPU clocks but is only 32 bits wide and
+wraps after ~6 s, so it is extended to 64 bits in software. It has to be read
+at least once per wrap, which every benchmark workload easily does.
+*/
+static void setup_cycle_counter(void) {
+  mtcp(XREG_CP15_PERF_MONITOR_CTRL, 0x5);         // enable, reset the counter
+  mtcp(XREG_CP15_COUNT_ENABLE_SET, 0x80000000U); // cycle counter enable bit
+}
+
+static uint64_t read_cycle_counter(void *context) {
+  (void)context;
+  static uint32_t last_count;
+  static uint64_t upper;
+  uint32_t count = mfcp(XREG_CP15_PERF_CYCLE_COUNTER);
+  if (count < last_count) {
+    upper += 1ULL << 32;
+  }
+  last_count = count;
+  return upper | count;
+}
+
+#if ZLCD_STATS_ENABLED
+static bool read_bus_counters(void *context, uint64_t *bytes,
+                              uint64_t *commands) {
+  (void)context;
+  ZLCD_stats stats;
+  if (ZLCD_get_stats(&stats) != ZLCD_SUCCESS) {
+    return false;
+  }
+  *bytes = stats.spi_bytes;
+  *commands = stats.command_bytes;
+  return true;
+}
+#endif
+
+static void run_benchmark(void) {
+  static const ZLCD_bench_font fonts[] = {
+      {"simple_font_8", &simple_font_8},
+      {"simple_font_12", &simple_font_12},
+      {"old_london_20", &old_london_20},
+      {"kiwi_soda_25", &kiwi_soda_25},
+      {"printf_font", &printf_font},
+  };
+  ZLCD_image image_1 = lvgl_image_to_ZLCD(&img_1, 0, 0);
+  ZLCD_image image_2 = lvgl_image_to_ZLCD(&img_2, 0, 0);
+  ZLCD_image image_3 = lvgl_image_to_ZLCD(&shrek_grin, 0, 0);
+  const ZLCD_bench_image images[] = {
+      {"img_1", &image_1}, {"img_2", &image_2}, {"shrek_grin", &image_3}};
+
+  setup_cycle_counter();
+  ZLCD_bench_config bench = {.read_cycles = read_cycle_counter,
+                             .cycle_unit = "cpu_cycles",
+#if ZLCD_STATS_ENABLED
+                             .read_bus_counters = read_bus_counters,
+#else
+                             .read_bus_counters = NULL,
+#endif
+                             .context = NULL,
+                             .fonts = fonts,
+                             .num_fonts = sizeof(fonts) / sizeof(fonts[0]),
+                             .images = images,
+                             .num_images = sizeof(images) / sizeof(images[0]),
+                             .iterations = 51};
+  ZLCD_ERROR_CHECK(ZLCD_bench_run(&bench));
+}
+#endif
+
 XGpio PWM_1, PWM_2; // LED indicator
 
 // ZLCD_RETURN_STATUS setup_PWM_LEDs(float brightness_percentage) {
@@ -71,6 +156,35 @@ const char *demo =
     "occaecat cupidatat non proident, sunt in culpa qui officia deserunt "
     "mollit anim id est laborum.";
 
+#if ZLCD_FRAMELESS
+int main(void) {
+  setup_timer();
+
+  int success = ZLCD_init(ZLCD_PORTRAIT_ORIENTATION, NAVY_GREEN);
+  printf("ZLCD init status: %s\n",
+         (success == ZLCD_SUCCESS) ? "successful" : "failed");
+  if (success)
+    return 1;
+
+  static ZLCD_band_item items[3];
+  ZLCD_display_list list;
+  ZLCD_display_list_init(&list, items, 3, NAVY_GREEN);
+  uint32_t t1, t2;
+  for (uint16_t y = 160;; y = (y < 260) ? y + 2 : 160) {
+    // a ball bouncing under the title, only the bands it moves through go out
+    ZLCD_display_list_clear(&list, NAVY_GREEN);
+    ZLCD_band_rectangle(&list, 10, 20, 152, 40, 2, WHITE, true, BLUE);
+    ZLCD_band_string(&list, "ZLCD bands", 20, 32, WHITE, &simple_font_12);
+    ZLCD_band_circle(&list, 86, y, 20, WHITE, true, YELLOW);
+    TIME_SECTION(t1, t2, ZLCD_ERROR_CHECK(ZLCD_band_render(&list, NULL)));
+    if (y == 160) {
+      printf("Time to render a frame: %.3f µs\n",
+             (double)(t1 - t2) / TIMER_TICKS_PER_US);
+    }
+  }
+  return 0;
+}
+#else
 int main(void) {
   setup_timer();
 
@@ -80,6 +194,12 @@ int main(void) {
   if (success)
     return 1;
 
+#ifdef ZLCD_BENCHMARK
+  // CSV on the UART instead of the demo
+  run_benchmark();
+  return 0;
+#endif
+
   ZLCD_print_wrapped_string_xy(demo, 19, 20, 0, 30, RED, &printf_font, true);
 
   ZLCD_print_wrapped_string_on_background_xy(demo, 15, 20, 0, 30, WHITE, BLUE,
@@ -95,18 +215,20 @@ int main(void) {
   TIME_SECTION(t1, t2,
                ZLCD_draw_filled_rectangle(ZLCD_create_coordinate(0, 0), 172,
                                           320, 6, RED, BLUE, false));
-  printf("Time to write full GRAM image: %.3f µs\n", (double)(t1 - t2) / 333.0);
+  printf("Time to write full GRAM image: %.3f µs\n",
+         (double)(t1 - t2) / TIMER_TICKS_PER_US);
 
   ZLCD_draw_filled_rectangle(ZLCD_create_coordinate(0, 0), 320, 320, 4, WHITE,
                              ORANGE, false);
   TIME_SECTION(t1, t2, ZLCD_refresh_display());
-  printf("Time to refresh screen only: %.3f µs\n", (double)(t1 - t2) / 333.0);
+  printf("Time to refresh screen only: %.3f µs\n",
+         (double)(t1 - t2) / TIMER_TICKS_PER_US);
 
   TIME_SECTION(t1, t2,
                ZLCD_draw_filled_rectangle(ZLCD_create_coordinate(0, 0), 320,
                                           320, 6, BLUE, GRAY, true));
   printf("Time to set GRAM image and transmit: %.3f µs\n",
-         (double)(t1 - t2) / 333.0);
+         (double)(t1 - t2) / TIMER_TICKS_PER_US);
 
   ZLCD_clear();
   ZLCD_set_orientation(ZLCD_INVERTED_LANDSCAPE_ORIENTATION);
@@ -128,10 +250,12 @@ int main(void) {
   ZLCD_set_orientation(ZLCD_INVERTED_PORTRAIT_ORIENTATION);
   TIME_SECTION(t1, t2,
                ZLCD_draw_image(ZLCD_create_coordinate(0, 0), &Zimg_1, false));
-  printf("Time to load image into GRAM: %.3f µs\n", (double)(t1 - t2) / 333.0);
+  printf("Time to load image into GRAM: %.3f µs\n",
+         (double)(t1 - t2) / TIMER_TICKS_PER_US);
 
   TIME_SECTION(t1, t2, ZLCD_refresh_display());
-  printf("Time to show image: %.3f µs\n", (double)(t1 - t2) / 333.0);
+  printf("Time to show image: %.3f µs\n",
+         (double)(t1 - t2) / TIMER_TICKS_PER_US);
 
   ZLCD_set_orientation(ZLCD_PORTRAIT_ORIENTATION);
   ZLCD_image Zimg_2 = lvgl_image_to_ZLCD(&img_2, 0, 0);
@@ -191,4 +315,5 @@ int main(void) {
     sleep(2);
   }
   return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
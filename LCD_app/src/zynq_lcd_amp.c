@@ -0,0 +1,245 @@
+#include "zynq_lcd_amp.h"
+#include "zynq_lcd_place.h"
+#include <sleep.h>
+#include <stdio.h>
+#include <string.h>
+#include <xil_cache_l.h>
+#include <xil_mmu.h>
+
+/*************************************************
+  CPU1 display pump for the ST7789VW driver
+**************************************************/
+
+// SEV after publishing wakes the pump out of WFE, both are hints elsewhere
+#if defined(__arm__)
+#define ZLCD_AMP_WAKE() __asm__ volatile("dsb\n\tsev" ::: "memory")
+#define ZLCD_AMP_SLEEP() __asm__ volatile("wfe" ::: "memory")
+#else
+#define ZLCD_AMP_WAKE() ((void)0)
+#define ZLCD_AMP_SLEEP() ((void)0)
+#endif
+
+// DC level the pump last drove, only used on CPU1
+static bool pump_dc;
+
+static inline const uint8_t *ZLCD_amp_step_bytes(const ZLCD_async_step *step) {
+  return step->bytes != NULL ? step->bytes : step->immediate;
+}
+
+static bool ZLCD_amp_publish(ZLCD_amp_queue *queue, const ZLCD_amp_job *job) {
+  uint32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  if (head - atomic_load_explicit(&queue->tail, memory_order_acquire) >=
+      ZLCD_AMP_QUEUE_DEPTH) {
+    return false;
+  }
+  // CPU1 reads the steps and the pixels past CPU0's L1, written back without
+  // invalidating the lines a ZLCD_MEMORY_L2_LOCKED placement locked
+  if (job->num_steps != 0) {
+    ZLCD_dcache_store_range(job->steps,
+                            job->num_steps * sizeof(ZLCD_async_step));
+    for (uint32_t i = 0; i < job->num_steps; i++) {
+      if (job->steps[i].bytes != NULL) {
+        ZLCD_dcache_store_range(job->steps[i].bytes, job->steps[i].length);
+      }
+    }
+  }
+  queue->jobs[head & (ZLCD_AMP_QUEUE_DEPTH - 1U)] = *job;
+  // the job is complete in memory before the pump can see the new head
+  atomic_store_explicit(&queue->head, head + 1U, memory_order_release);
+  ZLCD_AMP_WAKE();
+  return true;
+}
+
+static void ZLCD_amp_wait_idle(ZLCD_amp_queue *queue) {
+  while (!ZLCD_amp_idle(queue)) {
+  }
+}
+
+static void ZLCD_amp_send(ZLCD_amp_client *client, const ZLCD_amp_job *job) {
+  while (!ZLCD_amp_publish(client->queue, job)) {
+  }
+  // frames reference the driver's buffers, which are reused once this returns
+  ZLCD_amp_wait_idle(client->queue);
+}
+
+void ZLCD_amp_queue_init(ZLCD_amp_queue *queue) {
+  // the whole 1 MB section around the queue, both cores map it the same way
+  Xil_SetTlbAttributes((INTPTR)queue, NORM_NONCACHE);
+  atomic_store_explicit(&queue->ready, 0, memory_order_relaxed);
+  atomic_store_explicit(&queue->tail, 0, memory_order_relaxed);
+  atomic_store_explicit(&queue->head, 0, memory_order_release);
+}
+
+bool ZLCD_amp_idle(ZLCD_amp_queue *queue) {
+  return atomic_load_explicit(&queue->tail, memory_order_acquire) ==
+         atomic_load_explicit(&queue->head, memory_order_relaxed);
+}
+
+/*
+CPU0 transport hooks
+*/
+static ZLCD_RETURN_STATUS ZLCD_amp_client_start(void *context) {
+  ZLCD_amp_client *client = context;
+  for (uint32_t waited = 0;
+       !atomic_load_explicit(&client->queue->ready, memory_order_acquire);
+       waited++) {
+    if (waited >= ZLCD_AMP_READY_TIMEOUT_MS) {
+      printf("The CPU1 display pump is not running\n");
+      return ZLCD_FAILURE;
+    }
+    msleep(1);
+  }
+  client->num_steps = 0;
+  client->dc = false;
+  return ZLCD_SUCCESS;
+}
+
+static void ZLCD_amp_client_flush(ZLCD_amp_client *client) {
+  if (client->num_steps == 0) {
+    return;
+  }
+  ZLCD_amp_job job = {.steps = client->steps,
+                      .num_steps = client->num_steps,
+                      .kind = ZLCD_AMP_JOB_FRAME};
+  ZLCD_amp_send(client, &job);
+  client->num_steps = 0;
+}
+
+static void ZLCD_amp_client_begin(void *context) {
+  ((ZLCD_amp_client *)context)->num_steps = 0;
+}
+
+static void ZLCD_amp_client_write(void *context, const uint8_t *bytes,
+                                  size_t num_bytes) {
+  ZLCD_amp_client *client = context;
+  if (client->num_steps >= ZLCD_AMP_FRAME_STEPS) {
+    ZLCD_amp_client_flush(client); // longer than any frame the driver sends
+  }
+  ZLCD_async_step *step = &client->steps[client->num_steps++];
+  if (num_bytes <= ZLCD_ASYNC_IMMEDIATE_BYTES) {
+    memcpy(step->immediate, bytes, num_bytes);
+    step->bytes = NULL;
+  } else {
+    step->bytes = bytes; // end() waits, so the caller's buffer stays valid
+  }
+  step->length = (uint32_t)num_bytes;
+  step->is_command = !client->dc;
+  step->rows = 1;
+  step->stride = 0;
+}
+
+static void ZLCD_amp_client_end(void *context) {
+  ZLCD_amp_client_flush(context);
+}
+
+static void ZLCD_amp_client_set_pin(void *context, ZLCD_PIN pin, bool level) {
+  ZLCD_amp_client *client = context;
+  if (pin == ZLCD_PIN_DC) {
+    client->dc = level; // goes out with the steps written after this
+    return;
+  }
+  ZLCD_amp_job job = {.steps = NULL,
+                      .num_steps = 0,
+                      .kind = ZLCD_AMP_JOB_PIN,
+                      .pin = (uint8_t)pin,
+                      .level = level};
+  ZLCD_amp_send(client, &job);
+}
+
+static void ZLCD_amp_client_delay_ms(void *context, uint32_t milliseconds) {
+  // everything sent before the delay has to be on the LCD already
+  ZLCD_amp_wait_idle(((ZLCD_amp_client *)context)->queue);
+  msleep(milliseconds);
+}
+
+void ZLCD_amp_client_init(ZLCD_amp_client *client, ZLCD_amp_queue *queue) {
+  client->queue = queue;
+  client->num_steps = 0;
+  client->dc = false;
+  client->transport = (ZLCD_transport){
+      ZLCD_amp_client_start,   ZLCD_amp_client_begin,
+      ZLCD_amp_client_write,   ZLCD_amp_client_end,
+      ZLCD_amp_client_set_pin, ZLCD_amp_client_delay_ms,
+      client};
+}
+
+bool ZLCD_amp_submit(ZLCD_amp_client *client, const ZLCD_async_step *steps,
+                     size_t num_steps) {
+  ZLCD_amp_job job = {.steps = steps,
+                      .num_steps = (uint32_t)num_steps,
+                      .kind = ZLCD_AMP_JOB_FRAME};
+  return ZLCD_amp_publish(client->queue, &job);
+}
+
+/*
+CPU1 side
+*/
+ZLCD_RETURN_STATUS ZLCD_amp_pump_start(ZLCD_amp_queue *queue,
+                                       const ZLCD_transport *transport) {
+  Xil_SetTlbAttributes((INTPTR)queue, NORM_NONCACHE);
+  if (transport == NULL ||
+      transport->init(transport->context) != ZLCD_SUCCESS) {
+    printf("LCD transport init failed\n");
+    return ZLCD_FAILURE;
+  }
+  // the GPIO bus comes up low, CPU0's driver starts from the same levels
+  pump_dc = false;
+  atomic_store_explicit(&queue->ready, 1, memory_order_release);
+  return ZLCD_SUCCESS;
+}
+
+static void ZLCD_amp_pump_frame(const ZLCD_amp_job *job,
+                                const ZLCD_transport *transport) {
+  /*
+  this core may still hold the lines from the last time CPU0 used them. Only
+  its own L1 is dropped: the L2 is shared and up to date, and invalidating it
+  would unlock CPU0's locked lines
+  */
+  Xil_L1DCacheInvalidateRange((u32)(UINTPTR)job->steps,
+                              job->num_steps * sizeof(ZLCD_async_step));
+  transport->begin(transport->context);
+  for (uint32_t i = 0; i < job->num_steps; i++) {
+    const ZLCD_async_step *step = &job->steps[i];
+    if (step->bytes != NULL) {
+      Xil_L1DCacheInvalidateRange((u32)(UINTPTR)step->bytes, step->length);
+    }
+    if (pump_dc == step->is_command) {
+      pump_dc = !step->is_command;
+      transport->set_pin(transport->context, ZLCD_PIN_DC, pump_dc);
+    }
+    transport->write(transport->context, ZLCD_amp_step_bytes(step),
+                     step->length);
+  }
+  transport->end(transport->context);
+}
+
+bool ZLCD_amp_pump_once(ZLCD_amp_queue *queue,
+                        const ZLCD_transport *transport) {
+  uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  if (tail == atomic_load_explicit(&queue->head, memory_order_acquire)) {
+    return false;
+  }
+  const ZLCD_amp_job *job = &queue->jobs[tail & (ZLCD_AMP_QUEUE_DEPTH - 1U)];
+  if (job->kind == ZLCD_AMP_JOB_PIN) {
+    if (job->pin == ZLCD_PIN_DC) {
+      pump_dc = job->level;
+    }
+    transport->set_pin(transport->context, (ZLCD_PIN)job->pin, job->level);
+  } else {
+    ZLCD_amp_pump_frame(job, transport);
+  }
+  // hands the slot and the buffers the job referenced back to CPU0
+  atomic_store_explicit(&queue->tail, tail + 1U, memory_order_release);
+  return true;
+}
+
+void ZLCD_amp_pump(ZLCD_amp_queue *queue, const ZLCD_transport *transport) {
+  if (ZLCD_amp_pump_start(queue, transport) != ZLCD_SUCCESS) {
+    return;
+  }
+  for (;;) {
+    if (!ZLCD_amp_pump_once(queue, transport)) {
+      ZLCD_AMP_SLEEP();
+    }
+  }
+}
@@ -0,0 +1,112 @@
+#ifndef ZYNQ_LCD_AMP_H
+#define ZYNQ_LCD_AMP_H
+/****************************************************************************
+Dual core (AMP) split for the ZLCD driver. CPU0 renders and records what it
+sends, CPU1 runs a display pump that takes the recorded jobs from a single
+producer / single consumer queue in on chip memory and does all of the SPI and
+GPIO work. CPU0 never touches the LCD hardware once ZLCD_config.amp_queue is
+set, so nothing on CPU0 waits on the bus while a refresh goes out.
+
+Boot order: CPU0 calls ZLCD_amp_queue_init(), starts CPU1 (whose application
+calls ZLCD_amp_pump()) and then ZLCD_init_with_config(), which waits for the
+pump to be ready.
+*****************************************************************************/
+
+#include "zynq_lcd_async.h"
+#include "zynq_lcd_st7789.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+Both applications have to agree on where the queue is. The default is the last
+64 KB of the OCM mapped high (keep the linker scripts out of it), the CPU1 start
+address at 0xFFFFFFF0 is far above the queue.
+*/
+#ifndef ZLCD_AMP_QUEUE_ADDRESS
+#define ZLCD_AMP_QUEUE_ADDRESS 0xFFFF0000U
+#endif
+#define ZLCD_AMP_QUEUE ((ZLCD_amp_queue *)ZLCD_AMP_QUEUE_ADDRESS)
+// jobs in flight, power of two
+#define ZLCD_AMP_QUEUE_DEPTH 4U
+// steps the CPU0 transport collects per chip select frame before sending
+#define ZLCD_AMP_FRAME_STEPS 8U
+#ifndef ZLCD_AMP_READY_TIMEOUT_MS
+#define ZLCD_AMP_READY_TIMEOUT_MS 1000U
+#endif
+
+typedef enum {
+  ZLCD_AMP_JOB_FRAME, // steps sent as one chip select frame
+  ZLCD_AMP_JOB_PIN    // a pin change (the reset pulse)
+} ZLCD_AMP_JOB;
+
+typedef struct {
+  // in CPU0 memory, written back from the cache before the job is published
+  const ZLCD_async_step *steps;
+  uint32_t num_steps;
+  uint8_t kind; // ZLCD_AMP_JOB
+  uint8_t pin;  // ZLCD_PIN, for ZLCD_AMP_JOB_PIN
+  bool level;
+} ZLCD_amp_job;
+
+/*
+Lives in memory both cores map uncached. head only ever moves on CPU0 and tail
+on CPU1, so the two indices are the only synchronisation needed.
+*/
+struct ZLCD_amp_queue {
+  _Atomic uint32_t head;  // jobs published
+  _Atomic uint32_t tail;  // jobs sent
+  _Atomic uint32_t ready; // set by the pump once its transport is up
+  ZLCD_amp_job jobs[ZLCD_AMP_QUEUE_DEPTH];
+};
+
+/*
+CPU0 end of the queue. ZLCD_init_with_config() sets one up for
+ZLCD_config.amp_queue, client->transport also works as ZLCD_config.transport
+(without async refreshes).
+*/
+typedef struct {
+  ZLCD_amp_queue *queue;
+  ZLCD_async_step steps[ZLCD_AMP_FRAME_STEPS]; // frame being collected
+  uint32_t num_steps;
+  bool dc;
+  ZLCD_transport transport;
+} ZLCD_amp_client;
+
+// CPU0, before CPU1 is started: maps the queue uncached and empties it
+void ZLCD_amp_queue_init(ZLCD_amp_queue *queue);
+
+// true once every published job has been sent
+bool ZLCD_amp_idle(ZLCD_amp_queue *queue);
+
+/*
+Sets up client->transport. Frames are sent when end() is called and end()
+returns once CPU1 is done with them, so the driver's buffers may be reused.
+Delays are waited out on CPU0 after the frames before them have been sent.
+*/
+void ZLCD_amp_client_init(ZLCD_amp_client *client, ZLCD_amp_queue *queue);
+
+/*
+Publishes a recorded refresh (see zynq_lcd_async.h) as one frame without
+waiting. The steps and the bytes they reference must stay untouched until
+ZLCD_amp_idle(). Returns false if the queue is full.
+*/
+bool ZLCD_amp_submit(ZLCD_amp_client *client, const ZLCD_async_step *steps,
+                     size_t num_steps);
+
+/*
+CPU1: maps the queue, initializes transport (a built in one, e.g.
+ZLCD_get_builtin_transport(ZLCD_TRANSMIT_FIFO)) and sends every job CPU0
+publishes. Only returns if the transport fails to initialize.
+*/
+void ZLCD_amp_pump(ZLCD_amp_queue *queue, const ZLCD_transport *transport);
+
+// the two halves of ZLCD_amp_pump(), for running the pump elsewhere
+ZLCD_RETURN_STATUS ZLCD_amp_pump_start(ZLCD_amp_queue *queue,
+                                       const ZLCD_transport *transport);
+// sends the oldest job, false if there was none
+bool ZLCD_amp_pump_once(ZLCD_amp_queue *queue,
+                        const ZLCD_transport *transport);
+
+#endif // ZYNQ_LCD_AMP_H
@@ -0,0 +1,123 @@
+#include "zynq_lcd_async.h"
+#include <string.h>
+#include <xstatus.h>
+
+/*************************************************
+  interrupt driven refresh for the ST7789VW driver
+**************************************************/
+
+void ZLCD_async_finish(ZLCD_async_engine *engine, ZLCD_RETURN_STATUS status) {
+  ZLCD_refresh_callback callback = engine->callback;
+  engine->status = status;
+  // clear busy first so the callback may queue the next refresh right away
+  engine->busy = false;
+  if (callback != NULL) {
+    callback(status, engine->callback_data);
+  }
+}
+
+static bool ZLCD_async_issue(ZLCD_async_engine *engine) {
+  const ZLCD_async_step *step = &engine->steps[engine->current_step];
+  const uint8_t *bytes = step->bytes != NULL ? step->bytes : step->immediate;
+  // the previous step has fully left the FIFO, so DC can safely change here
+  engine->set_dc(engine->context, !step->is_command);
+  int status = step->rows > 1
+                   ? engine->start_rows(engine->context, bytes, step->length,
+                                        step->rows, step->stride)
+                   : engine->start_transfer(engine->context, bytes,
+                                            step->length);
+  if (status != XST_SUCCESS) {
+    ZLCD_async_finish(engine, ZLCD_FAILURE);
+    return false;
+  }
+  return true;
+}
+
+void ZLCD_async_reset(ZLCD_async_engine *engine) {
+  engine->num_steps = 0;
+  engine->current_step = 0;
+  engine->overflow = false;
+}
+
+bool ZLCD_async_push(ZLCD_async_engine *engine, bool is_command,
+                     const uint8_t *bytes, size_t num_bytes) {
+  if (bytes == NULL || num_bytes == 0) {
+    return false;
+  }
+  if (engine->num_steps >= ZLCD_ASYNC_MAX_STEPS) {
+    engine->overflow = true;
+    return false;
+  }
+  ZLCD_async_step *step = &engine->steps[engine->num_steps];
+  if (num_bytes <= ZLCD_ASYNC_IMMEDIATE_BYTES) {
+    memcpy(step->immediate, bytes, num_bytes);
+    step->bytes = NULL;
+  } else {
+    step->bytes = bytes;
+  }
+  step->length = (uint32_t)num_bytes;
+  step->is_command = is_command;
+  step->rows = 1;
+  step->stride = 0;
+  engine->num_steps++;
+  return true;
+}
+
+bool ZLCD_async_push_rows(ZLCD_async_engine *engine, const uint8_t *first_row,
+                          size_t row_bytes, uint16_t rows, size_t stride) {
+  if (engine->start_rows == NULL || rows < 2 || stride < row_bytes ||
+      row_bytes <= ZLCD_ASYNC_IMMEDIATE_BYTES ||
+      !ZLCD_async_push(engine, false, first_row, row_bytes)) {
+    return false;
+  }
+  ZLCD_async_step *step = &engine->steps[engine->num_steps - 1];
+  step->rows = rows;
+  step->stride = (uint32_t)stride;
+  return true;
+}
+
+ZLCD_RETURN_STATUS ZLCD_async_start(ZLCD_async_engine *engine,
+                                    ZLCD_refresh_callback callback,
+                                    void *user_data) {
+  if (engine->busy) {
+    return ZLCD_FAILURE;
+  }
+  engine->callback = callback;
+  engine->callback_data = user_data;
+  engine->current_step = 0;
+  engine->busy = true;
+  if (engine->overflow) {
+    // part of the refresh was never recorded, sending the rest would hide it
+    ZLCD_async_finish(engine, ZLCD_FAILURE);
+    return ZLCD_FAILURE;
+  }
+  if (engine->num_steps == 0) {
+    ZLCD_async_finish(engine, ZLCD_SUCCESS);
+    return ZLCD_SUCCESS;
+  }
+  if (engine->start_queue != NULL) {
+    if (engine->start_queue(engine->context, engine->steps,
+                            engine->num_steps) != XST_SUCCESS) {
+      ZLCD_async_finish(engine, ZLCD_FAILURE);
+      return ZLCD_FAILURE;
+    }
+    return ZLCD_SUCCESS;
+  }
+  return ZLCD_async_issue(engine) ? ZLCD_SUCCESS : ZLCD_FAILURE;
+}
+
+void ZLCD_async_step_done(ZLCD_async_engine *engine, int step_status) {
+  if (!engine->busy) {
+    return; // spurious interrupt
+  }
+  if (step_status != XST_SUCCESS) {
+    ZLCD_async_finish(engine, ZLCD_FAILURE);
+    return;
+  }
+  engine->current_step++;
+  if (engine->current_step >= engine->num_steps) {
+    ZLCD_async_finish(engine, ZLCD_SUCCESS);
+    return;
+  }
+  (void)ZLCD_async_issue(engine);
+}
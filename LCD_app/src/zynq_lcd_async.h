@@ -0,0 +1,100 @@
+#ifndef ZYNQ_LCD_ASYNC_H
+#define ZYNQ_LCD_ASYNC_H
+/****************************************************************************
+Interrupt driven refresh engine for the ZLCD driver. A refresh is recorded as a
+queue of command/data steps up front, then every "transfer done" interrupt from
+the SPI controller starts the next step until the queue is empty.
+*****************************************************************************/
+
+#include "zynq_lcd_st7789.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// command and window parameters are at most this long and are copied
+#define ZLCD_ASYNC_IMMEDIATE_BYTES 4U
+/*
+worst case refresh is a separate window for every row: CASET + parameters,
+RASET + parameters, RAMWR and the row's data
+*/
+#ifndef ZLCD_ASYNC_MAX_STEPS
+#define ZLCD_ASYNC_MAX_STEPS (6U * ZLCD_HEIGHT)
+#endif
+
+typedef struct {
+  const uint8_t *bytes; // NULL when the bytes are stored in immediate[]
+  uint32_t length;      // of a row for ZLCD_async_push_rows()
+  uint8_t immediate[ZLCD_ASYNC_IMMEDIATE_BYTES];
+  bool is_command; // DC low
+  uint16_t rows;   // 1, or rows of length bytes stride bytes apart
+  uint32_t stride;
+} ZLCD_async_step;
+
+/*
+The engine never touches hardware directly, everything goes through the two
+hooks below. On the board they drive the AXI GPIO and XSpiPs_Transfer(); off
+target they can be pointed at a model of the FIFO and the interrupt.
+*/
+typedef struct {
+  void (*set_dc)(void *context, bool data);
+  // must return XST_SUCCESS once the transfer has been started
+  int (*start_transfer)(void *context, const uint8_t *bytes, size_t num_bytes);
+  // optional, sends the steps of ZLCD_async_push_rows() in one transfer
+  int (*start_rows)(void *context, const uint8_t *first_row, size_t row_bytes,
+                    size_t rows, size_t stride);
+  void *context;
+  /*
+  optional, when set ZLCD_async_start() hands the whole queue over at once
+  (to the CPU1 display pump, see zynq_lcd_amp.h) instead of issuing it step by
+  step, and whoever sends it calls ZLCD_async_finish()
+  */
+  int (*start_queue)(void *context, const ZLCD_async_step *steps,
+                     size_t num_steps);
+
+  ZLCD_async_step steps[ZLCD_ASYNC_MAX_STEPS];
+  size_t num_steps;
+  bool overflow; // a step did not fit since ZLCD_async_reset()
+  volatile size_t current_step;
+  volatile bool busy;
+  volatile ZLCD_RETURN_STATUS status; // result of the last finished refresh
+
+  ZLCD_refresh_callback callback;
+  void *callback_data;
+} ZLCD_async_engine;
+
+// empties the step queue, must not be called while the engine is busy
+void ZLCD_async_reset(ZLCD_async_engine *engine);
+
+/*
+Appends a step to the queue. Up to ZLCD_ASYNC_IMMEDIATE_BYTES are copied so
+stack buffers may be passed, longer data is referenced and must stay untouched
+until the refresh has finished. Returns false if the step does not fit, a full
+queue also sets overflow and ZLCD_async_start() then fails the refresh.
+*/
+bool ZLCD_async_push(ZLCD_async_engine *engine, bool is_command,
+                     const uint8_t *bytes, size_t num_bytes);
+/*
+Appends rows of data with stride bytes from the start of one to the next as a
+single step, for engines with start_rows. The rows are referenced as above.
+*/
+bool ZLCD_async_push_rows(ZLCD_async_engine *engine, const uint8_t *first_row,
+                          size_t row_bytes, uint16_t rows, size_t stride);
+
+/*
+starts the first step, the callback runs once the last step is done. After an
+overflow nothing is sent and the callback gets ZLCD_FAILURE straight away
+*/
+ZLCD_RETURN_STATUS ZLCD_async_start(ZLCD_async_engine *engine,
+                                    ZLCD_refresh_callback callback,
+                                    void *user_data);
+
+/*
+Call from the "transfer done" interrupt with the status of the step that just
+finished (XST_SUCCESS or an error code). Starts the next step or finishes.
+*/
+void ZLCD_async_step_done(ZLCD_async_engine *engine, int step_status);
+
+// ends the refresh in flight with status and calls the callback
+void ZLCD_async_finish(ZLCD_async_engine *engine, ZLCD_RETURN_STATUS status);
+
+#endif // ZYNQ_LCD_ASYNC_H
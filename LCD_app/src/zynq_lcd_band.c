@@ -0,0 +1,595 @@
+#include "zynq_lcd_band.h"
+#include "zynq_lcd_fill.h"
+#include "zynq_lcd_hash.h"
+#include <string.h>
+
+/*************************************************
+  Band renderer for the ST7789VW driver
+**************************************************/
+
+// the band being drawn, wire order like GRAM_previous
+static ZLCD_fill_pixel band_pixels[ZLCD_BAND_ROWS * ZLCD_BAND_MAX_WIDTH]
+    ZLCD_WORK_DATA;
+// digest of what the LCD shows in every band, if known
+static uint32_t band_digest[ZLCD_BAND_MAX_BANDS];
+static bool band_known[ZLCD_BAND_MAX_BANDS];
+// the band shows nothing but band_background
+static bool band_blank[ZLCD_BAND_MAX_BANDS];
+static rgb565 band_background;
+// the orientation the band state is for
+static ZLCD_frame_layout band_layout;
+
+/*
+A band while it is drawn. Screen pixel (x, y) is band pixel
+origin + x * x_step + y * y_step, the screen pixels in the band are x0 to x1 by
+y0 to y1 (inclusive), anything else has to be clipped away
+*/
+typedef struct {
+  uint8_t *pixels;
+  int32_t origin;
+  int32_t x_step, y_step;
+  uint16_t frame_width;
+  int16_t x0, y0, x1, y1;
+} ZLCD_band;
+
+void ZLCD_display_list_init(ZLCD_display_list *list, ZLCD_band_item *items,
+                            size_t max_items, rgb565 background) {
+  list->items = items;
+  list->max_items = items != NULL ? max_items : 0;
+  ZLCD_display_list_clear(list, background);
+}
+
+void ZLCD_display_list_clear(ZLCD_display_list *list, rgb565 background) {
+  list->num_items = 0;
+  list->background = background;
+}
+
+void ZLCD_band_forget(void) {
+  memset(band_known, 0, sizeof(band_known));
+  memset(band_blank, 0, sizeof(band_blank));
+}
+
+static ZLCD_band_item *ZLCD_band_add(ZLCD_display_list *list,
+                                     ZLCD_BAND_ITEM_TYPE type) {
+  if (list == NULL) {
+    return NULL;
+  }
+  if (list->num_items == list->max_items) {
+    printf("ERROR: display list is full (%u items)\n",
+           (unsigned)list->max_items);
+    return NULL;
+  }
+  ZLCD_band_item *item = &list->items[list->num_items++];
+  memset(item, 0, sizeof(*item));
+  item->type = type;
+  return item;
+}
+
+ZLCD_RETURN_STATUS ZLCD_band_rectangle(ZLCD_display_list *list,
+                                       uint16_t origin_x, uint16_t origin_y,
+                                       uint16_t width_px, uint16_t height_px,
+                                       uint16_t border_thickness_px,
+                                       rgb565 border_colour, bool fill,
+                                       rgb565 fill_colour) {
+  if (width_px == 0 || height_px == 0) {
+    return ZLCD_FAILURE;
+  }
+  if (ZLCD_verify_coordinate_is_valid_xy(origin_x, origin_y) != ZLCD_SUCCESS) {
+    printf("Rectangle origin point must be on the screen\n");
+    return ZLCD_FAILURE;
+  }
+  if ((border_thickness_px >= width_px / 2) ||
+      (border_thickness_px >= height_px / 2)) {
+    uint16_t smaller_side = (width_px > height_px) ? height_px : width_px;
+    printf("border thickness for rectangle is too great. Passed %u but "
+           "thickness should not exceed %u\n",
+           border_thickness_px, smaller_side / 2);
+    return ZLCD_FAILURE;
+  }
+  ZLCD_band_item *item = ZLCD_band_add(list, ZLCD_BAND_RECTANGLE);
+  if (item == NULL) {
+    return ZLCD_FAILURE;
+  }
+  item->x = item->x0 = origin_x;
+  item->y = item->y0 = origin_y;
+  item->x2 = item->x1 = origin_x + width_px - 1;
+  item->y2 = item->y1 = origin_y + height_px - 1;
+  item->size = border_thickness_px == 0 ? 1 : border_thickness_px;
+  item->colour = border_colour;
+  item->fill = fill;
+  item->fill_colour = fill_colour;
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_band_circle(ZLCD_display_list *list, uint16_t origin_x,
+                                    uint16_t origin_y, uint16_t radius_px,
+                                    rgb565 border_colour, bool fill,
+                                    rgb565 fill_colour) {
+  if (ZLCD_verify_coordinate_is_valid_xy(origin_x, origin_y) != ZLCD_SUCCESS) {
+    printf("Circle origin is not on the screen\n");
+    return ZLCD_FAILURE;
+  }
+  if (radius_px > ZLCD_WIDTH) {
+    printf("Circle radius is too large\n");
+    return ZLCD_FAILURE;
+  }
+  ZLCD_band_item *item = ZLCD_band_add(list, ZLCD_BAND_CIRCLE);
+  if (item == NULL) {
+    return ZLCD_FAILURE;
+  }
+  item->x = origin_x;
+  item->y = origin_y;
+  item->x0 = origin_x - radius_px;
+  item->y0 = origin_y - radius_px;
+  item->x1 = origin_x + radius_px;
+  item->y1 = origin_y + radius_px;
+  item->size = radius_px;
+  item->colour = border_colour;
+  item->fill = fill;
+  item->fill_colour = fill_colour;
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_band_line(ZLCD_display_list *list, uint16_t x1,
+                                  uint16_t y1, uint16_t x2, uint16_t y2,
+                                  rgb565 colour) {
+  if (ZLCD_verify_coordinate_is_valid_xy(x1, y1) != ZLCD_SUCCESS ||
+      ZLCD_verify_coordinate_is_valid_xy(x2, y2) != ZLCD_SUCCESS) {
+    printf("Line end points must be on the screen\n");
+    return ZLCD_FAILURE;
+  }
+  ZLCD_band_item *item = ZLCD_band_add(list, ZLCD_BAND_LINE);
+  if (item == NULL) {
+    return ZLCD_FAILURE;
+  }
+  item->x = x1;
+  item->y = y1;
+  item->x2 = x2;
+  item->y2 = y2;
+  item->x0 = x1 < x2 ? x1 : x2;
+  item->x1 = x1 < x2 ? x2 : x1;
+  item->y0 = y1 < y2 ? y1 : y2;
+  item->y1 = y1 < y2 ? y2 : y1;
+  item->colour = colour;
+  return ZLCD_SUCCESS;
+}
+
+// distance between text lines, as the driver's get_font_height()
+static uint16_t ZLCD_band_text_height(const char *string, const ZLCD_font *f) {
+  uint8_t over = 0;
+  int8_t under = INT8_MAX;
+  for (; *string; string++) {
+    if (*string == '\n' || *string == '\r') {
+      continue;
+    }
+    const glyph_dsc_t *dsc = &f->glyph_descriptors[*string - 31];
+    int16_t glyph_over = (int)dsc->box_h + dsc->ofs_y;
+    if (glyph_over > over) {
+      over = glyph_over;
+    }
+    if (dsc->ofs_y < under) {
+      under = dsc->ofs_y;
+    }
+  }
+  return (uint16_t)(over - under);
+}
+
+ZLCD_RETURN_STATUS ZLCD_band_string(ZLCD_display_list *list,
+                                    const char *string, uint16_t base_x,
+                                    uint16_t base_y, rgb565 colour,
+                                    const ZLCD_font *f) {
+  if (string == NULL || f == NULL) {
+    return ZLCD_FAILURE;
+  }
+  if (ZLCD_verify_coordinate_is_valid_xy(base_x, base_y) != ZLCD_SUCCESS) {
+    printf("Base coordinate for string write invalid\n");
+    return ZLCD_FAILURE;
+  }
+  for (const char *c = string; *c; c++) {
+    if (!ZLCD_font_has_glyph(*c) && *c != '\n' && *c != '\r') {
+      printf("String has a character that can't be drawn (%d)\n",
+             (unsigned char)*c);
+      return ZLCD_FAILURE;
+    }
+  }
+  ZLCD_band_item *item = ZLCD_band_add(list, ZLCD_BAND_TEXT);
+  if (item == NULL) {
+    return ZLCD_FAILURE;
+  }
+  item->x = base_x;
+  item->y = base_y;
+  item->colour = colour;
+  item->string = string;
+  item->font = f;
+  // the glyph boxes, lines past the bottom of the screen included
+  uint16_t text_height = ZLCD_band_text_height(string, f);
+  int cursor_x = base_x << 4, cursor_y = base_y;
+  int x0 = INT16_MAX, y0 = INT16_MAX, x1 = INT16_MIN, y1 = INT16_MIN;
+  for (const char *c = string; *c; c++) {
+    if (*c == '\n' || *c == '\r') {
+      cursor_x = base_x << 4;
+      cursor_y += text_height;
+      continue;
+    }
+    const glyph_dsc_t *dsc = &f->glyph_descriptors[*c - 31];
+    int glyph_x0 = (cursor_x >> 4) + dsc->ofs_x;
+    int glyph_y0 = cursor_y - dsc->box_h - dsc->ofs_y;
+    cursor_x += dsc->adv_w;
+    if (dsc->box_w == 0 || dsc->box_h == 0) {
+      continue;
+    }
+    x0 = glyph_x0 < x0 ? glyph_x0 : x0;
+    y0 = glyph_y0 < y0 ? glyph_y0 : y0;
+    x1 = glyph_x0 + dsc->box_w - 1 > x1 ? glyph_x0 + dsc->box_w - 1 : x1;
+    y1 = glyph_y0 + dsc->box_h - 1 > y1 ? glyph_y0 + dsc->box_h - 1 : y1;
+  }
+  // x1 < x0 for a string without a visible glyph, it never meets a band
+  item->x0 = x0;
+  item->y0 = y0;
+  item->x1 = x1;
+  item->y1 = y1;
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_band_image(ZLCD_display_list *list, uint16_t x,
+                                   uint16_t y, const ZLCD_image *image) {
+  if (image == NULL) {
+    printf("ZLCD_image provided to ZLCD_band_image is NULL\n");
+    return ZLCD_FAILURE;
+  }
+  if (ZLCD_verify_coordinate_is_valid_xy(x, y) != ZLCD_SUCCESS) {
+    printf("Base coordinate for image draw is invalid\n");
+    return ZLCD_FAILURE;
+  }
+  if (image->offset_x >= image->width || image->offset_y >= image->height) {
+    printf("Image offset too large (x=%u, y=%u)\n", image->offset_x,
+           image->offset_y);
+    return ZLCD_FAILURE;
+  }
+  ZLCD_band_item *item = ZLCD_band_add(list, ZLCD_BAND_IMAGE);
+  if (item == NULL) {
+    return ZLCD_FAILURE;
+  }
+  item->x = item->x0 = x;
+  item->y = item->y0 = y;
+  item->x1 = x + (image->width - image->offset_x) - 1;
+  item->y1 = y + (image->height - image->offset_y) - 1;
+  item->image = image;
+  return ZLCD_SUCCESS;
+}
+
+static inline int32_t ZLCD_band_index(const ZLCD_band *band, int16_t x,
+                                      int16_t y) {
+  return band->origin + x * band->x_step + y * band->y_step;
+}
+
+static inline bool ZLCD_band_inside(const ZLCD_band *band, int16_t x,
+                                    int16_t y) {
+  return x >= band->x0 && x <= band->x1 && y >= band->y0 && y <= band->y1;
+}
+
+static inline void ZLCD_band_store(const ZLCD_band *band, int32_t index,
+                                   rgb565 colour) {
+  band->pixels[index * 2] = (uint8_t)(colour >> 8); // MSB first
+  band->pixels[index * 2 + 1] = (uint8_t)(colour & 0x00FF);
+}
+
+static inline void ZLCD_band_plot(const ZLCD_band *band, int16_t x, int16_t y,
+                                  rgb565 colour) {
+  if (ZLCD_band_inside(band, x, y)) {
+    ZLCD_band_store(band, ZLCD_band_index(band, x, y), colour);
+  }
+}
+
+// corners inclusive, a rectangle in the band whatever the orientation
+static void ZLCD_band_fill(const ZLCD_band *band, int16_t x0, int16_t y0,
+                           int16_t x1, int16_t y1, rgb565 colour) {
+  x0 = x0 > band->x0 ? x0 : band->x0;
+  y0 = y0 > band->y0 ? y0 : band->y0;
+  x1 = x1 < band->x1 ? x1 : band->x1;
+  y1 = y1 < band->y1 ? y1 : band->y1;
+  if (x0 > x1 || y0 > y1) {
+    return;
+  }
+  int32_t first = ZLCD_band_index(band, x0, y0);
+  int32_t last = ZLCD_band_index(band, x1, y1);
+  uint16_t stride = band->frame_width;
+  int32_t first_x = first % stride, first_y = first / stride;
+  int32_t last_x = last % stride, last_y = last / stride;
+  int32_t left = first_x < last_x ? first_x : last_x;
+  int32_t top = first_y < last_y ? first_y : last_y;
+  const uint8_t bytes[sizeof(rgb565)] = {(uint8_t)(colour >> 8),
+                                         (uint8_t)(colour & 0x00FF)};
+  uint16_t pattern;
+  memcpy(&pattern, bytes, sizeof(pattern));
+  ZLCD_fill_rect(
+      (ZLCD_fill_pixel *)&band->pixels[((size_t)top * stride + left) *
+                                       sizeof(rgb565)],
+      pattern, abs(last_x - first_x) + 1, abs(last_y - first_y) + 1, stride);
+}
+
+static void ZLCD_band_draw_rectangle(const ZLCD_band *band,
+                                     const ZLCD_band_item *item) {
+  int16_t t = item->size;
+  if (item->fill) {
+    ZLCD_band_fill(band, item->x, item->y, item->x2, item->y2,
+                   item->fill_colour);
+  }
+  ZLCD_band_fill(band, item->x, item->y, item->x2, item->y + t - 1,
+                 item->colour);
+  ZLCD_band_fill(band, item->x, item->y2 - t + 1, item->x2, item->y2,
+                 item->colour);
+  ZLCD_band_fill(band, item->x, item->y, item->x + t - 1, item->y2,
+                 item->colour);
+  ZLCD_band_fill(band, item->x2 - t + 1, item->y, item->x2, item->y2,
+                 item->colour);
+}
+
+// the spans and the outline of ZLCD_draw_filled_circle_xy()
+static void ZLCD_band_draw_circle(const ZLCD_band *band,
+                                  const ZLCD_band_item *item) {
+  int16_t origin_x = item->x, origin_y = item->y;
+  int x = 0;
+  int y = item->size;
+  int d = 3 - (2 * item->size);
+  while (x <= y) {
+    if (item->fill) {
+      rgb565 fill = item->fill_colour;
+      ZLCD_band_fill(band, origin_x - x, origin_y - y, origin_x + x,
+                     origin_y - y, fill);
+      ZLCD_band_fill(band, origin_x - y, origin_y - x, origin_x + y,
+                     origin_y - x, fill);
+      ZLCD_band_fill(band, origin_x - y, origin_y + x, origin_x + y,
+                     origin_y + x, fill);
+      ZLCD_band_fill(band, origin_x - x, origin_y + y, origin_x + x,
+                     origin_y + y, fill);
+    }
+    if (d < 0) {
+      d += (4 * x) + 6;
+    } else {
+      d += 4 * (x - y) + 10;
+      y--;
+    }
+    x++;
+  }
+  // the outline goes over all of the fill, as in the driver
+  x = 0;
+  y = item->size;
+  d = 3 - (2 * item->size);
+  while (x <= y) {
+    ZLCD_band_plot(band, origin_x + x, origin_y + y, item->colour);
+    ZLCD_band_plot(band, origin_x - x, origin_y + y, item->colour);
+    ZLCD_band_plot(band, origin_x + x, origin_y - y, item->colour);
+    ZLCD_band_plot(band, origin_x - x, origin_y - y, item->colour);
+    ZLCD_band_plot(band, origin_x + y, origin_y + x, item->colour);
+    ZLCD_band_plot(band, origin_x - y, origin_y + x, item->colour);
+    ZLCD_band_plot(band, origin_x + y, origin_y - x, item->colour);
+    ZLCD_band_plot(band, origin_x - y, origin_y - x, item->colour);
+    if (d < 0) {
+      d += (4 * x) + 6;
+    } else {
+      d += 4 * (x - y) + 10;
+      y--;
+    }
+    x++;
+  }
+}
+
+// Bresenham as in the line kernel, only the points in the band are stored
+static void ZLCD_band_draw_line(const ZLCD_band *band,
+                                const ZLCD_band_item *item) {
+  int16_t x1 = item->x, y1 = item->y, x2 = item->x2, y2 = item->y2;
+  int dx = abs(x2 - x1);
+  int dy = -abs(y2 - y1);
+  int sx = x1 < x2 ? 1 : -1;
+  int sy = y1 < y2 ? 1 : -1;
+  int err = dx + dy;
+  while (1) {
+    ZLCD_band_plot(band, x1, y1, item->colour);
+    if (x1 == x2 && y1 == y2)
+      break;
+    int e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x1 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y1 += sy;
+    }
+  }
+}
+
+static void ZLCD_band_draw_glyph(const ZLCD_band *band, const uint8_t *bitmap,
+                                 int16_t x0, int16_t y0, int16_t box_w,
+                                 int16_t box_h, rgb565 colour) {
+  for (int16_t row = 0; row < box_h; row++) {
+    int16_t y = y0 + row;
+    if (y < band->y0 || y > band->y1) {
+      continue;
+    }
+    uint32_t bit_index = (uint32_t)row * box_w;
+    for (int16_t column = 0; column < box_w; column++, bit_index++) {
+      if ((bitmap[bit_index / 8] >> (7 - (bit_index % 8))) & 0x1) {
+        ZLCD_band_plot(band, x0 + column, y, colour);
+      }
+    }
+  }
+}
+
+// the glyphs of ZLCD_print_string_xy(), lines below the screen are left out
+static void ZLCD_band_draw_text(const ZLCD_band *band,
+                                const ZLCD_band_item *item,
+                                uint16_t screen_height) {
+  const ZLCD_font *f = item->font;
+  uint16_t text_height = ZLCD_band_text_height(item->string, f);
+  int cursor_x = item->x << 4, cursor_y = item->y;
+  for (const char *c = item->string; *c; c++) {
+    if (*c == '\n' || *c == '\r') {
+      cursor_x = item->x << 4;
+      cursor_y += text_height;
+      if (cursor_y >= screen_height)
+        break;
+      continue;
+    }
+    const glyph_dsc_t *dsc = &f->glyph_descriptors[*c - 31];
+    int16_t glyph_x0 = (cursor_x >> 4) + dsc->ofs_x;
+    int16_t glyph_y0 = cursor_y - dsc->box_h - dsc->ofs_y;
+    cursor_x += dsc->adv_w;
+    if (glyph_x0 > band->x1 || glyph_x0 + dsc->box_w <= band->x0 ||
+        glyph_y0 > band->y1 || glyph_y0 + dsc->box_h <= band->y0) {
+      continue;
+    }
+    ZLCD_band_draw_glyph(band, &f->glyph_bitmap[dsc->bitmap_index], glyph_x0,
+                         glyph_y0, dsc->box_w, dsc->box_h, item->colour);
+  }
+}
+
+// the part of an LVGL map (LSB first) that is in the band
+static void ZLCD_band_draw_image(const ZLCD_band *band,
+                                 const ZLCD_band_item *item) {
+  const ZLCD_image *image = item->image;
+  int16_t x0 = item->x0 > band->x0 ? item->x0 : band->x0;
+  int16_t y0 = item->y0 > band->y0 ? item->y0 : band->y0;
+  int16_t x1 = item->x1 < band->x1 ? item->x1 : band->x1;
+  int16_t y1 = item->y1 < band->y1 ? item->y1 : band->y1;
+  for (int16_t y = y0; y <= y1; y++) {
+    const uint8_t *source =
+        &image->map[((size_t)(image->offset_y + y - item->y) * image->width +
+                     image->offset_x + x0 - item->x) *
+                    sizeof(rgb565)];
+    int32_t index = ZLCD_band_index(band, x0, y);
+    for (int16_t x = x0; x <= x1; x++) {
+      band->pixels[index * 2] = source[1]; // MSB
+      band->pixels[index * 2 + 1] = source[0];
+      index += band->x_step;
+      source += sizeof(rgb565);
+    }
+  }
+}
+
+static inline bool ZLCD_band_meets(const ZLCD_band *band,
+                                   const ZLCD_band_item *item) {
+  return item->x0 <= band->x1 && item->x1 >= band->x0 &&
+         item->y0 <= band->y1 && item->y1 >= band->y0;
+}
+
+/*
+screen coordinates low to high along the axis that steps step frame pixels,
+for frame rows first to last. origin is the frame pixel of screen pixel (0, 0).
+The other axis runs along the frame rows and is in every band whole
+*/
+static void ZLCD_band_rows_to_axis(const ZLCD_frame_layout *layout,
+                                   int32_t step, uint16_t first, uint16_t last,
+                                   int16_t *low, int16_t *high) {
+  int32_t origin_row = layout->origin / layout->frame_width;
+  if (step > 0) {
+    *low = first - origin_row;
+    *high = last - origin_row;
+  } else {
+    *low = origin_row - last;
+    *high = origin_row - first;
+  }
+}
+
+ZLCD_RETURN_STATUS ZLCD_band_render(const ZLCD_display_list *list,
+                                    ZLCD_band_stats *stats) {
+  if (list == NULL) {
+    return ZLCD_FAILURE;
+  }
+  ZLCD_frame_layout layout;
+  ZLCD_RETURN_STATUS status = ZLCD_get_frame_layout(&layout);
+  if (status != ZLCD_SUCCESS) {
+    return status;
+  }
+  if (memcmp(&layout, &band_layout, sizeof(layout)) != 0) {
+    // the bands are other parts of the screen now
+    ZLCD_band_forget();
+    band_layout = layout;
+  }
+  if (list->background != band_background) {
+    memset(band_blank, 0, sizeof(band_blank));
+    band_background = list->background;
+  }
+  ZLCD_band_stats counts = {
+      .bands = (layout.frame_height + ZLCD_BAND_ROWS - 1U) / ZLCD_BAND_ROWS};
+  uint16_t width = layout.frame_width;
+  ZLCD_band band = {.pixels = (uint8_t *)band_pixels,
+                    .x_step = layout.x_step,
+                    .y_step = layout.y_step,
+                    .frame_width = width};
+  bool rows_along_y = layout.y_step == width || layout.y_step == -width;
+  for (uint16_t b = 0; b < counts.bands; b++) {
+    uint16_t first = b * ZLCD_BAND_ROWS;
+    uint16_t rows = ZLCD_BAND_ROWS;
+    if (first + rows > layout.frame_height) {
+      rows = layout.frame_height - first;
+    }
+    band.origin = layout.origin - (int32_t)first * width;
+    if (rows_along_y) {
+      band.x0 = 0;
+      band.x1 = layout.width - 1;
+      ZLCD_band_rows_to_axis(&layout, layout.y_step, first, first + rows - 1,
+                             &band.y0, &band.y1);
+    } else {
+      band.y0 = 0;
+      band.y1 = layout.height - 1;
+      ZLCD_band_rows_to_axis(&layout, layout.x_step, first, first + rows - 1,
+                             &band.x0, &band.x1);
+    }
+    bool touched = false;
+    for (size_t i = 0; i < list->num_items && !touched; i++) {
+      touched = ZLCD_band_meets(&band, &list->items[i]);
+    }
+    if (!touched && band_known[b] && band_blank[b]) {
+      continue;
+    }
+
+    ZLCD_band_fill(&band, band.x0, band.y0, band.x1, band.y1,
+                   list->background);
+    for (size_t i = 0; touched && i < list->num_items; i++) {
+      const ZLCD_band_item *item = &list->items[i];
+      if (!ZLCD_band_meets(&band, item)) {
+        continue;
+      }
+      switch (item->type) {
+      case ZLCD_BAND_RECTANGLE:
+        ZLCD_band_draw_rectangle(&band, item);
+        break;
+      case ZLCD_BAND_CIRCLE:
+        ZLCD_band_draw_circle(&band, item);
+        break;
+      case ZLCD_BAND_LINE:
+        ZLCD_band_draw_line(&band, item);
+        break;
+      case ZLCD_BAND_TEXT:
+        ZLCD_band_draw_text(&band, item, layout.height);
+        break;
+      case ZLCD_BAND_IMAGE:
+        ZLCD_band_draw_image(&band, item);
+        break;
+      }
+    }
+    counts.bands_drawn++;
+
+    size_t row_bytes = (size_t)width * sizeof(rgb565);
+    uint32_t digest = ZLCD_hash_tile(band.pixels, row_bytes, width, rows);
+    if (band_known[b] && band_digest[b] == digest) {
+      band_blank[b] = !touched;
+      continue;
+    }
+    band_known[b] = false;
+    status = ZLCD_write_frame_rows(first, rows, band.pixels);
+    if (status != ZLCD_SUCCESS) {
+      break;
+    }
+    band_digest[b] = digest;
+    band_known[b] = true;
+    band_blank[b] = !touched;
+    counts.bands_sent++;
+  }
+  if (stats != NULL) {
+    *stats = counts;
+  }
+  return status;
+}
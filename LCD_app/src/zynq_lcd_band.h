@@ -0,0 +1,100 @@
+#ifndef ZYNQ_LCD_BAND_H
+#define ZYNQ_LCD_BAND_H
+/****************************************************************************
+Band renderer, for drawing a frame without going through the GRAM. The
+application puts what the screen shows into a display list and
+ZLCD_band_render() draws it into one band of ZLCD_BAND_ROWS frame rows at a
+time, sending every band with ZLCD_write_frame_rows(). Items are clipped to the
+band, so each one costs about the pixels it has in the band plus a bounding box
+test per band. A band no item reaches is not drawn at all once the LCD shows
+only the background there, and a band that comes out with the same digest
+(zynq_lcd_hash.h) as the one last sent there is not sent.
+
+The items look like the drawing functions of the same name and give the same
+pixels. Strings, fonts and images are not copied: they have to stay valid until
+ZLCD_band_render() has returned. Items are drawn in the order they were added,
+in the orientation ZLCD_band_render() finds.
+
+Only what ZLCD_band_render() sent is remembered. Call ZLCD_band_forget() after
+the LCD was written any other way (refreshes, update_now drawing, scrolling).
+*****************************************************************************/
+
+#include "zynq_lcd_st7789.h"
+
+// frame rows per band, a band takes ZLCD_BAND_ROWS * 640 bytes
+#ifndef ZLCD_BAND_ROWS
+#define ZLCD_BAND_ROWS 16U
+#endif
+// the frame is 320 pixels wide in landscape with ZLCD_ROTATE_MADCTL
+#define ZLCD_BAND_MAX_WIDTH ZLCD_HEIGHT
+#define ZLCD_BAND_MAX_BANDS                                                    \
+  ((ZLCD_HEIGHT + ZLCD_BAND_ROWS - 1U) / ZLCD_BAND_ROWS)
+
+typedef enum {
+  ZLCD_BAND_RECTANGLE,
+  ZLCD_BAND_CIRCLE,
+  ZLCD_BAND_LINE,
+  ZLCD_BAND_TEXT,
+  ZLCD_BAND_IMAGE
+} ZLCD_BAND_ITEM_TYPE;
+
+typedef struct {
+  ZLCD_BAND_ITEM_TYPE type;
+  int16_t x0, y0, x1, y1; // everything the item can draw on, inclusive
+  int16_t x, y;   // rectangle origin, circle centre, text base, line start
+  int16_t x2, y2; // rectangle corner across from the origin, line end
+  uint16_t size;  // border thickness or radius
+  bool fill;
+  rgb565 colour, fill_colour;
+  const char *string;
+  const ZLCD_font *font;
+  const ZLCD_image *image;
+} ZLCD_band_item;
+
+typedef struct {
+  ZLCD_band_item *items; // max_items long, owned by the application
+  size_t max_items;
+  size_t num_items;
+  rgb565 background; // under everything
+} ZLCD_display_list;
+
+// what the last ZLCD_band_render() did with the bands of the frame
+typedef struct {
+  uint16_t bands;
+  uint16_t bands_drawn; // the others had no item and showed the background
+  uint16_t bands_sent;  // the others came out the same as last time
+} ZLCD_band_stats;
+
+void ZLCD_display_list_init(ZLCD_display_list *list, ZLCD_band_item *items,
+                            size_t max_items, rgb565 background);
+// empties the list for the next frame
+void ZLCD_display_list_clear(ZLCD_display_list *list, rgb565 background);
+
+ZLCD_RETURN_STATUS ZLCD_band_rectangle(ZLCD_display_list *list,
+                                       uint16_t origin_x, uint16_t origin_y,
+                                       uint16_t width_px, uint16_t height_px,
+                                       uint16_t border_thickness_px,
+                                       rgb565 border_colour, bool fill,
+                                       rgb565 fill_colour);
+ZLCD_RETURN_STATUS ZLCD_band_circle(ZLCD_display_list *list, uint16_t origin_x,
+                                    uint16_t origin_y, uint16_t radius_px,
+                                    rgb565 border_colour, bool fill,
+                                    rgb565 fill_colour);
+ZLCD_RETURN_STATUS ZLCD_band_line(ZLCD_display_list *list, uint16_t x1,
+                                  uint16_t y1, uint16_t x2, uint16_t y2,
+                                  rgb565 colour);
+// ZLCD_print_string_xy(), newlines start a new line below base_x
+ZLCD_RETURN_STATUS ZLCD_band_string(ZLCD_display_list *list,
+                                    const char *string, uint16_t base_x,
+                                    uint16_t base_y, rgb565 colour,
+                                    const ZLCD_font *f);
+ZLCD_RETURN_STATUS ZLCD_band_image(ZLCD_display_list *list, uint16_t x,
+                                   uint16_t y, const ZLCD_image *image);
+
+// draws and sends the list, stats may be NULL
+ZLCD_RETURN_STATUS ZLCD_band_render(const ZLCD_display_list *list,
+                                    ZLCD_band_stats *stats);
+// what the LCD shows is no longer known, the next render sends every band
+void ZLCD_band_forget(void);
+
+#endif // ZYNQ_LCD_BAND_H
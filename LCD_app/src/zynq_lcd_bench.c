@@ -0,0 +1,493 @@
+#include "zynq_lcd_bench.h"
+#include "zynq_lcd_fill.h"
+#include "zynq_lcd_stats.h"
+#include <string.h>
+
+/*************************************************
+  benchmark matrix for the ST7789VW driver
+**************************************************/
+
+// the workloads draw into the frame, there is nothing to measure without it
+#if !ZLCD_FRAMELESS
+
+// sizes are the side of the box a primitive is drawn in, 0 means full screen
+static const uint16_t bench_sizes[] = {8, 32, 0};
+
+static const ZLCD_ORIENTATION bench_orientations[] = {
+    ZLCD_PORTRAIT_ORIENTATION, ZLCD_INVERTED_PORTRAIT_ORIENTATION,
+    ZLCD_LANDSCAPE_ORIENTATION, ZLCD_INVERTED_LANDSCAPE_ORIENTATION};
+
+static const char *const bench_text =
+    "The quick brown fox jumps over the lazy dog";
+
+static uint64_t bench_samples[ZLCD_BENCH_MAX_ITERATIONS];
+// target of the fill kernel workloads, one frame in size
+static uint16_t bench_scratch[ZLCD_WIDTH * ZLCD_HEIGHT];
+
+static const char *ZLCD_bench_orientation_name(ZLCD_ORIENTATION orientation) {
+  switch (orientation) {
+  case ZLCD_PORTRAIT_ORIENTATION:
+    return "portrait";
+  case ZLCD_INVERTED_PORTRAIT_ORIENTATION:
+    return "inverted_portrait";
+  case ZLCD_LANDSCAPE_ORIENTATION:
+    return "landscape";
+  case ZLCD_INVERTED_LANDSCAPE_ORIENTATION:
+    return "inverted_landscape";
+  default:
+    return "unknown";
+  }
+}
+
+static void ZLCD_bench_screen_size(uint16_t *width, uint16_t *height) {
+  ZLCD_ORIENTATION orientation = ZLCD_get_orientation();
+  bool landscape = orientation == ZLCD_LANDSCAPE_ORIENTATION ||
+                   orientation == ZLCD_INVERTED_LANDSCAPE_ORIENTATION;
+  *width = landscape ? ZLCD_HEIGHT : ZLCD_WIDTH;
+  *height = landscape ? ZLCD_WIDTH : ZLCD_HEIGHT;
+}
+
+// every iteration draws in the other colour so the refresh always has work
+static rgb565 ZLCD_bench_colour(uint32_t iteration) {
+  return (iteration & 1) ? YELLOW : MAGENTA;
+}
+
+void ZLCD_bench_summarize(uint64_t *samples, size_t num_samples,
+                          ZLCD_bench_summary *summary) {
+  if (summary == NULL) {
+    return;
+  }
+  if (samples == NULL || num_samples == 0) {
+    *summary = (ZLCD_bench_summary){0};
+    return;
+  }
+  // insertion sort, there are only ever a few hundred samples
+  for (size_t i = 1; i < num_samples; i++) {
+    uint64_t value = samples[i];
+    size_t j = i;
+    for (; j > 0 && samples[j - 1] > value; j--) {
+      samples[j] = samples[j - 1];
+    }
+    samples[j] = value;
+  }
+  size_t p99_rank = (num_samples * 99 + 99) / 100; // ceil(0.99 * n)
+  summary->min = samples[0];
+  summary->median = samples[num_samples / 2];
+  summary->p99 = samples[p99_rank - 1];
+}
+
+/*
+One workload: setup() runs untimed before every iteration, run() is what gets
+measured. size is only passed through to the primitives.
+*/
+typedef struct {
+  void (*setup)(const void *argument, uint16_t size, uint32_t iteration);
+  void (*run)(const void *argument, uint16_t size, uint32_t iteration);
+  const void *argument;
+} ZLCD_bench_workload;
+
+static void ZLCD_bench_measure_as(const ZLCD_bench_config *config,
+                                  const char *name, const char *orientation,
+                                  uint16_t size,
+                                  const ZLCD_bench_workload *workload) {
+  uint64_t bytes = 0, commands = 0;
+  bool have_bus = config->read_bus_counters != NULL;
+  // the transmit interrupts and the time until the bus was idle again
+  uint64_t interrupts = 0, interrupt_us = 0, busy_us = 0;
+
+  for (uint32_t i = 0; i < config->iterations; i++) {
+    if (workload->setup != NULL) {
+      workload->setup(workload->argument, size, i);
+    }
+    uint64_t bytes_before = 0, commands_before = 0;
+    if (have_bus) {
+      have_bus = config->read_bus_counters(config->context, &bytes_before,
+                                           &commands_before);
+    }
+#if ZLCD_STATS_ENABLED
+    ZLCD_stats stats_before, stats_after;
+    ZLCD_get_stats(&stats_before);
+    uint64_t ticks_before = ZLCD_stats_ticks();
+#endif
+    uint64_t start = config->read_cycles(config->context);
+    workload->run(workload->argument, size, i);
+    uint64_t end = config->read_cycles(config->context);
+#if ZLCD_STATS_ENABLED
+    // waits for the bus, so the interrupts of an async refresh are all in
+    ZLCD_get_stats(&stats_after);
+    busy_us += ZLCD_stats_ticks_to_us(ZLCD_stats_ticks() - ticks_before);
+    interrupts +=
+        stats_after.transmit_interrupts - stats_before.transmit_interrupts;
+    interrupt_us += stats_after.interrupt_us - stats_before.interrupt_us;
+#endif
+    if (have_bus) {
+      uint64_t bytes_after = 0, commands_after = 0;
+      have_bus = config->read_bus_counters(config->context, &bytes_after,
+                                           &commands_after);
+      bytes += bytes_after - bytes_before;
+      commands += commands_after - commands_before;
+    }
+    bench_samples[i] = end - start;
+  }
+
+  ZLCD_bench_summary summary;
+  ZLCD_bench_summarize(bench_samples, config->iterations, &summary);
+  printf("%s,%s,%u,%lu,%llu,%llu,%llu,", name, orientation, size,
+         (unsigned long)config->iterations, (unsigned long long)summary.min,
+         (unsigned long long)summary.median, (unsigned long long)summary.p99);
+  if (have_bus) {
+    // per iteration, the same drawing always puts the same bytes on the bus
+    printf("%llu,%llu,", (unsigned long long)(bytes / config->iterations),
+           (unsigned long long)(commands / config->iterations));
+  } else {
+    printf(",,");
+  }
+#if ZLCD_STATS_ENABLED
+  // irq_load in tenths of a percent of the time the bus was busy
+  uint64_t load = busy_us != 0 ? interrupt_us * 1000U / busy_us : 0;
+  printf("%llu,%llu,%llu.%llu\n",
+         (unsigned long long)(interrupts / config->iterations),
+         (unsigned long long)(interrupt_us / config->iterations),
+         (unsigned long long)(load / 10U), (unsigned long long)(load % 10U));
+#else
+  (void)interrupts;
+  (void)interrupt_us;
+  (void)busy_us;
+  printf(",,\n");
+#endif
+}
+
+static void ZLCD_bench_measure(const ZLCD_bench_config *config,
+                               const char *name, uint16_t size,
+                               const ZLCD_bench_workload *workload) {
+  ZLCD_bench_measure_as(config, name,
+                        ZLCD_bench_orientation_name(ZLCD_get_orientation()),
+                        size, workload);
+}
+
+/*************************************************
+  primitives, drawn in a size x size box at the
+  top left and sent right away
+**************************************************/
+
+static void ZLCD_bench_pixels(const void *argument, uint16_t size,
+                              uint32_t iteration) {
+  (void)argument;
+  for (uint16_t i = 0; i < size; i++) {
+    ZLCD_set_pixel_xy(i, i, ZLCD_bench_colour(iteration), false);
+  }
+  ZLCD_refresh_display();
+}
+
+static void ZLCD_bench_hline(const void *argument, uint16_t size,
+                             uint32_t iteration) {
+  (void)argument;
+  ZLCD_draw_hline(0, 0, size - 1, ZLCD_bench_colour(iteration), true);
+}
+
+static void ZLCD_bench_vline(const void *argument, uint16_t size,
+                             uint32_t iteration) {
+  (void)argument;
+  ZLCD_draw_vline(0, 0, size - 1, ZLCD_bench_colour(iteration), true);
+}
+
+static void ZLCD_bench_line(const void *argument, uint16_t size,
+                            uint32_t iteration) {
+  (void)argument;
+  ZLCD_draw_line_xy(0, 0, size - 1, size - 1, ZLCD_bench_colour(iteration),
+                    true);
+}
+
+static void ZLCD_bench_unfilled_rectangle(const void *argument, uint16_t size,
+                                          uint32_t iteration) {
+  (void)argument;
+  ZLCD_draw_unfilled_rectangle_xy(0, 0, size, size, 1,
+                                  ZLCD_bench_colour(iteration), true);
+}
+
+static void ZLCD_bench_filled_rectangle(const void *argument, uint16_t size,
+                                        uint32_t iteration) {
+  (void)argument;
+  rgb565 colour = ZLCD_bench_colour(iteration);
+  ZLCD_draw_filled_rectangle_xy(0, 0, size, size, 1, colour, colour, true);
+}
+
+static void ZLCD_bench_unfilled_triangle(const void *argument, uint16_t size,
+                                         uint32_t iteration) {
+  (void)argument;
+  ZLCD_draw_unfilled_triangle_xy(0, 0, size - 1, 0, 0, size - 1,
+                                 ZLCD_bench_colour(iteration), true);
+}
+
+static void ZLCD_bench_filled_triangle(const void *argument, uint16_t size,
+                                       uint32_t iteration) {
+  (void)argument;
+  rgb565 colour = ZLCD_bench_colour(iteration);
+  ZLCD_draw_filled_triangle_xy(0, 0, size - 1, 0, 0, size - 1, colour, colour,
+                               true);
+}
+
+static void ZLCD_bench_unfilled_circle(const void *argument, uint16_t size,
+                                       uint32_t iteration) {
+  (void)argument;
+  uint16_t radius = size / 2 > 1 ? size / 2 - 1 : 1;
+  ZLCD_draw_unfilled_circle_xy(radius, radius, radius,
+                               ZLCD_bench_colour(iteration), true);
+}
+
+static void ZLCD_bench_filled_circle(const void *argument, uint16_t size,
+                                     uint32_t iteration) {
+  (void)argument;
+  uint16_t radius = size / 2 > 1 ? size / 2 - 1 : 1;
+  rgb565 colour = ZLCD_bench_colour(iteration);
+  ZLCD_draw_filled_circle_xy(radius, radius, radius, colour, colour, true);
+}
+
+typedef struct {
+  const char *name;
+  void (*run)(const void *argument, uint16_t size, uint32_t iteration);
+} ZLCD_bench_primitive;
+
+static const ZLCD_bench_primitive bench_primitives[] = {
+    {"pixels", ZLCD_bench_pixels},
+    {"hline", ZLCD_bench_hline},
+    {"vline", ZLCD_bench_vline},
+    {"line", ZLCD_bench_line},
+    {"unfilled_rectangle", ZLCD_bench_unfilled_rectangle},
+    {"filled_rectangle", ZLCD_bench_filled_rectangle},
+    {"unfilled_triangle", ZLCD_bench_unfilled_triangle},
+    {"filled_triangle", ZLCD_bench_filled_triangle},
+    {"unfilled_circle", ZLCD_bench_unfilled_circle},
+    {"filled_circle", ZLCD_bench_filled_circle},
+};
+
+/*************************************************
+  text, images, refreshes and printf
+**************************************************/
+
+static void ZLCD_bench_text(const void *argument, uint16_t size,
+                            uint32_t iteration) {
+  (void)size;
+  const ZLCD_font *font = argument;
+  ZLCD_print_string_on_background_xy(bench_text, 0, 40,
+                                     ZLCD_bench_colour(iteration), BLACK, font,
+                                     true);
+}
+
+// the image itself never changes, so the screen is filled in between
+static void ZLCD_bench_fill_screen(const void *argument, uint16_t size,
+                                   uint32_t iteration) {
+  (void)argument;
+  (void)size;
+  uint16_t width, height;
+  ZLCD_bench_screen_size(&width, &height);
+  rgb565 colour = ZLCD_bench_colour(iteration);
+  ZLCD_draw_filled_rectangle_xy(0, 0, width, height, 1, colour, colour, true);
+}
+
+static void ZLCD_bench_image_blit(const void *argument, uint16_t size,
+                                  uint32_t iteration) {
+  (void)size;
+  (void)iteration;
+  ZLCD_draw_image(ZLCD_create_coordinate(0, 0), argument, true);
+}
+
+static void ZLCD_bench_draw_full(const void *argument, uint16_t size,
+                                 uint32_t iteration) {
+  (void)argument;
+  (void)size;
+  uint16_t width, height;
+  ZLCD_bench_screen_size(&width, &height);
+  rgb565 colour = ZLCD_bench_colour(iteration);
+  ZLCD_draw_filled_rectangle_xy(0, 0, width, height, 1, colour, colour, false);
+}
+
+static void ZLCD_bench_draw_partial(const void *argument, uint16_t size,
+                                    uint32_t iteration) {
+  (void)argument;
+  rgb565 colour = ZLCD_bench_colour(iteration);
+  ZLCD_draw_filled_rectangle_xy(size, size, size, size, 1, colour, colour,
+                                false);
+}
+
+static void ZLCD_bench_refresh(const void *argument, uint16_t size,
+                               uint32_t iteration) {
+  (void)argument;
+  (void)size;
+  (void)iteration;
+  ZLCD_refresh_display();
+}
+
+static void ZLCD_bench_printf(const void *argument, uint16_t size,
+                              uint32_t iteration) {
+  (void)argument;
+  (void)size;
+  ZLCD_printf("benchmark line %lu\n", (unsigned long)iteration);
+}
+
+/*************************************************
+  fill kernels on their own, size is in pixels
+**************************************************/
+
+// how the drawing functions filled the MSB-first GRAM before the kernels
+static void ZLCD_bench_fill_bytewise(const void *argument, uint16_t size,
+                                     uint32_t iteration) {
+  (void)argument;
+  uint8_t *bytes = (uint8_t *)bench_scratch;
+  rgb565 colour = ZLCD_bench_colour(iteration);
+  for (uint16_t i = 0; i < size; i++) {
+    bytes[2 * i] = (uint8_t)(colour >> 8);
+    bytes[2 * i + 1] = (uint8_t)(colour & 0xFF);
+  }
+}
+
+static void ZLCD_bench_fill_span_scalar(const void *argument, uint16_t size,
+                                        uint32_t iteration) {
+  (void)argument;
+  ZLCD_fill_span_scalar(bench_scratch, ZLCD_bench_colour(iteration), size);
+}
+
+static void ZLCD_bench_fill_span(const void *argument, uint16_t size,
+                                 uint32_t iteration) {
+  (void)argument;
+  ZLCD_fill_span(bench_scratch, ZLCD_bench_colour(iteration), size);
+}
+
+// a landscape row, size pixels down a portrait column
+static void ZLCD_bench_fill_strided(const void *argument, uint16_t size,
+                                    uint32_t iteration) {
+  (void)argument;
+  ZLCD_fill_strided(bench_scratch, ZLCD_bench_colour(iteration), size,
+                    ZLCD_WIDTH);
+}
+
+static void ZLCD_bench_run_kernels(const ZLCD_bench_config *config) {
+  static const struct {
+    const char *name;
+    void (*run)(const void *argument, uint16_t size, uint32_t iteration);
+  } kernels[] = {
+      {"fill_bytewise", ZLCD_bench_fill_bytewise},
+      {"fill_span_scalar", ZLCD_bench_fill_span_scalar},
+      {"fill_span", ZLCD_bench_fill_span},
+  };
+  // a short run, a portrait row and a whole frame
+  static const uint16_t sizes[] = {8, ZLCD_WIDTH, ZLCD_WIDTH * ZLCD_HEIGHT};
+
+  for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+    ZLCD_bench_workload workload = {NULL, kernels[k].run, NULL};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+      ZLCD_bench_measure_as(config, kernels[k].name, "none", sizes[s],
+                            &workload);
+    }
+  }
+  ZLCD_bench_workload strided = {NULL, ZLCD_bench_fill_strided, NULL};
+  ZLCD_bench_measure_as(config, "fill_strided", "none", 8, &strided);
+  ZLCD_bench_measure_as(config, "fill_strided", "none", ZLCD_HEIGHT, &strided);
+}
+
+static void ZLCD_bench_run_orientation(const ZLCD_bench_config *config) {
+  uint16_t width, height;
+  ZLCD_bench_screen_size(&width, &height);
+
+  // every workload starts from a blank screen so its first iteration has work
+  for (size_t p = 0; p < sizeof(bench_primitives) / sizeof(bench_primitives[0]);
+       p++) {
+    ZLCD_bench_workload workload = {NULL, bench_primitives[p].run, NULL};
+    for (size_t s = 0; s < sizeof(bench_sizes) / sizeof(bench_sizes[0]);
+         s++) {
+      uint16_t size = bench_sizes[s] != 0 ? bench_sizes[s]
+                                          : (width < height ? width : height);
+      ZLCD_draw_background();
+      ZLCD_bench_measure(config, bench_primitives[p].name, size, &workload);
+    }
+  }
+
+  for (size_t f = 0; f < config->num_fonts; f++) {
+    char name[48];
+    snprintf(name, sizeof(name), "text_%s", config->fonts[f].name);
+    ZLCD_bench_workload workload = {NULL, ZLCD_bench_text,
+                                    config->fonts[f].font};
+    ZLCD_draw_background();
+    ZLCD_bench_measure(config, name, (uint16_t)strlen(bench_text), &workload);
+  }
+
+  for (size_t i = 0; i < config->num_images; i++) {
+    char name[48];
+    snprintf(name, sizeof(name), "image_%s", config->images[i].name);
+    ZLCD_bench_workload workload = {ZLCD_bench_fill_screen,
+                                    ZLCD_bench_image_blit,
+                                    config->images[i].image};
+    const ZLCD_image *image = config->images[i].image;
+    ZLCD_bench_measure(config, name,
+                       image->width > image->height ? image->width
+                                                    : image->height,
+                       &workload);
+  }
+
+  ZLCD_draw_background();
+  ZLCD_bench_workload full = {ZLCD_bench_draw_full, ZLCD_bench_refresh, NULL};
+  ZLCD_bench_measure(config, "refresh_full", width < height ? width : height,
+                     &full);
+  ZLCD_draw_background();
+  ZLCD_bench_workload partial = {ZLCD_bench_draw_partial, ZLCD_bench_refresh,
+                                 NULL};
+  ZLCD_bench_measure(config, "refresh_partial", 32, &partial);
+  ZLCD_bench_workload unchanged = {NULL, ZLCD_bench_refresh, NULL};
+  ZLCD_bench_measure(config, "refresh_unchanged", 0, &unchanged);
+
+  ZLCD_PRINTF_MODE printf_mode = ZLCD_get_printf_mode();
+  ZLCD_draw_background();
+  ZLCD_set_printf_mode(ZLCD_PRINTF_MODE_SCROLL);
+  ZLCD_set_printf_cursor_xy(0, 0);
+  ZLCD_bench_workload scroll = {NULL, ZLCD_bench_printf, NULL};
+  ZLCD_bench_measure(config, "printf_scroll", 0, &scroll);
+  ZLCD_set_printf_mode(printf_mode);
+}
+
+ZLCD_RETURN_STATUS ZLCD_bench_run(const ZLCD_bench_config *config) {
+  if (config == NULL || config->read_cycles == NULL) {
+    printf("ERROR: benchmark needs a cycle counter\n");
+    return ZLCD_FAILURE;
+  }
+  if (config->iterations == 0 ||
+      config->iterations > ZLCD_BENCH_MAX_ITERATIONS) {
+    printf("ERROR: benchmark iterations must be 1 to %u\n",
+           ZLCD_BENCH_MAX_ITERATIONS);
+    return ZLCD_FAILURE;
+  }
+  ZLCD_ORIENTATION original_orientation = ZLCD_get_orientation();
+  if (original_orientation == ZLCD_UNKNOWN_ORIENTATION) {
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+
+  printf("# ZLCD benchmark, cycles in %s, spi_bytes, commands, interrupts and "
+         "interrupt_us are per iteration, irq_load is the percent of the time "
+         "until the bus was idle spent in transmit interrupts\n",
+         config->cycle_unit != NULL ? config->cycle_unit : "ticks");
+  // which build this is, so runs with the working set elsewhere can be told
+  // apart (zynq_lcd_place.h)
+  ZLCD_placement placement;
+  ZLCD_get_placement(&placement);
+  printf("# placement frame=%s spare_frames=%s work=%s fonts=%s code=%s "
+         "ocm_bytes=%lu l2_bytes=%lu l2_ways=0x%02x\n",
+         ZLCD_memory_name(ZLCD_FRAME_MEMORY),
+         ZLCD_memory_name(ZLCD_SPARE_FRAME_MEMORY),
+         ZLCD_memory_name(ZLCD_WORK_MEMORY),
+         ZLCD_memory_name(ZLCD_FONT_MEMORY),
+         ZLCD_memory_name(ZLCD_CODE_MEMORY),
+         (unsigned long)placement.ocm_bytes, (unsigned long)placement.l2_bytes,
+         (unsigned)placement.l2_ways);
+  printf("workload,orientation,size,iterations,min,median,p99,spi_bytes,"
+         "commands,interrupts,interrupt_us,irq_load\n");
+  for (size_t o = 0;
+       o < sizeof(bench_orientations) / sizeof(bench_orientations[0]); o++) {
+    ZLCD_set_orientation(bench_orientations[o]);
+    ZLCD_bench_run_orientation(config);
+  }
+  ZLCD_bench_run_kernels(config);
+
+  ZLCD_set_orientation(original_orientation);
+  ZLCD_draw_background();
+  return ZLCD_SUCCESS;
+}
+#endif
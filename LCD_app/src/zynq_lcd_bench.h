@@ -0,0 +1,72 @@
+#ifndef ZYNQ_LCD_BENCH_H
+#define ZYNQ_LCD_BENCH_H
+/****************************************************************************
+Benchmark suite for the ZLCD driver. Runs a fixed matrix of workloads (every
+primitive in every orientation and a few sizes, text in each given font, image
+blits, refreshes and ZLCD_printf() scrolling) and prints one CSV line per
+workload so runs can be compared when the driver changes. It needs the frame,
+a ZLCD_FRAMELESS build leaves it out.
+*****************************************************************************/
+
+#include "zynq_lcd_st7789.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ZLCD_BENCH_MAX_ITERATIONS
+#define ZLCD_BENCH_MAX_ITERATIONS 255U
+#endif
+
+typedef struct {
+  const char *name; // used in the workload column, no commas
+  const ZLCD_font *font;
+} ZLCD_bench_font;
+
+typedef struct {
+  const char *name;
+  const ZLCD_image *image;
+} ZLCD_bench_image;
+
+/*
+Everything platform specific comes from the caller: on the board a cycle
+counter, on the host a clock and the byte counters of the ST7789 emulator.
+*/
+typedef struct {
+  // free running counter, only differences are used
+  uint64_t (*read_cycles)(void *context);
+  const char *cycle_unit; // printed in the header, e.g. "cpu_cycles"
+  /*
+  total bytes and command bytes put on the SPI bus so far. May be NULL if the
+  platform cannot count them, the columns are left empty then.
+  */
+  bool (*read_bus_counters)(void *context, uint64_t *bytes,
+                            uint64_t *commands);
+  void *context;
+
+  const ZLCD_bench_font *fonts;
+  size_t num_fonts;
+  const ZLCD_bench_image *images;
+  size_t num_images;
+  uint32_t iterations; // per workload, 1 to ZLCD_BENCH_MAX_ITERATIONS
+} ZLCD_bench_config;
+
+typedef struct {
+  uint64_t min;
+  uint64_t median;
+  uint64_t p99; // nearest rank
+} ZLCD_bench_summary;
+
+/*
+Sorts samples in place and fills in summary. Does not touch the LCD, so it
+can be checked off-target.
+*/
+void ZLCD_bench_summarize(uint64_t *samples, size_t num_samples,
+                          ZLCD_bench_summary *summary);
+
+/*
+Runs the whole matrix with printf() output. The LCD must be initialized, its
+orientation is restored and the screen cleared at the end.
+*/
+ZLCD_RETURN_STATUS ZLCD_bench_run(const ZLCD_bench_config *config);
+
+#endif // ZYNQ_LCD_BENCH_H
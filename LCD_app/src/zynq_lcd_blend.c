@@ -0,0 +1,83 @@
+#include "zynq_lcd_blend.h"
+#include "zynq_lcd_place.h"
+#include <string.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*************************************************
+  layer blend kernels for the ST7789VW driver
+**************************************************/
+
+static inline ZLCD_HOT_CODE uint16_t ZLCD_blend_pixel(uint16_t s, uint16_t d,
+                                                      uint16_t a) {
+  uint16_t r = ((s >> 11) * a + (d >> 11) * (32U - a)) >> 5;
+  uint16_t g = (((s >> 5) & 0x3FU) * a + ((d >> 5) & 0x3FU) * (32U - a)) >> 5;
+  uint16_t b = ((s & 0x1FU) * a + (d & 0x1FU) * (32U - a)) >> 5;
+  return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+ZLCD_HOT_CODE void ZLCD_blend_span_scalar(uint16_t *dst, const uint16_t *src,
+                                          size_t count, uint8_t alpha,
+                                          bool keyed, uint16_t key) {
+  if (alpha == UINT8_MAX && !keyed) {
+    memcpy(dst, src, count * sizeof(*dst));
+    return;
+  }
+  uint16_t a = (alpha + 4U) >> 3;
+  for (size_t i = 0; i < count; i++) {
+    if (keyed && src[i] == key) {
+      continue;
+    }
+    dst[i] = a == 32U ? src[i] : ZLCD_blend_pixel(src[i], dst[i], a);
+  }
+}
+
+#if defined(__ARM_NEON)
+ZLCD_HOT_CODE void ZLCD_blend_span(uint16_t *dst, const uint16_t *src,
+                                   size_t count, uint8_t alpha, bool keyed,
+                                   uint16_t key) {
+  if (alpha == UINT8_MAX && !keyed) {
+    memcpy(dst, src, count * sizeof(*dst));
+    return;
+  }
+  uint16_t a = (alpha + 4U) >> 3;
+  uint16x8_t weight = vdupq_n_u16(a);
+  uint16x8_t inverse = vdupq_n_u16(32U - a);
+  uint16x8_t six_bits = vdupq_n_u16(0x3FU);
+  uint16x8_t five_bits = vdupq_n_u16(0x1FU);
+  // every pixel is the key when not keyed, or none is
+  uint16x8_t keys = vdupq_n_u16(key);
+  uint16x8_t no_key = vdupq_n_u16(keyed ? 0 : 0xFFFFU);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    uint16x8_t s = vld1q_u16(src + i);
+    uint16x8_t d = vld1q_u16(dst + i);
+    // the channels are at most 63, times 32 still fits a lane
+    uint16x8_t r = vshrq_n_u16(
+        vmlaq_u16(vmulq_u16(vshrq_n_u16(s, 11), weight), vshrq_n_u16(d, 11),
+                  inverse),
+        5);
+    uint16x8_t g = vshrq_n_u16(
+        vmlaq_u16(vmulq_u16(vandq_u16(vshrq_n_u16(s, 5), six_bits), weight),
+                  vandq_u16(vshrq_n_u16(d, 5), six_bits), inverse),
+        5);
+    uint16x8_t b = vshrq_n_u16(vmlaq_u16(vmulq_u16(vandq_u16(s, five_bits),
+                                                   weight),
+                                         vandq_u16(d, five_bits), inverse),
+                               5);
+    uint16x8_t blended = vorrq_u16(
+        vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b);
+    // keyed pixels keep the destination
+    uint16x8_t keep = vbicq_u16(vceqq_u16(s, keys), no_key);
+    vst1q_u16(dst + i, vbslq_u16(keep, d, blended));
+  }
+  ZLCD_blend_span_scalar(dst + i, src + i, count - i, alpha, keyed, key);
+}
+#else
+ZLCD_HOT_CODE void ZLCD_blend_span(uint16_t *dst, const uint16_t *src,
+                                   size_t count, uint8_t alpha, bool keyed,
+                                   uint16_t key) {
+  ZLCD_blend_span_scalar(dst, src, count, alpha, keyed, key);
+}
+#endif
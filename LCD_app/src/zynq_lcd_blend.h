@@ -0,0 +1,24 @@
+#ifndef ZYNQ_LCD_BLEND_H
+#define ZYNQ_LCD_BLEND_H
+/****************************************************************************
+Blend kernels for the layer compositor. They put a span of RGB565 source pixels
+over a span of destination pixels, both as rgb565 values in memory order. With
+a key, source pixels equal to it are left out. alpha is the source weight, 255
+copies the source, anything less is blended in 32 steps per channel:
+c = (s * a + d * (32 - a)) >> 5 with a = (alpha + 4) >> 3.
+*****************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+count pixels, 8 at a time with NEON when built with it (-mfpu=neon-vfpv3),
+otherwise the scalar version. Both give the same pixels
+*/
+void ZLCD_blend_span(uint16_t *dst, const uint16_t *src, size_t count,
+                     uint8_t alpha, bool keyed, uint16_t key);
+void ZLCD_blend_span_scalar(uint16_t *dst, const uint16_t *src, size_t count,
+                            uint8_t alpha, bool keyed, uint16_t key);
+
+#endif // ZYNQ_LCD_BLEND_H
@@ -0,0 +1,525 @@
+#include "zynq_lcd_dma.h"
+#include "zynq_lcd_fifo.h"
+#include "zynq_lcd_place.h"
+#include "zynq_lcd_stats.h"
+#include <string.h>
+#include <xinterrupt_wrap.h>
+#include <xspips_hw.h>
+#include <xstatus.h>
+
+/*************************************************
+  PL330 DMA transmit path for the ST7789VW driver
+**************************************************/
+
+// PL330 instruction encodings (the XDmaPs_Instr_* helpers are static)
+#define ZLCD_DMA_END 0x00U
+#define ZLCD_DMA_KILL 0x01U
+#define ZLCD_DMA_LD 0x04U
+#define ZLCD_DMA_ST 0x08U
+#define ZLCD_DMA_WMB 0x13U
+#define ZLCD_DMA_LP 0x20U    // | loop counter << 1, iterations - 1
+#define ZLCD_DMA_SEV 0x34U   // event << 3
+#define ZLCD_DMA_WFE 0x36U   // event << 3
+#define ZLCD_DMA_LPEND 0x38U // | loop counter << 2, bytes back to the body
+#define ZLCD_DMA_ADDH 0x54U  // to SAR, 16 bit immediate
+#define ZLCD_DMA_MOV 0xBCU   // register, 32 bit immediate
+#define ZLCD_DMA_SAR 0U
+#define ZLCD_DMA_CCR 1U
+#define ZLCD_DMA_DAR 2U
+// bursts of up to 16 single bytes, the TX FIFO takes one byte per write
+#define ZLCD_DMA_BURST_BYTES 16U
+// one word, fixed addresses on both sides: the rearm channel's copy
+#define ZLCD_DMA_CCR_WORD ((2U << 1) | (2U << 15))
+
+size_t ZLCD_dma_chunk_count(size_t num_bytes) {
+  return (num_bytes + ZLCD_DMA_CHUNK_BYTES - 1) / ZLCD_DMA_CHUNK_BYTES;
+}
+
+typedef struct {
+  uint8_t *bytes;
+  size_t length;
+  size_t capacity;
+  bool overflow;
+} ZLCD_dma_program;
+
+static void ZLCD_dma_emit(ZLCD_dma_program *program, uint8_t byte) {
+  if (program->length >= program->capacity) {
+    program->overflow = true;
+    return;
+  }
+  program->bytes[program->length++] = byte;
+}
+
+static void ZLCD_dma_emit_mov(ZLCD_dma_program *program, uint8_t reg,
+                              uint32_t value) {
+  ZLCD_dma_emit(program, ZLCD_DMA_MOV);
+  ZLCD_dma_emit(program, reg);
+  for (unsigned i = 0; i < 4; i++) {
+    ZLCD_dma_emit(program, (uint8_t)(value >> (8 * i)));
+  }
+}
+
+/*
+channel control: incrementing single byte reads, fixed single byte writes,
+burst_bytes beats each, no cache or protection bits (as XDmaPs_Start() builds it
+from a zeroed XDmaPs_ChanCtrl)
+*/
+static uint32_t ZLCD_dma_ccr(size_t burst_bytes) {
+  uint32_t beats = (uint32_t)burst_bytes - 1U;
+  return 0x1U | (beats << 4) | (beats << 18);
+}
+
+// the loop body starts after the DMALP, returns where it does
+static size_t ZLCD_dma_emit_loop(ZLCD_dma_program *program, unsigned counter,
+                                 size_t iterations) {
+  ZLCD_dma_emit(program, (uint8_t)(ZLCD_DMA_LP | (counter << 1)));
+  ZLCD_dma_emit(program, (uint8_t)(iterations - 1U));
+  return program->length;
+}
+
+static void ZLCD_dma_emit_loop_end(ZLCD_dma_program *program, unsigned counter,
+                                   size_t body) {
+  size_t back = program->length - body;
+  if (back > 0xFFU) {
+    program->overflow = true;
+  }
+  ZLCD_dma_emit(program, (uint8_t)(ZLCD_DMA_LPEND | (counter << 2)));
+  ZLCD_dma_emit(program, (uint8_t)back);
+}
+
+/*
+one chunk of up to ZLCD_DMA_CHUNK_BYTES: wait for room in the FIFO, copy, and
+raise event once the writes have reached the FIFO
+*/
+static void ZLCD_dma_emit_chunk(ZLCD_dma_program *program, size_t num_bytes,
+                                unsigned event) {
+  ZLCD_dma_emit(program, ZLCD_DMA_WFE);
+  ZLCD_dma_emit(program, (uint8_t)(ZLCD_DMA_PACE_EVENT << 3));
+  for (size_t i = 0; i < num_bytes / ZLCD_DMA_BURST_BYTES; i++) {
+    ZLCD_dma_emit(program, ZLCD_DMA_LD);
+    ZLCD_dma_emit(program, ZLCD_DMA_ST);
+  }
+  size_t rest = num_bytes % ZLCD_DMA_BURST_BYTES;
+  if (rest != 0) {
+    ZLCD_dma_emit_mov(program, ZLCD_DMA_CCR, ZLCD_dma_ccr(rest));
+    ZLCD_dma_emit(program, ZLCD_DMA_LD);
+    ZLCD_dma_emit(program, ZLCD_DMA_ST);
+    ZLCD_dma_emit_mov(program, ZLCD_DMA_CCR,
+                      ZLCD_dma_ccr(ZLCD_DMA_BURST_BYTES));
+  }
+  ZLCD_dma_emit(program, ZLCD_DMA_WMB);
+  ZLCD_dma_emit(program, ZLCD_DMA_SEV);
+  ZLCD_dma_emit(program, (uint8_t)(event << 3));
+}
+
+// count whole chunks, loop counter 1 is only free outside the row loop
+static void ZLCD_dma_emit_chunks(ZLCD_dma_program *program, size_t count,
+                                 bool outer_free) {
+  size_t blocks = count > 256U ? count / 256U : 0;
+  if (blocks != 0 && !outer_free) {
+    program->overflow = true;
+    return;
+  }
+  if (blocks != 0) {
+    count %= 256U;
+  }
+  while (blocks != 0) {
+    size_t iterations = blocks < 256U ? blocks : 256U;
+    size_t outer = ZLCD_dma_emit_loop(program, 1, iterations);
+    size_t inner = ZLCD_dma_emit_loop(program, 0, 256U);
+    ZLCD_dma_emit_chunk(program, ZLCD_DMA_CHUNK_BYTES, ZLCD_DMA_REARM_EVENT);
+    ZLCD_dma_emit_loop_end(program, 0, inner);
+    ZLCD_dma_emit_loop_end(program, 1, outer);
+    blocks -= iterations;
+  }
+  if (count == 1) {
+    ZLCD_dma_emit_chunk(program, ZLCD_DMA_CHUNK_BYTES, ZLCD_DMA_REARM_EVENT);
+  } else if (count != 0) {
+    size_t body = ZLCD_dma_emit_loop(program, 0, count);
+    ZLCD_dma_emit_chunk(program, ZLCD_DMA_CHUNK_BYTES, ZLCD_DMA_REARM_EVENT);
+    ZLCD_dma_emit_loop_end(program, 0, body);
+  }
+}
+
+/*
+num_bytes from SAR on. The last chunk of the program signals the channel done
+interrupt rather than the rearm, so no pace is asked for after it
+*/
+static void ZLCD_dma_emit_run(ZLCD_dma_program *program, size_t num_bytes,
+                              bool last, bool outer_free) {
+  size_t whole = num_bytes / ZLCD_DMA_CHUNK_BYTES;
+  size_t rest = num_bytes % ZLCD_DMA_CHUNK_BYTES;
+  if (last && rest == 0) {
+    whole--;
+    rest = ZLCD_DMA_CHUNK_BYTES;
+  }
+  ZLCD_dma_emit_chunks(program, whole, outer_free);
+  if (rest != 0) {
+    ZLCD_dma_emit_chunk(program, rest,
+                        last ? ZLCD_DMA_CHANNEL : ZLCD_DMA_REARM_EVENT);
+  }
+}
+
+size_t ZLCD_dma_build_program(uint8_t *program, size_t capacity,
+                              UINTPTR source_address, size_t row_bytes,
+                              size_t rows, size_t stride,
+                              UINTPTR tx_fifo_address) {
+  if (program == NULL || row_bytes == 0 || rows == 0 ||
+      (rows > 1 && stride < row_bytes)) {
+    return 0;
+  }
+  if (rows > 1 && stride == row_bytes) {
+    row_bytes *= rows; // back to back, one run
+    rows = 1;
+  }
+  uint64_t last_byte =
+      (uint64_t)source_address + (uint64_t)(rows - 1) * stride + row_bytes - 1;
+  if (last_byte > UINT32_MAX || (uint64_t)tx_fifo_address > UINT32_MAX ||
+      (rows > 1 && (stride - row_bytes > 0xFFFFU ||
+                    row_bytes / ZLCD_DMA_CHUNK_BYTES > 256U))) {
+    return 0;
+  }
+
+  ZLCD_dma_program out = {.bytes = program, .capacity = capacity};
+  ZLCD_dma_emit_mov(&out, ZLCD_DMA_CCR, ZLCD_dma_ccr(ZLCD_DMA_BURST_BYTES));
+  ZLCD_dma_emit_mov(&out, ZLCD_DMA_SAR, (uint32_t)source_address);
+  ZLCD_dma_emit_mov(&out, ZLCD_DMA_DAR, (uint32_t)tx_fifo_address);
+  // every row but the last, SAR skips the gap to the next one
+  for (size_t left = rows - 1; left != 0;) {
+    size_t iterations = left < 256U ? left : 256U;
+    size_t body = ZLCD_dma_emit_loop(&out, 1, iterations);
+    ZLCD_dma_emit_run(&out, row_bytes, false, false);
+    uint16_t gap = (uint16_t)(stride - row_bytes);
+    ZLCD_dma_emit(&out, ZLCD_DMA_ADDH);
+    ZLCD_dma_emit(&out, (uint8_t)(gap & 0xFF));
+    ZLCD_dma_emit(&out, (uint8_t)(gap >> 8));
+    ZLCD_dma_emit_loop_end(&out, 1, body);
+    left -= iterations;
+  }
+  ZLCD_dma_emit_run(&out, row_bytes, true, rows == 1);
+  ZLCD_dma_emit(&out, ZLCD_DMA_END);
+  return out.overflow ? 0 : out.length;
+}
+
+size_t ZLCD_dma_build_rearm_program(uint8_t *program, size_t capacity,
+                                    size_t rearms, UINTPTR mask_address,
+                                    UINTPTR enable_address) {
+  if (program == NULL || rearms == 0 || rearms > 65536U ||
+      (uint64_t)mask_address > UINT32_MAX ||
+      (uint64_t)enable_address > UINT32_MAX) {
+    return 0;
+  }
+  ZLCD_dma_program out = {.bytes = program, .capacity = capacity};
+  ZLCD_dma_emit_mov(&out, ZLCD_DMA_CCR, ZLCD_DMA_CCR_WORD);
+  ZLCD_dma_emit_mov(&out, ZLCD_DMA_SAR, (uint32_t)mask_address);
+  ZLCD_dma_emit_mov(&out, ZLCD_DMA_DAR, (uint32_t)enable_address);
+  // blocks of 256 rearms, then the rest
+  size_t blocks = rearms / 256U;
+  size_t rest = rearms % 256U;
+  for (size_t pass = 0; pass < 2; pass++) {
+    size_t count = pass == 0 ? blocks : rest;
+    if (count == 0) {
+      continue;
+    }
+    size_t outer = pass == 0 ? ZLCD_dma_emit_loop(&out, 1, count) : 0;
+    size_t body = ZLCD_dma_emit_loop(&out, 0, pass == 0 ? 256U : count);
+    ZLCD_dma_emit(&out, ZLCD_DMA_WFE);
+    ZLCD_dma_emit(&out, (uint8_t)(ZLCD_DMA_REARM_EVENT << 3));
+    ZLCD_dma_emit(&out, ZLCD_DMA_LD);
+    ZLCD_dma_emit(&out, ZLCD_DMA_ST);
+    ZLCD_dma_emit_loop_end(&out, 0, body);
+    if (pass == 0) {
+      ZLCD_dma_emit_loop_end(&out, 1, outer);
+    }
+  }
+  ZLCD_dma_emit(&out, ZLCD_DMA_SEV);
+  ZLCD_dma_emit(&out, (uint8_t)(ZLCD_DMA_REARM_CHANNEL << 3));
+  ZLCD_dma_emit(&out, ZLCD_DMA_END);
+  return out.overflow ? 0 : out.length;
+}
+
+// an instruction through the debug interface, as XDmaPs_Start() issues DMAGO
+static void ZLCD_dma_debug(UINTPTR dma_base, u32 instruction) {
+  while (XDmaPs_ReadReg(dma_base, XDMAPS_DBGSTATUS_OFFSET) &
+         XDMAPS_DBGSTATUS_BUSY) {
+  }
+  XDmaPs_WriteReg(dma_base, XDMAPS_DBGINST0_OFFSET, instruction);
+  XDmaPs_WriteReg(dma_base, XDMAPS_DBGINST1_OFFSET, 0);
+  XDmaPs_WriteReg(dma_base, XDMAPS_DBGCMD_OFFSET, 0);
+}
+
+/*
+The interrupts. They all run on CPU0 at the same priority, so they never
+preempt each other and the state only changes in one of them at a time.
+*/
+static XTime ZLCD_dma_interrupt_entry(void) {
+  XTime entry = 0;
+  ZLCD_STATS(XTime_GetTime(&entry));
+  return entry;
+}
+
+static void ZLCD_dma_interrupt_exit(ZLCD_dma_transfer *transfer,
+                                    XTime entry) {
+#if ZLCD_STATS_ENABLED
+  XTime now;
+  XTime_GetTime(&now);
+  transfer->interrupts++;
+  transfer->interrupt_ticks += now - entry;
+#else
+  (void)transfer;
+  (void)entry;
+#endif
+}
+
+/*
+the TX FIFO is empty, but the last byte is still being shifted out. That takes
+shift_ticks at most, ZLCD_dma_settle() waits out what is left of them
+*/
+static void ZLCD_dma_finish(ZLCD_dma_transfer *transfer) {
+  XTime now;
+  XTime_GetTime(&now);
+  transfer->settle_time = now + transfer->shift_ticks;
+
+  ZLCD_dma_done_callback callback = transfer->callback;
+  // idle first, the callback may start the next transfer
+  transfer->state = ZLCD_DMA_IDLE;
+  if (callback != NULL) {
+    callback(transfer->callback_context, transfer->status);
+  }
+}
+
+static void ZLCD_dma_spi_interrupt(void *instance) {
+  ZLCD_dma_transfer *transfer = instance;
+  XTime entry = ZLCD_dma_interrupt_entry();
+  if (transfer->state == ZLCD_DMA_IDLE) {
+    XSpiPs_InterruptHandler(transfer->spi);
+  } else {
+    // below the watermark, this fires again once the rearm channel enables it
+    XSpiPs_WriteReg(transfer->spi->Config.BaseAddress, XSPIPS_IDR_OFFSET,
+                    XSPIPS_IXR_TXOW_MASK);
+    if (transfer->state == ZLCD_DMA_SENDING) {
+      ZLCD_dma_debug(transfer->dma->Config.BaseAddress,
+                     XDmaPs_DBGINST0(ZLCD_DMA_PACE_EVENT << 3, ZLCD_DMA_SEV,
+                                     0, 0));
+    } else {
+      ZLCD_dma_finish(transfer);
+    }
+  }
+  ZLCD_dma_interrupt_exit(transfer, entry);
+}
+
+// from XDmaPs_DoneISR_0(): the last chunk is in, wait for the FIFO to empty
+static void ZLCD_dma_done_handler(unsigned int channel, XDmaPs_Cmd *command,
+                                  void *callback_ref) {
+  (void)channel;
+  (void)command;
+  ZLCD_dma_transfer *transfer = callback_ref;
+  XTime entry = ZLCD_dma_interrupt_entry();
+  transfer->state = ZLCD_DMA_DRAINING;
+  XSpiPs_SetTXWatermark(transfer->spi, 1);
+  XSpiPs_WriteReg(transfer->spi->Config.BaseAddress, XSPIPS_IER_OFFSET,
+                  XSPIPS_IXR_TXOW_MASK);
+  ZLCD_dma_interrupt_exit(transfer, entry);
+}
+
+// from XDmaPs_DoneISR_1(): the rearm program is done, its channel is free
+static void ZLCD_dma_rearm_done_handler(unsigned int channel,
+                                        XDmaPs_Cmd *command,
+                                        void *callback_ref) {
+  (void)channel;
+  (void)command;
+  ZLCD_dma_transfer *transfer = callback_ref;
+  ZLCD_dma_interrupt_exit(transfer, ZLCD_dma_interrupt_entry());
+}
+
+int ZLCD_dma_init(ZLCD_dma_transfer *transfer, XDmaPs *dma, XSpiPs *spi,
+                  UINTPTR dma_base_address) {
+  XDmaPs_Config *config = XDmaPs_LookupConfig(dma_base_address);
+  if (transfer == NULL || config == NULL) {
+    return XST_FAILURE;
+  }
+  if (XDmaPs_CfgInitialize(dma, config, config->BaseAddress) != XST_SUCCESS) {
+    return XST_FAILURE;
+  }
+  memset(transfer, 0, sizeof(*transfer));
+  transfer->dma = dma;
+  transfer->spi = spi;
+  transfer->state = ZLCD_DMA_IDLE;
+  transfer->status = XST_SUCCESS;
+  // 8 bits of the SPI clock, the input clock divided by 2 << prescaler code
+  uint64_t divider = 2ULL << XSpiPs_GetClkPrescaler(spi);
+  transfer->shift_ticks =
+      (XTime)((8U * divider * COUNTS_PER_SECOND + spi->Config.InputClockHz -
+               1U) /
+              spi->Config.InputClockHz) +
+      1U;
+  // the PL330 reads the mask from DDR
+  transfer->rearm_mask = XSPIPS_IXR_TXOW_MASK;
+  ZLCD_dcache_store_range(&transfer->rearm_mask, sizeof(transfer->rearm_mask));
+
+  XDmaPs_SetDoneHandler(dma, ZLCD_DMA_CHANNEL, ZLCD_dma_done_handler,
+                        transfer);
+  XDmaPs_SetDoneHandler(dma, ZLCD_DMA_REARM_CHANNEL,
+                        ZLCD_dma_rearm_done_handler, transfer);
+  // the pace and rearm events only wake a DMAWFE, they are no interrupts
+  u32 interrupts = XDmaPs_ReadReg(dma->Config.BaseAddress, XDMAPS_INTEN_OFFSET);
+  interrupts &= ~((1U << ZLCD_DMA_PACE_EVENT) | (1U << ZLCD_DMA_REARM_EVENT));
+  XDmaPs_WriteReg(dma->Config.BaseAddress, XDMAPS_INTEN_OFFSET, interrupts);
+
+  // IntrId[0] is the abort interrupt, channel (event) n's follows at n + 1
+  if (XSetupInterruptSystem(dma, (void *)XDmaPs_DoneISR_0,
+                            config->IntrId[ZLCD_DMA_CHANNEL + 1],
+                            config->IntrParent,
+                            XINTERRUPT_DEFAULT_PRIORITY) != XST_SUCCESS ||
+      XSetupInterruptSystem(dma, (void *)XDmaPs_DoneISR_1,
+                            config->IntrId[ZLCD_DMA_REARM_CHANNEL + 1],
+                            config->IntrParent,
+                            XINTERRUPT_DEFAULT_PRIORITY) != XST_SUCCESS ||
+      XSetupInterruptSystem(transfer, (void *)ZLCD_dma_spi_interrupt,
+                            spi->Config.IntrId, spi->Config.IntrParent,
+                            XINTERRUPT_DEFAULT_PRIORITY) != XST_SUCCESS) {
+    return XST_FAILURE;
+  }
+  return XST_SUCCESS;
+}
+
+int ZLCD_dma_start(ZLCD_dma_transfer *transfer, const uint8_t *first_row,
+                   size_t row_bytes, size_t rows, size_t stride,
+                   ZLCD_dma_done_callback callback, void *callback_context) {
+  if (transfer == NULL || first_row == NULL) {
+    return XST_FAILURE;
+  }
+  if (transfer->state != ZLCD_DMA_IDLE) {
+    return XST_DEVICE_BUSY;
+  }
+  UINTPTR spi_base = transfer->spi->Config.BaseAddress;
+  size_t length = ZLCD_dma_build_program(
+      transfer->program, sizeof(transfer->program), (UINTPTR)first_row,
+      row_bytes, rows, stride, spi_base + XSPIPS_TXD_OFFSET);
+  if (length == 0) {
+    return XST_FAILURE;
+  }
+  // every chunk but the last is followed by a rearm
+  size_t chunks = rows == 1 || stride == row_bytes
+                      ? ZLCD_dma_chunk_count(row_bytes * rows)
+                      : ZLCD_dma_chunk_count(row_bytes) * rows;
+  size_t rearm_length = 0;
+  if (chunks > 1) {
+    rearm_length = ZLCD_dma_build_rearm_program(
+        transfer->rearm_program, sizeof(transfer->rearm_program), chunks - 1,
+        (UINTPTR)&transfer->rearm_mask, spi_base + XSPIPS_IER_OFFSET);
+    if (rearm_length == 0) {
+      return XST_FAILURE;
+    }
+  }
+  /*
+  the PL330 reads DDR directly, so the programs and the rows are written back
+  first, and only that: the rows may be locked into the L2. XDmaPs_Start()
+  leaves the caches alone for a program of our own (no SrcInc in the command)
+  */
+  size_t span = (rows - 1) * stride + row_bytes;
+  ZLCD_dcache_store_range(transfer->program, length);
+  if (rearm_length != 0) {
+    ZLCD_dcache_store_range(transfer->rearm_program, rearm_length);
+  }
+  ZLCD_dcache_store_range(first_row, span);
+
+  memset(&transfer->command, 0, sizeof(transfer->command));
+  transfer->command.UserDmaProg = transfer->program;
+  transfer->command.UserDmaProgLength = (int)length;
+  memset(&transfer->rearm_command, 0, sizeof(transfer->rearm_command));
+  transfer->rearm_command.UserDmaProg = transfer->rearm_program;
+  transfer->rearm_command.UserDmaProgLength = (int)rearm_length;
+  transfer->callback = callback;
+  transfer->callback_context = callback_context;
+  transfer->status = XST_SUCCESS;
+  transfer->state = ZLCD_DMA_SENDING;
+  // "TX FIFO not full" now means there is room for at least one whole chunk
+  XSpiPs_SetTXWatermark(transfer->spi, ZLCD_DMA_PACE_WATERMARK);
+  // the rearm channel first, it has to wait before the first chunk is done
+  int status = XST_SUCCESS;
+  if (rearm_length != 0) {
+    status = XDmaPs_Start(transfer->dma, ZLCD_DMA_REARM_CHANNEL,
+                          &transfer->rearm_command, 0);
+  }
+  if (status == XST_SUCCESS) {
+    status =
+        XDmaPs_Start(transfer->dma, ZLCD_DMA_CHANNEL, &transfer->command, 0);
+    if (status != XST_SUCCESS && rearm_length != 0) {
+      // still in its first DMAWFE, nothing was stored yet
+      ZLCD_dma_debug(transfer->dma->Config.BaseAddress,
+                     XDmaPs_DBGINST0(0, ZLCD_DMA_KILL,
+                                     ZLCD_DMA_REARM_CHANNEL, 1));
+      transfer->dma->Chans[ZLCD_DMA_REARM_CHANNEL].DmaCmdToHw = NULL;
+    }
+  }
+  if (status != XST_SUCCESS) {
+    XSpiPs_SetTXWatermark(transfer->spi, 1);
+    transfer->status = status;
+    transfer->state = ZLCD_DMA_IDLE;
+    return status;
+  }
+  /*
+  the FIFO is empty, so the watermark interrupt paces the first chunk right
+  away. Events are latched, it does not matter if the program gets to its
+  DMAWFE later
+  */
+  XSpiPs_WriteReg(spi_base, XSPIPS_IER_OFFSET, XSPIPS_IXR_TXOW_MASK);
+  return XST_SUCCESS;
+}
+
+bool ZLCD_dma_busy(const ZLCD_dma_transfer *transfer) {
+  return transfer->state != ZLCD_DMA_IDLE;
+}
+
+void ZLCD_dma_settle(ZLCD_dma_transfer *transfer) {
+  XTime settle_time = transfer->settle_time;
+  if (settle_time == 0) {
+    return;
+  }
+  XTime now;
+  do {
+    XTime_GetTime(&now);
+  } while (now < settle_time);
+  // nothing is read back from the LCD, throw away whatever was shifted in
+  UINTPTR spi_base = transfer->spi->Config.BaseAddress;
+  while (XSpiPs_ReadReg(spi_base, XSPIPS_SR_OFFSET) &
+         XSPIPS_IXR_RXNEMPTY_MASK) {
+    (void)XSpiPs_ReadReg(spi_base, XSPIPS_RXD_OFFSET);
+  }
+  XSpiPs_WriteReg(spi_base, XSPIPS_SR_OFFSET, XSPIPS_IXR_RXOVR_MASK);
+  transfer->settle_time = 0;
+}
+
+int ZLCD_dma_write_rows(ZLCD_dma_transfer *transfer, const uint8_t *first_row,
+                        size_t row_bytes, size_t rows, size_t stride) {
+  int status = ZLCD_dma_start(transfer, first_row, row_bytes, rows, stride,
+                              NULL, NULL);
+  if (status != XST_SUCCESS) {
+    return status;
+  }
+  // the interrupts do the work, this only waits for the last one
+  while (transfer->state != ZLCD_DMA_IDLE) {
+  }
+  ZLCD_dma_settle(transfer);
+  return transfer->status;
+}
+
+int ZLCD_dma_write(ZLCD_dma_transfer *transfer, const uint8_t *byte_stream,
+                   size_t num_bytes) {
+  return ZLCD_dma_write_rows(transfer, byte_stream, num_bytes, 1, num_bytes);
+}
+
+int ZLCD_dma_send(ZLCD_dma_transfer *transfer, const uint8_t *byte_stream,
+                  size_t num_bytes) {
+  if (transfer == NULL || byte_stream == NULL || num_bytes == 0) {
+    return XST_FAILURE;
+  }
+  if (transfer->spi->IsBusy) {
+    return XST_DEVICE_BUSY;
+  }
+  ZLCD_fifo_begin(transfer->spi);
+  int status = ZLCD_dma_write(transfer, byte_stream, num_bytes);
+  ZLCD_fifo_end(transfer->spi);
+  return status;
+}
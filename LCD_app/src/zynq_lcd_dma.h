@@ -0,0 +1,158 @@
+#ifndef ZYNQ_LCD_DMA_H
+#define ZYNQ_LCD_DMA_H
+/****************************************************************************
+PL330 (XDmaPs) transmit backend for the ZLCD driver. The DMA engine copies
+pixel bytes from the GRAM straight into the SPI0 TX FIFO so the CPU no longer
+has to write every byte of a refresh by hand.
+*****************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <xdmaps.h>
+#include <xil_types.h>
+#include <xiltimer.h>
+#include <xspips.h>
+
+/*
+The PS SPI controller has no DMA request lines, so the PL330 cannot be paced by
+the peripheral and a chunk can never be more than the 128 byte TX FIFO holds.
+A transfer is one channel program that copies it in chunks of
+ZLCD_DMA_CHUNK_BYTES. Before every chunk the program waits for
+ZLCD_DMA_PACE_EVENT, which the SPI0 interrupt signals once the FIFO is below
+ZLCD_DMA_PACE_WATERMARK, and after it the program raises ZLCD_DMA_REARM_EVENT.
+A second channel (ZLCD_DMA_REARM_CHANNEL) waits for that event and stores the
+watermark bit into the SPI0 interrupt enable register, so the interrupt comes
+back without the CPU. The last chunk raises the channel's done event instead.
+The CPU takes one short interrupt per chunk, one when the program is done and
+one when the FIFO has run empty.
+
+ZLCD_DMA_PACE_EVENT and ZLCD_DMA_REARM_EVENT are the events (and interrupts)
+of PL330 channels 2 and 3, which can't be used while the driver uses DMA.
+*/
+#define ZLCD_DMA_CHANNEL 0U
+#define ZLCD_DMA_REARM_CHANNEL 1U
+#define ZLCD_DMA_PACE_EVENT 2U  // an event: the TX FIFO has room for a chunk
+#define ZLCD_DMA_REARM_EVENT 3U // an event: a chunk is in the TX FIFO
+/*
+bytes left in the FIFO when the pace interrupt fires, they keep the bus busy
+while the interrupt and the PL330 get the next chunk in
+*/
+#define ZLCD_DMA_PACE_WATERMARK 16U
+#define ZLCD_DMA_CHUNK_BYTES (XSPIPS_FIFO_DEPTH - ZLCD_DMA_PACE_WATERMARK)
+// smaller transfers (commands, window addresses) are cheaper for the CPU to
+// write into the FIFO itself (zynq_lcd_fifo.h)
+#define ZLCD_DMA_MIN_TRANSFER_BYTES 64U
+// room for the program of a window of ZLCD_HEIGHT separate rows
+#define ZLCD_DMA_PROGRAM_BYTES 256U
+
+// number of chunks (and paced waits) the program of num_bytes is split into
+size_t ZLCD_dma_chunk_count(size_t num_bytes);
+
+/*
+Writes the channel program sending rows rows of row_bytes each, the first at
+source_address and every next one stride bytes further on, to the byte wide
+register at tx_fifo_address. Rows that follow each other without a gap are one
+run of chunks. Memory side increments, FIFO side is a fixed single byte wide
+register. Does not touch any hardware so it can be checked off-target. Returns
+the program length, or 0 if it does not fit into capacity bytes or the PL330
+can't address the rows (32 bit addresses, row gaps below 64 KB).
+*/
+size_t ZLCD_dma_build_program(uint8_t *program, size_t capacity,
+                              UINTPTR source_address, size_t row_bytes,
+                              size_t rows, size_t stride,
+                              UINTPTR tx_fifo_address);
+
+/*
+Writes the ZLCD_DMA_REARM_CHANNEL program for a transfer that raises
+ZLCD_DMA_REARM_EVENT rearms times: after each it copies the word at
+mask_address to the register at enable_address. Returns the program length,
+or 0 if it does not fit or rearms is above 65536.
+*/
+size_t ZLCD_dma_build_rearm_program(uint8_t *program, size_t capacity,
+                                    size_t rearms, UINTPTR mask_address,
+                                    UINTPTR enable_address);
+
+/*
+called in interrupt context once the TX FIFO has run empty. The last byte may
+still be in the shift register, ZLCD_dma_settle() waits for it
+*/
+typedef void (*ZLCD_dma_done_callback)(void *context, int status);
+
+typedef enum {
+  ZLCD_DMA_IDLE,
+  ZLCD_DMA_SENDING, // the program runs, the SPI0 interrupt paces it
+  ZLCD_DMA_DRAINING // the program is done, the SPI0 FIFO is emptying
+} ZLCD_DMA_STATE;
+
+typedef struct {
+  XDmaPs *dma;
+  XSpiPs *spi;
+  XDmaPs_Cmd command; // in use by XDmaPs until the done interrupt
+  XDmaPs_Cmd rearm_command;
+  uint8_t program[ZLCD_DMA_PROGRAM_BYTES] __attribute__((aligned(32)));
+  uint8_t rearm_program[64] __attribute__((aligned(32)));
+  // what the rearm channel stores into the SPI0 interrupt enable register
+  uint32_t rearm_mask __attribute__((aligned(32)));
+  XTime shift_ticks; // one byte on the SPI bus, rounded up
+  // the last byte is out from here on, 0 once ZLCD_dma_settle() has run
+  volatile XTime settle_time;
+  volatile ZLCD_DMA_STATE state;
+  volatile int status; // of the transfer in flight or the last one
+  ZLCD_dma_done_callback callback;
+  void *callback_context;
+  // interrupts taken so far and the time spent in them (ZLCD_STATS_ENABLED)
+  volatile uint32_t interrupts;
+  volatile XTime interrupt_ticks;
+} ZLCD_dma_transfer;
+
+/*
+Sets up the DMA controller for transfer and connects the done interrupts of
+both channels and the SPI0 interrupt (XSetupInterruptSystem()). The SPI0
+interrupt runs XSpiPs_InterruptHandler() while no DMA transfer is in flight,
+so interrupt mode XSpiPs transfers keep working.
+*/
+int ZLCD_dma_init(ZLCD_dma_transfer *transfer, XDmaPs *dma, XSpiPs *spi,
+                  UINTPTR dma_base_address);
+
+/*
+Starts sending rows as in ZLCD_dma_build_program() (rows must not change until
+the callback). Chip select and DC have to be set already, the data cache is
+cleaned here. The callback (may be NULL) runs once the TX FIFO is empty; DC and
+chip select can be changed after ZLCD_dma_settle().
+*/
+int ZLCD_dma_start(ZLCD_dma_transfer *transfer, const uint8_t *first_row,
+                   size_t row_bytes, size_t rows, size_t stride,
+                   ZLCD_dma_done_callback callback, void *callback_context);
+
+bool ZLCD_dma_busy(const ZLCD_dma_transfer *transfer);
+
+/*
+Waits until the last byte of the finished transfer has been shifted out and
+throws away what came into the RX FIFO meanwhile. Left to the next user of the
+bus so the interrupts never wait for the shift register. Does nothing if it
+has run since the last transfer.
+*/
+void ZLCD_dma_settle(ZLCD_dma_transfer *transfer);
+
+/*
+ZLCD_dma_start() of num_bytes for a chip select frame that is already open
+(ZLCD_fifo_begin()), so DC can change around it without releasing it. Waits
+for the done interrupt and ZLCD_dma_settle() and returns the status of the
+transfer.
+*/
+int ZLCD_dma_write(ZLCD_dma_transfer *transfer, const uint8_t *byte_stream,
+                   size_t num_bytes);
+// the same for rows as in ZLCD_dma_build_program()
+int ZLCD_dma_write_rows(ZLCD_dma_transfer *transfer, const uint8_t *first_row,
+                        size_t row_bytes, size_t rows, size_t stride);
+
+/*
+Sends num_bytes from byte_stream over the SPI bus using the DMA engine. Handles
+chip select the same way XSpiPs_PolledTransfer() does. Blocks until the last
+byte has left the bus.
+*/
+int ZLCD_dma_send(ZLCD_dma_transfer *transfer, const uint8_t *byte_stream,
+                  size_t num_bytes);
+
+#endif // ZYNQ_LCD_DMA_H
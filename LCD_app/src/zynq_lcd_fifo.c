@@ -0,0 +1,60 @@
+#include "zynq_lcd_fifo.h"
+#include <xspips_hw.h>
+#include <xstatus.h>
+
+/*************************************************
+  raw TX FIFO transmit path for the ST7789VW driver
+**************************************************/
+
+void ZLCD_fifo_begin(XSpiPs *spi) {
+  UINTPTR spi_base = spi->Config.BaseAddress;
+  spi->IsBusy = TRUE;
+  XSpiPs_Enable(spi);
+  u32 config_reg = XSpiPs_ReadReg(spi_base, XSPIPS_CR_OFFSET);
+  config_reg &= ~XSPIPS_CR_SSCTRL_MASK;
+  config_reg |= spi->SlaveSelect;
+  XSpiPs_WriteReg(spi_base, XSPIPS_CR_OFFSET, config_reg);
+}
+
+void ZLCD_fifo_write(XSpiPs *spi, const uint8_t *byte_stream,
+                     size_t num_bytes) {
+  UINTPTR spi_base = spi->Config.BaseAddress;
+  size_t sent = 0;
+  size_t received = 0;
+  while (received < num_bytes) {
+    /*
+    a byte is in flight from the TXD write until its RX byte is read, keeping
+    that below the FIFO depth means neither FIFO can overflow
+    */
+    while (sent < num_bytes && sent - received < XSPIPS_FIFO_DEPTH) {
+      XSpiPs_WriteReg(spi_base, XSPIPS_TXD_OFFSET, byte_stream[sent++]);
+    }
+    while (received < sent && (XSpiPs_ReadReg(spi_base, XSPIPS_SR_OFFSET) &
+                               XSPIPS_IXR_RXNEMPTY_MASK)) {
+      (void)XSpiPs_ReadReg(spi_base, XSPIPS_RXD_OFFSET);
+      received++;
+    }
+  }
+}
+
+void ZLCD_fifo_end(XSpiPs *spi) {
+  UINTPTR spi_base = spi->Config.BaseAddress;
+  u32 config_reg = XSpiPs_ReadReg(spi_base, XSPIPS_CR_OFFSET);
+  config_reg |= XSPIPS_CR_SSCTRL_MASK;
+  XSpiPs_WriteReg(spi_base, XSPIPS_CR_OFFSET, config_reg);
+  XSpiPs_Disable(spi);
+  spi->IsBusy = FALSE;
+}
+
+int ZLCD_fifo_send(XSpiPs *spi, const uint8_t *byte_stream, size_t num_bytes) {
+  if (spi == NULL || byte_stream == NULL || num_bytes == 0) {
+    return XST_FAILURE;
+  }
+  if (spi->IsBusy) {
+    return XST_DEVICE_BUSY;
+  }
+  ZLCD_fifo_begin(spi);
+  ZLCD_fifo_write(spi, byte_stream, num_bytes);
+  ZLCD_fifo_end(spi);
+  return XST_SUCCESS;
+}
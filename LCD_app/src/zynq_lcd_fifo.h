@@ -0,0 +1,58 @@
+#ifndef ZYNQ_LCD_FIFO_H
+#define ZYNQ_LCD_FIFO_H
+/****************************************************************************
+Raw SPI0 transmit path for the ZLCD driver. Bytes go straight into the TX FIFO
+register (xspips_hw.h) instead of through XSpiPs_PolledTransfer(), which checks
+its arguments, sets up chip select and the watermark and tracks the transfer in
+the instance for every call. That setup costs more than the 1 to 4 bytes of a
+command or window address, and a refresh made of small windows is mostly those.
+*****************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <xil_types.h>
+#include <xspips.h>
+
+/*
+SPI0 delay register values (XSpiPs_SetDelays(), in SPI reference clock cycles),
+written by ZLCD_spi_init(). 0 gives the shortest gap between bytes and around
+chip select, raise them with -D if the wiring to the LCD needs more margin.
+*/
+#ifndef ZLCD_SPI_DELAY_NSS
+#define ZLCD_SPI_DELAY_NSS 0U // chip select high between words
+#endif
+#ifndef ZLCD_SPI_DELAY_BTWN
+#define ZLCD_SPI_DELAY_BTWN 0U // chip select of one slave to the next
+#endif
+#ifndef ZLCD_SPI_DELAY_AFTER
+#define ZLCD_SPI_DELAY_AFTER 0U // end of one word to the start of the next
+#endif
+#ifndef ZLCD_SPI_DELAY_INIT
+#define ZLCD_SPI_DELAY_INIT 0U // chip select low to the first bit
+#endif
+
+/*
+Enables the controller and asserts chip select (the driver always runs SPI0
+with XSPIPS_FORCE_SSELECT_OPTION). Everything written until ZLCD_fifo_end() is
+one frame, DC may be changed between ZLCD_fifo_write() calls.
+*/
+void ZLCD_fifo_begin(XSpiPs *spi);
+
+/*
+Writes num_bytes into the TX FIFO, never more than the FIFO holds in flight,
+and reads back one RX byte for every byte sent. Returns once the last byte has
+been shifted out, so DC can be toggled right after. The RX FIFO has to be empty
+and the shift register idle when it is called, a byte left over from an earlier
+transfer would be counted as one of these and the write would return early.
+Every write here leaves the bus that way, and so does ZLCD_dma_write().
+*/
+void ZLCD_fifo_write(XSpiPs *spi, const uint8_t *byte_stream,
+                     size_t num_bytes);
+
+// releases chip select and disables the controller
+void ZLCD_fifo_end(XSpiPs *spi);
+
+// one chip select framed transfer, the replacement for XSpiPs_PolledTransfer()
+int ZLCD_fifo_send(XSpiPs *spi, const uint8_t *byte_stream, size_t num_bytes);
+
+#endif // ZYNQ_LCD_FIFO_H
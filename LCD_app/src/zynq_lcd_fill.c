@@ -0,0 +1,88 @@
+#include "zynq_lcd_fill.h"
+#include "zynq_lcd_place.h"
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*************************************************
+  span fill kernels for the ST7789VW driver
+**************************************************/
+
+typedef uint32_t ZLCD_fill_word __attribute__((may_alias));
+
+ZLCD_HOT_CODE void ZLCD_fill_span_scalar(ZLCD_fill_pixel *dst,
+                                         uint16_t pattern, size_t count) {
+  if (count != 0 && ((uintptr_t)dst & 0x2U) != 0) {
+    *dst++ = pattern;
+    count--;
+  }
+  ZLCD_fill_word *words = (ZLCD_fill_word *)dst;
+  uint32_t word = ((uint32_t)pattern << 16) | pattern;
+  size_t num_words = count / 2;
+  // four words per pass, gcc turns these into two strd on the A9
+  size_t i = 0;
+  for (; i + 4 <= num_words; i += 4) {
+    words[i] = word;
+    words[i + 1] = word;
+    words[i + 2] = word;
+    words[i + 3] = word;
+  }
+  for (; i < num_words; i++) {
+    words[i] = word;
+  }
+  if (count & 1U) {
+    dst[count - 1] = pattern;
+  }
+}
+
+#if defined(__ARM_NEON)
+ZLCD_HOT_CODE void ZLCD_fill_span(ZLCD_fill_pixel *dst, uint16_t pattern,
+                                  size_t count) {
+  // peel single pixels until dst is on a 16 byte boundary
+  while (count != 0 && ((uintptr_t)dst & 0xFU) != 0) {
+    *dst++ = pattern;
+    count--;
+  }
+  uint16x8_t value = vdupq_n_u16(pattern);
+  uint16_t *out = (uint16_t *)__builtin_assume_aligned(dst, 16);
+  // 32 bytes per pass, the A9 NEON store path is 64 bits wide
+  for (; count >= 16; count -= 16, out += 16) {
+    vst1q_u16(out, value);
+    vst1q_u16(out + 8, value);
+  }
+  if (count >= 8) {
+    vst1q_u16(out, value);
+    out += 8;
+    count -= 8;
+  }
+  ZLCD_fill_span_scalar((ZLCD_fill_pixel *)out, pattern, count);
+}
+#else
+ZLCD_HOT_CODE void ZLCD_fill_span(ZLCD_fill_pixel *dst, uint16_t pattern,
+                                  size_t count) {
+  ZLCD_fill_span_scalar(dst, pattern, count);
+}
+#endif
+
+ZLCD_HOT_CODE void ZLCD_fill_strided(ZLCD_fill_pixel *dst, uint16_t pattern,
+                                     size_t count, ptrdiff_t stride) {
+  // every pixel is on another cache line, nothing to gain from wider stores
+  for (size_t i = 0; i < count; i++) {
+    *dst = pattern;
+    dst += stride;
+  }
+}
+
+ZLCD_HOT_CODE void ZLCD_fill_rect(ZLCD_fill_pixel *dst, uint16_t pattern,
+                                  size_t width, size_t height,
+                                  ptrdiff_t stride) {
+  if (width == (size_t)stride) {
+    // full width rows are one contiguous run
+    ZLCD_fill_span(dst, pattern, width * height);
+    return;
+  }
+  for (size_t y = 0; y < height; y++) {
+    ZLCD_fill_span(dst, pattern, width);
+    dst += stride;
+  }
+}
@@ -0,0 +1,32 @@
+#ifndef ZYNQ_LCD_FILL_H
+#define ZYNQ_LCD_FILL_H
+/****************************************************************************
+Span fill kernels for the ZLCD frame buffers. They write one 16-bit pattern over
+a run of pixels, contiguous (a portrait row) or strided (a portrait column, which
+is what a row becomes in landscape). The pattern is the value exactly as it is
+stored in memory, so the kernels work for both GRAM layouts.
+*****************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+// the MSB-first GRAM is a byte array, so stores through this type may alias it
+typedef uint16_t ZLCD_fill_pixel __attribute__((may_alias));
+
+/*
+count pixels starting at dst (2 byte aligned). Uses 128-bit NEON stores after
+aligning dst when built with NEON (-mfpu=neon-vfpv3), otherwise the scalar
+version
+*/
+void ZLCD_fill_span(ZLCD_fill_pixel *dst, uint16_t pattern, size_t count);
+// aligns dst to 4 bytes and stores two pixels at a time
+void ZLCD_fill_span_scalar(ZLCD_fill_pixel *dst, uint16_t pattern,
+                           size_t count);
+// count pixels, stride pixels apart (negative stride walks backwards)
+void ZLCD_fill_strided(ZLCD_fill_pixel *dst, uint16_t pattern, size_t count,
+                       ptrdiff_t stride);
+// height rows of width pixels, stride pixels from one row start to the next
+void ZLCD_fill_rect(ZLCD_fill_pixel *dst, uint16_t pattern, size_t width,
+                    size_t height, ptrdiff_t stride);
+
+#endif // ZYNQ_LCD_FILL_H
@@ -0,0 +1,80 @@
+#include "zynq_lcd_hash.h"
+#include "zynq_lcd_place.h"
+#include <string.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*************************************************
+  Tile digests for the ST7789VW driver
+**************************************************/
+
+static inline ZLCD_HOT_CODE uint32_t ZLCD_hash_step(uint32_t h,
+                                                    uint32_t word) {
+  h = (h ^ word) * ZLCD_HASH_PRIME;
+  return h ^ (h >> 15);
+}
+
+// words first to end - 1 of a tile row, word i goes to lane i % 4
+static inline ZLCD_HOT_CODE void ZLCD_hash_words(uint32_t lanes[4],
+                                                 const uint8_t *row,
+                                                 uint16_t first, uint16_t end) {
+  for (uint16_t i = first; i < end; i++) {
+    uint32_t word;
+    memcpy(&word, row + (size_t)i * sizeof(word), sizeof(word));
+    lanes[i & 3U] = ZLCD_hash_step(lanes[i & 3U], word);
+  }
+}
+
+// one lane at a time, so the digest still changes with every lane
+static inline ZLCD_HOT_CODE uint32_t ZLCD_hash_fold(const uint32_t lanes[4]) {
+  uint32_t digest = lanes[0];
+  for (uint8_t i = 1; i < 4; i++) {
+    digest = (digest * ZLCD_HASH_PRIME) ^ lanes[i];
+  }
+  return digest;
+}
+
+ZLCD_HOT_CODE uint32_t ZLCD_hash_tile_scalar(const uint8_t *pixels,
+                                             size_t stride_bytes,
+                                             uint16_t width, uint16_t height) {
+  uint32_t lanes[4] = {ZLCD_HASH_SEED, ZLCD_HASH_SEED, ZLCD_HASH_SEED,
+                       ZLCD_HASH_SEED};
+  for (uint16_t y = 0; y < height; y++, pixels += stride_bytes) {
+    ZLCD_hash_words(lanes, pixels, 0, width / 2U);
+  }
+  return ZLCD_hash_fold(lanes);
+}
+
+#if defined(__ARM_NEON)
+ZLCD_HOT_CODE uint32_t ZLCD_hash_tile(const uint8_t *pixels,
+                                      size_t stride_bytes, uint16_t width,
+                                      uint16_t height) {
+  uint16_t words = width / 2U;
+  uint16_t vector_words = words & ~3U;
+  uint32x4_t lanes = vdupq_n_u32(ZLCD_HASH_SEED);
+  uint32_t tail[4];
+  for (uint16_t y = 0; y < height; y++, pixels += stride_bytes) {
+    // 4 words (8 pixels) per step, lane i takes word i of every group
+    for (uint16_t i = 0; i < vector_words; i += 4U) {
+      uint32x4_t word = vreinterpretq_u32_u8(vld1q_u8(pixels + i * 4U));
+      lanes = vmulq_n_u32(veorq_u32(lanes, word), ZLCD_HASH_PRIME);
+      lanes = veorq_u32(lanes, vshrq_n_u32(lanes, 15));
+    }
+    if (vector_words != words) {
+      // the 12 pixel wide tiles at the right edge of the portrait frame
+      vst1q_u32(tail, lanes);
+      ZLCD_hash_words(tail, pixels, vector_words, words);
+      lanes = vld1q_u32(tail);
+    }
+  }
+  vst1q_u32(tail, lanes);
+  return ZLCD_hash_fold(tail);
+}
+#else
+ZLCD_HOT_CODE uint32_t ZLCD_hash_tile(const uint8_t *pixels,
+                                      size_t stride_bytes, uint16_t width,
+                                      uint16_t height) {
+  return ZLCD_hash_tile_scalar(pixels, stride_bytes, width, height);
+}
+#endif
@@ -0,0 +1,36 @@
+#ifndef ZYNQ_LCD_HASH_H
+#define ZYNQ_LCD_HASH_H
+/****************************************************************************
+Tile digests for ZLCD_BUFFER_HASHED. Instead of a second frame holding what the
+LCD shows, the driver keeps a 32-bit digest of every 16x16 tile of it and a
+refresh only sends the tiles whose digest changed. A tile row is read as 32-bit
+words (two wire order pixels each) that go round 4 lanes, every lane taking
+  h = (h ^ word) * ZLCD_HASH_PRIME, h ^= h >> 15
+and the lanes are folded into one digest at the end. Every step can be undone
+for a given word, so a change of a single word (a pixel pair) always changes
+the digest. Any other change is missed with a chance of about 1 in 2^32 per
+tile, which leaves the tile's old pixels on the LCD until it changes again.
+*****************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ZLCD_HASH_TILE_SIZE 16U
+#define ZLCD_HASH_PRIME 0x9E3779B1U
+#define ZLCD_HASH_SEED 0x811C9DC5U
+
+/*
+digest of a width (even) by height pixel tile of wire order RGB565 starting at
+pixels, rows stride_bytes apart. Uses NEON (8 pixels per step) when built with
+NEON (-mfpu=neon-vfpv3), otherwise the scalar version. Both give the same value
+*/
+uint32_t ZLCD_hash_tile(const uint8_t *pixels, size_t stride_bytes,
+                        uint16_t width, uint16_t height);
+uint32_t ZLCD_hash_tile_scalar(const uint8_t *pixels, size_t stride_bytes,
+                               uint16_t width, uint16_t height);
+
+// tiles needed to cover length pixels
+#define ZLCD_HASH_TILES(length)                                                \
+  (((length) + ZLCD_HASH_TILE_SIZE - 1U) / ZLCD_HASH_TILE_SIZE)
+
+#endif // ZYNQ_LCD_HASH_H
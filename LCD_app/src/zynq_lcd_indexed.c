@@ -0,0 +1,550 @@
+#include "zynq_lcd_indexed.h"
+#include "zynq_lcd_fill.h"
+#include "zynq_lcd_hash.h"
+#include <string.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*************************************************
+  Indexed colour canvas for the ST7789VW driver
+**************************************************/
+
+// one palette index per frame pixel, frame rows of canvas_layout.frame_width
+static uint8_t canvas[ZLCD_WIDTH * ZLCD_HEIGHT];
+static rgb565 palette[ZLCD_INDEXED_COLOURS];
+// the palette in wire order (MSB first), what a pixel expands to
+static ZLCD_fill_pixel wire_palette[ZLCD_INDEXED_COLOURS];
+#if defined(__ARM_NEON)
+// the first and the second wire byte of every entry, the tables vtbl looks in
+static uint8_t wire_high[ZLCD_INDEXED_COLOURS] __attribute__((aligned(16)));
+static uint8_t wire_low[ZLCD_INDEXED_COLOURS] __attribute__((aligned(16)));
+#endif
+// expanded rows on their way out
+static ZLCD_fill_pixel send_pixels[ZLCD_INDEXED_SEND_ROWS *
+                                   ZLCD_INDEXED_MAX_WIDTH] ZLCD_WORK_DATA;
+// drawn on since the last present / to be sent whatever the digest says
+static bool row_dirty[ZLCD_INDEXED_MAX_ROWS];
+static bool row_resend[ZLCD_INDEXED_MAX_ROWS];
+// digest of the indexes the LCD shows in every row, if known
+static uint32_t row_digest[ZLCD_INDEXED_MAX_ROWS];
+static bool row_known[ZLCD_INDEXED_MAX_ROWS];
+// the orientation the canvas is drawn in, valid once begun
+static ZLCD_frame_layout canvas_layout;
+static bool canvas_begun = false;
+
+static bool ZLCD_indexed_ready(void) {
+  if (!canvas_begun) {
+    printf("Call ZLCD_indexed_begin() before drawing on the canvas\n");
+  }
+  return canvas_begun;
+}
+
+void ZLCD_indexed_forget(void) {
+  memset(row_known, 0, sizeof(row_known));
+}
+
+ZLCD_RETURN_STATUS ZLCD_indexed_begin(uint8_t background) {
+  ZLCD_frame_layout layout;
+  ZLCD_RETURN_STATUS status = ZLCD_get_frame_layout(&layout);
+  if (status != ZLCD_SUCCESS) {
+    return status;
+  }
+  if (!canvas_begun || memcmp(&layout, &canvas_layout, sizeof(layout)) != 0) {
+    // the rows are other parts of the screen now
+    ZLCD_indexed_forget();
+    canvas_layout = layout;
+  }
+  memset(canvas, background, (size_t)layout.frame_width * layout.frame_height);
+  memset(row_dirty, true, layout.frame_height);
+  canvas_begun = true;
+  return ZLCD_SUCCESS;
+}
+
+// every row holding one of the marked indexes is sent on the next present
+static void ZLCD_indexed_resend(const bool marked[ZLCD_INDEXED_COLOURS]) {
+  if (!canvas_begun) {
+    return;
+  }
+  uint16_t width = canvas_layout.frame_width;
+  const uint8_t *row = canvas;
+  for (uint16_t y = 0; y < canvas_layout.frame_height; y++, row += width) {
+    for (uint16_t x = 0; x < width && !row_resend[y]; x++) {
+      row_resend[y] = marked[row[x]];
+    }
+  }
+}
+
+static void ZLCD_indexed_store_palette(uint8_t index, rgb565 colour) {
+  const uint8_t bytes[sizeof(rgb565)] = {(uint8_t)(colour >> 8),
+                                         (uint8_t)(colour & 0x00FF)};
+  palette[index] = colour;
+  memcpy(&wire_palette[index], bytes, sizeof(bytes));
+#if defined(__ARM_NEON)
+  wire_high[index] = bytes[0];
+  wire_low[index] = bytes[1];
+#endif
+}
+
+void ZLCD_indexed_set_palette(uint8_t index, rgb565 colour, bool resend) {
+  if (palette[index] == colour) {
+    return;
+  }
+  ZLCD_indexed_store_palette(index, colour);
+  if (resend) {
+    bool marked[ZLCD_INDEXED_COLOURS] = {false};
+    marked[index] = true;
+    ZLCD_indexed_resend(marked);
+  }
+}
+
+ZLCD_RETURN_STATUS ZLCD_indexed_load_palette(uint8_t first,
+                                             const rgb565 *colours,
+                                             uint16_t count, bool resend) {
+  if (colours == NULL || first + count > ZLCD_INDEXED_COLOURS) {
+    printf("ERROR: palette entries %u to %u do not exist\n", first,
+           first + count - 1U);
+    return ZLCD_FAILURE;
+  }
+  bool marked[ZLCD_INDEXED_COLOURS] = {false};
+  bool changed = false;
+  for (uint16_t i = 0; i < count; i++) {
+    if (palette[first + i] != colours[i]) {
+      ZLCD_indexed_store_palette(first + i, colours[i]);
+      marked[first + i] = changed = true;
+    }
+  }
+  if (resend && changed) {
+    ZLCD_indexed_resend(marked);
+  }
+  return ZLCD_SUCCESS;
+}
+
+rgb565 ZLCD_indexed_get_palette(uint8_t index) { return palette[index]; }
+
+static inline int32_t ZLCD_indexed_at(int16_t x, int16_t y) {
+  return canvas_layout.origin + x * canvas_layout.x_step +
+         y * canvas_layout.y_step;
+}
+
+static inline void ZLCD_indexed_plot(int16_t x, int16_t y, uint8_t index) {
+  if (x >= 0 && x < canvas_layout.width && y >= 0 &&
+      y < canvas_layout.height) {
+    canvas[ZLCD_indexed_at(x, y)] = index;
+  }
+}
+
+/*
+clips corners x0, y0 to x1, y1 (inclusive) to the screen and gives the frame
+rectangle they cover, whatever the orientation. false if nothing is left
+*/
+static bool ZLCD_indexed_frame_rect(int16_t x0, int16_t y0, int16_t x1,
+                                    int16_t y1, uint16_t *left, uint16_t *top,
+                                    uint16_t *width, uint16_t *height) {
+  x0 = x0 > 0 ? x0 : 0;
+  y0 = y0 > 0 ? y0 : 0;
+  x1 = x1 < canvas_layout.width - 1 ? x1 : canvas_layout.width - 1;
+  y1 = y1 < canvas_layout.height - 1 ? y1 : canvas_layout.height - 1;
+  if (x0 > x1 || y0 > y1) {
+    return false;
+  }
+  uint16_t stride = canvas_layout.frame_width;
+  int32_t first = ZLCD_indexed_at(x0, y0);
+  int32_t last = ZLCD_indexed_at(x1, y1);
+  int32_t first_x = first % stride, first_y = first / stride;
+  int32_t last_x = last % stride, last_y = last / stride;
+  *left = first_x < last_x ? first_x : last_x;
+  *top = first_y < last_y ? first_y : last_y;
+  *width = abs(last_x - first_x) + 1;
+  *height = abs(last_y - first_y) + 1;
+  return true;
+}
+
+// the frame rows of everything drawn inside x0, y0 to x1, y1
+static void ZLCD_indexed_mark(int16_t x0, int16_t y0, int16_t x1,
+                              int16_t y1) {
+  uint16_t left, top, width, height;
+  if (ZLCD_indexed_frame_rect(x0, y0, x1, y1, &left, &top, &width, &height)) {
+    memset(&row_dirty[top], true, height);
+  }
+}
+
+static void ZLCD_indexed_fill(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                              uint8_t index) {
+  uint16_t left, top, width, height;
+  if (!ZLCD_indexed_frame_rect(x0, y0, x1, y1, &left, &top, &width,
+                               &height)) {
+    return;
+  }
+  uint16_t stride = canvas_layout.frame_width;
+  uint8_t *row = &canvas[(size_t)top * stride + left];
+  for (uint16_t y = 0; y < height; y++, row += stride) {
+    memset(row, index, width);
+  }
+  memset(&row_dirty[top], true, height);
+}
+
+ZLCD_RETURN_STATUS ZLCD_indexed_pixel(uint16_t x, uint16_t y, uint8_t index) {
+  if (!ZLCD_indexed_ready()) {
+    return ZLCD_FAILURE;
+  }
+  if (x >= canvas_layout.width || y >= canvas_layout.height) {
+    printf("Pixel (%u, %u) is not on the screen\n", x, y);
+    return ZLCD_FAILURE;
+  }
+  ZLCD_indexed_fill(x, y, x, y, index);
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_indexed_rectangle(uint16_t origin_x, uint16_t origin_y,
+                                          uint16_t width_px, uint16_t height_px,
+                                          uint16_t border_thickness_px,
+                                          uint8_t border_index, bool fill,
+                                          uint8_t fill_index) {
+  if (!ZLCD_indexed_ready() || width_px == 0 || height_px == 0) {
+    return ZLCD_FAILURE;
+  }
+  if (origin_x >= canvas_layout.width || origin_y >= canvas_layout.height) {
+    printf("Rectangle origin point must be on the screen\n");
+    return ZLCD_FAILURE;
+  }
+  if ((border_thickness_px >= width_px / 2) ||
+      (border_thickness_px >= height_px / 2)) {
+    uint16_t smaller_side = (width_px > height_px) ? height_px : width_px;
+    printf("border thickness for rectangle is too great. Passed %u but "
+           "thickness should not exceed %u\n",
+           border_thickness_px, smaller_side / 2);
+    return ZLCD_FAILURE;
+  }
+  int16_t t = border_thickness_px == 0 ? 1 : border_thickness_px;
+  int16_t x0 = origin_x, y0 = origin_y;
+  int16_t x1 = origin_x + width_px - 1, y1 = origin_y + height_px - 1;
+  if (fill) {
+    ZLCD_indexed_fill(x0, y0, x1, y1, fill_index);
+  }
+  ZLCD_indexed_fill(x0, y0, x1, y0 + t - 1, border_index);
+  ZLCD_indexed_fill(x0, y1 - t + 1, x1, y1, border_index);
+  ZLCD_indexed_fill(x0, y0, x0 + t - 1, y1, border_index);
+  ZLCD_indexed_fill(x1 - t + 1, y0, x1, y1, border_index);
+  return ZLCD_SUCCESS;
+}
+
+// the spans and the outline of ZLCD_draw_filled_circle_xy()
+ZLCD_RETURN_STATUS ZLCD_indexed_circle(uint16_t origin_x, uint16_t origin_y,
+                                       uint16_t radius_px, uint8_t border_index,
+                                       bool fill, uint8_t fill_index) {
+  if (!ZLCD_indexed_ready()) {
+    return ZLCD_FAILURE;
+  }
+  if (origin_x >= canvas_layout.width || origin_y >= canvas_layout.height) {
+    printf("Circle origin is not on the screen\n");
+    return ZLCD_FAILURE;
+  }
+  if (radius_px > ZLCD_WIDTH) {
+    printf("Circle radius is too large\n");
+    return ZLCD_FAILURE;
+  }
+  int16_t cx = origin_x, cy = origin_y;
+  int x = 0;
+  int y = radius_px;
+  int d = 3 - (2 * radius_px);
+  while (fill && x <= y) {
+    ZLCD_indexed_fill(cx - x, cy - y, cx + x, cy - y, fill_index);
+    ZLCD_indexed_fill(cx - y, cy - x, cx + y, cy - x, fill_index);
+    ZLCD_indexed_fill(cx - y, cy + x, cx + y, cy + x, fill_index);
+    ZLCD_indexed_fill(cx - x, cy + y, cx + x, cy + y, fill_index);
+    if (d < 0) {
+      d += (4 * x) + 6;
+    } else {
+      d += 4 * (x - y) + 10;
+      y--;
+    }
+    x++;
+  }
+  // the outline goes over all of the fill, as in the driver
+  x = 0;
+  y = radius_px;
+  d = 3 - (2 * radius_px);
+  while (x <= y) {
+    ZLCD_indexed_plot(cx + x, cy + y, border_index);
+    ZLCD_indexed_plot(cx - x, cy + y, border_index);
+    ZLCD_indexed_plot(cx + x, cy - y, border_index);
+    ZLCD_indexed_plot(cx - x, cy - y, border_index);
+    ZLCD_indexed_plot(cx + y, cy + x, border_index);
+    ZLCD_indexed_plot(cx - y, cy + x, border_index);
+    ZLCD_indexed_plot(cx + y, cy - x, border_index);
+    ZLCD_indexed_plot(cx - y, cy - x, border_index);
+    if (d < 0) {
+      d += (4 * x) + 6;
+    } else {
+      d += 4 * (x - y) + 10;
+      y--;
+    }
+    x++;
+  }
+  ZLCD_indexed_mark(cx - radius_px, cy - radius_px, cx + radius_px,
+                    cy + radius_px);
+  return ZLCD_SUCCESS;
+}
+
+// Bresenham as in the line kernel
+ZLCD_RETURN_STATUS ZLCD_indexed_line(uint16_t x1, uint16_t y1, uint16_t x2,
+                                     uint16_t y2, uint8_t index) {
+  if (!ZLCD_indexed_ready()) {
+    return ZLCD_FAILURE;
+  }
+  if (x1 >= canvas_layout.width || y1 >= canvas_layout.height ||
+      x2 >= canvas_layout.width || y2 >= canvas_layout.height) {
+    printf("Line end points must be on the screen\n");
+    return ZLCD_FAILURE;
+  }
+  int16_t x = x1, y = y1;
+  int dx = abs(x2 - x1);
+  int dy = -abs(y2 - y1);
+  int sx = x1 < x2 ? 1 : -1;
+  int sy = y1 < y2 ? 1 : -1;
+  int err = dx + dy;
+  while (1) {
+    canvas[ZLCD_indexed_at(x, y)] = index;
+    if (x == x2 && y == y2)
+      break;
+    int e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y += sy;
+    }
+  }
+  ZLCD_indexed_mark(x1 < x2 ? x1 : x2, y1 < y2 ? y1 : y2, x1 < x2 ? x2 : x1,
+                    y1 < y2 ? y2 : y1);
+  return ZLCD_SUCCESS;
+}
+
+// distance between text lines, as the driver's get_font_height()
+static uint16_t ZLCD_indexed_text_height(const char *string,
+                                         const ZLCD_font *f) {
+  uint8_t over = 0;
+  int8_t under = INT8_MAX;
+  for (; *string; string++) {
+    if (*string == '\n' || *string == '\r') {
+      continue;
+    }
+    const glyph_dsc_t *dsc = &f->glyph_descriptors[*string - 31];
+    int16_t glyph_over = (int)dsc->box_h + dsc->ofs_y;
+    if (glyph_over > over) {
+      over = glyph_over;
+    }
+    if (dsc->ofs_y < under) {
+      under = dsc->ofs_y;
+    }
+  }
+  return (uint16_t)(over - under);
+}
+
+static void ZLCD_indexed_glyph(const uint8_t *bitmap, int16_t x0, int16_t y0,
+                               int16_t box_w, int16_t box_h, uint8_t index) {
+  uint32_t bit_index = 0;
+  for (int16_t row = 0; row < box_h; row++) {
+    for (int16_t column = 0; column < box_w; column++, bit_index++) {
+      if ((bitmap[bit_index / 8] >> (7 - (bit_index % 8))) & 0x1) {
+        ZLCD_indexed_plot(x0 + column, y0 + row, index);
+      }
+    }
+  }
+  ZLCD_indexed_mark(x0, y0, x0 + box_w - 1, y0 + box_h - 1);
+}
+
+// the glyphs of ZLCD_print_string_xy(), lines below the screen are left out
+ZLCD_RETURN_STATUS ZLCD_indexed_string(const char *string, uint16_t base_x,
+                                       uint16_t base_y, uint8_t index,
+                                       const ZLCD_font *f) {
+  if (!ZLCD_indexed_ready() || string == NULL || f == NULL) {
+    return ZLCD_FAILURE;
+  }
+  if (base_x >= canvas_layout.width || base_y >= canvas_layout.height) {
+    printf("Base coordinate for string write invalid\n");
+    return ZLCD_FAILURE;
+  }
+  for (const char *c = string; *c; c++) {
+    if (!ZLCD_font_has_glyph(*c) && *c != '\n' && *c != '\r') {
+      printf("String has a character that can't be drawn (%d)\n",
+             (unsigned char)*c);
+      return ZLCD_FAILURE;
+    }
+  }
+  uint16_t text_height = ZLCD_indexed_text_height(string, f);
+  int cursor_x = base_x << 4, cursor_y = base_y;
+  for (const char *c = string; *c; c++) {
+    if (*c == '\n' || *c == '\r') {
+      cursor_x = base_x << 4;
+      cursor_y += text_height;
+      if (cursor_y >= canvas_layout.height)
+        break;
+      continue;
+    }
+    const glyph_dsc_t *dsc = &f->glyph_descriptors[*c - 31];
+    int16_t glyph_x0 = (cursor_x >> 4) + dsc->ofs_x;
+    int16_t glyph_y0 = cursor_y - dsc->box_h - dsc->ofs_y;
+    cursor_x += dsc->adv_w;
+    if (dsc->box_w == 0 || dsc->box_h == 0) {
+      continue;
+    }
+    ZLCD_indexed_glyph(&f->glyph_bitmap[dsc->bitmap_index], glyph_x0, glyph_y0,
+                       dsc->box_w, dsc->box_h, index);
+  }
+  return ZLCD_SUCCESS;
+}
+
+// count indexes from src through the palette into wire order pixels at dst
+static ZLCD_HOT_CODE void ZLCD_indexed_expand_scalar(ZLCD_fill_pixel *dst,
+                                                     const uint8_t *src,
+                                                     size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    dst[i] = wire_palette[src[i]];
+    dst[i + 1] = wire_palette[src[i + 1]];
+    dst[i + 2] = wire_palette[src[i + 2]];
+    dst[i + 3] = wire_palette[src[i + 3]];
+  }
+  for (; i < count; i++) {
+    dst[i] = wire_palette[src[i]];
+  }
+}
+
+#if defined(__ARM_NEON)
+// 32 entries of a wire byte table, as much as vtbl4/vtbx4 look up in
+static inline uint8x8x4_t ZLCD_indexed_table_part(const uint8_t *table) {
+  uint8x8x4_t part = {{vld1_u8(table), vld1_u8(table + 8),
+                       vld1_u8(table + 16), vld1_u8(table + 24)}};
+  return part;
+}
+
+/*
+16 pixels per pass, the high and the low wire bytes looked up separately in 32
+entry parts of wire_high and wire_low: vtbl4 for indexes 0-31, then vtbx4 with
+the index less 32, 64, ... 224, which leaves the bytes whose index is outside
+the part alone. 8 lookups per 8 bytes of a plane, every part is loaded once
+for both planes and both halves. vst2 interleaves the planes into wire order.
+*/
+static ZLCD_HOT_CODE void ZLCD_indexed_expand(ZLCD_fill_pixel *dst,
+                                              const uint8_t *src,
+                                              size_t count) {
+  const uint8x8_t part_size = vdup_n_u8(32);
+  uint8_t *out = (uint8_t *)dst;
+  for (; count >= 16; count -= 16, src += 16, out += 32) {
+    uint8x16_t indexes = vld1q_u8(src);
+    uint8x8_t first = vget_low_u8(indexes), second = vget_high_u8(indexes);
+    uint8x8x4_t high = ZLCD_indexed_table_part(wire_high);
+    uint8x8x4_t low = ZLCD_indexed_table_part(wire_low);
+    uint8x8_t high_first = vtbl4_u8(high, first);
+    uint8x8_t high_second = vtbl4_u8(high, second);
+    uint8x8_t low_first = vtbl4_u8(low, first);
+    uint8x8_t low_second = vtbl4_u8(low, second);
+    for (size_t part = 32; part < ZLCD_INDEXED_COLOURS; part += 32) {
+      first = vsub_u8(first, part_size);
+      second = vsub_u8(second, part_size);
+      high = ZLCD_indexed_table_part(&wire_high[part]);
+      low = ZLCD_indexed_table_part(&wire_low[part]);
+      high_first = vtbx4_u8(high_first, high, first);
+      high_second = vtbx4_u8(high_second, high, second);
+      low_first = vtbx4_u8(low_first, low, first);
+      low_second = vtbx4_u8(low_second, low, second);
+    }
+    uint8x16x2_t pixels = {{vcombine_u8(high_first, high_second),
+                            vcombine_u8(low_first, low_second)}};
+    vst2q_u8(out, pixels);
+  }
+  ZLCD_indexed_expand_scalar((ZLCD_fill_pixel *)out, src, count);
+}
+#else
+static ZLCD_HOT_CODE void ZLCD_indexed_expand(ZLCD_fill_pixel *dst,
+                                              const uint8_t *src,
+                                              size_t count) {
+  ZLCD_indexed_expand_scalar(dst, src, count);
+}
+#endif
+
+// sends the expanded rows first to first + num_rows - 1
+static ZLCD_RETURN_STATUS ZLCD_indexed_send(uint16_t first, uint16_t num_rows) {
+  if (num_rows == 0) {
+    return ZLCD_SUCCESS;
+  }
+  ZLCD_RETURN_STATUS status =
+      ZLCD_write_frame_rows(first, num_rows, (const uint8_t *)send_pixels);
+  if (status != ZLCD_SUCCESS) {
+    // not known to be on the LCD, tried again on the next present
+    memset(&row_known[first], false, num_rows);
+    memset(&row_dirty[first], true, num_rows);
+  }
+  return status;
+}
+
+ZLCD_RETURN_STATUS ZLCD_indexed_present(ZLCD_indexed_stats *stats) {
+  if (!ZLCD_indexed_ready()) {
+    return ZLCD_FAILURE;
+  }
+  ZLCD_frame_layout layout;
+  ZLCD_RETURN_STATUS status = ZLCD_get_frame_layout(&layout);
+  if (status != ZLCD_SUCCESS) {
+    return status;
+  }
+  if (memcmp(&layout, &canvas_layout, sizeof(layout)) != 0) {
+    printf("ERROR: the orientation changed, call ZLCD_indexed_begin() and "
+           "draw again\n");
+    return ZLCD_FAILURE;
+  }
+  uint16_t width = layout.frame_width;
+  ZLCD_indexed_stats counts = {.rows = layout.frame_height};
+  // rows waiting in send_pixels, consecutive from run_first
+  uint16_t run_first = 0, run_rows = 0;
+  for (uint16_t y = 0; y < layout.frame_height; y++) {
+    if (!row_dirty[y] && !row_resend[y]) {
+      status = ZLCD_indexed_send(run_first, run_rows);
+      run_rows = 0;
+      if (status != ZLCD_SUCCESS) {
+        break;
+      }
+      continue;
+    }
+    const uint8_t *row = &canvas[(size_t)y * width];
+    // an index is half a pixel of the hash
+    uint32_t digest = ZLCD_hash_tile(row, width, width / 2U, 1);
+    counts.rows_hashed++;
+    row_dirty[y] = false;
+    bool resend = row_resend[y];
+    row_resend[y] = false;
+    if (!resend && row_known[y] && row_digest[y] == digest) {
+      status = ZLCD_indexed_send(run_first, run_rows);
+      run_rows = 0;
+      if (status != ZLCD_SUCCESS) {
+        break;
+      }
+      continue;
+    }
+    if (run_rows == 0) {
+      run_first = y;
+    }
+    ZLCD_indexed_expand(&send_pixels[(size_t)run_rows * width], row, width);
+    row_digest[y] = digest;
+    row_known[y] = true;
+    run_rows++;
+    counts.rows_sent++;
+    if (run_rows == ZLCD_INDEXED_SEND_ROWS) {
+      status = ZLCD_indexed_send(run_first, run_rows);
+      run_rows = 0;
+      if (status != ZLCD_SUCCESS) {
+        break;
+      }
+    }
+  }
+  if (status == ZLCD_SUCCESS) {
+    status = ZLCD_indexed_send(run_first, run_rows);
+  }
+  if (stats != NULL) {
+    *stats = counts;
+  }
+  return status;
+}
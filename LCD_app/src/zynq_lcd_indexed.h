@@ -0,0 +1,79 @@
+#ifndef ZYNQ_LCD_INDEXED_H
+#define ZYNQ_LCD_INDEXED_H
+/****************************************************************************
+Indexed colour canvas, for drawing with one byte per pixel instead of the two
+the GRAM takes. The canvas holds a palette index for every pixel of the frame
+(55040 bytes) and the palette maps the 256 indexes to RGB565. Drawing writes
+and clears half the bytes the GRAM functions do, and ZLCD_indexed_present()
+hashes the drawn frame rows at one byte per pixel as well. Only rows with a
+new digest are expanded through the palette, a few rows at a time, and sent
+with ZLCD_write_frame_rows().
+
+The drawing functions look like the driver functions of the same name and set
+the same pixels, in the orientation ZLCD_indexed_begin() found. Changing a
+palette entry changes every pixel with that index the next time its row is
+sent. With resend the rows that hold the index are sent on the next present,
+and only those.
+
+Only what ZLCD_indexed_present() sent is remembered. Call ZLCD_indexed_forget()
+after the LCD was written any other way (refreshes, update_now drawing,
+scrolling, the band renderer).
+*****************************************************************************/
+
+#include "zynq_lcd_st7789.h"
+
+// frame rows expanded and sent per ZLCD_write_frame_rows() call
+#ifndef ZLCD_INDEXED_SEND_ROWS
+#define ZLCD_INDEXED_SEND_ROWS 8U
+#endif
+#define ZLCD_INDEXED_COLOURS 256U
+// the frame is 320 pixels wide in landscape with ZLCD_ROTATE_MADCTL
+#define ZLCD_INDEXED_MAX_WIDTH ZLCD_HEIGHT
+#define ZLCD_INDEXED_MAX_ROWS ZLCD_HEIGHT
+
+// what the last ZLCD_indexed_present() did with the frame rows
+typedef struct {
+  uint16_t rows;
+  uint16_t rows_hashed; // drawn on or resent for the palette, the others not
+  uint16_t rows_sent;   // the others came out the same as last time
+} ZLCD_indexed_stats;
+
+/*
+fills the canvas with background for the current orientation, draw the frame
+from scratch after it. Every row is hashed on the next present
+*/
+ZLCD_RETURN_STATUS ZLCD_indexed_begin(uint8_t background);
+/*
+the new colour shows in the entry's pixels whenever their rows are sent next.
+With resend the rows holding the entry are marked to be sent on the next
+present, nothing is sent here
+*/
+void ZLCD_indexed_set_palette(uint8_t index, rgb565 colour, bool resend);
+// entries first to first + count - 1, as ZLCD_indexed_set_palette()
+ZLCD_RETURN_STATUS ZLCD_indexed_load_palette(uint8_t first,
+                                             const rgb565 *colours,
+                                             uint16_t count, bool resend);
+rgb565 ZLCD_indexed_get_palette(uint8_t index);
+
+ZLCD_RETURN_STATUS ZLCD_indexed_pixel(uint16_t x, uint16_t y, uint8_t index);
+ZLCD_RETURN_STATUS ZLCD_indexed_rectangle(uint16_t origin_x, uint16_t origin_y,
+                                          uint16_t width_px, uint16_t height_px,
+                                          uint16_t border_thickness_px,
+                                          uint8_t border_index, bool fill,
+                                          uint8_t fill_index);
+ZLCD_RETURN_STATUS ZLCD_indexed_circle(uint16_t origin_x, uint16_t origin_y,
+                                       uint16_t radius_px, uint8_t border_index,
+                                       bool fill, uint8_t fill_index);
+ZLCD_RETURN_STATUS ZLCD_indexed_line(uint16_t x1, uint16_t y1, uint16_t x2,
+                                     uint16_t y2, uint8_t index);
+// ZLCD_print_string_xy(), newlines start a new line below base_x
+ZLCD_RETURN_STATUS ZLCD_indexed_string(const char *string, uint16_t base_x,
+                                       uint16_t base_y, uint8_t index,
+                                       const ZLCD_font *f);
+
+// sends the rows that changed since the last present, stats may be NULL
+ZLCD_RETURN_STATUS ZLCD_indexed_present(ZLCD_indexed_stats *stats);
+// what the LCD shows is no longer known, the next present sends every row
+void ZLCD_indexed_forget(void);
+
+#endif // ZYNQ_LCD_INDEXED_H
@@ -0,0 +1,177 @@
+/****************************************************************************
+Drawing kernels for one orientation, written once and included by
+zynq_lcd_st7789.c for each orientation (no include guard on purpose). The
+includer defines:
+
+  ZLCD_KERNEL_SUFFIX        appended to every name (portrait, landscape, ...)
+  ZLCD_KERNEL_WIDTH         horizontal axis length in this orientation
+  ZLCD_KERNEL_HEIGHT        vertical axis length in this orientation
+  ZLCD_KERNEL_STRIDE        pixels per GRAM row (frame width)
+  ZLCD_KERNEL_FRAME_X       GRAM column of pixel (x, y)
+  ZLCD_KERNEL_FRAME_Y       GRAM row of pixel (x, y)
+  ZLCD_KERNEL_X_STEP        GRAM pixels from (x, y) to (x + 1, y)
+  ZLCD_KERNEL_Y_STEP        GRAM pixels from (x, y) to (x, y + 1)
+
+so every index below is plain arithmetic on constants, and the functions end
+up in a ZLCD_orientation_kernels table named ZLCD_kernels_<suffix>. They are
+undefined again at the end.
+*****************************************************************************/
+
+#define ZLCD_KERNEL_CONCAT_(base, suffix) base##_##suffix
+#define ZLCD_KERNEL_CONCAT(base, suffix) ZLCD_KERNEL_CONCAT_(base, suffix)
+#define ZLCD_KERNEL_NAME(base) ZLCD_KERNEL_CONCAT(base, ZLCD_KERNEL_SUFFIX)
+#define ZLCD_KERNEL_INDEX(x, y)                                                \
+  (((size_t)ZLCD_KERNEL_FRAME_Y(x, y) * ZLCD_KERNEL_STRIDE +                  \
+    ZLCD_KERNEL_FRAME_X(x, y)) *                                               \
+   sizeof(rgb565))
+#define ZLCD_KERNEL_ON_SCREEN(x, y)                                            \
+  ((x) >= 0 && (x) < ZLCD_KERNEL_WIDTH && (y) >= 0 && (y) < ZLCD_KERNEL_HEIGHT)
+
+static ZLCD_HOT_CODE size_t ZLCD_KERNEL_NAME(ZLCD_index)(uint16_t x,
+                                                         uint16_t y) {
+  return ZLCD_KERNEL_INDEX(x, y);
+}
+
+// without a frame (ZLCD_FRAMELESS) only the layout is left
+#if !ZLCD_FRAMELESS
+
+// one pixel, clipped and marked
+static inline ZLCD_HOT_CODE void
+ZLCD_KERNEL_NAME(ZLCD_plot)(int16_t x, int16_t y, rgb565 colour) {
+  if (!ZLCD_KERNEL_ON_SCREEN(x, y)) {
+    return;
+  }
+  uint16_t frame_x = ZLCD_KERNEL_FRAME_X(x, y);
+  uint16_t frame_y = ZLCD_KERNEL_FRAME_Y(x, y);
+  ZLCD_mark_covered(frame_x, frame_x, frame_y, frame_y);
+  ZLCD_gram_store(((size_t)frame_y * ZLCD_KERNEL_STRIDE + frame_x) *
+                      sizeof(rgb565),
+                  colour);
+}
+
+// Bresenham, pixels off the screen are skipped
+static ZLCD_HOT_CODE void ZLCD_KERNEL_NAME(ZLCD_line)(int16_t x1, int16_t y1,
+                                                      int16_t x2, int16_t y2,
+                                                      rgb565 colour) {
+  int dx = abs(x2 - x1);
+  int dy = -abs(y2 - y1);
+  int sx = x1 < x2 ? 1 : -1;
+  int sy = y1 < y2 ? 1 : -1;
+  int err = dx + dy;
+
+  while (1) {
+    ZLCD_KERNEL_NAME(ZLCD_plot)(x1, y1, colour);
+    if (x1 == x2 && y1 == y2)
+      break;
+
+    int e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x1 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y1 += sy;
+    }
+  }
+}
+
+// midpoint circle outline, all 8 symmetric points per step
+static ZLCD_HOT_CODE void
+ZLCD_KERNEL_NAME(ZLCD_circle)(int16_t origin_x, int16_t origin_y,
+                              int16_t radius, rgb565 colour) {
+  int x = 0;
+  int y = radius;
+  int d = 3 - (2 * radius);
+  while (x <= y) {
+    ZLCD_KERNEL_NAME(ZLCD_plot)(origin_x + x, origin_y + y, colour);
+    ZLCD_KERNEL_NAME(ZLCD_plot)(origin_x - x, origin_y + y, colour);
+    ZLCD_KERNEL_NAME(ZLCD_plot)(origin_x + x, origin_y - y, colour);
+    ZLCD_KERNEL_NAME(ZLCD_plot)(origin_x - x, origin_y - y, colour);
+    ZLCD_KERNEL_NAME(ZLCD_plot)(origin_x + y, origin_y + x, colour);
+    ZLCD_KERNEL_NAME(ZLCD_plot)(origin_x - y, origin_y + x, colour);
+    ZLCD_KERNEL_NAME(ZLCD_plot)(origin_x + y, origin_y - x, colour);
+    ZLCD_KERNEL_NAME(ZLCD_plot)(origin_x - y, origin_y - x, colour);
+    if (d < 0) {
+      d += (4 * x) + 6;
+    } else {
+      d += 4 * (x - y) + 10;
+      y--;
+    }
+    x++;
+  }
+}
+
+// set bits of a 1 bpp, MSB first glyph bitmap. The caller marks the area
+static ZLCD_HOT_CODE void
+ZLCD_KERNEL_NAME(ZLCD_glyph)(const uint8_t *bitmap, int16_t x0, int16_t y0,
+                             int16_t box_w, int16_t box_h, rgb565 colour) {
+  uint32_t bit_index = 0;
+  for (int16_t row = 0; row < box_h; row++) {
+    int16_t y = y0 + row;
+    for (int16_t column = 0; column < box_w; column++, bit_index++) {
+      if (((bitmap[bit_index / 8] >> (7 - (bit_index % 8))) & 0x1) == 0) {
+        continue;
+      }
+      int16_t x = x0 + column;
+      if (ZLCD_KERNEL_ON_SCREEN(x, y)) {
+        ZLCD_gram_store(ZLCD_KERNEL_INDEX(x, y), colour);
+      }
+    }
+  }
+}
+
+/*
+copies width x height pixels of an LVGL map, starting at (source_x, source_y)
+in the map, to (x0, y0). Already clipped by the caller, which also marks it.
+*/
+static ZLCD_HOT_CODE void
+ZLCD_KERNEL_NAME(ZLCD_blit)(const uint8_t *map, uint16_t map_width,
+                            uint16_t source_x, uint16_t source_y, uint16_t x0,
+                            uint16_t y0, uint16_t width, uint16_t height) {
+  for (uint16_t row = 0; row < height; row++) {
+    const uint8_t *source =
+        &map[((size_t)(source_y + row) * map_width + source_x) *
+             sizeof(rgb565)];
+    size_t index = ZLCD_KERNEL_INDEX(x0, y0 + row);
+    if (ZLCD_KERNEL_X_STEP == 1) {
+      ZLCD_gram_store_lvgl_row(index, source, width);
+      continue;
+    }
+    for (uint16_t column = 0; column < width; column++) {
+      ZLCD_gram_store_lvgl(index, source);
+      index += (ptrdiff_t)ZLCD_KERNEL_X_STEP * (ptrdiff_t)sizeof(rgb565);
+      source += sizeof(rgb565);
+    }
+  }
+}
+#endif
+
+static const ZLCD_orientation_kernels ZLCD_KERNEL_NAME(ZLCD_kernels) = {
+    .index = ZLCD_KERNEL_NAME(ZLCD_index),
+#if !ZLCD_FRAMELESS
+    .line = ZLCD_KERNEL_NAME(ZLCD_line),
+    .circle = ZLCD_KERNEL_NAME(ZLCD_circle),
+    .glyph = ZLCD_KERNEL_NAME(ZLCD_glyph),
+    .blit = ZLCD_KERNEL_NAME(ZLCD_blit),
+#endif
+    .x_step = ZLCD_KERNEL_X_STEP,
+    .y_step = ZLCD_KERNEL_Y_STEP,
+    .width = ZLCD_KERNEL_WIDTH,
+    .height = ZLCD_KERNEL_HEIGHT,
+    .frame_width = ZLCD_KERNEL_STRIDE,
+    .frame_height = ZLCD_WIDTH * ZLCD_HEIGHT / ZLCD_KERNEL_STRIDE};
+
+#undef ZLCD_KERNEL_ON_SCREEN
+#undef ZLCD_KERNEL_INDEX
+#undef ZLCD_KERNEL_NAME
+#undef ZLCD_KERNEL_CONCAT
+#undef ZLCD_KERNEL_CONCAT_
+#undef ZLCD_KERNEL_SUFFIX
+#undef ZLCD_KERNEL_WIDTH
+#undef ZLCD_KERNEL_HEIGHT
+#undef ZLCD_KERNEL_STRIDE
+#undef ZLCD_KERNEL_FRAME_X
+#undef ZLCD_KERNEL_FRAME_Y
+#undef ZLCD_KERNEL_X_STEP
+#undef ZLCD_KERNEL_Y_STEP
@@ -0,0 +1,336 @@
+#include "zynq_lcd_layer.h"
+#include "zynq_lcd_blend.h"
+#include "zynq_lcd_fill.h"
+#include <string.h>
+
+/*************************************************
+  layer compositor for the ST7789VW driver
+**************************************************/
+
+// layers are composed into the GRAM, a frameless build has none
+#if !ZLCD_FRAMELESS
+
+typedef struct {
+  ZLCD_surface surface;
+  int16_t x, y;
+  bool attached, visible, keyed;
+  rgb565 key;
+  uint8_t alpha;
+} ZLCD_layer_state;
+
+// screen rectangle, inclusive
+typedef struct {
+  int16_t x0, y0, x1, y1;
+} ZLCD_layer_rect;
+
+static ZLCD_layer_state layers[ZLCD_MAX_LAYERS];
+static ZLCD_layer_rect damage[ZLCD_MAX_DAMAGE];
+static uint8_t num_damage = 0;
+// the whole screen, until the first compose
+static bool damage_all = true;
+static rgb565 layer_background = BLACK;
+// the orientation the GRAM was last composed in
+static ZLCD_frame_layout composed_layout;
+// rows being composed, as ZLCD_draw_image() reads them
+static rgb565 scratch[ZLCD_LAYER_ROWS * ZLCD_LAYER_MAX_WIDTH] ZLCD_WORK_DATA;
+
+static ZLCD_layer_state *ZLCD_layer_get(uint8_t layer, bool attached) {
+  if (layer >= ZLCD_MAX_LAYERS) {
+    printf("ERROR: there is no layer %u (ZLCD_MAX_LAYERS is %u)\n", layer,
+           (unsigned)ZLCD_MAX_LAYERS);
+    return NULL;
+  }
+  if (attached && !layers[layer].attached) {
+    printf("ERROR: nothing is attached to layer %u\n", layer);
+    return NULL;
+  }
+  return &layers[layer];
+}
+
+static inline int32_t ZLCD_layer_area(const ZLCD_layer_rect *rect) {
+  return (int32_t)(rect->x1 - rect->x0 + 1) * (rect->y1 - rect->y0 + 1);
+}
+
+static ZLCD_layer_rect ZLCD_layer_union(const ZLCD_layer_rect *a,
+                                        const ZLCD_layer_rect *b) {
+  return (ZLCD_layer_rect){a->x0 < b->x0 ? a->x0 : b->x0,
+                           a->y0 < b->y0 ? a->y0 : b->y0,
+                           a->x1 > b->x1 ? a->x1 : b->x1,
+                           a->y1 > b->y1 ? a->y1 : b->y1};
+}
+
+/*
+Adds x0, y0 to x1, y1, cut down to the largest screen. It is merged with every
+rectangle where the two together cost no more than apart, and into the one it
+grows least when the list is full
+*/
+static void ZLCD_layer_add_damage(int32_t x0, int32_t y0, int32_t x1,
+                                  int32_t y1) {
+  const int32_t last = ZLCD_LAYER_MAX_WIDTH - 1;
+  x0 = x0 > 0 ? x0 : 0;
+  y0 = y0 > 0 ? y0 : 0;
+  x1 = x1 < last ? x1 : last;
+  y1 = y1 < last ? y1 : last;
+  if (damage_all || x0 > x1 || y0 > y1) {
+    return;
+  }
+  ZLCD_layer_rect rect = {x0, y0, x1, y1};
+  while (true) {
+    uint8_t best = num_damage;
+    int32_t best_growth = INT32_MAX;
+    for (uint8_t i = 0; i < num_damage; i++) {
+      ZLCD_layer_rect joined = ZLCD_layer_union(&damage[i], &rect);
+      int32_t growth = ZLCD_layer_area(&joined) - ZLCD_layer_area(&damage[i]);
+      if (growth <= ZLCD_layer_area(&rect)) {
+        best = i;
+        break;
+      }
+      if (num_damage == ZLCD_MAX_DAMAGE && growth < best_growth) {
+        best = i;
+        best_growth = growth;
+      }
+    }
+    if (best == num_damage) {
+      break;
+    }
+    // the bigger rectangle may meet others now
+    rect = ZLCD_layer_union(&damage[best], &rect);
+    damage[best] = damage[--num_damage];
+  }
+  damage[num_damage++] = rect;
+}
+
+// where the layer shows, if it shows at all
+static void ZLCD_layer_add_bounds(const ZLCD_layer_state *l) {
+  if (l->attached && l->visible && l->alpha != 0) {
+    ZLCD_layer_add_damage(l->x, l->y, (int32_t)l->x + l->surface.width - 1,
+                          (int32_t)l->y + l->surface.height - 1);
+  }
+}
+
+void ZLCD_layer_damage_all(void) {
+  damage_all = true;
+  num_damage = 0;
+}
+
+void ZLCD_layer_set_background(rgb565 colour) {
+  if (colour != layer_background) {
+    layer_background = colour;
+    ZLCD_layer_damage_all();
+  }
+}
+
+ZLCD_RETURN_STATUS ZLCD_layer_attach(uint8_t layer,
+                                     const ZLCD_surface *surface, int16_t x,
+                                     int16_t y) {
+  ZLCD_layer_state *l = ZLCD_layer_get(layer, false);
+  if (l == NULL) {
+    return ZLCD_FAILURE;
+  }
+  if (surface == NULL || surface->pixels == NULL || surface->width == 0 ||
+      surface->height == 0 || surface->stride < surface->width) {
+    printf("ERROR: the surface for layer %u is not valid\n", layer);
+    return ZLCD_FAILURE;
+  }
+  ZLCD_layer_add_bounds(l);
+  *l = (ZLCD_layer_state){.surface = *surface,
+                          .x = x,
+                          .y = y,
+                          .attached = true,
+                          .visible = true,
+                          .alpha = UINT8_MAX};
+  ZLCD_layer_add_bounds(l);
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_layer_detach(uint8_t layer) {
+  ZLCD_layer_state *l = ZLCD_layer_get(layer, true);
+  if (l == NULL) {
+    return ZLCD_FAILURE;
+  }
+  ZLCD_layer_add_bounds(l);
+  l->attached = false;
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_layer_move(uint8_t layer, int16_t x, int16_t y) {
+  ZLCD_layer_state *l = ZLCD_layer_get(layer, true);
+  if (l == NULL) {
+    return ZLCD_FAILURE;
+  }
+  if (x != l->x || y != l->y) {
+    ZLCD_layer_add_bounds(l);
+    l->x = x;
+    l->y = y;
+    ZLCD_layer_add_bounds(l);
+  }
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_layer_set_visible(uint8_t layer, bool visible) {
+  ZLCD_layer_state *l = ZLCD_layer_get(layer, true);
+  if (l == NULL) {
+    return ZLCD_FAILURE;
+  }
+  if (visible != l->visible) {
+    ZLCD_layer_add_bounds(l);
+    l->visible = visible;
+    ZLCD_layer_add_bounds(l);
+  }
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_layer_set_alpha(uint8_t layer, uint8_t alpha) {
+  ZLCD_layer_state *l = ZLCD_layer_get(layer, true);
+  if (l == NULL) {
+    return ZLCD_FAILURE;
+  }
+  if (alpha != l->alpha) {
+    ZLCD_layer_add_bounds(l);
+    l->alpha = alpha;
+    ZLCD_layer_add_bounds(l);
+  }
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_layer_set_key(uint8_t layer, bool keyed, rgb565 key) {
+  ZLCD_layer_state *l = ZLCD_layer_get(layer, true);
+  if (l == NULL) {
+    return ZLCD_FAILURE;
+  }
+  if (keyed != l->keyed || (keyed && key != l->key)) {
+    l->keyed = keyed;
+    l->key = key;
+    ZLCD_layer_add_bounds(l);
+  }
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_layer_damage(uint8_t layer, uint16_t x, uint16_t y,
+                                     uint16_t width, uint16_t height) {
+  ZLCD_layer_state *l = ZLCD_layer_get(layer, true);
+  if (l == NULL) {
+    return ZLCD_FAILURE;
+  }
+  if (width == 0 || height == 0 || x >= l->surface.width ||
+      y >= l->surface.height) {
+    return ZLCD_SUCCESS;
+  }
+  width = width < l->surface.width - x ? width : l->surface.width - x;
+  height = height < l->surface.height - y ? height : l->surface.height - y;
+  if (l->visible && l->alpha != 0) {
+    ZLCD_layer_add_damage((int32_t)l->x + x, (int32_t)l->y + y,
+                          (int32_t)l->x + x + width - 1,
+                          (int32_t)l->y + y + height - 1);
+  }
+  return ZLCD_SUCCESS;
+}
+
+/*
+rows first_y to first_y + num_rows - 1 of rect into the scratch buffer, rect
+wide: the background, then every layer in meets[] from the bottom up
+*/
+static void ZLCD_layer_compose_rows(const ZLCD_layer_rect *rect,
+                                    const ZLCD_layer_state *const *meets,
+                                    uint8_t num_meets, int16_t first_y,
+                                    uint16_t num_rows,
+                                    ZLCD_layer_stats *counts) {
+  uint16_t width = rect->x1 - rect->x0 + 1;
+  for (uint16_t row = 0; row < num_rows; row++) {
+    int16_t y = first_y + row;
+    rgb565 *out = &scratch[(size_t)row * width];
+    ZLCD_fill_span((ZLCD_fill_pixel *)out, layer_background, width);
+    for (uint8_t i = 0; i < num_meets; i++) {
+      const ZLCD_layer_state *l = meets[i];
+      int32_t surface_y = (int32_t)y - l->y;
+      if (surface_y < 0 || surface_y >= l->surface.height) {
+        continue;
+      }
+      int32_t x0 = rect->x0 > l->x ? rect->x0 : l->x;
+      int32_t x1 = (int32_t)l->x + l->surface.width - 1;
+      x1 = rect->x1 < x1 ? rect->x1 : x1;
+      const rgb565 *source =
+          &l->surface.pixels[(size_t)surface_y * l->surface.stride +
+                             (x0 - l->x)];
+      ZLCD_blend_span(&out[x0 - rect->x0], source, x1 - x0 + 1, l->alpha,
+                      l->keyed, l->key);
+      counts->spans++;
+    }
+  }
+  counts->pixels += (uint32_t)width * num_rows;
+}
+
+ZLCD_RETURN_STATUS ZLCD_layer_compose(ZLCD_layer_stats *stats,
+                                      bool update_now) {
+  ZLCD_frame_layout layout;
+  ZLCD_RETURN_STATUS status = ZLCD_get_frame_layout(&layout);
+  if (status != ZLCD_SUCCESS) {
+    return status;
+  }
+  if (memcmp(&layout, &composed_layout, sizeof(layout)) != 0) {
+    // whatever was composed is somewhere else on the screen now
+    ZLCD_layer_damage_all();
+    composed_layout = layout;
+  }
+  if (damage_all) {
+    damage[0] = (ZLCD_layer_rect){0, 0, layout.width - 1, layout.height - 1};
+    num_damage = 1;
+    damage_all = false;
+  }
+  // cut to this screen, so the last rectangle that is left is known
+  uint8_t num_rects = 0;
+  for (uint8_t d = 0; d < num_damage; d++) {
+    ZLCD_layer_rect rect = damage[d];
+    rect.x1 = rect.x1 < layout.width ? rect.x1 : layout.width - 1;
+    rect.y1 = rect.y1 < layout.height ? rect.y1 : layout.height - 1;
+    if (rect.x0 <= rect.x1 && rect.y0 <= rect.y1) {
+      damage[num_rects++] = rect;
+    }
+  }
+  num_damage = 0;
+
+  ZLCD_layer_stats counts = {.rectangles = num_rects};
+  for (uint8_t d = 0; d < num_rects && status == ZLCD_SUCCESS; d++) {
+    const ZLCD_layer_rect *rect = &damage[d];
+    const ZLCD_layer_state *meets[ZLCD_MAX_LAYERS];
+    uint8_t num_meets = 0;
+    for (uint8_t i = 0; i < ZLCD_MAX_LAYERS; i++) {
+      const ZLCD_layer_state *l = &layers[i];
+      if (l->attached && l->visible && l->alpha != 0 && l->x <= rect->x1 &&
+          l->y <= rect->y1 &&
+          (int32_t)l->x + l->surface.width - 1 >= rect->x0 &&
+          (int32_t)l->y + l->surface.height - 1 >= rect->y0) {
+        meets[num_meets++] = l;
+      }
+    }
+    uint16_t width = rect->x1 - rect->x0 + 1;
+    uint16_t rows_per_pass = (uint16_t)(sizeof(scratch) / sizeof(rgb565) /
+                                        width);
+    for (int16_t y = rect->y0; y <= rect->y1; y += rows_per_pass) {
+      uint16_t num_rows = rect->y1 - y + 1;
+      num_rows = num_rows < rows_per_pass ? num_rows : rows_per_pass;
+      ZLCD_layer_compose_rows(rect, meets, num_meets, y, num_rows, &counts);
+      // memory order is what an LVGL map is on the little endian A9
+      ZLCD_image image = {.width = width,
+                          .height = num_rows,
+                          .data_size = (size_t)width * num_rows *
+                                       sizeof(rgb565),
+                          .map = (const uint8_t *)scratch};
+      bool last = d == num_rects - 1 && y + num_rows > rect->y1;
+      status = ZLCD_draw_image(ZLCD_create_coordinate(rect->x0, y), &image,
+                               update_now && last);
+      if (status != ZLCD_SUCCESS) {
+        break;
+      }
+    }
+  }
+  if (status != ZLCD_SUCCESS) {
+    // not known what made it into the GRAM
+    ZLCD_layer_damage_all();
+  }
+  if (stats != NULL) {
+    *stats = counts;
+  }
+  return status;
+}
+#endif
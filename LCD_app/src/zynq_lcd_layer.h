@@ -0,0 +1,77 @@
+#ifndef ZYNQ_LCD_LAYER_H
+#define ZYNQ_LCD_LAYER_H
+/****************************************************************************
+Layer compositor. Up to ZLCD_MAX_LAYERS surfaces are stacked over a background
+colour, layer 0 at the bottom. Each layer has a screen position (it may hang
+off the screen), can be hidden, can have a colour key (source pixels of that
+colour are transparent) and a global alpha.
+
+Changing a layer only records the screen rectangles it changed (damage).
+ZLCD_layer_compose() then composes just those rectangles, a few rows at a time
+into a scratch buffer (zynq_lcd_blend.c), and draws them into the GRAM like an
+image, so the next refresh sends whatever pixels actually changed. The first
+compose, and the first one after an orientation change, composes the whole
+screen.
+
+Surfaces are rgb565 values in memory order, which on the little endian
+Cortex-A9 is also the LVGL RGB565 map layout. They are not copied and have to
+stay valid while attached. After changing the pixels of a surface call
+ZLCD_layer_damage() for the part that changed. Anything drawn on the GRAM
+another way is only covered again where damage is composed over it. A
+ZLCD_FRAMELESS build leaves the compositor out.
+*****************************************************************************/
+
+#include "zynq_lcd_st7789.h"
+
+#ifndef ZLCD_MAX_LAYERS
+#define ZLCD_MAX_LAYERS 8U
+#endif
+// rectangles kept apart before they are merged into bigger ones
+#ifndef ZLCD_MAX_DAMAGE
+#define ZLCD_MAX_DAMAGE 16U
+#endif
+// scratch buffer rows of the widest screen (320 pixels), 640 bytes each
+#ifndef ZLCD_LAYER_ROWS
+#define ZLCD_LAYER_ROWS 16U
+#endif
+#define ZLCD_LAYER_MAX_WIDTH ZLCD_HEIGHT
+
+typedef struct {
+  const rgb565 *pixels;
+  uint16_t width, height;
+  uint16_t stride; // pixels from the start of one row to the next
+} ZLCD_surface;
+
+// what the last ZLCD_layer_compose() did
+typedef struct {
+  uint16_t rectangles; // damage composed, after merging and clipping
+  uint32_t pixels;     // pixels composed
+  uint32_t spans;      // layer row spans blended onto them
+} ZLCD_layer_stats;
+
+// puts the surface on layer, shown and opaque without a key
+ZLCD_RETURN_STATUS ZLCD_layer_attach(uint8_t layer,
+                                     const ZLCD_surface *surface, int16_t x,
+                                     int16_t y);
+ZLCD_RETURN_STATUS ZLCD_layer_detach(uint8_t layer);
+ZLCD_RETURN_STATUS ZLCD_layer_move(uint8_t layer, int16_t x, int16_t y);
+ZLCD_RETURN_STATUS ZLCD_layer_set_visible(uint8_t layer, bool visible);
+// 255 opaque, 0 not shown
+ZLCD_RETURN_STATUS ZLCD_layer_set_alpha(uint8_t layer, uint8_t alpha);
+ZLCD_RETURN_STATUS ZLCD_layer_set_key(uint8_t layer, bool keyed, rgb565 key);
+// surface pixels (x, y) to (x + width - 1, y + height - 1) have changed
+ZLCD_RETURN_STATUS ZLCD_layer_damage(uint8_t layer, uint16_t x, uint16_t y,
+                                     uint16_t width, uint16_t height);
+// the colour under every layer, damages the whole screen when it changes
+void ZLCD_layer_set_background(rgb565 colour);
+// the next compose covers the whole screen
+void ZLCD_layer_damage_all(void);
+
+/*
+composes the damage into the GRAM and forgets it, refreshing after it with
+update_now (as the drawing functions do). stats may be NULL
+*/
+ZLCD_RETURN_STATUS ZLCD_layer_compose(ZLCD_layer_stats *stats,
+                                      bool update_now);
+
+#endif // ZYNQ_LCD_LAYER_H
@@ -0,0 +1,135 @@
+#include "zynq_lcd_pack.h"
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*************************************************
+  RGB444 packing for the ST7789VW driver
+**************************************************/
+
+// 4x4 Bayer thresholds, 0-15
+static const uint8_t ZLCD_bayer4[4][4] = {
+    {0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+
+static inline void ZLCD_pack_pair(uint8_t *dst, uint8_t r0, uint8_t g0,
+                                  uint8_t b0, uint8_t r1, uint8_t g1,
+                                  uint8_t b1) {
+  dst[0] = (uint8_t)(r0 << 4 | g0);
+  dst[1] = (uint8_t)(b0 << 4 | r1);
+  dst[2] = (uint8_t)(g1 << 4 | b1);
+}
+
+void ZLCD_pack_rgb444_scalar(uint8_t *dst, const uint8_t *src, size_t count) {
+  for (size_t i = 0; i + 1 < count; i += 2, src += 4, dst += 3) {
+    // src is hi, lo of two pixels: RRRRRGGG GGGBBBBB
+    ZLCD_pack_pair(dst, src[0] >> 4, (src[0] & 0x07) << 1 | src[1] >> 7,
+                   (src[1] >> 1) & 0x0F, src[2] >> 4,
+                   (src[2] & 0x07) << 1 | src[3] >> 7, (src[3] >> 1) & 0x0F);
+  }
+}
+
+// a 5 or 6 bit channel plus its threshold, down to 4 bits
+static inline uint8_t ZLCD_dither5(uint8_t value, uint8_t threshold) {
+  uint8_t result = (uint8_t)((value + (threshold >> 3)) >> 1);
+  return result > 15 ? 15 : result;
+}
+
+static inline uint8_t ZLCD_dither6(uint8_t value, uint8_t threshold) {
+  uint8_t result = (uint8_t)((value + (threshold >> 2)) >> 2);
+  return result > 15 ? 15 : result;
+}
+
+void ZLCD_pack_rgb444_dithered_scalar(uint8_t *dst, const uint8_t *src,
+                                      size_t count, uint16_t x, uint16_t y) {
+  const uint8_t *row = ZLCD_bayer4[y & 3U];
+  for (size_t i = 0; i + 1 < count; i += 2, src += 4, dst += 3, x += 2) {
+    uint8_t m0 = row[x & 3U], m1 = row[(x + 1U) & 3U];
+    ZLCD_pack_pair(
+        dst, ZLCD_dither5(src[0] >> 3, m0),
+        ZLCD_dither6((src[0] & 0x07) << 3 | src[1] >> 5, m0),
+        ZLCD_dither5(src[1] & 0x1F, m0), ZLCD_dither5(src[2] >> 3, m1),
+        ZLCD_dither6((src[2] & 0x07) << 3 | src[3] >> 5, m1),
+        ZLCD_dither5(src[3] & 0x1F, m1));
+  }
+}
+
+#if defined(__ARM_NEON)
+void ZLCD_pack_rgb444(uint8_t *dst, const uint8_t *src, size_t count) {
+  const uint8x16_t high_nibble = vdupq_n_u8(0xF0);
+  const uint8x16_t low_nibble = vdupq_n_u8(0x0F);
+  const uint8x16_t green_high = vdupq_n_u8(0x07);
+  // 64 bytes in, 48 out. vld4 splits hi/lo of the even and the odd pixels
+  for (; count >= 32; count -= 32, src += 64, dst += 48) {
+    uint8x16x4_t in = vld4q_u8(src);
+    uint8x16_t g0 = vorrq_u8(vshlq_n_u8(vandq_u8(in.val[0], green_high), 1),
+                             vshrq_n_u8(in.val[1], 7));
+    uint8x16_t g1 = vorrq_u8(vshlq_n_u8(vandq_u8(in.val[2], green_high), 1),
+                             vshrq_n_u8(in.val[3], 7));
+    uint8x16x3_t out;
+    out.val[0] = vorrq_u8(vandq_u8(in.val[0], high_nibble), g0);
+    out.val[1] = vorrq_u8(vandq_u8(vshlq_n_u8(in.val[1], 3), high_nibble),
+                          vshrq_n_u8(in.val[2], 4));
+    out.val[2] = vorrq_u8(vshlq_n_u8(g1, 4),
+                          vandq_u8(vshrq_n_u8(in.val[3], 1), low_nibble));
+    vst3q_u8(dst, out);
+  }
+  ZLCD_pack_rgb444_scalar(dst, src, count);
+}
+
+void ZLCD_pack_rgb444_dithered(uint8_t *dst, const uint8_t *src, size_t count,
+                               uint16_t x, uint16_t y) {
+  /*
+  32 pixels per pass is a multiple of the pattern width, so the thresholds of
+  the even and the odd pixels are the same for every pass of the row
+  */
+  const uint8_t *row = ZLCD_bayer4[y & 3U];
+  uint8_t thresholds[4][16];
+  for (unsigned i = 0; i < 16; i++) {
+    uint8_t m0 = row[(x + 2U * i) & 3U], m1 = row[(x + 2U * i + 1U) & 3U];
+    thresholds[0][i] = m0 >> 3;
+    thresholds[1][i] = m0 >> 2;
+    thresholds[2][i] = m1 >> 3;
+    thresholds[3][i] = m1 >> 2;
+  }
+  const uint8x16_t rb0 = vld1q_u8(thresholds[0]);
+  const uint8x16_t g0_add = vld1q_u8(thresholds[1]);
+  const uint8x16_t rb1 = vld1q_u8(thresholds[2]);
+  const uint8x16_t g1_add = vld1q_u8(thresholds[3]);
+  const uint8x16_t max = vdupq_n_u8(15);
+  const uint8x16_t green_high = vdupq_n_u8(0x07);
+  const uint8x16_t blue = vdupq_n_u8(0x1F);
+  for (; count >= 32; count -= 32, src += 64, dst += 48, x += 32) {
+    uint8x16x4_t in = vld4q_u8(src);
+    // the 5 and 6 bit channels of the even (0) and odd (1) pixels
+    uint8x16_t r0 = vshrq_n_u8(in.val[0], 3);
+    uint8x16_t g0 = vorrq_u8(vshlq_n_u8(vandq_u8(in.val[0], green_high), 3),
+                             vshrq_n_u8(in.val[1], 5));
+    uint8x16_t b0 = vandq_u8(in.val[1], blue);
+    uint8x16_t r1 = vshrq_n_u8(in.val[2], 3);
+    uint8x16_t g1 = vorrq_u8(vshlq_n_u8(vandq_u8(in.val[2], green_high), 3),
+                             vshrq_n_u8(in.val[3], 5));
+    uint8x16_t b1 = vandq_u8(in.val[3], blue);
+    r0 = vminq_u8(vshrq_n_u8(vaddq_u8(r0, rb0), 1), max);
+    g0 = vminq_u8(vshrq_n_u8(vaddq_u8(g0, g0_add), 2), max);
+    b0 = vminq_u8(vshrq_n_u8(vaddq_u8(b0, rb0), 1), max);
+    r1 = vminq_u8(vshrq_n_u8(vaddq_u8(r1, rb1), 1), max);
+    g1 = vminq_u8(vshrq_n_u8(vaddq_u8(g1, g1_add), 2), max);
+    b1 = vminq_u8(vshrq_n_u8(vaddq_u8(b1, rb1), 1), max);
+    uint8x16x3_t out;
+    out.val[0] = vorrq_u8(vshlq_n_u8(r0, 4), g0);
+    out.val[1] = vorrq_u8(vshlq_n_u8(b0, 4), r1);
+    out.val[2] = vorrq_u8(vshlq_n_u8(g1, 4), b1);
+    vst3q_u8(dst, out);
+  }
+  ZLCD_pack_rgb444_dithered_scalar(dst, src, count, x, y);
+}
+#else
+void ZLCD_pack_rgb444(uint8_t *dst, const uint8_t *src, size_t count) {
+  ZLCD_pack_rgb444_scalar(dst, src, count);
+}
+
+void ZLCD_pack_rgb444_dithered(uint8_t *dst, const uint8_t *src, size_t count,
+                               uint16_t x, uint16_t y) {
+  ZLCD_pack_rgb444_dithered_scalar(dst, src, count, x, y);
+}
+#endif
@@ -0,0 +1,34 @@
+#ifndef ZYNQ_LCD_PACK_H
+#define ZYNQ_LCD_PACK_H
+/****************************************************************************
+Pixel packing for the 12-bit (RGB444) transmit format. The frame buffers stay
+RGB565, a refresh packs what it sends from the MSB-first (wire order) bytes of
+GRAM_previous into 3 bytes for every 2 pixels:
+  R0G0 B0R1 G1B1 (4 bits each, first pixel in the high nibbles)
+*****************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+count pixels (even) of wire order RGB565 at src to count * 3 / 2 bytes at dst,
+keeping the top 4 bits of every channel. Uses NEON (vld4/vst3, 32 pixels per
+pass) when built with NEON (-mfpu=neon-vfpv3), otherwise the scalar version
+*/
+void ZLCD_pack_rgb444(uint8_t *dst, const uint8_t *src, size_t count);
+void ZLCD_pack_rgb444_scalar(uint8_t *dst, const uint8_t *src, size_t count);
+
+/*
+same with a 4x4 ordered (Bayer) dither applied before the bits are dropped, so
+gradients do not band. x (even) and y are the frame coordinates of the first
+pixel, the pattern is fixed to the frame so a pixel always packs the same way
+*/
+void ZLCD_pack_rgb444_dithered(uint8_t *dst, const uint8_t *src, size_t count,
+                               uint16_t x, uint16_t y);
+void ZLCD_pack_rgb444_dithered_scalar(uint8_t *dst, const uint8_t *src,
+                                      size_t count, uint16_t x, uint16_t y);
+
+// bytes on the wire for count (even) packed pixels
+#define ZLCD_PACK_RGB444_BYTES(count) ((count) / 2U * 3U)
+
+#endif // ZYNQ_LCD_PACK_H
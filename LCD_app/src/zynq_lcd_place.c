@@ -0,0 +1,232 @@
+#include "zynq_lcd_place.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <xil_cache.h>
+#include <xil_cache_l.h>
+#include <xil_io.h>
+#include <xl2cc.h>
+
+/*************************************************
+  working set placement for the ST7789VW driver
+**************************************************/
+
+// PL310 registers xl2cc.h has no name for (the lockdown ones)
+#ifndef XPS_L2CC_BASEADDR
+#define XPS_L2CC_BASEADDR 0xF8F02000U
+#endif
+#ifndef XPS_L2CC_CNTRL_OFFSET
+#define XPS_L2CC_CNTRL_OFFSET 0x0100U
+#endif
+#ifndef XPS_L2CC_DATA_LOCKDOWN_0_OFFSET
+#define XPS_L2CC_DATA_LOCKDOWN_0_OFFSET 0x0900U
+#endif
+#ifndef XPS_L2CC_INST_LOCKDOWN_0_OFFSET
+#define XPS_L2CC_INST_LOCKDOWN_0_OFFSET 0x0904U
+#endif
+#define ZLCD_L2_ALL_WAYS ((1U << ZLCD_L2_WAYS) - 1U)
+
+#if defined(__arm__)
+#define ZLCD_PLACE_BARRIER() __asm__ volatile("dsb" ::: "memory")
+#else
+#define ZLCD_PLACE_BARRIER() __asm__ volatile("" ::: "memory")
+#endif
+
+/*
+Section bounds, set in lscript.ld (on the host the linker makes them up for
+the sections that exist). Weak, so a section nothing went into has none.
+*/
+#define ZLCD_SECTION_BOUNDS(name)                                              \
+  extern uint8_t __start_##name[] __attribute__((weak));                      \
+  extern uint8_t __stop_##name[] __attribute__((weak))
+ZLCD_SECTION_BOUNDS(zlcd_ocm_text);
+ZLCD_SECTION_BOUNDS(zlcd_ocm_rodata);
+ZLCD_SECTION_BOUNDS(zlcd_ocm_bss);
+ZLCD_SECTION_BOUNDS(zlcd_l2_text);
+ZLCD_SECTION_BOUNDS(zlcd_l2_rodata);
+ZLCD_SECTION_BOUNDS(zlcd_l2_bss);
+// where the loader put the OCM code and fonts, in DDR. None on the host
+extern uint8_t __zlcd_ocm_text_load[] __attribute__((weak));
+extern uint8_t __zlcd_ocm_rodata_load[] __attribute__((weak));
+
+typedef struct {
+  uintptr_t start, end;
+} ZLCD_l2_range;
+
+static bool placed = false;
+static ZLCD_placement current_placement;
+
+static inline size_t ZLCD_section_bytes(const uint8_t *start,
+                                        const uint8_t *stop) {
+  return start != NULL && stop != NULL ? (size_t)(stop - start) : 0;
+}
+
+static void ZLCD_load_ocm(uint8_t *start, uint8_t *stop, const uint8_t *load,
+                          bool code) {
+  size_t num_bytes = ZLCD_section_bytes(start, stop);
+  if (num_bytes == 0) {
+    return;
+  }
+  if (load != NULL && load != start) {
+    memcpy(start, load, num_bytes);
+  }
+  // out to the OCM, and no stale instructions from before the copy
+  Xil_DCacheFlushRange((INTPTR)start, num_bytes);
+  if (code) {
+    Xil_ICacheInvalidateRange((INTPTR)start, num_bytes);
+  }
+  current_placement.ocm_bytes += num_bytes;
+}
+
+// the loader leaves NOLOAD sections alone, crt0 only zeroes .bss
+static size_t ZLCD_zero_section(uint8_t *start, uint8_t *stop) {
+  size_t num_bytes = ZLCD_section_bytes(start, stop);
+  if (num_bytes != 0) {
+    memset(start, 0, num_bytes);
+  }
+  return num_bytes;
+}
+
+// adds start to end - 1 in whole lines, merged with the range before it
+static size_t ZLCD_add_l2_range(ZLCD_l2_range *ranges, size_t num_ranges,
+                                const uint8_t *start, const uint8_t *stop) {
+  if (ZLCD_section_bytes(start, stop) == 0) {
+    return num_ranges;
+  }
+  uintptr_t first = (uintptr_t)start & ~(uintptr_t)(ZLCD_L2_LINE_BYTES - 1U);
+  uintptr_t end = ((uintptr_t)stop + ZLCD_L2_LINE_BYTES - 1U) &
+                  ~(uintptr_t)(ZLCD_L2_LINE_BYTES - 1U);
+  if (num_ranges != 0 && ranges[num_ranges - 1].end >= first &&
+      ranges[num_ranges - 1].start <= first) {
+    if (end > ranges[num_ranges - 1].end) {
+      ranges[num_ranges - 1].end = end;
+    }
+    return num_ranges;
+  }
+  ranges[num_ranges] = (ZLCD_l2_range){first, end};
+  return num_ranges + 1;
+}
+
+/*
+Lockdown by way: with every other way locked, the lines read in can only be
+allocated to the one way left, which is then locked as well. 64 KB of
+consecutive lines is one line in every set, so a way takes up to that much of
+one range. Lines the preload itself pushes out (its stack) are only cached
+the normal way. Whatever cleans and invalidates the locked lines by address
+drops them from the L2 too, so the driver only cleans them
+(ZLCD_dcache_store_range()) before a DMA transfer or CPU1 reads them.
+*/
+static bool ZLCD_lock_l2(void) {
+  ZLCD_l2_range ranges[3];
+  size_t num_ranges = 0;
+  num_ranges = ZLCD_add_l2_range(ranges, num_ranges, __start_zlcd_l2_text,
+                                 __stop_zlcd_l2_text);
+  num_ranges = ZLCD_add_l2_range(ranges, num_ranges, __start_zlcd_l2_rodata,
+                                 __stop_zlcd_l2_rodata);
+  num_ranges = ZLCD_add_l2_range(ranges, num_ranges, __start_zlcd_l2_bss,
+                                 __stop_zlcd_l2_bss);
+  if (num_ranges == 0) {
+    return true;
+  }
+  uint32_t ways_needed = 0;
+  size_t num_bytes = 0;
+  for (size_t i = 0; i < num_ranges; i++) {
+    size_t length = ranges[i].end - ranges[i].start;
+    ways_needed += (length + ZLCD_L2_WAY_BYTES - 1U) / ZLCD_L2_WAY_BYTES;
+    num_bytes += length;
+  }
+  if ((Xil_In32(XPS_L2CC_BASEADDR + XPS_L2CC_CNTRL_OFFSET) & 0x1U) == 0) {
+    printf("ERROR: the L2 cache is off, nothing to lock\n");
+    return false;
+  }
+  uint32_t locked =
+      Xil_In32(XPS_L2CC_BASEADDR + XPS_L2CC_DATA_LOCKDOWN_0_OFFSET) &
+      ZLCD_L2_ALL_WAYS;
+  uint32_t free_ways = ZLCD_L2_WAYS - (uint32_t)__builtin_popcount(locked);
+  uint32_t lockable = free_ways < ZLCD_L2_LOCK_WAYS ? free_ways
+                                                    : ZLCD_L2_LOCK_WAYS;
+  if (ways_needed > lockable) {
+    printf("ERROR: %lu bytes need %lu L2 ways, %lu can be locked\n",
+           (unsigned long)num_bytes, (unsigned long)ways_needed,
+           (unsigned long)lockable);
+    return false;
+  }
+
+  // written back and out of every way first, so each line is read in again
+  for (size_t i = 0; i < num_ranges; i++) {
+    Xil_DCacheFlushRange((INTPTR)ranges[i].start,
+                         (u32)(ranges[i].end - ranges[i].start));
+  }
+  for (size_t i = 0; i < num_ranges; i++) {
+    for (uintptr_t chunk = ranges[i].start; chunk < ranges[i].end;
+         chunk += ZLCD_L2_WAY_BYTES) {
+      uintptr_t chunk_end = ranges[i].end - chunk > ZLCD_L2_WAY_BYTES
+                                ? chunk + ZLCD_L2_WAY_BYTES
+                                : ranges[i].end;
+      uint32_t way = (uint32_t)__builtin_ctz(~locked);
+      uint32_t others = ZLCD_L2_ALL_WAYS & ~(1U << way);
+      Xil_Out32(XPS_L2CC_BASEADDR + XPS_L2CC_DATA_LOCKDOWN_0_OFFSET, others);
+      Xil_Out32(XPS_L2CC_BASEADDR + XPS_L2CC_INST_LOCKDOWN_0_OFFSET, others);
+      ZLCD_PLACE_BARRIER();
+      for (uintptr_t line = chunk; line < chunk_end;
+           line += ZLCD_L2_LINE_BYTES) {
+        (void)*(volatile const uint32_t *)line;
+      }
+      ZLCD_PLACE_BARRIER();
+      locked |= 1U << way;
+      current_placement.l2_ways |= (uint8_t)(1U << way);
+    }
+  }
+  Xil_Out32(XPS_L2CC_BASEADDR + XPS_L2CC_DATA_LOCKDOWN_0_OFFSET, locked);
+  Xil_Out32(XPS_L2CC_BASEADDR + XPS_L2CC_INST_LOCKDOWN_0_OFFSET, locked);
+  ZLCD_PLACE_BARRIER();
+  current_placement.l2_bytes = (uint32_t)num_bytes;
+  return true;
+}
+
+bool ZLCD_place_working_set(void) {
+  if (placed) {
+    return true;
+  }
+  current_placement = (ZLCD_placement){0};
+  ZLCD_load_ocm(__start_zlcd_ocm_text, __stop_zlcd_ocm_text,
+                __zlcd_ocm_text_load, true);
+  ZLCD_load_ocm(__start_zlcd_ocm_rodata, __stop_zlcd_ocm_rodata,
+                __zlcd_ocm_rodata_load, false);
+  current_placement.ocm_bytes +=
+      ZLCD_zero_section(__start_zlcd_ocm_bss, __stop_zlcd_ocm_bss);
+  ZLCD_zero_section(__start_zlcd_l2_bss, __stop_zlcd_l2_bss);
+  if (!ZLCD_lock_l2()) {
+    return false;
+  }
+  placed = true;
+  return true;
+}
+
+void ZLCD_get_placement(ZLCD_placement *placement) {
+  if (placement != NULL) {
+    *placement = current_placement;
+  }
+}
+
+void ZLCD_dcache_store_range(const void *start, size_t num_bytes) {
+  uintptr_t line = (uintptr_t)start & ~(uintptr_t)(ZLCD_L2_LINE_BYTES - 1U);
+  uintptr_t end = (uintptr_t)start + num_bytes;
+  // the BSP cleans by line only, Xil_DCacheStoreLine() does L1 then L2
+  for (; line < end; line += ZLCD_L2_LINE_BYTES) {
+    Xil_DCacheStoreLine((u32)line);
+  }
+}
+
+const char *ZLCD_memory_name(int memory) {
+  switch (memory) {
+  case ZLCD_MEMORY_DDR:
+    return "ddr";
+  case ZLCD_MEMORY_OCM:
+    return "ocm";
+  case ZLCD_MEMORY_L2_LOCKED:
+    return "l2_locked";
+  default:
+    return "unknown";
+  }
+}
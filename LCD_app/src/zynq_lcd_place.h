@@ -0,0 +1,102 @@
+#ifndef ZYNQ_LCD_PLACE_H
+#define ZYNQ_LCD_PLACE_H
+/****************************************************************************
+Where the driver's working set lives. lscript.ld puts everything in DDR, the
+groups below can be moved out of it one by one:
+
+  ZLCD_FRAME_MEMORY        the first frame buffer, which ZLCD_BUFFER_COPY draws
+                           in and ZLCD_BUFFER_HASHED's only one (110080 bytes)
+  ZLCD_SPARE_FRAME_MEMORY  the other ZLCD_MAX_FRAME_BUFFERS - 1 frames
+  ZLCD_WORK_MEMORY         dirty spans, refresh plan, stale spans, tile digests,
+                           fill stream, the band buffer, the indexed send
+                           buffer and the layer scratch rows
+  ZLCD_FONT_MEMORY         glyph bitmaps and descriptors tagged ZLCD_FONT_DATA
+  ZLCD_CODE_MEMORY         the GRAM store / compare / commit loops, the drawing
+                           kernels, the span fills, the tile hash and the
+                           blend kernels
+
+each set to one of
+
+  ZLCD_MEMORY_DDR        where the linker puts everything else (default)
+  ZLCD_MEMORY_OCM        the 192 KB of on chip memory at 0x0. Only one frame
+                         fits next to the rest
+  ZLCD_MEMORY_L2_LOCKED  DDR, with its lines loaded into ways of the PL310 L2
+                         cache that are then locked, so nothing evicts them
+
+The groups go into named sections (zlcd_ocm_*, zlcd_l2_*) that lscript.ld
+places. ZLCD_init() copies the OCM code and fonts in from their load address,
+zeroes the OCM and L2 data and locks the L2 lines, before anything else runs.
+Hot code and fonts in OCM can only be called / read after that.
+*****************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ZLCD_MEMORY_DDR 0
+#define ZLCD_MEMORY_OCM 1
+#define ZLCD_MEMORY_L2_LOCKED 2
+
+#ifndef ZLCD_FRAME_MEMORY
+#define ZLCD_FRAME_MEMORY ZLCD_MEMORY_DDR
+#endif
+#ifndef ZLCD_SPARE_FRAME_MEMORY
+#define ZLCD_SPARE_FRAME_MEMORY ZLCD_MEMORY_DDR
+#endif
+#ifndef ZLCD_WORK_MEMORY
+#define ZLCD_WORK_MEMORY ZLCD_MEMORY_DDR
+#endif
+#ifndef ZLCD_FONT_MEMORY
+#define ZLCD_FONT_MEMORY ZLCD_MEMORY_DDR
+#endif
+#ifndef ZLCD_CODE_MEMORY
+#define ZLCD_CODE_MEMORY ZLCD_MEMORY_DDR
+#endif
+
+// L2 ways ZLCD_init() may lock, of the 8 (64 KB each)
+#ifndef ZLCD_L2_LOCK_WAYS
+#define ZLCD_L2_LOCK_WAYS 4U
+#endif
+#define ZLCD_L2_WAYS 8U
+#define ZLCD_L2_WAY_BYTES 65536U
+#define ZLCD_L2_LINE_BYTES 32U
+
+// the memories are plain numbers so they can be pasted into a section name
+#define ZLCD_SECTION_0(kind)
+#define ZLCD_SECTION_1(kind) __attribute__((section("zlcd_ocm_" kind)))
+#define ZLCD_SECTION_2(kind) __attribute__((section("zlcd_l2_" kind)))
+#define ZLCD_SECTION_(memory, kind) ZLCD_SECTION_##memory(kind)
+#define ZLCD_SECTION(memory, kind) ZLCD_SECTION_(memory, kind)
+
+// on zero-initialized arrays, never on anything with an initializer
+#define ZLCD_FRAME_DATA ZLCD_SECTION(ZLCD_FRAME_MEMORY, "bss")
+#define ZLCD_SPARE_FRAME_DATA ZLCD_SECTION(ZLCD_SPARE_FRAME_MEMORY, "bss")
+#define ZLCD_WORK_DATA ZLCD_SECTION(ZLCD_WORK_MEMORY, "bss")
+// on const font arrays, define them in one file only
+#define ZLCD_FONT_DATA ZLCD_SECTION(ZLCD_FONT_MEMORY, "rodata")
+// on functions only reached once the LCD is initialized
+#define ZLCD_HOT_CODE ZLCD_SECTION(ZLCD_CODE_MEMORY, "text")
+
+typedef struct {
+  uint32_t ocm_bytes; // copied or zeroed into the OCM
+  uint32_t l2_bytes;  // locked into the L2, whole lines
+  uint8_t l2_ways;    // mask of the ways locked
+} ZLCD_placement;
+
+/*
+Moves the groups where they were configured, once. false (with an error
+printed) if the L2 lines do not fit in ZLCD_L2_LOCK_WAYS free ways.
+Called by ZLCD_init().
+*/
+bool ZLCD_place_working_set(void);
+void ZLCD_get_placement(ZLCD_placement *placement);
+// "ddr", "ocm" or "l2_locked"
+const char *ZLCD_memory_name(int memory);
+/*
+Writes the data cache lines of num_bytes from start back to DDR (L1 and L2),
+for a DMA master or CPU1 to read. Unlike Xil_DCacheFlushRange() it does not
+invalidate them, so lines locked into the L2 stay there.
+*/
+void ZLCD_dcache_store_range(const void *start, size_t num_bytes);
+
+#endif // ZYNQ_LCD_PLACE_H
@@ -0,0 +1,117 @@
+#include "zynq_lcd_planner.h"
+
+/*************************************************
+  refresh window planner for the ST7789VW driver
+**************************************************/
+
+// a command or a parameter block is its own transfer with a DC change in front
+#define ZLCD_PLAN_COMMAND_COST                                                 \
+  (1U + ZLCD_PLAN_TRANSFER_COST + ZLCD_PLAN_DC_TOGGLE_COST)
+#define ZLCD_PLAN_PARAMETER_COST                                               \
+  (4U + ZLCD_PLAN_TRANSFER_COST + ZLCD_PLAN_DC_TOGGLE_COST)
+
+static bool ZLCD_plan_can_continue(const ZLCD_plan_state *state,
+                                   const ZLCD_plan_entry *entry) {
+  return state->pointer_row != ZLCD_PLAN_UNKNOWN &&
+         state->pointer_row == entry->y0 && state->col_start == entry->x0 &&
+         state->col_end == entry->x1 && state->row_start <= entry->y0;
+}
+
+static void ZLCD_plan_apply(ZLCD_plan_state *state,
+                            const ZLCD_plan_entry *entry) {
+  if (!entry->continue_write) {
+    state->col_start = entry->x0;
+    state->col_end = entry->x1;
+    state->row_start = entry->y0;
+  }
+  // past the last row the pointer wraps back to row_start, don't rely on it
+  state->pointer_row =
+      entry->y1 + 1U < state->height ? entry->y1 + 1U : ZLCD_PLAN_UNKNOWN;
+}
+
+uint32_t ZLCD_plan_entry_cost(const ZLCD_plan_state *state,
+                              const ZLCD_plan_entry *entry) {
+  uint32_t width = entry->x1 - entry->x0 + 1U;
+  uint32_t height = entry->y1 - entry->y0 + 1U;
+  uint32_t cost;
+  if (entry->continue_write) {
+    cost = ZLCD_PLAN_COMMAND_COST; // RAMWRC
+  } else {
+    cost = ZLCD_PLAN_COMMAND_COST; // RAMWR
+    if (state->col_start != entry->x0 || state->col_end != entry->x1) {
+      cost += ZLCD_PLAN_COMMAND_COST + ZLCD_PLAN_PARAMETER_COST; // CASET
+    }
+    if (state->row_start != entry->y0) {
+      cost += ZLCD_PLAN_COMMAND_COST + ZLCD_PLAN_PARAMETER_COST; // RASET
+    }
+  }
+  // full width rows are contiguous in the GRAM and go out in one transfer,
+  // packed rows are packed back to back and always do
+  uint32_t transfers =
+      width == state->width || state->bits_per_pixel != 16U ? 1U : height;
+  cost += ZLCD_PLAN_DC_TOGGLE_COST + transfers * ZLCD_PLAN_TRANSFER_COST;
+  cost += width * height * state->bits_per_pixel / 8U;
+  return cost;
+}
+
+static ZLCD_plan_entry ZLCD_plan_make_entry(const ZLCD_plan_state *state,
+                                            uint16_t x0, uint16_t x1,
+                                            uint16_t y0, uint16_t y1) {
+  ZLCD_plan_entry entry = {
+      .x0 = x0, .x1 = x1, .y0 = y0, .y1 = y1, .continue_write = false};
+  entry.continue_write = ZLCD_plan_can_continue(state, &entry);
+  return entry;
+}
+
+size_t ZLCD_plan_windows(const uint16_t x_start[ZLCD_HEIGHT],
+                         const uint16_t x_end[ZLCD_HEIGHT], uint16_t y_start,
+                         uint16_t y_end, ZLCD_plan_state *state,
+                         ZLCD_plan_entry *entries, size_t max_entries) {
+  size_t num_entries = 0;
+  bool have_current = false;
+  ZLCD_plan_entry current = {0};
+
+  if (y_end > state->height) {
+    y_end = state->height;
+  }
+  for (uint16_t y = y_start; y < y_end; y++) {
+    if (x_end[y] == 0) {
+      continue;
+    }
+    uint16_t x0 = x_start[y];
+    uint16_t x1 = x_end[y] - 1;
+    if (!have_current) {
+      current = ZLCD_plan_make_entry(state, x0, x1, y, y);
+      have_current = true;
+      continue;
+    }
+    /*
+    Either grow the current rectangle down to this row (sending any clean rows
+    in between and the widened columns again), or close it and open a new
+    window for this row. Greedy, but both sides are costed from the same state.
+    */
+    ZLCD_plan_entry merged = ZLCD_plan_make_entry(
+        state, x0 < current.x0 ? x0 : current.x0,
+        x1 > current.x1 ? x1 : current.x1, current.y0, y);
+    uint32_t merge_cost = ZLCD_plan_entry_cost(state, &merged);
+
+    ZLCD_plan_state after_current = *state;
+    ZLCD_plan_apply(&after_current, &current);
+    ZLCD_plan_entry split = ZLCD_plan_make_entry(&after_current, x0, x1, y, y);
+    uint32_t split_cost = ZLCD_plan_entry_cost(state, &current) +
+                          ZLCD_plan_entry_cost(&after_current, &split);
+
+    if (merge_cost <= split_cost || num_entries + 1 >= max_entries) {
+      current = merged;
+      continue;
+    }
+    entries[num_entries++] = current;
+    *state = after_current;
+    current = split;
+  }
+  if (have_current && num_entries < max_entries) {
+    entries[num_entries++] = current;
+    ZLCD_plan_apply(state, &current);
+  }
+  return num_entries;
+}
@@ -0,0 +1,61 @@
+#ifndef ZYNQ_LCD_PLANNER_H
+#define ZYNQ_LCD_PLANNER_H
+/****************************************************************************
+Transmit window planner for the ZLCD driver. Turns the changed column span of
+every row into the list of windows a refresh sends, deciding with a simple cost
+model whether neighbouring rows are merged into one rectangle or split up.
+*****************************************************************************/
+
+#include "zynq_lcd_st7789.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+Costs are in "byte times" on the SPI bus so they can be compared with pixel
+data directly. Starting a transfer (chip select, FIFO drain) and toggling the
+DC pin over AXI GPIO both stall the bus for roughly as long as a few bytes take
+to shift out. Override with -D if the SPI clock changes.
+*/
+#ifndef ZLCD_PLAN_TRANSFER_COST
+#define ZLCD_PLAN_TRANSFER_COST 8U
+#endif
+#ifndef ZLCD_PLAN_DC_TOGGLE_COST
+#define ZLCD_PLAN_DC_TOGGLE_COST 2U
+#endif
+
+#define ZLCD_PLAN_UNKNOWN 0xFFFFU
+
+/*
+What the ST7789 is set up for before the plan runs, in frame pixels (no address
+offset). Rows are always set open ended (row_start up to the last row) so the
+write pointer can be continued into the rows below with RAMWRC.
+*/
+typedef struct {
+  uint16_t col_start, col_end; // ZLCD_PLAN_UNKNOWN if not known
+  uint16_t row_start;          // ZLCD_PLAN_UNKNOWN if not known
+  uint16_t pointer_row;        // next row RAMWRC would write to
+  // frame size, portrait unless the ST7789 does the rotation
+  uint16_t width, height;
+  // 16, or 12 when packed RGB444 is sent (always one transfer per window)
+  uint8_t bits_per_pixel;
+} ZLCD_plan_state;
+
+/*
+Plans the windows for the rows y_start to y_end - 1 (at most state->height).
+Row y is clean when x_end[y] is 0, otherwise pixels x_start[y] to x_end[y] - 1
+have to be sent. state is updated to what the controller looks like after the
+plan has run.
+Returns the number of entries written (at most max_entries, one per dirty row
+is always enough).
+*/
+size_t ZLCD_plan_windows(const uint16_t x_start[ZLCD_HEIGHT],
+                         const uint16_t x_end[ZLCD_HEIGHT], uint16_t y_start,
+                         uint16_t y_end, ZLCD_plan_state *state,
+                         ZLCD_plan_entry *entries, size_t max_entries);
+
+// bus cost of sending entry from state (commands, DC toggles and pixels)
+uint32_t ZLCD_plan_entry_cost(const ZLCD_plan_state *state,
+                              const ZLCD_plan_entry *entry);
+
+#endif // ZYNQ_LCD_PLANNER_H
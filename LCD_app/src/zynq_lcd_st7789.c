@@ -1,9 +1,22 @@
 #include "zynq_lcd_st7789.h"
+#include "zynq_lcd_amp.h"
+#include "zynq_lcd_async.h"
+#include "zynq_lcd_dma.h"
+#include "zynq_lcd_fifo.h"
+#include "zynq_lcd_fill.h"
+#include "zynq_lcd_hash.h"
+#include "zynq_lcd_pack.h"
+#include "zynq_lcd_place.h"
+#include "zynq_lcd_planner.h"
+#include "zynq_lcd_stats.h"
+#include "zynq_lcd_vsync.h"
 #include <sleep.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <xgpio_l.h>
+#include <xiltimer.h>
+#include <xinterrupt_wrap.h>
 #include <xparameters.h>
 #include <xpseudo_asm_gcc.h>
 #include <xspips.h>
@@ -26,6 +39,10 @@ in the hardware configuration. It is pulled up and driven high.
 // Memory Access Data control RGB/BGR flags
 #define ST7789_MADCTL_RGB 0x00
 #define ST7789_MADCTL_BGR 0x08
+// row/column order and exchange, used by ZLCD_ROTATE_MADCTL
+#define ST7789_MADCTL_MY 0x80
+#define ST7789_MADCTL_MX 0x40
+#define ST7789_MADCTL_MV 0x20
 
 // ST7789VW memory is 240 x 320, but the LCD is 172 x 320
 #define ZLCD_X_OFFSET 34U // (240 - 172) / 2
@@ -43,7 +60,49 @@ typedef enum {
   SLEEP_OUT_MODE // not sleeping
 } ZLCD_SLEEP_MODE;
 
-typedef size_t (*pixel_transform_function)(uint16_t x, uint16_t y);
+/*
+Drawing kernels of one orientation, generated from zynq_lcd_kernels.h. The table
+is picked once in ZLCD_set_orientation(), the index math inside every kernel is
+fixed at compile time, so their loops have no orientation switch and no
+indirect call per pixel.
+*/
+typedef struct {
+  size_t (*index)(uint16_t x, uint16_t y); // GRAM byte index, no bounds check
+  // the ones below clip to the screen, line and circle also mark what they set
+  void (*line)(int16_t x1, int16_t y1, int16_t x2, int16_t y2, rgb565 colour);
+  void (*circle)(int16_t origin_x, int16_t origin_y, int16_t radius,
+                 rgb565 colour);
+  void (*glyph)(const uint8_t *bitmap, int16_t x0, int16_t y0, int16_t box_w,
+                int16_t box_h, rgb565 colour);
+  void (*blit)(const uint8_t *map, uint16_t map_width, uint16_t source_x,
+               uint16_t source_y, uint16_t x0, uint16_t y0, uint16_t width,
+               uint16_t height);
+  // GRAM pixels from one pixel to the next along x (a span) and y
+  int32_t x_step, y_step;
+  uint16_t width, height; // screen size in this orientation
+  // GRAM layout the kernels draw into, rows are frame_width pixels apart
+  uint16_t frame_width, frame_height;
+} ZLCD_orientation_kernels;
+
+/*
+How ZLCD_ROTATE_MADCTL sets up the ST7789 for one orientation: the kernels for
+the frame, the MADCTL value and the column/row address of frame pixel (0, 0)
+*/
+typedef struct {
+  const ZLCD_orientation_kernels *kernels;
+  uint8_t madctl;
+  uint16_t col_offset, row_offset;
+} ZLCD_madctl_layout;
+
+/*
+The commands of one ZLCD_set_window() call and their parameters: CASET and RASET
+(only when the address changed) and RAMWR, at most 1 + 4 + 1 + 4 + 1 bytes
+*/
+typedef struct {
+  uint8_t bytes[11];
+  uint8_t length;
+  uint16_t commands; // bit i is set when bytes[i] is a command (DC low)
+} ZLCD_window_packet;
 
 typedef struct {
   uint16_t horizontal_axis_length_px, vertical_axis_length_px;
@@ -86,13 +145,76 @@ typedef struct {
 ********************************/
 
 static XGpio LCD_gpios;
+// DC pin/reset/backlight GPIO bus as last written by the built in transports
+static uint32_t builtin_gpio_values;
 static XSpiPs spi_instance;
+static XDmaPs dma_instance;
+static ZLCD_dma_transfer dma_transfer;
+// a DMA write of the built in transport failed, kept until a refresh reports it
+static ZLCD_RETURN_STATUS transport_status = ZLCD_SUCCESS;
+// one per ZLCD_TRANSMIT_MODE, defined after ZLCD_spi_init()
+static const ZLCD_transport ZLCD_builtin_transports[3];
+#ifdef ZLCD_STATIC_TRANSPORT
+// a constant, so the compiler calls the hooks directly
+#define ZLCD_TRANSPORT (&ZLCD_builtin_transports[ZLCD_STATIC_TRANSPORT])
+#else
+static const ZLCD_transport *active_transport =
+    &ZLCD_builtin_transports[ZLCD_TRANSMIT_POLLED];
+#define ZLCD_TRANSPORT active_transport
+#endif
+/*
+A refresh recorded for the async engine (async_refresh, amp_queue) leaves the
+frame it sends alone until it is out, which takes a second one. With one frame
+the refresh slots are left out and amp_queue refreshes go window by window.
+*/
+#define ZLCD_ASYNC_REFRESH (ZLCD_MAX_FRAME_BUFFERS > 1)
+#if !ZLCD_FRAMELESS
+// interrupt driven refresh state
+static bool async_refresh_enabled = false;
+// when set, sends are queued in the next slot's engine instead of transmitted
+static bool async_recording = false;
+// result of the last finished refresh
+static volatile ZLCD_RETURN_STATUS refresh_status = ZLCD_SUCCESS;
+#endif
+#if ZLCD_ASYNC_REFRESH
+/*
+A refresh handed to the async engine. ZLCD_BUFFER_TRIPLE can have two
+outstanding, the one being sent and the next one, which is started from the
+completion of the first (ZLCD_refresh_sent()).
+*/
+typedef struct {
+  ZLCD_async_engine engine;
+  ZLCD_refresh_callback callback; // the user's
+  void *user_data;
+#if ZLCD_STATS_ENABLED
+  bool record_stats; // async, ZLCD_refresh_display() records its own
+  uint64_t compare_ticks;
+  uint64_t transmit_start;
+#endif
+} ZLCD_refresh_slot;
+#define ZLCD_REFRESH_SLOTS (ZLCD_MAX_FRAME_BUFFERS > 2 ? 2U : 1U)
+static ZLCD_refresh_slot refresh_slots[ZLCD_REFRESH_SLOTS];
+// the slot the next refresh is recorded into, they are used in turn
+static uint8_t next_slot = 0;
+// handed to the engine and not finished yet
+static _Atomic uint32_t refreshes_pending;
+// on the bus (or with CPU1), NULL while nothing is
+static ZLCD_refresh_slot *_Atomic sending_slot;
+// recorded and waiting for sending_slot to finish
+static ZLCD_refresh_slot *_Atomic queued_slot;
+#endif
+#if ZLCD_ASYNC_REFRESH || !defined(ZLCD_STATIC_TRANSPORT)
+// CPU0 end of ZLCD_config.amp_queue, queue is NULL when CPU0 sends itself
+static ZLCD_amp_client amp_client;
+#endif
 // tracks current orientation data
 static ZLCD_orientation_parameters current_orientation = {0};
 
+#if !ZLCD_FRAMELESS
 static ZLCD_PRINTF_MODE current_printf_mode = ZLCD_PRINTF_MODE_SCROLL;
-// tracks current state of DC pin/reset/backlight GPIO bus
-static uint32_t current_gpio_values;
+#endif
+// level of every ZLCD_PIN (bit ZLCD_PIN_DC etc.) as last set
+static uint32_t current_pin_levels;
 static ZLCD_SLEEP_MODE current_sleep_mode;
 
 static bool ZLCD_initialized = false; // has the user initialized yet?
@@ -101,9 +223,17 @@ static uint16_t cached_col_start = 0xFFFF;
 static uint16_t cached_col_end = 0xFFFF;
 static uint16_t cached_row_start = 0xFFFF;
 static uint16_t cached_row_end = 0xFFFF;
+// row the RAMWR/RAMWRC write pointer is on after a refresh (0xFFFF = unknown)
+static uint16_t cached_pointer_row = 0xFFFF;
 static rgb565 current_background_colour;
 
-static pixel_transform_function current_transform_fun = NULL;
+static const ZLCD_orientation_kernels *current_kernels = NULL;
+static ZLCD_ROTATION_MODE current_rotation_mode = ZLCD_ROTATE_SOFTWARE;
+static uint8_t current_madctl = ST7789_MADCTL_RGB;
+static ZLCD_PIXEL_FORMAT current_pixel_format = ZLCD_PIXEL_RGB565;
+// ST7789 column and row address of frame pixel (0, 0)
+static uint16_t frame_col_offset = ZLCD_X_OFFSET;
+static uint16_t frame_row_offset = ZLCD_Y_OFFSET;
 
 // ZLCD_printf cursor index
 static uint16_t printf_y = 0, printf_x = 0;
@@ -130,34 +260,428 @@ Therefore, every two consecutive bytes of the GRAM array represent one single
 rgb565 pixel, and must be ordered MSB-first
 
 Each GRAM image is 110.08 Kbytes long
-The GRAM images are ALWAYS configured for portrait mode even if the user selects
-another mode
+The GRAM images are configured for portrait mode whatever mode the user selects,
+unless the ST7789 does the rotation (ZLCD_ROTATE_MADCTL). Then they hold the
+screen the way the user sees it, 320 pixels per row in the landscape modes
+
+With ZLCD_NATIVE_ENDIAN_GRAM the drawing side (GRAM_current) holds native
+rgb565 words instead and the swap happens in ZLCD_gram_commit(). GRAM_previous
+is what was sent last and is always in wire order, it is what SPI/DMA reads.
+Indexes are byte offsets in both layouts so the drawing code is shared.
+
+Both point into the frame buffers, GRAM_buffer(0) to
+GRAM_buffer(ZLCD_MAX_FRAME_BUFFERS - 1). ZLCD_BUFFER_COPY keeps them on the
+first two, the swap modes trade them around on every refresh instead
+(ZLCD_swap_buffers()). ZLCD_BUFFER_HASHED points both at the first one and
+keeps tile digests of what the LCD shows instead (tile_digest). The first one
+is placed on its own (ZLCD_FRAME_MEMORY), the OCM has room for one frame only.
+A ZLCD_FRAMELESS build has none of it.
 ***************************************************************************************************/
-static uint8_t GRAM_current[ZLCD_WIDTH * ZLCD_HEIGHT * sizeof(rgb565)];
-static uint8_t GRAM_previous[ZLCD_WIDTH * ZLCD_HEIGHT * sizeof(rgb565)];
+#if ZLCD_MAX_FRAME_BUFFERS < 0
+#error "ZLCD_MAX_FRAME_BUFFERS can't be negative"
+#endif
+#if !ZLCD_FRAMELESS
+#if ZLCD_NATIVE_ENDIAN_GRAM
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "ZLCD_NATIVE_ENDIAN_GRAM expects a little endian CPU"
+#endif
+typedef rgb565 ZLCD_gram_frame[ZLCD_WIDTH * ZLCD_HEIGHT];
+typedef rgb565 ZLCD_gram_word;
+#else
+typedef uint8_t ZLCD_gram_frame[ZLCD_WIDTH * ZLCD_HEIGHT * sizeof(rgb565)];
+typedef uint8_t ZLCD_gram_word;
+#endif
+static ZLCD_gram_frame GRAM_first_frame ZLCD_FRAME_DATA;
+#if ZLCD_MAX_FRAME_BUFFERS > 1
+static ZLCD_gram_frame GRAM_spare_frames[ZLCD_MAX_FRAME_BUFFERS - 1]
+    ZLCD_SPARE_FRAME_DATA;
+#endif
+static ZLCD_gram_word *GRAM_current = GRAM_first_frame;
+#if ZLCD_MAX_FRAME_BUFFERS > 1
+static ZLCD_gram_word *GRAM_previous = GRAM_spare_frames[0];
+#else
+static ZLCD_gram_word *GRAM_previous = GRAM_first_frame;
+#endif
+
+static inline ZLCD_gram_word *GRAM_buffer(uint8_t buffer) {
+#if ZLCD_MAX_FRAME_BUFFERS > 1
+  return buffer == 0 ? GRAM_first_frame : GRAM_spare_frames[buffer - 1];
+#else
+  (void)buffer;
+  return GRAM_first_frame;
+#endif
+}
+
+// stores colour at a GRAM byte index
+static inline ZLCD_HOT_CODE void ZLCD_gram_store(size_t index,
+                                                 rgb565 colour) {
+#if ZLCD_NATIVE_ENDIAN_GRAM
+  GRAM_current[index / sizeof(rgb565)] = colour;
+#else
+  GRAM_current[index] = (uint8_t)(colour >> 8); // MSB first
+  GRAM_current[index + 1] = (uint8_t)(colour & 0x00FF);
+#endif
+}
+
+// stores an LVGL image pixel (LSB first in the map) at a GRAM byte index
+static inline ZLCD_HOT_CODE void ZLCD_gram_store_lvgl(size_t index,
+                                                      const uint8_t *pixel) {
+#if ZLCD_NATIVE_ENDIAN_GRAM
+  GRAM_current[index / sizeof(rgb565)] = (rgb565)(pixel[0] | (pixel[1] << 8));
+#else
+  GRAM_current[index] = pixel[1];     // MSB
+  GRAM_current[index + 1] = pixel[0]; // LSB
+#endif
+}
+
+// count LVGL image pixels to consecutive pixels from a GRAM byte index on
+static inline ZLCD_HOT_CODE void
+ZLCD_gram_store_lvgl_row(size_t index, const uint8_t *pixels, uint16_t count) {
+#if ZLCD_NATIVE_ENDIAN_GRAM
+  // the map is already in native (little endian) order
+  memcpy(&GRAM_current[index / sizeof(rgb565)], pixels,
+         (size_t)count * sizeof(rgb565));
+#else
+  uint8_t *dst = &GRAM_current[index];
+  for (uint16_t i = 0; i < count; i++) {
+    dst[2 * i] = pixels[2 * i + 1];
+    dst[2 * i + 1] = pixels[2 * i];
+  }
+#endif
+}
+
+// true if the pixel at a GRAM byte index differs from what the LCD shows
+static inline ZLCD_HOT_CODE bool ZLCD_gram_changed(size_t index) {
+#if ZLCD_NATIVE_ENDIAN_GRAM
+  return __builtin_bswap16(GRAM_current[index / sizeof(rgb565)]) !=
+         GRAM_previous[index / sizeof(rgb565)];
+#else
+  return GRAM_current[index] != GRAM_previous[index] ||
+         GRAM_current[index + 1] != GRAM_previous[index + 1];
+#endif
+}
+
+// copies num_bytes at a GRAM byte index into GRAM_previous, in wire order
+static inline ZLCD_HOT_CODE void ZLCD_gram_commit(size_t index,
+                                                  size_t num_bytes) {
+  if (GRAM_previous == GRAM_current) {
+    return; // ZLCD_BUFFER_HASHED sends the frame itself
+  }
+#if ZLCD_NATIVE_ENDIAN_GRAM
+  const rgb565 *src = &GRAM_current[index / sizeof(rgb565)];
+  rgb565 *dst = &GRAM_previous[index / sizeof(rgb565)];
+  for (size_t i = 0; i < num_bytes / sizeof(rgb565); i++) {
+    dst[i] = __builtin_bswap16(src[i]); // rev16, vectorized to vrev16 by gcc
+  }
+#else
+  memcpy(&GRAM_previous[index], &GRAM_current[index], num_bytes);
+#endif
+}
+
+// copies num_bytes at a GRAM byte index back from GRAM_previous (swap modes)
+static inline ZLCD_HOT_CODE void ZLCD_gram_restore(size_t index,
+                                                   size_t num_bytes) {
+  memcpy((uint8_t *)GRAM_current + index,
+         (const uint8_t *)GRAM_previous + index, num_bytes);
+}
+
+/*
+stores the complement of num_bytes of the frame at a GRAM byte index in
+GRAM_previous, in wire order, so none of those pixels compare unchanged
+*/
+static inline ZLCD_HOT_CODE void ZLCD_gram_invert(size_t index,
+                                                  size_t num_bytes) {
+  if (GRAM_previous == GRAM_current) {
+    return; // ZLCD_BUFFER_HASHED forgets the tiles instead
+  }
+#if ZLCD_NATIVE_ENDIAN_GRAM
+  const rgb565 *src = &GRAM_current[index / sizeof(rgb565)];
+  rgb565 *dst = &GRAM_previous[index / sizeof(rgb565)];
+  for (size_t i = 0; i < num_bytes / sizeof(rgb565); i++) {
+    dst[i] = (rgb565)~__builtin_bswap16(src[i]);
+  }
+#else
+  for (size_t i = index; i < index + num_bytes; i++) {
+    GRAM_previous[i] = (uint8_t)~GRAM_current[i];
+  }
+#endif
+}
+
+// the bytes to send for a GRAM byte index, valid after ZLCD_gram_commit()
+static inline const uint8_t *ZLCD_gram_wire_bytes(size_t index) {
+  return (const uint8_t *)GRAM_previous + index;
+}
+#endif
+
+// colour the way it sits in GRAM_previous (wire order), for the fill kernels
+static inline uint16_t ZLCD_wire_pattern(rgb565 colour) {
+  const uint8_t bytes[sizeof(rgb565)] = {(uint8_t)(colour >> 8),
+                                         (uint8_t)(colour & 0x00FF)};
+  uint16_t pattern;
+  memcpy(&pattern, bytes, sizeof(pattern));
+  return pattern;
+}
+
+#if !ZLCD_FRAMELESS
+// colour the way it sits in GRAM_current, for the fill kernels
+static inline uint16_t ZLCD_gram_pattern(rgb565 colour) {
+#if ZLCD_NATIVE_ENDIAN_GRAM
+  return colour;
+#else
+  return ZLCD_wire_pattern(colour);
+#endif
+}
+
+static inline ZLCD_fill_pixel *ZLCD_gram_pixels(size_t index) {
+  return (ZLCD_fill_pixel *)((uint8_t *)GRAM_current + index);
+}
+
+/*
+fills length pixels from a GRAM byte index on, step pixels apart (+-1 along a
+row, +-frame width down a column)
+*/
+static ZLCD_HOT_CODE void ZLCD_gram_fill_run(size_t index, uint16_t length,
+                                             int32_t step, rgb565 colour) {
+  if (length == 0) {
+    return;
+  }
+  if (step == -1) {
+    // the same pixels, filled from the other end
+    index -= (size_t)(length - 1) * sizeof(rgb565);
+    step = 1;
+  }
+  if (step == 1) {
+    ZLCD_fill_span(ZLCD_gram_pixels(index), ZLCD_gram_pattern(colour), length);
+  } else {
+    ZLCD_fill_strided(ZLCD_gram_pixels(index), ZLCD_gram_pattern(colour),
+                      length, step);
+  }
+}
+
+/*
+Pixels written since the last refresh, tracked by the drawing functions so the
+refresh does not have to compare the whole GRAM. Kept in frame coordinates
+(after the orientation transform) as one column span per row. The end values
+are exclusive, so an end of 0 means clean and zero-initialized means nothing is
+dirty.
+*/
+static uint16_t dirty_x_start[ZLCD_HEIGHT] ZLCD_WORK_DATA;
+static uint16_t dirty_x_end[ZLCD_HEIGHT] ZLCD_WORK_DATA;
+static uint16_t dirty_y_start = 0;
+static uint16_t dirty_y_end = 0;
+static ZLCD_REFRESH_MODE current_refresh_mode = ZLCD_REFRESH_TRACKED;
+static ZLCD_plan_entry refresh_plan[ZLCD_HEIGHT] ZLCD_WORK_DATA;
+
+/*
+ZLCD_BUFFER_DOUBLE/TRIPLE: what every frame buffer is missing of the frame on
+the LCD, kept like the dirty spans. A refresh adds what it sends to all the
+other buffers. The one drawn into next only gets those pixels back from
+GRAM_previous where drawing does not cover them (ZLCD_repair_rows()) and before
+it is sent itself.
+*/
+typedef struct {
+  uint16_t x_start[ZLCD_HEIGHT];
+  uint16_t x_end[ZLCD_HEIGHT];
+  uint16_t y_start, y_end;
+} ZLCD_row_spans;
+static ZLCD_row_spans stale_rows[ZLCD_MAX_FRAME_BUFFERS] ZLCD_WORK_DATA;
+
+/*
+Frame rows ZLCD_write_frame_rows() sent that the GRAM has not been told about
+yet (ZLCD_settle_overwritten_rows()), so an outside canvas presented frame after
+frame never writes the GRAM itself
+*/
+static bool overwritten_rows[ZLCD_HEIGHT];
+static uint16_t overwritten_y_start = ZLCD_HEIGHT;
+static uint16_t overwritten_y_end = 0;
+static ZLCD_BUFFER_MODE current_buffer_mode = ZLCD_BUFFER_COPY;
+static uint8_t num_frame_buffers = 2;
+// GRAM_buffer() index of GRAM_current and GRAM_previous
+static uint8_t current_buffer = 0;
+static uint8_t previous_buffer = 1;
+
+/*
+ZLCD_BUFFER_HASHED: digest of every tile of the frame the way the LCD shows it,
+row-major in tiles of ZLCD_HASH_TILE_SIZE frame pixels (fewer at the right and
+bottom edges). The LCD matches the frame wherever nothing is marked dirty, so a
+refresh only has to hash the tiles the dirty spans meet. A tile that reached
+the LCD some other way (update_now writes, scrolling, orientation changes) has
+no known digest and its dirty spans go out as they are.
+*/
+#define ZLCD_HASH_MAX_TILES                                                    \
+  (ZLCD_HASH_TILES(ZLCD_WIDTH) * ZLCD_HASH_TILES(ZLCD_HEIGHT))
+static uint32_t tile_digest[ZLCD_HASH_MAX_TILES] ZLCD_WORK_DATA;
+static bool tile_known[ZLCD_HASH_MAX_TILES] ZLCD_WORK_DATA;
+
+#if ZLCD_ASYNC_REFRESH && ZLCD_ASYNC_RGB444
+/*
+A recorded refresh (async_refresh, amp_queue) with the RGB444 formats packs
+the windows it sends back to back in here (a window is one transfer), one per
+refresh slot. Like GRAM_previous it is not touched again until the refresh has
+left the SPI FIFO. Refreshes sent right away pack through fill_stream.
+*/
+static uint8_t wire_packed[ZLCD_REFRESH_SLOTS]
+                         [ZLCD_PACK_RGB444_BYTES(ZLCD_WIDTH * ZLCD_HEIGHT)];
+// bytes of wire_packed[next_slot] used by the refresh being recorded
+static size_t wire_packed_bytes;
+#endif
+#endif
+
+/*
+One colour repeated, sent over and over by ZLCD_fill_rect_xy_now(). A multiple
+of 6 bytes so it holds whole pixels and whole RGB444 pixel pairs. Also where
+ZLCD_write_frame_rows() packs its rows for the RGB444 formats.
+*/
+#define ZLCD_FILL_STREAM_BYTES 3072U
+static uint8_t fill_stream[ZLCD_FILL_STREAM_BYTES] ZLCD_WORK_DATA;
+
+static inline bool ZLCD_pixels_packed(void) {
+  return current_pixel_format != ZLCD_PIXEL_RGB565;
+}
+
+#if !ZLCD_FRAMELESS
+// rows of ZLCD_fill_rect_xy_now() that are sent, like dirty_x_start/end
+static uint16_t fill_x_start[ZLCD_HEIGHT] ZLCD_WORK_DATA;
+static uint16_t fill_x_end[ZLCD_HEIGHT] ZLCD_WORK_DATA;
+
+/*
+packs count (even) pixels from a GRAM byte index on, committed with
+ZLCD_gram_commit(). x, y are the frame coordinates of the first one
+*/
+static void ZLCD_pack_pixels(uint8_t *dst, size_t index, size_t count,
+                             uint16_t x, uint16_t y) {
+  if (current_pixel_format == ZLCD_PIXEL_RGB444_DITHERED) {
+    ZLCD_pack_rgb444_dithered(dst, ZLCD_gram_wire_bytes(index), count, x, y);
+  } else {
+    ZLCD_pack_rgb444(dst, ZLCD_gram_wire_bytes(index), count);
+  }
+}
+#endif
+
+/*
+Hardware scrolling, in frame rows. The scroll_height rows from scroll_top on
+are a ring in the LCD RAM and its row scroll_offset is shown at the top. The
+GRAM keeps what is on the screen, so screen row y of the area is LCD RAM row
+scroll_top + (y - scroll_top + scroll_offset) % scroll_height.
+*/
+static uint16_t scroll_top = 0;
+static uint16_t scroll_height = ZLCD_HEIGHT;
+static uint16_t scroll_offset = 0;
+
+#if !ZLCD_FRAMELESS
+/*
+ZLCD_config.vsync_mode. The TE clock holds when the last rising TE edge was
+seen, how many frames the panel has started since init and how long one takes
+(measured between edges, 0 until two were seen). ZLCD_vsync_te_edge() may
+update it from an interrupt, readers retry while te_sequence is odd or moves.
+*/
+static ZLCD_VSYNC_MODE current_vsync_mode = ZLCD_VSYNC_OFF;
+static _Atomic uint32_t te_sequence;
+static volatile uint64_t te_edge_ticks;
+static volatile uint32_t te_edges;
+static volatile uint32_t te_frame_ticks;
+// ZLCD_VSYNC_TE_GPIO: level at the last poll and when TE was last seen low
+static bool te_level;
+static uint64_t te_low_ticks;
+// PORCTRL in ZLCD_init_with_config(): 12 lines of back and of front porch
+#define ZLCD_PORCH_LINES 24U
+// SPI0 runs at a quarter of its reference clock, see ZLCD_spi_init()
+#define ZLCD_SPI_CLOCK_HZ (XPAR_SPI0_SPI_CLK_FREQ_HZ / 4U)
+// a byte on the wire in 1/256 ticks, nothing goes out faster
+#define ZLCD_VSYNC_WIRE_BYTE_TICKS                                             \
+  ((uint32_t)((uint64_t)COUNTS_PER_SECOND * 8U * 256U / ZLCD_SPI_CLOCK_HZ))
+#define ZLCD_VSYNC_TIMEOUT_TICKS                                               \
+  ((uint64_t)COUNTS_PER_SECOND * ZLCD_VSYNC_TIMEOUT_MS / 1000U)
+// a known edge older than this is checked against TE before it is relied on
+#define ZLCD_VSYNC_RESYNC_FRAMES 8U
+// synchronous refreshes shorter than this do not update vsync_byte_ticks
+#define ZLCD_VSYNC_MEASURE_BYTES 4096U
+// edge the last refresh was sent against, the next one needs a later edge
+static uint32_t vsync_last_edge;
+// refresh_plan entries the next ZLCD_vsync_wait() schedules, 0 for none
+static size_t vsync_entries;
+// bus time of a byte in 1/256 ticks with the gaps between transfers, measured
+static uint32_t vsync_byte_ticks;
+// bytes of the refresh ZLCD_vsync_wait() let go and when it did
+static uint32_t vsync_sent_bytes;
+static uint64_t vsync_sent_ticks;
+
+/*
+Frame scope (ZLCD_frame_begin() / ZLCD_frame_end()). update_now requests made
+inside one only set frame_present_pending, the outermost ZLCD_frame_end()
+presents once for all of them, paced to frame_period_ticks (0 for unpaced).
+*/
+static uint16_t frame_depth;
+static bool frame_present_pending;
+static uint64_t frame_begin_ticks;
+static uint64_t frame_period_ticks;
+static uint64_t frame_next_present; // 0 until the first paced present
+#endif
+
+#if ZLCD_STATS_ENABLED
+static ZLCD_stats driver_stats;
+#endif
 
 /*******************************
     STATIC FUNCTIONS HERE
 ********************************/
 
-// function pointer options based on orientation
-static size_t pixel_coordinate_to_internal_index_portrait(uint16_t x,
-                                                          uint16_t y);
-static size_t pixel_coordinate_to_internal_index_inverted_portrait(uint16_t x,
-                                                                   uint16_t y);
-static size_t pixel_coordinate_to_internal_index_landscape(uint16_t x,
-                                                           uint16_t y);
-static size_t pixel_coordinate_to_internal_index_inverted_landscape(uint16_t x,
-                                                                    uint16_t y);
-
 static ZLCD_RETURN_STATUS ZLCD_gpio_init(void);
 static ZLCD_RETURN_STATUS ZLCD_spi_init(void);
-static void ZLCD_write_gpio(uint32_t gpio_bit_mask, bool value);
+static inline void ZLCD_wait_for_bus(void);
+static inline int16_t ZLCD_scroll_shift(uint16_t y);
+#if ZLCD_FRAMELESS
+static void ZLCD_clear_lcd(rgb565 colour);
+#else
+#if ZLCD_ASYNC_REFRESH
+static ZLCD_RETURN_STATUS ZLCD_interrupt_init(void);
+#endif
+static inline void ZLCD_mark_dirty(uint16_t x0, uint16_t x1, uint16_t y0,
+                                   uint16_t y1);
+static void ZLCD_mark_dirty_rect_xy(int16_t x0, int16_t y0, int16_t x1,
+                                    int16_t y1);
+static inline void ZLCD_mark_covered(uint16_t x0, uint16_t x1, uint16_t y0,
+                                     uint16_t y1);
+static void ZLCD_mark_covered_rect_xy(int16_t x0, int16_t y0, int16_t x1,
+                                      int16_t y1);
+static inline void ZLCD_repair_rows(uint16_t x0, uint16_t x1, uint16_t y0,
+                                    uint16_t y1, bool covered);
+static void ZLCD_repair_all_rows(void);
+static void ZLCD_add_stale(uint8_t buffer, uint16_t x0, uint16_t x1,
+                           uint16_t y0, uint16_t y1);
+static void ZLCD_stale_frame(uint8_t buffer);
+static void ZLCD_mark_stale(uint16_t x0, uint16_t x1, uint16_t y0,
+                            uint16_t y1);
+static void ZLCD_settle_overwritten_rows(void);
+static void ZLCD_fill_rect_xy_internal(int16_t x0, int16_t y0, int16_t x1,
+                                       int16_t y1, rgb565 colour);
+static bool ZLCD_can_fill_now(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+static void ZLCD_fill_rect_xy_now(int16_t x0, int16_t y0, int16_t x1,
+                                  int16_t y1, rgb565 colour);
+static bool ZLCD_prepare_dirty_rows(void);
+static size_t ZLCD_plan_spans(const uint16_t *x_start, const uint16_t *x_end,
+                              uint16_t y_start, uint16_t y_end,
+                              ZLCD_plan_entry *entries, size_t max_entries);
+static void ZLCD_send_dirty_rows(void);
+static ZLCD_RETURN_STATUS ZLCD_vsync_init(void);
+static bool ZLCD_update_now(bool update_now);
+static ZLCD_RETURN_STATUS ZLCD_present(void);
+#endif
+static void ZLCD_write_pin(ZLCD_PIN pin, bool value);
+static inline void ZLCD_delay_ms(uint32_t milliseconds);
 static inline void ZLCD_write_bytes(const uint8_t *byte_stream,
                                     size_t num_bytes);
 static inline void ZLCD_send_data_byte(uint8_t data);
 static inline void ZLCD_send_data(const uint8_t *byte_stream, size_t num_bytes);
+#if !ZLCD_FRAMELESS
+static void ZLCD_send_data_rows(const uint8_t *first_row, size_t row_bytes,
+                                uint16_t rows, size_t stride);
+#endif
 static inline void ZLCD_send_command(uint8_t command);
+static inline void ZLCD_set_dc(bool data);
+static void ZLCD_send_packet(const ZLCD_window_packet *packet);
+static void ZLCD_set_window(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1);
+#if !ZLCD_FRAMELESS
 static ZLCD_RETURN_STATUS
 ZLCD_draw_triangle_internal(ZLCD_pixel_coordinate p1, ZLCD_pixel_coordinate p2,
                             ZLCD_pixel_coordinate p3, rgb565 border_colour,
@@ -174,9 +698,6 @@ ZLCD_draw_circle_xy_internal(uint16_t origin_x, uint16_t origin_y,
                              uint16_t radius_px, rgb565 border_colour,
                              bool fill, rgb565 fill_colour, bool update_now);
 
-static void ZLCD_set_rows(uint16_t y_start, uint16_t y_end);
-static void ZLCD_set_columns(uint16_t x_start, uint16_t x_end);
-static void ZLCD_set_window(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1);
 static void fill_bottom_flat_triangle(ZLCD_pixel_coordinate v1,
                                       ZLCD_pixel_coordinate v2,
                                       ZLCD_pixel_coordinate v3, rgb565 colour);
@@ -191,9 +712,85 @@ static void ZLCD_draw_vline_internal(int16_t x, int16_t y1, int16_t y2,
                                      rgb565 colour);
 static void ZLCD_draw_line_xy_internal(int16_t x1, int16_t y1, int16_t x2,
                                        int16_t y2, rgb565 colour);
+#endif
+
+// one set of kernels per orientation, see zynq_lcd_kernels.h
+#define ZLCD_KERNEL_SUFFIX portrait
+#define ZLCD_KERNEL_WIDTH ZLCD_WIDTH
+#define ZLCD_KERNEL_HEIGHT ZLCD_HEIGHT
+#define ZLCD_KERNEL_STRIDE ZLCD_WIDTH
+#define ZLCD_KERNEL_FRAME_X(x, y) (x)
+#define ZLCD_KERNEL_FRAME_Y(x, y) (y)
+#define ZLCD_KERNEL_X_STEP 1
+#define ZLCD_KERNEL_Y_STEP ZLCD_WIDTH
+#include "zynq_lcd_kernels.h"
+
+// 180 degrees clockwise relative to portrait
+#define ZLCD_KERNEL_SUFFIX inverted_portrait
+#define ZLCD_KERNEL_WIDTH ZLCD_WIDTH
+#define ZLCD_KERNEL_HEIGHT ZLCD_HEIGHT
+#define ZLCD_KERNEL_STRIDE ZLCD_WIDTH
+#define ZLCD_KERNEL_FRAME_X(x, y) (ZLCD_WIDTH - 1 - (x))
+#define ZLCD_KERNEL_FRAME_Y(x, y) (ZLCD_HEIGHT - 1 - (y))
+#define ZLCD_KERNEL_X_STEP (-1)
+#define ZLCD_KERNEL_Y_STEP (-ZLCD_WIDTH)
+#include "zynq_lcd_kernels.h"
+
+// 90 degrees clockwise relative to portrait
+#define ZLCD_KERNEL_SUFFIX landscape
+#define ZLCD_KERNEL_WIDTH ZLCD_HEIGHT
+#define ZLCD_KERNEL_HEIGHT ZLCD_WIDTH
+#define ZLCD_KERNEL_STRIDE ZLCD_WIDTH
+#define ZLCD_KERNEL_FRAME_X(x, y) (ZLCD_WIDTH - 1 - (y))
+#define ZLCD_KERNEL_FRAME_Y(x, y) (x)
+#define ZLCD_KERNEL_X_STEP ZLCD_WIDTH
+#define ZLCD_KERNEL_Y_STEP (-1)
+#include "zynq_lcd_kernels.h"
+
+// 90 degrees counter-clockwise relative to portrait
+#define ZLCD_KERNEL_SUFFIX inverted_landscape
+#define ZLCD_KERNEL_WIDTH ZLCD_HEIGHT
+#define ZLCD_KERNEL_HEIGHT ZLCD_WIDTH
+#define ZLCD_KERNEL_STRIDE ZLCD_WIDTH
+#define ZLCD_KERNEL_FRAME_X(x, y) (y)
+#define ZLCD_KERNEL_FRAME_Y(x, y) (ZLCD_HEIGHT - 1 - (x))
+#define ZLCD_KERNEL_X_STEP (-ZLCD_WIDTH)
+#define ZLCD_KERNEL_Y_STEP 1
+#include "zynq_lcd_kernels.h"
 
-static inline void ZLCD_set_pixel_xy_internal(int16_t x, int16_t y,
-                                              rgb565 colour);
+/*
+ZLCD_ROTATE_MADCTL keeps the frame the way the user sees it, so both portrait
+modes use the portrait kernels above and both landscape modes this one
+*/
+#define ZLCD_KERNEL_SUFFIX madctl_landscape
+#define ZLCD_KERNEL_WIDTH ZLCD_HEIGHT
+#define ZLCD_KERNEL_HEIGHT ZLCD_WIDTH
+#define ZLCD_KERNEL_STRIDE ZLCD_HEIGHT
+#define ZLCD_KERNEL_FRAME_X(x, y) (x)
+#define ZLCD_KERNEL_FRAME_Y(x, y) (y)
+#define ZLCD_KERNEL_X_STEP 1
+#define ZLCD_KERNEL_Y_STEP ZLCD_HEIGHT
+#include "zynq_lcd_kernels.h"
+
+/*
+Indexed by ZLCD_ORIENTATION. MV exchanges the column and row counters and MX/MY
+mirror them, giving the same picture as the software kernels. The 172 visible
+columns are 34 to 205 of the 240 the ST7789 has, which is still true mirrored,
+and with MV they are addressed through RASET instead.
+*/
+static const ZLCD_madctl_layout ZLCD_madctl_layouts[] = {
+    [ZLCD_PORTRAIT_ORIENTATION] = {&ZLCD_kernels_portrait, ST7789_MADCTL_RGB,
+                                   ZLCD_X_OFFSET, ZLCD_Y_OFFSET},
+    [ZLCD_INVERTED_PORTRAIT_ORIENTATION] = {&ZLCD_kernels_portrait,
+                                            ST7789_MADCTL_MX | ST7789_MADCTL_MY,
+                                            ZLCD_X_OFFSET, ZLCD_Y_OFFSET},
+    [ZLCD_LANDSCAPE_ORIENTATION] = {&ZLCD_kernels_madctl_landscape,
+                                    ST7789_MADCTL_MV | ST7789_MADCTL_MX,
+                                    ZLCD_Y_OFFSET, ZLCD_X_OFFSET},
+    [ZLCD_INVERTED_LANDSCAPE_ORIENTATION] = {
+        &ZLCD_kernels_madctl_landscape, ST7789_MADCTL_MV | ST7789_MADCTL_MY,
+        ZLCD_Y_OFFSET, ZLCD_X_OFFSET}};
+#if !ZLCD_FRAMELESS
 // static void ZLCD_set_pixel_internal(ZLCD_internal_coordinate p, rgb565
 // colour);
 static void ZLCD_draw_line_internal(ZLCD_internal_coordinate p1,
@@ -218,6 +815,7 @@ static void ZLCD_print_aligned_string_internal(
 
 static uint16_t get_font_height(const char *string, const ZLCD_font *f,
                                 int8_t *y_offset);
+#endif
 
 /*******************************
     FUNCTION DEFINITIONS HERE
@@ -235,81 +833,258 @@ void ZLCD_change_pixel_coordinate(ZLCD_pixel_coordinate *coordinate,
   coordinate->y = new_y;
 }
 
-static void ZLCD_set_rows(uint16_t y_start, uint16_t y_end) {
-  uint8_t data[4];
-  ZLCD_send_command(0x2B);           // Row address set
-  data[0] = (y_start & 0xFF00) >> 8; // MSBs
-  data[1] = (y_start & 0x00FF);      // LSBs
-  data[2] = (y_end & 0xFF00) >> 8;
-  data[3] = y_end & 0x00FF;
-  ZLCD_send_data(data, sizeof(data));
+static inline void ZLCD_packet_command(ZLCD_window_packet *packet,
+                                       uint8_t command) {
+  packet->commands |= (uint16_t)(1U << packet->length);
+  packet->bytes[packet->length++] = command;
 }
 
-static void ZLCD_set_columns(uint16_t x_start, uint16_t x_end) {
-  uint8_t data[4];
-  ZLCD_send_command(0x2A);           // Column address set
-  data[0] = (x_start & 0xFF00) >> 8; // MSBs
-  data[1] = x_start & 0x00FF;        // LSBs
-  data[2] = (x_end & 0xFF00) >> 8;
-  data[3] = x_end & 0x00FF;
-  ZLCD_send_data(data, sizeof(data));
+// CASET or RASET with its start and end address
+static void ZLCD_packet_address(ZLCD_window_packet *packet, uint8_t command,
+                                uint16_t start, uint16_t end) {
+  ZLCD_packet_command(packet, command);
+  packet->bytes[packet->length++] = (start & 0xFF00) >> 8; // MSBs
+  packet->bytes[packet->length++] = start & 0x00FF;        // LSBs
+  packet->bytes[packet->length++] = (end & 0xFF00) >> 8;
+  packet->bytes[packet->length++] = end & 0x00FF;
+}
+
+// number of bytes from start on that are sent with the same DC level
+static uint8_t ZLCD_packet_run(const ZLCD_window_packet *packet,
+                               uint8_t start) {
+  bool is_command = (packet->commands >> start) & 0x1;
+  uint8_t end = start + 1;
+  while (end < packet->length &&
+         (bool)((packet->commands >> end) & 0x1) == is_command) {
+    end++;
+  }
+  return end - start;
+}
+
+/*
+With the raw FIFO path the whole packet is one chip select frame and DC is
+switched in between. Otherwise (and when recording for the async engine) every
+command and parameter block is its own transfer.
+*/
+static void ZLCD_send_packet(const ZLCD_window_packet *packet) {
+  uint8_t run;
+#if ZLCD_ASYNC_REFRESH
+  if (async_recording) {
+    for (uint8_t i = 0; i < packet->length; i += run) {
+      run = ZLCD_packet_run(packet, i);
+      if ((packet->commands >> i) & 0x1) {
+        for (uint8_t j = i; j < i + run; j++) {
+          ZLCD_send_command(packet->bytes[j]);
+        }
+      } else {
+        ZLCD_send_data(&packet->bytes[i], run);
+      }
+    }
+    return;
+  }
+#endif
+  ZLCD_wait_for_bus();
+  ZLCD_TRANSPORT->begin(ZLCD_TRANSPORT->context);
+  for (uint8_t i = 0; i < packet->length; i += run) {
+    run = ZLCD_packet_run(packet, i);
+    bool is_command = (packet->commands >> i) & 0x1;
+    ZLCD_STATS(driver_stats.spi_bytes += run;
+               driver_stats.command_bytes += is_command ? run : 0);
+    ZLCD_set_dc(!is_command);
+    ZLCD_TRANSPORT->write(ZLCD_TRANSPORT->context, &packet->bytes[i], run);
+  }
+  ZLCD_TRANSPORT->end(ZLCD_TRANSPORT->context);
 }
 
 static void ZLCD_set_window(uint16_t x0, uint16_t x1, uint16_t y0,
                             uint16_t y1) {
+  ZLCD_window_packet packet = {.length = 0, .commands = 0};
   if (x0 != cached_col_start || x1 != cached_col_end) {
-    ZLCD_set_columns(x0, x1);
+    ZLCD_packet_address(&packet, 0x2A, x0, x1); // Column address set
     cached_col_start = x0;
     cached_col_end = x1;
+    ZLCD_STATS(driver_stats.window_column_misses++);
+  } else {
+    ZLCD_STATS(driver_stats.window_column_hits++);
   }
   if (y0 != cached_row_start || y1 != cached_row_end) {
-    ZLCD_set_rows(y0, y1);
+    ZLCD_packet_address(&packet, 0x2B, y0, y1); // Row address set
     cached_row_start = y0;
     cached_row_end = y1;
+    ZLCD_STATS(driver_stats.window_row_misses++);
+  } else {
+    ZLCD_STATS(driver_stats.window_row_hits++);
+  }
+  ZLCD_packet_command(&packet, 0x2C); // Memory write
+  ZLCD_send_packet(&packet);
+  // the caller decides how much is written, so the pointer is not known
+  cached_pointer_row = 0xFFFF;
+}
+
+#if ZLCD_ASYNC_REFRESH
+// nothing interrupts CPU0 when CPU1 is done, its refreshes are finished here
+static void ZLCD_amp_poll(void) {
+  ZLCD_refresh_slot *slot = atomic_load(&sending_slot);
+  if (amp_client.queue != NULL && slot != NULL &&
+      ZLCD_amp_idle(amp_client.queue)) {
+    ZLCD_async_finish(&slot->engine, ZLCD_SUCCESS);
+  }
+}
+
+// waits until no more than max_pending refreshes are left with the engine
+static inline void ZLCD_wait_for_refreshes(uint32_t max_pending) {
+  while (atomic_load(&refreshes_pending) > max_pending) {
+    ZLCD_amp_poll();
+  }
+}
+#endif
+
+static inline void ZLCD_wait_for_bus(void) {
+#if ZLCD_ASYNC_REFRESH
+  // the SPI controller and the DC pin belong to the async engine until done
+  ZLCD_wait_for_refreshes(0);
+#endif
+}
+
+#if ZLCD_ASYNC_REFRESH
+/*
+the engine the sends go to while async_recording is set. A send that does not
+fit sets its overflow flag, see ZLCD_recorded_all()
+*/
+static inline ZLCD_async_engine *ZLCD_recording_engine(void) {
+  return &refresh_slots[next_slot].engine;
+}
+
+// false, after an error, if the refresh just recorded lost steps
+static bool ZLCD_recorded_all(void) {
+  if (ZLCD_recording_engine()->overflow) {
+    printf("ERROR: the refresh needs more than %u async steps, not sent\n",
+           ZLCD_ASYNC_MAX_STEPS);
+    return false;
+  }
+  return true;
+}
+#endif
+
+static inline void ZLCD_set_dc(bool data) {
+  if (((current_pin_levels >> ZLCD_PIN_DC) & 0x1) != (uint32_t)data) {
+    ZLCD_write_pin(ZLCD_PIN_DC, data);
   }
-  ZLCD_send_command(0x2C);
 }
 
 static inline void ZLCD_send_command(uint8_t command) {
+  ZLCD_STATS(driver_stats.spi_bytes++; driver_stats.command_bytes++);
+#if ZLCD_ASYNC_REFRESH
+  if (async_recording) {
+    (void)ZLCD_async_push(ZLCD_recording_engine(), true, &command, 1);
+    return;
+  }
+#endif
+  ZLCD_wait_for_bus();
   // set DC to 0 --> indicates command
-  if ((current_gpio_values >> LCD_DC) & 0x1) {
-    ZLCD_write_gpio(LCD_DC, 0);
+  if ((current_pin_levels >> ZLCD_PIN_DC) & 0x1) {
+    ZLCD_write_pin(ZLCD_PIN_DC, 0);
   }
   ZLCD_write_bytes(&command, 1);
 }
 
 static inline void ZLCD_send_data_byte(uint8_t data) {
+  ZLCD_STATS(driver_stats.spi_bytes++);
+#if ZLCD_ASYNC_REFRESH
+  if (async_recording) {
+    (void)ZLCD_async_push(ZLCD_recording_engine(), false, &data, 1);
+    return;
+  }
+#endif
+  ZLCD_wait_for_bus();
   // set DC to 1 --> indicates data
-  if (((current_gpio_values >> LCD_DC) & 0x1) == 0) {
-    ZLCD_write_gpio(LCD_DC, 1);
+  if (((current_pin_levels >> ZLCD_PIN_DC) & 0x1) == 0) {
+    ZLCD_write_pin(ZLCD_PIN_DC, 1);
   }
   ZLCD_write_bytes(&data, 1);
 }
 
 static inline void ZLCD_send_data(const uint8_t *byte_stream,
                                   size_t num_bytes) {
+  ZLCD_STATS(driver_stats.spi_bytes += num_bytes);
+#if ZLCD_ASYNC_REFRESH
+  if (async_recording) {
+    (void)ZLCD_async_push(ZLCD_recording_engine(), false, byte_stream,
+                          num_bytes);
+    return;
+  }
+#endif
+  ZLCD_wait_for_bus();
   // set CD to 1 --> indicates data
-  if (((current_gpio_values >> LCD_DC) & 0x1) == 0) {
-    ZLCD_write_gpio(LCD_DC, 1);
+  if (((current_pin_levels >> ZLCD_PIN_DC) & 0x1) == 0) {
+    ZLCD_write_pin(ZLCD_PIN_DC, 1);
   }
   ZLCD_write_bytes(byte_stream, num_bytes);
 }
 
 static inline void ZLCD_write_bytes(const uint8_t *byte_stream,
                                     size_t num_bytes) {
-  XSpiPs_PolledTransfer(&spi_instance, (uint8_t *)byte_stream, NULL, num_bytes);
+  ZLCD_TRANSPORT->begin(ZLCD_TRANSPORT->context);
+  ZLCD_TRANSPORT->write(ZLCD_TRANSPORT->context, byte_stream, num_bytes);
+  ZLCD_TRANSPORT->end(ZLCD_TRANSPORT->context);
+}
+
+#if !ZLCD_FRAMELESS
+/*
+rows of a window, stride bytes from the start of one to the next. The built in
+DMA transport sends them with one channel program (one step when recording),
+anything else row by row
+*/
+static void ZLCD_send_data_rows(const uint8_t *first_row, size_t row_bytes,
+                                uint16_t rows, size_t stride) {
+  if (rows > 1 && row_bytes >= ZLCD_DMA_MIN_TRANSFER_BYTES) {
+#if ZLCD_ASYNC_REFRESH
+    if (async_recording &&
+        ZLCD_async_push_rows(ZLCD_recording_engine(), first_row, row_bytes,
+                             rows, stride)) {
+      ZLCD_STATS(driver_stats.spi_bytes += row_bytes * rows);
+      return;
+    }
+#endif
+    if (!async_recording &&
+        ZLCD_TRANSPORT == &ZLCD_builtin_transports[ZLCD_TRANSMIT_DMA]) {
+      ZLCD_STATS(driver_stats.spi_bytes += row_bytes * rows);
+      ZLCD_wait_for_bus();
+      ZLCD_set_dc(true);
+      ZLCD_TRANSPORT->begin(ZLCD_TRANSPORT->context);
+      if (ZLCD_dma_write_rows(&dma_transfer, first_row, row_bytes, rows,
+                              stride) != XST_SUCCESS) {
+        transport_status = ZLCD_FAILURE;
+      }
+      ZLCD_TRANSPORT->end(ZLCD_TRANSPORT->context);
+      return;
+    }
+  }
+  for (uint16_t row = 0; row < rows; row++) {
+    ZLCD_send_data(first_row + (size_t)row * stride, row_bytes);
+  }
 }
+#endif
 
-static void ZLCD_write_gpio(uint32_t gpio_bit_mask, bool value) {
-  current_gpio_values = XGpio_DiscreteRead(&LCD_gpios, 1); // renove me
+static void ZLCD_write_pin(ZLCD_PIN pin, bool value) {
+#if ZLCD_STATS_ENABLED
+  if (pin == ZLCD_PIN_DC &&
+      ((current_pin_levels >> ZLCD_PIN_DC) & 0x1) != (uint32_t)value) {
+    driver_stats.dc_toggles++;
+  }
+#endif
   if (value) {
     // set with bitwise OR
-    current_gpio_values |= (1 << gpio_bit_mask);
+    current_pin_levels |= (1 << pin);
   } else {
     // clear by bitwise AND
-    current_gpio_values &= ~(1 << gpio_bit_mask);
+    current_pin_levels &= ~(1 << pin);
   }
-  XGpio_DiscreteWrite(&LCD_gpios, 1, current_gpio_values);
+  ZLCD_TRANSPORT->set_pin(ZLCD_TRANSPORT->context, pin, value);
+}
+
+static inline void ZLCD_delay_ms(uint32_t milliseconds) {
+  ZLCD_TRANSPORT->delay_ms(ZLCD_TRANSPORT->context, milliseconds);
 }
 
 static void ZLCD_software_reset(void) {
@@ -323,7 +1098,7 @@ static void ZLCD_software_reset(void) {
   */
 
   ZLCD_send_command(0x01);
-  msleep(5);
+  ZLCD_delay_ms(5);
 }
 
 static ZLCD_RETURN_STATUS ZLCD_gpio_init(void) {
@@ -343,7 +1118,7 @@ static ZLCD_RETURN_STATUS ZLCD_gpio_init(void) {
   // all single channel output only
   XGpio_SetDataDirection(&LCD_gpios, 1, 0); // all ouputs (0)
 
-  current_gpio_values = 0x0;
+  builtin_gpio_values = 0x0;
   XGpio_DiscreteWrite(&LCD_gpios, 1, 0x0); // disable all LCD pins
   return ZLCD_SUCCESS;
 }
@@ -362,8 +1137,235 @@ static ZLCD_RETURN_STATUS ZLCD_spi_init(void) {
                     (XSPIPS_MASTER_OPTION | XSPIPS_FORCE_SSELECT_OPTION));
   // sets the clock of the SPI peripheral to fastest option (4)
   XSpiPs_SetClkPrescaler(&spi_instance, XSPIPS_CLK_PRESCALE_4);
+  // no extra gaps between bytes, see zynq_lcd_fifo.h
+  XSpiPs_SetDelays(&spi_instance, ZLCD_SPI_DELAY_NSS, ZLCD_SPI_DELAY_BTWN,
+                   ZLCD_SPI_DELAY_AFTER, ZLCD_SPI_DELAY_INIT);
+  return ZLCD_SUCCESS;
+}
+
+// async engine hooks, called from ZLCD_refresh_display_async() and the SPI ISR
+/*
+Built in transports. GPIO 0 channel 1 belongs to the driver, so the pins are
+written from builtin_gpio_values without reading the data register back first
+*/
+static void ZLCD_builtin_set_pin(void *context, ZLCD_PIN pin, bool level) {
+  (void)context;
+  uint32_t bit = pin == ZLCD_PIN_DC ? LCD_DC : LCD_RESET;
+  if (level) {
+    builtin_gpio_values |= (1 << bit);
+  } else {
+    builtin_gpio_values &= ~(1 << bit);
+  }
+  XGpio_WriteReg(LCD_gpios.BaseAddress, XGPIO_DATA_OFFSET, builtin_gpio_values);
+}
+
+static void ZLCD_builtin_delay_ms(void *context, uint32_t milliseconds) {
+  (void)context;
+  msleep(milliseconds);
+}
+
+// XSpiPs_PolledTransfer() frames every write with chip select itself
+static void ZLCD_builtin_no_frame(void *context) { (void)context; }
+
+static ZLCD_RETURN_STATUS ZLCD_polled_init(void *context) {
+  (void)context;
+  if (ZLCD_gpio_init() != ZLCD_SUCCESS) {
+    printf("GPIO init failed\n");
+    return ZLCD_FAILURE;
+  }
+  if (ZLCD_spi_init() != ZLCD_SUCCESS) {
+    printf("SPI init failed\n");
+    return ZLCD_FAILURE;
+  }
+  return ZLCD_SUCCESS;
+}
+
+static void ZLCD_polled_write(void *context, const uint8_t *bytes,
+                              size_t num_bytes) {
+  XSpiPs_PolledTransfer((XSpiPs *)context, (uint8_t *)bytes, NULL,
+                        (u32)num_bytes);
+}
+
+static void ZLCD_fifo_transport_begin(void *context) {
+  ZLCD_fifo_begin((XSpiPs *)context);
+}
+
+static void ZLCD_fifo_transport_write(void *context, const uint8_t *bytes,
+                                      size_t num_bytes) {
+  ZLCD_fifo_write((XSpiPs *)context, bytes, num_bytes);
+}
+
+static void ZLCD_fifo_transport_end(void *context) {
+  ZLCD_fifo_end((XSpiPs *)context);
+}
+
+static ZLCD_RETURN_STATUS ZLCD_dma_transport_init(void *context) {
+  if (ZLCD_polled_init(context) != ZLCD_SUCCESS) {
+    return ZLCD_FAILURE;
+  }
+  if (ZLCD_dma_init(&dma_transfer, &dma_instance, &spi_instance,
+                    XPAR_XDMAPS_0_BASEADDR) != XST_SUCCESS) {
+    printf("DMA init failed\n");
+    return ZLCD_FAILURE;
+  }
+  return ZLCD_SUCCESS;
+}
+
+/*
+short transfers (commands, window addresses) go through the FIFO directly. They
+share the chip select frame with the DMA writes, which only return once the
+last byte is out and the RX FIFO has been drained (ZLCD_dma_settle())
+*/
+static void ZLCD_dma_transport_write(void *context, const uint8_t *bytes,
+                                     size_t num_bytes) {
+  if (num_bytes < ZLCD_DMA_MIN_TRANSFER_BYTES) {
+    ZLCD_fifo_write((XSpiPs *)context, bytes, num_bytes);
+  } else if (ZLCD_dma_write(&dma_transfer, bytes, num_bytes) != XST_SUCCESS) {
+    transport_status = ZLCD_FAILURE;
+  }
+}
+
+static const ZLCD_transport ZLCD_builtin_transports[3] = {
+    [ZLCD_TRANSMIT_POLLED] = {ZLCD_polled_init, ZLCD_builtin_no_frame,
+                              ZLCD_polled_write, ZLCD_builtin_no_frame,
+                              ZLCD_builtin_set_pin, ZLCD_builtin_delay_ms,
+                              &spi_instance},
+    [ZLCD_TRANSMIT_DMA] = {ZLCD_dma_transport_init, ZLCD_fifo_transport_begin,
+                           ZLCD_dma_transport_write, ZLCD_fifo_transport_end,
+                           ZLCD_builtin_set_pin, ZLCD_builtin_delay_ms,
+                           &spi_instance},
+    [ZLCD_TRANSMIT_FIFO] = {ZLCD_polled_init, ZLCD_fifo_transport_begin,
+                            ZLCD_fifo_transport_write, ZLCD_fifo_transport_end,
+                            ZLCD_builtin_set_pin, ZLCD_builtin_delay_ms,
+                            &spi_instance}};
+
+const ZLCD_transport *ZLCD_get_builtin_transport(ZLCD_TRANSMIT_MODE mode) {
+  if (mode != ZLCD_TRANSMIT_POLLED && mode != ZLCD_TRANSMIT_DMA &&
+      mode != ZLCD_TRANSMIT_FIFO) {
+    return NULL;
+  }
+  return &ZLCD_builtin_transports[mode];
+}
+
+#if ZLCD_ASYNC_REFRESH
+static void ZLCD_async_set_dc(void *context, bool data) {
+  (void)context;
+  ZLCD_set_dc(data);
+}
+
+static int ZLCD_async_start_transfer(void *context, const uint8_t *bytes,
+                                     size_t num_bytes) {
+  return XSpiPs_Transfer((XSpiPs *)context, (uint8_t *)bytes, NULL,
+                         (u32)num_bytes);
+}
+
+/*
+With the DMA transport long steps go through the PL330. It runs in the frame
+of ZLCD_fifo_begin(), as the sync writes do
+*/
+static void ZLCD_dma_step_sent(void *context, int status) {
+  // the engine goes on from this interrupt, so the bus is settled here
+  ZLCD_dma_settle(&dma_transfer);
+  ZLCD_fifo_end((XSpiPs *)context);
+  ZLCD_refresh_slot *slot = atomic_load(&sending_slot);
+  if (slot != NULL) {
+    ZLCD_async_step_done(&slot->engine, status);
+  }
+}
+
+static int ZLCD_dma_async_start_rows(void *context, const uint8_t *first_row,
+                                     size_t row_bytes, size_t rows,
+                                     size_t stride) {
+  ZLCD_fifo_begin((XSpiPs *)context);
+  int status = ZLCD_dma_start(&dma_transfer, first_row, row_bytes, rows,
+                              stride, ZLCD_dma_step_sent, context);
+  if (status != XST_SUCCESS) {
+    ZLCD_fifo_end((XSpiPs *)context);
+  }
+  return status;
+}
+
+static int ZLCD_dma_async_start_transfer(void *context, const uint8_t *bytes,
+                                         size_t num_bytes) {
+  if (num_bytes < ZLCD_DMA_MIN_TRANSFER_BYTES) {
+    return ZLCD_async_start_transfer(context, bytes, num_bytes);
+  }
+  return ZLCD_dma_async_start_rows(context, bytes, num_bytes, 1, num_bytes);
+}
+
+static void ZLCD_spi_status_handler(const void *callback_ref,
+                                    u32 status_event, u32 byte_count) {
+  (void)callback_ref;
+  (void)byte_count;
+  ZLCD_refresh_slot *slot = atomic_load(&sending_slot);
+  if (slot == NULL) {
+    return; // spurious interrupt
+  }
+  ZLCD_async_step_done(&slot->engine, status_event == XST_SPI_TRANSFER_DONE
+                                          ? XST_SUCCESS
+                                          : XST_FAILURE);
+}
+#endif
+
+#ifndef ZLCD_STATIC_TRANSPORT
+#if ZLCD_ASYNC_REFRESH
+static int ZLCD_amp_start_queue(void *context, const ZLCD_async_step *steps,
+                                size_t num_steps) {
+  // CPU1 switches DC for these, keep the pin level (and the stats) in step
+  for (size_t i = 0; i < num_steps; i++) {
+    ZLCD_set_dc(!steps[i].is_command);
+  }
+  return ZLCD_amp_submit((ZLCD_amp_client *)context, steps, num_steps)
+             ? XST_SUCCESS
+             : XST_FAILURE;
+}
+#endif
+
+// refreshes are recorded like async ones and handed to CPU1 in one piece
+static void ZLCD_amp_init(ZLCD_amp_queue *queue) {
+  ZLCD_amp_client_init(&amp_client, queue);
+#if ZLCD_ASYNC_REFRESH
+  for (size_t i = 0; i < ZLCD_REFRESH_SLOTS; i++) {
+    refresh_slots[i].engine.start_queue = ZLCD_amp_start_queue;
+    refresh_slots[i].engine.context = &amp_client;
+    ZLCD_async_reset(&refresh_slots[i].engine);
+  }
+#endif
+}
+#endif
+
+#if ZLCD_ASYNC_REFRESH
+static ZLCD_RETURN_STATUS ZLCD_interrupt_init(void) {
+  bool dma = ZLCD_TRANSPORT == &ZLCD_builtin_transports[ZLCD_TRANSMIT_DMA];
+  for (size_t i = 0; i < ZLCD_REFRESH_SLOTS; i++) {
+    ZLCD_async_engine *engine = &refresh_slots[i].engine;
+    engine->set_dc = ZLCD_async_set_dc;
+    engine->start_transfer =
+        dma ? ZLCD_dma_async_start_transfer : ZLCD_async_start_transfer;
+    engine->start_rows = dma ? ZLCD_dma_async_start_rows : NULL;
+    engine->start_queue = NULL;
+    engine->context = &spi_instance;
+    ZLCD_async_reset(engine);
+  }
+
+  // the handler looks up the slot being sent itself
+  XSpiPs_SetStatusHandler(&spi_instance, refresh_slots,
+                          ZLCD_spi_status_handler);
+  if (dma) {
+    // ZLCD_dma_init() connected SPI0, idle it runs XSpiPs_InterruptHandler()
+    return ZLCD_SUCCESS;
+  }
+  // sets up the GIC (if nobody has yet) and enables the SPI0 interrupt
+  if (XSetupInterruptSystem(&spi_instance, (void *)XSpiPs_InterruptHandler,
+                            spi_instance.Config.IntrId,
+                            spi_instance.Config.IntrParent,
+                            XINTERRUPT_DEFAULT_PRIORITY) != XST_SUCCESS) {
+    printf("Failed to connect the SPI0 interrupt\n");
+    return ZLCD_FAILURE;
+  }
   return ZLCD_SUCCESS;
 }
+#endif
 
 rgb565 ZLCD_construct_rgb565(uint8_t red, uint8_t green, uint8_t blue) {
   // red 5 MSBs, green 6 MSBs, blue 5 MSBs = 16 bits
@@ -395,7 +1397,7 @@ ZLCD_RETURN_STATUS ZLCD_sleep(void) {
   */
 
   ZLCD_send_command(0x10);
-  msleep(5);
+  ZLCD_delay_ms(5);
   current_sleep_mode = SLEEP_MODE;
   return ZLCD_SUCCESS;
 }
@@ -413,74 +1415,361 @@ ZLCD_RETURN_STATUS ZLCD_sleep_wake(void) {
   -It will be necessary to wait 120msec after sending sleep out command (when in
   sleep in mode) before sending an sleepin command.
   */
-  msleep(5);
+  ZLCD_delay_ms(5);
   current_sleep_mode = SLEEP_OUT_MODE;
   return ZLCD_SUCCESS;
 }
 
-ZLCD_RETURN_STATUS ZLCD_set_orientation(ZLCD_ORIENTATION desired_orientation) {
-  if (!ZLCD_initialized) {
-    printf("Initialize the LCD before calling other ZLCD functions\n");
-    return ZLCD_ERR_NOT_INITIALIZED;
-  }
-  if (desired_orientation == current_orientation.orientation_type) {
-    return ZLCD_SUCCESS;
-  }
-  switch (desired_orientation) {
+// kernels drawing an orientation into the portrait frame, NULL if invalid
+static const ZLCD_orientation_kernels *
+ZLCD_software_kernels(ZLCD_ORIENTATION orientation) {
+  switch (orientation) {
   case ZLCD_PORTRAIT_ORIENTATION:
-    current_orientation.horizontal_axis_length_px = ZLCD_WIDTH;
-    current_orientation.vertical_axis_length_px = ZLCD_HEIGHT;
-    current_transform_fun = pixel_coordinate_to_internal_index_portrait;
-    break;
+    return &ZLCD_kernels_portrait;
   case ZLCD_INVERTED_PORTRAIT_ORIENTATION:
-    current_orientation.horizontal_axis_length_px = ZLCD_WIDTH;
-    current_orientation.vertical_axis_length_px = ZLCD_HEIGHT;
-    current_transform_fun =
-        pixel_coordinate_to_internal_index_inverted_portrait;
-    break;
+    return &ZLCD_kernels_inverted_portrait;
   case ZLCD_LANDSCAPE_ORIENTATION:
-    current_orientation.horizontal_axis_length_px = ZLCD_HEIGHT;
-    current_orientation.vertical_axis_length_px = ZLCD_WIDTH;
-    current_transform_fun = pixel_coordinate_to_internal_index_landscape;
-    break;
+    return &ZLCD_kernels_landscape;
   case ZLCD_INVERTED_LANDSCAPE_ORIENTATION:
-    current_orientation.horizontal_axis_length_px = ZLCD_HEIGHT;
-    current_orientation.vertical_axis_length_px = ZLCD_WIDTH;
-    current_transform_fun =
-        pixel_coordinate_to_internal_index_inverted_landscape;
-    break;
+    return &ZLCD_kernels_inverted_landscape;
   default:
-    printf("ERROR: invalid orientation value\nFILE: %s\nLINE: %u\n", __FILE__,
-           __LINE__);
-    return ZLCD_FAILURE;
+    return NULL;
   }
-  current_orientation.orientation_type =
-      desired_orientation; // update current orientation
-  printf_x = 0;
-  printf_y = printf_font.font_size;
-  return ZLCD_SUCCESS;
 }
 
-ZLCD_RETURN_STATUS ZLCD_init(ZLCD_ORIENTATION desired_orientation,
-                             rgb565 background_colour) {
-  if (ZLCD_initialized) {
-    return ZLCD_SUCCESS;
-  }
-  if (ZLCD_gpio_init() != ZLCD_SUCCESS) {
-    printf("GPIO init failed\n");
-    return ZLCD_FAILURE;
-  }
-  if (ZLCD_spi_init() != ZLCD_SUCCESS) {
-    printf("SPI init failed\n");
-    return ZLCD_FAILURE;
-  }
-
-  uint8_t transmission_data[14] = {0};
+#if !ZLCD_FRAMELESS
+// portrait pixel the software kernels draw pixel i of the screen to, counting
+// row by row in their orientation
+static inline size_t
+ZLCD_relayout_target(const ZLCD_orientation_kernels *kernels, size_t i) {
+  return kernels->index(i % kernels->width, i / kernels->width) /
+         sizeof(rgb565);
+}
 
-  // hard reset using the reset pin
-  ZLCD_write_gpio(LCD_RESET, 0); // active low
+/*
+Rearranges both GRAM images in place between the screen kept row-major the way
+the user sees it and the portrait frame the software kernels draw into (either
+direction). The pixels are moved along the cycles of the permutation, with a
+bit per pixel marking what has moved instead of a second 110 Kbyte image.
+*/
+static void ZLCD_relayout_frame(const ZLCD_orientation_kernels *kernels,
+                                bool to_portrait) {
+  static uint32_t moved[(ZLCD_WIDTH * ZLCD_HEIGHT + 31U) / 32U];
+  ZLCD_fill_pixel *current = ZLCD_gram_pixels(0);
+  ZLCD_fill_pixel *previous = (ZLCD_fill_pixel *)GRAM_previous;
+  // ZLCD_BUFFER_HASHED: a single image, moving it twice would undo the move
+  bool both = previous != current;
+
+  memset(moved, 0, sizeof(moved));
+  for (size_t start = 0; start < ZLCD_WIDTH * ZLCD_HEIGHT; start++) {
+    if (moved[start / 32U] & (1U << (start % 32U))) {
+      continue;
+    }
+    uint16_t carried_current = current[start];
+    uint16_t carried_previous = previous[start];
+    size_t i = start;
+    if (to_portrait) {
+      // push: the pixel at i belongs at its target, which is carried on
+      do {
+        size_t next = ZLCD_relayout_target(kernels, i);
+        uint16_t temp = current[next];
+        current[next] = carried_current;
+        carried_current = temp;
+        if (both) {
+          temp = previous[next];
+          previous[next] = carried_previous;
+          carried_previous = temp;
+        }
+        moved[next / 32U] |= 1U << (next % 32U);
+        i = next;
+      } while (i != start);
+    } else {
+      // pull: i takes the pixel from its target until the cycle closes
+      moved[i / 32U] |= 1U << (i % 32U);
+      for (size_t next = ZLCD_relayout_target(kernels, i); next != start;
+           next = ZLCD_relayout_target(kernels, i)) {
+        current[i] = current[next];
+        if (both) {
+          previous[i] = previous[next];
+        }
+        moved[next / 32U] |= 1U << (next % 32U);
+        i = next;
+      }
+      current[i] = carried_current;
+      if (both) {
+        previous[i] = carried_previous;
+      }
+    }
+  }
+}
+
+#endif
+
+/*
+ZLCD_ROTATE_MADCTL: moves the frame of from over into the layout of to (through
+portrait) and points the ST7789 at it. The LCD keeps showing the same picture,
+only the frame and the addresses that map onto it change.
+*/
+static void ZLCD_madctl_rotate(ZLCD_ORIENTATION from, ZLCD_ORIENTATION to) {
+  const ZLCD_madctl_layout *layout = &ZLCD_madctl_layouts[to];
+  const ZLCD_orientation_kernels *from_kernels = ZLCD_software_kernels(from);
+  const ZLCD_orientation_kernels *to_kernels = ZLCD_software_kernels(to);
+
+  // GRAM_previous may still be going out over SPI
+  ZLCD_wait_for_bus();
+#if !ZLCD_FRAMELESS
+  ZLCD_settle_overwritten_rows();
+  // the LCD RAM rows stop being frame rows, so line them up again first
+  ZLCD_scroll_to(0);
+  // only GRAM_current and GRAM_previous are moved, the others start over
+  ZLCD_repair_all_rows();
+#endif
+  current_kernels = layout->kernels;
+  frame_col_offset = layout->col_offset;
+  frame_row_offset = layout->row_offset;
+#if ZLCD_FRAMELESS
+  (void)from_kernels;
+  (void)to_kernels;
+#else
+  if (from_kernels != NULL) { // unknown while ZLCD_init() sets it up
+    if (from_kernels != &ZLCD_kernels_portrait) {
+      ZLCD_relayout_frame(from_kernels, true);
+    }
+    if (to_kernels != &ZLCD_kernels_portrait) {
+      ZLCD_relayout_frame(to_kernels, false);
+    }
+    // and so did the tiles
+    memset(tile_known, 0, sizeof(tile_known));
+    // rows and columns changed meaning, the next refresh trims it back down
+    bool any_dirty = dirty_y_end != 0;
+    memset(dirty_x_end, 0, sizeof(dirty_x_end));
+    dirty_y_end = 0;
+    if (any_dirty) {
+      ZLCD_mark_dirty(0, current_kernels->frame_width - 1, 0,
+                      current_kernels->frame_height - 1);
+    }
+    for (uint8_t i = 0; i < num_frame_buffers; i++) {
+      if (i != current_buffer && i != previous_buffer) {
+        ZLCD_stale_frame(i);
+      }
+    }
+  }
+#endif
+  if (layout->madctl != current_madctl) {
+    ZLCD_send_command(0x36); // Memory Data Access Control
+    ZLCD_send_data_byte(layout->madctl);
+    current_madctl = layout->madctl;
+    // the cached window is in the old address space
+    cached_col_start = cached_col_end = 0xFFFF;
+    cached_row_start = cached_row_end = 0xFFFF;
+    cached_pointer_row = 0xFFFF;
+  }
+}
+
+ZLCD_RETURN_STATUS ZLCD_set_orientation(ZLCD_ORIENTATION desired_orientation) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+  if (desired_orientation == current_orientation.orientation_type) {
+    return ZLCD_SUCCESS;
+  }
+  const ZLCD_orientation_kernels *kernels =
+      ZLCD_software_kernels(desired_orientation);
+  if (kernels == NULL) {
+    printf("ERROR: invalid orientation value\nFILE: %s\nLINE: %u\n", __FILE__,
+           __LINE__);
+    return ZLCD_FAILURE;
+  }
+  current_orientation.horizontal_axis_length_px = kernels->width;
+  current_orientation.vertical_axis_length_px = kernels->height;
+  if (current_rotation_mode == ZLCD_ROTATE_MADCTL) {
+    ZLCD_madctl_rotate(current_orientation.orientation_type,
+                       desired_orientation);
+  } else {
+    current_kernels = kernels;
+  }
+  current_orientation.orientation_type =
+      desired_orientation; // update current orientation
+  printf_x = 0;
+  printf_y = printf_font.font_size;
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_config ZLCD_create_config(ZLCD_ORIENTATION desired_orientation,
+                               rgb565 background_colour) {
+  return (ZLCD_config){.orientation = desired_orientation,
+                       .background_colour = background_colour,
+                       .transmit_mode = ZLCD_TRANSMIT_POLLED,
+                       .async_refresh = false,
+                       .rotation_mode = ZLCD_ROTATE_SOFTWARE,
+                       .pixel_format = ZLCD_PIXEL_RGB565,
+                       .transport = NULL,
+                       .amp_queue = NULL,
+                       .buffer_mode = ZLCD_BUFFER_COPY,
+                       .vsync_mode = ZLCD_VSYNC_OFF,
+                       .frame_rate = 0};
+}
+
+ZLCD_RETURN_STATUS ZLCD_init(ZLCD_ORIENTATION desired_orientation,
+                             rgb565 background_colour) {
+  ZLCD_config config =
+      ZLCD_create_config(desired_orientation, background_colour);
+  return ZLCD_init_with_config(&config);
+}
+
+ZLCD_RETURN_STATUS ZLCD_init_with_config(const ZLCD_config *config) {
+  if (ZLCD_initialized) {
+    return ZLCD_SUCCESS;
+  }
+  if (config == NULL) {
+    printf("ZLCD_config passed to ZLCD_init_with_config() is NULL\n");
+    return ZLCD_FAILURE;
+  }
+  // OCM code copied in and L2 lines locked before any of it runs
+  if (!ZLCD_place_working_set()) {
+    return ZLCD_FAILURE;
+  }
+  ZLCD_ORIENTATION desired_orientation = config->orientation;
+  rgb565 background_colour = config->background_colour;
+
+  if (ZLCD_get_builtin_transport(config->transmit_mode) == NULL) {
+    printf("ERROR: invalid transmit mode %d\n", config->transmit_mode);
+    return ZLCD_FAILURE;
+  }
+  if (config->amp_queue != NULL && config->transport != NULL) {
+    printf("ERROR: with amp_queue the transport is the CPU1 pump's\n");
+    return ZLCD_FAILURE;
+  }
+#ifdef ZLCD_STATIC_TRANSPORT
+  if (config->transport != NULL || config->amp_queue != NULL ||
+      config->transmit_mode != ZLCD_STATIC_TRANSPORT) {
+    printf("ERROR: built for transmit mode %d only\n", ZLCD_STATIC_TRANSPORT);
+    return ZLCD_FAILURE;
+  }
+#else
+  if (config->amp_queue != NULL) {
+    ZLCD_amp_init(config->amp_queue);
+    active_transport = &amp_client.transport;
+  } else {
+    active_transport = config->transport != NULL
+                           ? config->transport
+                           : &ZLCD_builtin_transports[config->transmit_mode];
+  }
+#endif
+  if (config->async_refresh && config->transport != NULL) {
+    printf("ERROR: async_refresh needs the built in transport\n");
+    return ZLCD_FAILURE;
+  }
+  current_pin_levels = 0x0;
+  if (ZLCD_TRANSPORT->init(ZLCD_TRANSPORT->context) != ZLCD_SUCCESS) {
+    printf("LCD transport init failed\n");
+    return ZLCD_FAILURE;
+  }
+#if ZLCD_FRAMELESS
+  if (config->async_refresh || config->vsync_mode != ZLCD_VSYNC_OFF) {
+    printf("ERROR: async_refresh and vsync_mode need a frame, built with "
+           "ZLCD_MAX_FRAME_BUFFERS 0\n");
+    return ZLCD_FAILURE;
+  }
+#elif !ZLCD_ASYNC_REFRESH
+  if (config->async_refresh) {
+    printf("ERROR: async_refresh needs a second frame, built with "
+           "ZLCD_MAX_FRAME_BUFFERS %d\n",
+           ZLCD_MAX_FRAME_BUFFERS);
+    return ZLCD_FAILURE;
+  }
+#else
+  if (config->async_refresh && config->amp_queue != NULL) {
+    async_refresh_enabled = true; // CPU1 sends, no interrupt needed
+  } else if (config->async_refresh) {
+    if (ZLCD_interrupt_init() != ZLCD_SUCCESS) {
+      printf("Interrupt init failed\n");
+      return ZLCD_FAILURE;
+    }
+    async_refresh_enabled = true;
+  }
+#endif
+  if (config->rotation_mode != ZLCD_ROTATE_SOFTWARE &&
+      config->rotation_mode != ZLCD_ROTATE_MADCTL) {
+    printf("ERROR: invalid rotation mode %d\n", config->rotation_mode);
+    return ZLCD_FAILURE;
+  }
+  current_rotation_mode = config->rotation_mode;
+  if (config->pixel_format != ZLCD_PIXEL_RGB565 &&
+      config->pixel_format != ZLCD_PIXEL_RGB444 &&
+      config->pixel_format != ZLCD_PIXEL_RGB444_DITHERED) {
+    printf("ERROR: invalid pixel format %d\n", config->pixel_format);
+    return ZLCD_FAILURE;
+  }
+  current_pixel_format = config->pixel_format;
+#if !ZLCD_FRAMELESS
+  if (config->buffer_mode != ZLCD_BUFFER_COPY &&
+      config->buffer_mode != ZLCD_BUFFER_DOUBLE &&
+      config->buffer_mode != ZLCD_BUFFER_TRIPLE &&
+      config->buffer_mode != ZLCD_BUFFER_HASHED) {
+    printf("ERROR: invalid buffer mode %d\n", config->buffer_mode);
+    return ZLCD_FAILURE;
+  }
+  // the swap modes send the drawn frame itself, so it has to be in wire order
+  if (config->buffer_mode != ZLCD_BUFFER_COPY && ZLCD_NATIVE_ENDIAN_GRAM) {
+    printf("ERROR: buffer mode %d needs ZLCD_NATIVE_ENDIAN_GRAM 0\n",
+           config->buffer_mode);
+    return ZLCD_FAILURE;
+  }
+  // and ZLCD_BUFFER_HASHED can't have it change while it goes out
+  if (config->buffer_mode == ZLCD_BUFFER_HASHED && config->async_refresh) {
+    printf("ERROR: buffer mode %d can't be used with async_refresh\n",
+           config->buffer_mode);
+    return ZLCD_FAILURE;
+  }
+#if !ZLCD_ASYNC_RGB444
+  // the recorded windows would need wire_packed
+  if (config->async_refresh && config->pixel_format != ZLCD_PIXEL_RGB565) {
+    printf("ERROR: async_refresh with pixel format %d needs "
+           "ZLCD_ASYNC_RGB444 1\n",
+           config->pixel_format);
+    return ZLCD_FAILURE;
+  }
+#endif
+  num_frame_buffers = config->buffer_mode == ZLCD_BUFFER_TRIPLE   ? 3
+                      : config->buffer_mode == ZLCD_BUFFER_HASHED ? 1
+                                                                  : 2;
+  if (num_frame_buffers > ZLCD_MAX_FRAME_BUFFERS) {
+    printf("ERROR: buffer mode %d needs ZLCD_MAX_FRAME_BUFFERS %u\n",
+           config->buffer_mode, num_frame_buffers);
+    return ZLCD_FAILURE;
+  }
+  current_buffer_mode = config->buffer_mode;
+  if (config->vsync_mode != ZLCD_VSYNC_OFF &&
+      config->vsync_mode != ZLCD_VSYNC_TE_GPIO &&
+      config->vsync_mode != ZLCD_VSYNC_TE_EDGES) {
+    printf("ERROR: invalid vsync mode %d\n", config->vsync_mode);
+    return ZLCD_FAILURE;
+  }
+  current_vsync_mode = config->vsync_mode;
+  frame_depth = 0;
+  frame_present_pending = false;
+  frame_period_ticks = config->frame_rate == 0
+                           ? 0
+                           : COUNTS_PER_SECOND / config->frame_rate;
+  frame_next_present = 0;
+  current_buffer = 0;
+  previous_buffer = num_frame_buffers > 1 ? 1 : 0;
+  GRAM_current = GRAM_buffer(current_buffer);
+  GRAM_previous = GRAM_buffer(previous_buffer);
+  memset(stale_rows, 0, sizeof(stale_rows));
+  memset(overwritten_rows, 0, sizeof(overwritten_rows));
+  overwritten_y_start = ZLCD_HEIGHT;
+  overwritten_y_end = 0;
+#endif
+
+  uint8_t transmission_data[14] = {0};
+
+  // hard reset using the reset pin
+  ZLCD_write_pin(ZLCD_PIN_RESET, 0); // active low
   // msleep(10);
-  ZLCD_write_gpio(LCD_RESET, 1);
+  ZLCD_write_pin(ZLCD_PIN_RESET, 1);
   // msleep(20);
 
   // perform a software reset
@@ -490,9 +1779,14 @@ ZLCD_RETURN_STATUS ZLCD_init(ZLCD_ORIENTATION desired_orientation,
   ZLCD_send_command(0x36); // Memory Data Access Control
   uint8_t mdactl = ST7789_MADCTL_RGB;
   ZLCD_send_data_byte(mdactl);
+  current_madctl = mdactl;
 
-  ZLCD_send_command(0x3A);   // COLMOD
-  ZLCD_send_data_byte(0x55); // 16-bit RGB565 with 65K colours
+  ZLCD_send_command(0x3A); // COLMOD
+  if (ZLCD_pixels_packed()) {
+    ZLCD_send_data_byte(0x53); // 12-bit RGB444 with 4K colours
+  } else {
+    ZLCD_send_data_byte(0x55); // 16-bit RGB565 with 65K colours
+  }
 
   // porch setting
   ZLCD_send_command(0xB2); // PORCTRL power on sequence
@@ -586,181 +1880,1985 @@ ZLCD_RETURN_STATUS ZLCD_init(ZLCD_ORIENTATION desired_orientation,
 
   ZLCD_display_on(); // command 0x29
 
+#if !ZLCD_FRAMELESS
+  if (current_vsync_mode != ZLCD_VSYNC_OFF) {
+    ZLCD_send_command(0x35); // TEON
+    ZLCD_send_data_byte(0x00); // TE pulses in the vertical blank only
+  }
+  if (ZLCD_vsync_init() != ZLCD_SUCCESS) {
+    ZLCD_initialized = false;
+    return ZLCD_FAILURE;
+  }
+#endif
+
   // set background colour
   current_orientation.orientation_type = ZLCD_UNKNOWN_ORIENTATION;
   ZLCD_set_orientation(desired_orientation);
-  // Force a full refresh by making GRAM_previous differ from the target colour
-  for (size_t i = 0; i < ZLCD_WIDTH * ZLCD_HEIGHT; i++) {
-    GRAM_previous[2 * i] = (uint8_t) ~(background_colour >> 8);
-    GRAM_previous[2 * i + 1] = (uint8_t) ~(background_colour & 0x00FF);
+#if ZLCD_FRAMELESS
+  current_background_colour = background_colour;
+  ZLCD_clear_lcd(background_colour);
+#else
+  if (current_buffer_mode == ZLCD_BUFFER_HASHED) {
+    // no tile is known, so everything drawn goes out
+    memset(tile_known, 0, sizeof(tile_known));
+  } else {
+    // Force a full refresh by making GRAM_previous differ from the target
+    // colour
+    for (size_t i = 0; i < ZLCD_WIDTH * ZLCD_HEIGHT; i++) {
+#if ZLCD_NATIVE_ENDIAN_GRAM
+      GRAM_previous[i] = __builtin_bswap16((rgb565)~background_colour);
+#else
+      GRAM_previous[2 * i] = (uint8_t) ~(background_colour >> 8);
+      GRAM_previous[2 * i + 1] = (uint8_t) ~(background_colour & 0x00FF);
+#endif
+    }
+  }
+  if (current_buffer_mode == ZLCD_BUFFER_DOUBLE ||
+      current_buffer_mode == ZLCD_BUFFER_TRIPLE) {
+    // and have nothing of it in the buffers that are drawn into
+    for (uint8_t i = 0; i < num_frame_buffers; i++) {
+      if (i != previous_buffer) {
+        ZLCD_stale_frame(i);
+      }
+    }
+  }
+  ZLCD_set_background_colour(background_colour);
+  ZLCD_draw_background(); // set pixels and refresh screen
+#endif
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_display_on(void) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+  ZLCD_send_command(0x29); // Display ON
+  ZLCD_delay_ms(10);
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_display_off(void) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+  ZLCD_send_command(0x28); // Display OFF
+  ZLCD_delay_ms(10);
+  return ZLCD_SUCCESS;
+}
+
+#if !ZLCD_FRAMELESS
+// static void ZLCD_set_pixel_internal(ZLCD_internal_coordinate p, rgb565
+// colour) { 	return ZLCD_set_pixel_xy_internal(p.x, p.y, colour);
+// }
+
+ZLCD_RETURN_STATUS ZLCD_set_pixel_xy(uint16_t x, uint16_t y, rgb565 colour,
+                                     bool update_now) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+
+  // inlined version of the ZLCD_verify_coordinate_is_valid_xy() function
+  if (x >= current_orientation.horizontal_axis_length_px) {
+    char error_message[100];
+    snprintf(error_message, sizeof(error_message) - 1,
+             "Error: coordinate %d exceeds maximum allowed value of %d", x,
+             current_orientation.horizontal_axis_length_px - 1);
+    log_error_message(error_message);
+    return ZLCD_FAILURE;
+  }
+  if (y >= current_orientation.vertical_axis_length_px) {
+    char error_message[100];
+    snprintf(error_message, sizeof(error_message) - 1,
+             "Error: y coordinate %d exceeds maximum allowed value of %d", y,
+             current_orientation.vertical_axis_length_px - 1);
+    log_error_message(error_message);
+    return ZLCD_FAILURE;
+  }
+
+  update_now = ZLCD_update_now(update_now);
+  // convert x and y to frame coordinates
+  size_t index = current_kernels->index(x, y);
+  uint16_t converted_x =
+      (index / sizeof(rgb565)) % current_kernels->frame_width;
+  uint16_t converted_y =
+      (index / sizeof(rgb565)) / current_kernels->frame_width;
+  if (update_now && ZLCD_pixels_packed()) {
+    // the pixel next to it goes out too and has to be up to date
+    ZLCD_repair_rows(converted_x & ~1U, converted_x | 1U, converted_y,
+                     converted_y, false);
+  } else {
+    ZLCD_repair_rows(converted_x, converted_x, converted_y, converted_y, true);
+  }
+  ZLCD_gram_store(index, colour);
+
+  if (update_now) {
+    uint16_t lcd_y = converted_y + ZLCD_scroll_shift(converted_y);
+    if (ZLCD_pixels_packed()) {
+      // packed pixels go in pairs, send the pixel next to it along
+      uint16_t pair_x = converted_x & ~1U;
+      size_t pair_index = index - (converted_x - pair_x) * sizeof(rgb565);
+      uint8_t packed[ZLCD_PACK_RGB444_BYTES(2)];
+      ZLCD_set_window(frame_col_offset + pair_x, frame_col_offset + pair_x + 1,
+                      frame_row_offset + lcd_y, frame_row_offset + lcd_y);
+      ZLCD_gram_commit(pair_index, 2 * sizeof(rgb565));
+      ZLCD_mark_stale(pair_x, pair_x + 1, converted_y, converted_y);
+      ZLCD_pack_pixels(packed, pair_index, 2, pair_x, converted_y);
+      ZLCD_send_data(packed, sizeof(packed));
+    } else {
+      ZLCD_set_window(frame_col_offset + converted_x,
+                      frame_col_offset + converted_x, frame_row_offset + lcd_y,
+                      frame_row_offset + lcd_y);
+      ZLCD_gram_commit(index, sizeof(rgb565));
+      ZLCD_mark_stale(converted_x, converted_x, converted_y, converted_y);
+      ZLCD_send_data(ZLCD_gram_wire_bytes(index), sizeof(rgb565));
+    }
+  } else {
+    ZLCD_mark_covered(converted_x, converted_x, converted_y, converted_y);
+  }
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_set_pixel(ZLCD_pixel_coordinate coordinate,
+                                  rgb565 colour, bool update_now) {
+  return ZLCD_set_pixel_xy(coordinate.x, coordinate.y, colour, update_now);
+}
+
+// todo: PWM for backlight
+// ZLCD_RETURN_STATUS ZLCD_set_brightness(uint16_t brightness) {
+//   if (!ZLCD_initialized) {
+//     printf("Initialize the LCD before calling other ZLCD functions\n");
+//     return ZLCD_ERR_NOT_INITIALIZED;
+//   }
+//   if (brightness == current_brightness) {
+//     return ZLCD_SUCCESS;
+//   }
+//   // use FPGA fabric to control backlight with PWM instead
+//   XGpio_DiscreteWrite(&LCD_backlight_duty_cycle_16_bit, 1, brightness);
+//   printf("Reading of backlight: %u\n", (XGpio_DiscreteRead(&LCD_gpios, 1) >>
+//   LCD_BACKLIGHT) & 0x1); printf("Reading of duty cycle: %u\n",
+//   XGpio_DiscreteRead(&LCD_backlight_duty_cycle_16_bit, 1));
+//   current_brightness = brightness;
+//   return ZLCD_SUCCESS;
+// }
+
+// grows row spans (dirty_x_start/end and the like) to take in a rectangle
+static inline void ZLCD_add_spans(uint16_t *x_start, uint16_t *x_end,
+                                  uint16_t *y_start, uint16_t *y_end,
+                                  uint16_t x0, uint16_t x1, uint16_t y0,
+                                  uint16_t y1) {
+  for (uint16_t y = y0; y <= y1; y++) {
+    if (x_end[y] == 0) {
+      x_start[y] = x0;
+      x_end[y] = x1 + 1;
+      continue;
+    }
+    if (x0 < x_start[y]) {
+      x_start[y] = x0;
+    }
+    if (x1 >= x_end[y]) {
+      x_end[y] = x1 + 1;
+    }
+  }
+  if (*y_end == 0) {
+    *y_start = y0;
+    *y_end = y1 + 1;
+    return;
+  }
+  if (y0 < *y_start) {
+    *y_start = y0;
+  }
+  if (y1 >= *y_end) {
+    *y_end = y1 + 1;
+  }
+}
+
+static void ZLCD_add_stale(uint8_t buffer, uint16_t x0, uint16_t x1,
+                           uint16_t y0, uint16_t y1) {
+  ZLCD_row_spans *stale = &stale_rows[buffer];
+  ZLCD_add_spans(stale->x_start, stale->x_end, &stale->y_start, &stale->y_end,
+                 x0, x1, y0, y1);
+}
+
+/*
+the whole frame is missing from a buffer, replacing spans that may be in the
+shape of another orientation's frame
+*/
+static void ZLCD_stale_frame(uint8_t buffer) {
+  memset(&stale_rows[buffer], 0, sizeof(stale_rows[buffer]));
+  ZLCD_add_stale(buffer, 0, current_kernels->frame_width - 1, 0,
+                 current_kernels->frame_height - 1);
+}
+
+// frame pixels tile number tile covers along an axis length pixels long
+static inline uint16_t ZLCD_tile_extent(uint16_t tile, uint16_t length) {
+  uint16_t left = length - tile * ZLCD_HASH_TILE_SIZE;
+  return left < ZLCD_HASH_TILE_SIZE ? left : ZLCD_HASH_TILE_SIZE;
+}
+
+static inline size_t ZLCD_tile_index(uint16_t tile_x, uint16_t tile_y) {
+  return (size_t)tile_y * ZLCD_HASH_TILES(current_kernels->frame_width) +
+         tile_x;
+}
+
+// digest of a tile of the frame, as it would go out
+static uint32_t ZLCD_hash_frame_tile(uint16_t tile_x, uint16_t tile_y) {
+  size_t stride_bytes = (size_t)current_kernels->frame_width * sizeof(rgb565);
+  size_t index = (size_t)tile_y * ZLCD_HASH_TILE_SIZE * stride_bytes +
+                 (size_t)tile_x * ZLCD_HASH_TILE_SIZE * sizeof(rgb565);
+  return ZLCD_hash_tile(
+      ZLCD_gram_wire_bytes(index), stride_bytes,
+      ZLCD_tile_extent(tile_x, current_kernels->frame_width),
+      ZLCD_tile_extent(tile_y, current_kernels->frame_height));
+}
+
+// digest of a width by height tile all in one colour (wire order pattern)
+static uint32_t ZLCD_hash_solid_tile(uint16_t wire, uint16_t width,
+                                     uint16_t height) {
+  uint16_t row[ZLCD_HASH_TILE_SIZE];
+  for (uint16_t i = 0; i < ZLCD_HASH_TILE_SIZE; i++) {
+    row[i] = wire;
+  }
+  return ZLCD_hash_tile((const uint8_t *)row, 0, width, height);
+}
+
+// forgets the digests of the tiles meeting columns x0 to x1, rows y0 to y1
+static void ZLCD_forget_tiles(uint16_t x0, uint16_t x1, uint16_t y0,
+                              uint16_t y1) {
+  for (uint16_t tile_y = y0 / ZLCD_HASH_TILE_SIZE;
+       tile_y <= y1 / ZLCD_HASH_TILE_SIZE; tile_y++) {
+    for (uint16_t tile_x = x0 / ZLCD_HASH_TILE_SIZE;
+         tile_x <= x1 / ZLCD_HASH_TILE_SIZE; tile_x++) {
+      tile_known[ZLCD_tile_index(tile_x, tile_y)] = false;
+    }
+  }
+}
+
+/*
+Columns of the tiles in tile row tile_y that lie inside the frame rectangle x0
+to x1, y0 to y1 (inclusive) as tile numbers first to end - 1. false if none do.
+*/
+static bool ZLCD_tiles_inside(uint16_t tile_y, uint16_t x0, uint16_t x1,
+                              uint16_t y0, uint16_t y1, uint16_t *first,
+                              uint16_t *end) {
+  uint16_t width = current_kernels->frame_width;
+  uint16_t top = tile_y * ZLCD_HASH_TILE_SIZE;
+  if (top < y0 ||
+      top + ZLCD_tile_extent(tile_y, current_kernels->frame_height) > y1 + 1U) {
+    return false;
+  }
+  *first = ZLCD_HASH_TILES(x0);
+  // the narrow tile at the right edge ends with the frame
+  *end = x1 + 1U == width ? ZLCD_HASH_TILES(width)
+                          : (x1 + 1U) / ZLCD_HASH_TILE_SIZE;
+  return *first < *end;
+}
+
+/*
+sets solid[tile_x] for the tiles of tile row tile_y that lie inside the frame
+rectangle and are known to show the colour (wire order pattern) on the LCD
+*/
+static void ZLCD_find_solid_tiles(bool *solid, uint16_t tile_y, uint16_t x0,
+                                  uint16_t x1, uint16_t y0, uint16_t y1,
+                                  uint16_t wire) {
+  uint16_t first, end;
+  memset(solid, 0,
+         ZLCD_HASH_TILES(current_kernels->frame_width) * sizeof(bool));
+  if (!ZLCD_tiles_inside(tile_y, x0, x1, y0, y1, &first, &end)) {
+    return;
+  }
+  uint16_t height = ZLCD_tile_extent(tile_y, current_kernels->frame_height);
+  for (uint16_t tile_x = first; tile_x < end; tile_x++) {
+    size_t tile = ZLCD_tile_index(tile_x, tile_y);
+    solid[tile_x] =
+        tile_known[tile] &&
+        tile_digest[tile] ==
+            ZLCD_hash_solid_tile(
+                wire, ZLCD_tile_extent(tile_x, current_kernels->frame_width),
+                height);
+  }
+}
+
+// the tiles inside the frame rectangle show the colour on the LCD now
+static void ZLCD_know_solid_tiles(uint16_t x0, uint16_t x1, uint16_t y0,
+                                  uint16_t y1, uint16_t wire) {
+  for (uint16_t tile_y = y0 / ZLCD_HASH_TILE_SIZE;
+       tile_y <= y1 / ZLCD_HASH_TILE_SIZE; tile_y++) {
+    uint16_t first, end;
+    if (!ZLCD_tiles_inside(tile_y, x0, x1, y0, y1, &first, &end)) {
+      continue;
+    }
+    uint16_t height = ZLCD_tile_extent(tile_y, current_kernels->frame_height);
+    for (uint16_t tile_x = first; tile_x < end; tile_x++) {
+      size_t tile = ZLCD_tile_index(tile_x, tile_y);
+      tile_digest[tile] = ZLCD_hash_solid_tile(
+          wire, ZLCD_tile_extent(tile_x, current_kernels->frame_width),
+          height);
+      tile_known[tile] = true;
+    }
+  }
+}
+
+/*
+GRAM_previous was changed behind the drawing functions' back (an immediate
+update), so the buffers other than the two in use no longer have it there and
+the digests of the tiles it is in no longer tell what the LCD shows
+*/
+static void ZLCD_mark_stale(uint16_t x0, uint16_t x1, uint16_t y0,
+                            uint16_t y1) {
+  for (uint8_t i = 0; i < num_frame_buffers; i++) {
+    if (i != current_buffer && i != previous_buffer) {
+      ZLCD_add_stale(i, x0, x1, y0, y1);
+    }
+  }
+  if (current_buffer_mode == ZLCD_BUFFER_HASHED) {
+    ZLCD_forget_tiles(x0, x1, y0, y1);
+  }
+}
+
+/*
+the LCD rows y0 to y1 were written from outside the GRAM
+(ZLCD_write_frame_rows()), only remembered until ZLCD_settle_overwritten_rows()
+*/
+static void ZLCD_overwritten_rows(uint16_t y0, uint16_t y1) {
+  for (uint16_t y = y0; y <= y1; y++) {
+    overwritten_rows[y] = true;
+  }
+  overwritten_y_start = y0 < overwritten_y_start ? y0 : overwritten_y_start;
+  overwritten_y_end = y1 >= overwritten_y_end ? y1 + 1U : overwritten_y_end;
+}
+
+/*
+Makes the next refresh send the overwritten rows from the GRAM again: they are
+marked dirty and GRAM_previous gets their complement. Called with the bus idle
+before anything reads GRAM_previous, the dirty spans or the tile digests. No
+refresh can have started since the rows were written, ZLCD_write_frame_rows()
+waits for the bus and every refresh settles first.
+*/
+static void ZLCD_settle_overwritten_rows(void) {
+  if (overwritten_y_end == 0) {
+    return;
+  }
+  uint16_t x1 = current_kernels->frame_width - 1;
+  size_t row_bytes = (size_t)current_kernels->frame_width * sizeof(rgb565);
+  for (uint16_t y = overwritten_y_start, end; y < overwritten_y_end; y = end) {
+    end = y + 1U;
+    if (!overwritten_rows[y]) {
+      continue;
+    }
+    while (end < overwritten_y_end && overwritten_rows[end]) {
+      end++;
+    }
+    memset(&overwritten_rows[y], 0, end - y);
+    ZLCD_mark_stale(0, x1, y, end - 1U);
+    ZLCD_mark_dirty(0, x1, y, end - 1U);
+    ZLCD_gram_invert((size_t)y * row_bytes, (size_t)(end - y) * row_bytes);
+  }
+  overwritten_y_start = ZLCD_HEIGHT;
+  overwritten_y_end = 0;
+}
+
+/*
+Brings the stale pixels of GRAM_current in rows y0 to y1 that meet columns x0
+to x1 up to date before they are drawn on. With covered every pixel of the area
+is about to be written: stale pixels under it are dropped instead of copied
+and a span sticking out on one side only shrinks. A span the area is inside of
+is copied whole, so a span never has holes.
+*/
+static inline void ZLCD_repair_rows(uint16_t x0, uint16_t x1, uint16_t y0,
+                                    uint16_t y1, bool covered) {
+  ZLCD_row_spans *stale = &stale_rows[current_buffer];
+  if (stale->y_end == 0 || y1 < stale->y_start || y0 >= stale->y_end) {
+    return; // always the case with ZLCD_BUFFER_COPY
+  }
+  y0 = y0 > stale->y_start ? y0 : stale->y_start;
+  y1 = y1 < stale->y_end - 1 ? y1 : stale->y_end - 1;
+  size_t stride_bytes = (size_t)current_kernels->frame_width * sizeof(rgb565);
+  for (uint16_t y = y0; y <= y1; y++) {
+    uint16_t start = stale->x_start[y], end = stale->x_end[y];
+    if (end == 0 || end <= x0 || start > x1) {
+      continue;
+    }
+    if (covered && start >= x0) {
+      if (end <= x1 + 1U) {
+        stale->x_end[y] = 0;
+      } else {
+        stale->x_start[y] = x1 + 1;
+      }
+      continue;
+    }
+    if (covered && end <= x1 + 1U) {
+      stale->x_end[y] = x0;
+      continue;
+    }
+    ZLCD_gram_restore((size_t)y * stride_bytes + start * sizeof(rgb565),
+                      (size_t)(end - start) * sizeof(rgb565));
+    stale->x_end[y] = 0;
+  }
+}
+
+// brings all of GRAM_current up to date with GRAM_previous
+static void ZLCD_repair_all_rows(void) {
+  ZLCD_row_spans *stale = &stale_rows[current_buffer];
+  if (stale->y_end != 0) {
+    ZLCD_repair_rows(0, current_kernels->frame_width - 1, stale->y_start,
+                     stale->y_end - 1, false);
+    stale->y_end = 0;
+  }
+}
+
+// frame coordinates, inclusive, x0 <= x1 and y0 <= y1
+static inline void ZLCD_mark_dirty(uint16_t x0, uint16_t x1, uint16_t y0,
+                                   uint16_t y1) {
+  ZLCD_repair_rows(x0, x1, y0, y1, false);
+  ZLCD_add_spans(dirty_x_start, dirty_x_end, &dirty_y_start, &dirty_y_end, x0,
+                 x1, y0, y1);
+}
+
+// ZLCD_mark_dirty() for an area that is about to be written in full
+static inline void ZLCD_mark_covered(uint16_t x0, uint16_t x1, uint16_t y0,
+                                     uint16_t y1) {
+  ZLCD_repair_rows(x0, x1, y0, y1, true);
+  ZLCD_add_spans(dirty_x_start, dirty_x_end, &dirty_y_start, &dirty_y_end, x0,
+                 x1, y0, y1);
+}
+
+/*
+converts a rectangle given in the current orientation (inclusive corners) to
+frame pixels, clipped to the screen. Opposite corners stay opposite corners
+after the transform. Returns false if nothing of it is on the screen.
+*/
+static bool ZLCD_frame_rect_xy(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                               uint16_t *frame_x0, uint16_t *frame_x1,
+                               uint16_t *frame_y0, uint16_t *frame_y1) {
+  if (x0 < 0) {
+    x0 = 0;
+  }
+  if (y0 < 0) {
+    y0 = 0;
+  }
+  if (x1 >= current_orientation.horizontal_axis_length_px) {
+    x1 = current_orientation.horizontal_axis_length_px - 1;
+  }
+  if (y1 >= current_orientation.vertical_axis_length_px) {
+    y1 = current_orientation.vertical_axis_length_px - 1;
+  }
+  if (x0 > x1 || y0 > y1) {
+    return false;
+  }
+  size_t first = current_kernels->index(x0, y0) / sizeof(rgb565);
+  size_t last = current_kernels->index(x1, y1) / sizeof(rgb565);
+  uint16_t stride = current_kernels->frame_width;
+  uint16_t first_x = first % stride, first_y = first / stride;
+  uint16_t last_x = last % stride, last_y = last / stride;
+  *frame_x0 = first_x < last_x ? first_x : last_x;
+  *frame_x1 = first_x < last_x ? last_x : first_x;
+  *frame_y0 = first_y < last_y ? first_y : last_y;
+  *frame_y1 = first_y < last_y ? last_y : first_y;
+  return true;
+}
+
+// marks a rectangle given in the current orientation (inclusive corners)
+static void ZLCD_mark_dirty_rect_xy(int16_t x0, int16_t y0, int16_t x1,
+                                    int16_t y1) {
+  uint16_t px0, px1, py0, py1;
+  if (ZLCD_frame_rect_xy(x0, y0, x1, y1, &px0, &px1, &py0, &py1)) {
+    ZLCD_mark_dirty(px0, px1, py0, py1);
+  }
+}
+
+// same for a rectangle every pixel of which is about to be written
+static void ZLCD_mark_covered_rect_xy(int16_t x0, int16_t y0, int16_t x1,
+                                      int16_t y1) {
+  uint16_t px0, px1, py0, py1;
+  if (ZLCD_frame_rect_xy(x0, y0, x1, y1, &px0, &px1, &py0, &py1)) {
+    ZLCD_mark_covered(px0, px1, py0, py1);
+  }
+}
+
+/*
+fills and marks a rectangle given in the current orientation (inclusive
+corners). It is a rectangle in the GRAM whatever the orientation, so it is
+filled with contiguous row spans.
+*/
+static void ZLCD_fill_rect_xy_internal(int16_t x0, int16_t y0, int16_t x1,
+                                       int16_t y1, rgb565 colour) {
+  uint16_t px0, px1, py0, py1;
+  if (!ZLCD_frame_rect_xy(x0, y0, x1, y1, &px0, &px1, &py0, &py1)) {
+    return;
+  }
+  uint16_t stride = current_kernels->frame_width;
+  ZLCD_mark_covered(px0, px1, py0, py1);
+  ZLCD_fill_rect(
+      ZLCD_gram_pixels(((size_t)py0 * stride + px0) * sizeof(rgb565)),
+      ZLCD_gram_pattern(colour), px1 - px0 + 1U, py1 - py0 + 1U, stride);
+}
+
+#endif
+
+// sends num_pixels of one colour as pixel data, from fill_stream
+static void ZLCD_send_repeated(rgb565 colour, size_t num_pixels) {
+  size_t num_bytes = ZLCD_pixels_packed() ? ZLCD_PACK_RGB444_BYTES(num_pixels)
+                                          : num_pixels * sizeof(rgb565);
+  // only as much as the first chunk needs
+  size_t stream_bytes =
+      num_bytes < ZLCD_FILL_STREAM_BYTES ? num_bytes : ZLCD_FILL_STREAM_BYTES;
+  if (ZLCD_pixels_packed()) {
+    const uint8_t pair[2 * sizeof(rgb565)] = {
+        (uint8_t)(colour >> 8), (uint8_t)(colour & 0x00FF),
+        (uint8_t)(colour >> 8), (uint8_t)(colour & 0x00FF)};
+    ZLCD_pack_rgb444(fill_stream, pair, 2);
+    for (size_t i = 3; i < stream_bytes; i++) {
+      fill_stream[i] = fill_stream[i - 3];
+    }
+  } else {
+    ZLCD_fill_span((ZLCD_fill_pixel *)fill_stream, ZLCD_wire_pattern(colour),
+                   stream_bytes / sizeof(rgb565));
+  }
+  while (num_bytes != 0) {
+    size_t chunk = num_bytes < ZLCD_FILL_STREAM_BYTES ? num_bytes
+                                                      : ZLCD_FILL_STREAM_BYTES;
+    ZLCD_send_data(fill_stream, chunk);
+    num_bytes -= chunk;
+  }
+}
+
+#if !ZLCD_FRAMELESS
+/*
+false if a rectangle has to go through the GRAM instead of
+ZLCD_fill_rect_xy_now(): dithered pixels differ per position and RGB444 pairs
+must not be cut in half
+*/
+static bool ZLCD_can_fill_now(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+  uint16_t px0, px1, py0, py1;
+  if (!ZLCD_frame_rect_xy(x0, y0, x1, y1, &px0, &px1, &py0, &py1)) {
+    return true; // nothing on the screen
+  }
+  if (current_pixel_format == ZLCD_PIXEL_RGB444_DITHERED) {
+    return false;
+  }
+  return !ZLCD_pixels_packed() || ((px0 & 1U) == 0 && (px1 & 1U) != 0);
+}
+
+/*
+Immediate solid rectangle (corners inclusive, current orientation). Every row is
+trimmed to the pixels the LCD does not show in the colour yet, read only from
+both ends of GRAM_previous, so redrawing the same background costs no more bus
+time than a refresh and a page switch stops at the first pixel. Both GRAM images
+then get the colour from the fill kernels and the rows are planned like a
+refresh, each window streaming the colour from fill_stream. Nothing is copied
+and nothing is left dirty. ZLCD_BUFFER_HASHED has no image of the LCD to read,
+rows are only trimmed by the tiles inside the rectangle whose digest says they
+show the colour already, and the tiles inside get that digest afterwards.
+Check ZLCD_can_fill_now() first.
+*/
+static void ZLCD_fill_rect_xy_now(int16_t x0, int16_t y0, int16_t x1,
+                                  int16_t y1, rgb565 colour) {
+  uint16_t px0, px1, py0, py1;
+  if (!ZLCD_frame_rect_xy(x0, y0, x1, y1, &px0, &px1, &py0, &py1)) {
+    return;
+  }
+  // GRAM_previous and the LCD may still be busy with an async refresh
+  ZLCD_wait_for_bus();
+  ZLCD_settle_overwritten_rows();
+  uint16_t stride = current_kernels->frame_width;
+  uint16_t width = px1 - px0 + 1U;
+  uint16_t height = py1 - py0 + 1U;
+  size_t index = ((size_t)py0 * stride + px0) * sizeof(rgb565);
+  uint16_t wire = ZLCD_wire_pattern(colour);
+  bool hashed = current_buffer_mode == ZLCD_BUFFER_HASHED;
+  // ZLCD_BUFFER_HASHED: tiles of the current tile row showing the colour
+  bool solid[ZLCD_HASH_TILES(ZLCD_HEIGHT)];
+
+  for (uint16_t y = py0; y <= py1; y++) {
+    uint16_t first = px0, end = px1 + 1U;
+    if (hashed) {
+      if (y == py0 || y % ZLCD_HASH_TILE_SIZE == 0) {
+        ZLCD_find_solid_tiles(solid, y / ZLCD_HASH_TILE_SIZE, px0, px1, py0,
+                              py1, wire);
+      }
+      while (first < end && solid[first / ZLCD_HASH_TILE_SIZE]) {
+        first = (first / ZLCD_HASH_TILE_SIZE + 1U) * ZLCD_HASH_TILE_SIZE;
+        first = first < end ? first : end;
+      }
+      while (end > first && solid[(end - 1U) / ZLCD_HASH_TILE_SIZE]) {
+        end = (end - 1U) / ZLCD_HASH_TILE_SIZE * ZLCD_HASH_TILE_SIZE;
+        end = end > first ? end : first;
+      }
+    } else {
+      const ZLCD_fill_pixel *row =
+          (const ZLCD_fill_pixel *)((const uint8_t *)GRAM_previous +
+                                    (size_t)y * stride * sizeof(rgb565));
+      while (first < end && row[first] == wire) {
+        first++;
+      }
+      while (end > first && row[end - 1] == wire) {
+        end--;
+      }
+    }
+    if (ZLCD_pixels_packed() && first != end) {
+      first &= ~1U; // still inside the rectangle, px0 is even
+      end = (end + 1U) & ~1U;
+    }
+    fill_x_start[y] = first;
+    fill_x_end[y] = first == end ? 0 : end;
+    if (first != end) {
+      ZLCD_mark_stale(first, end - 1, y, y);
+    }
+    // spans that are now fully covered have nothing left to send
+    if (dirty_x_end[y] != 0 && dirty_x_start[y] >= px0 &&
+        dirty_x_end[y] <= px1 + 1U) {
+      dirty_x_end[y] = 0;
+    }
+  }
+  ZLCD_repair_rows(px0, px1, py0, py1, true);
+  ZLCD_fill_rect(ZLCD_gram_pixels(index), ZLCD_gram_pattern(colour), width,
+                 height, stride);
+  if (hashed) {
+    ZLCD_know_solid_tiles(px0, px1, py0, py1, wire);
+  } else {
+    ZLCD_fill_rect((ZLCD_fill_pixel *)((uint8_t *)GRAM_previous + index), wire,
+                   width, height, stride);
+  }
+
+  size_t num_entries = ZLCD_plan_spans(fill_x_start, fill_x_end, py0, py1 + 1U,
+                                       refresh_plan, ZLCD_HEIGHT);
+  uint16_t frame_height = current_kernels->frame_height;
+  for (size_t i = 0; i < num_entries; i++) {
+    const ZLCD_plan_entry *entry = &refresh_plan[i];
+    uint16_t lcd_y0 = entry->y0 + ZLCD_scroll_shift(entry->y0);
+    uint16_t lcd_y1 = lcd_y0 + (entry->y1 - entry->y0);
+    if (entry->continue_write) {
+      ZLCD_send_command(0x3C); // Memory write continue
+    } else {
+      ZLCD_set_window(frame_col_offset + entry->x0,
+                      frame_col_offset + entry->x1, frame_row_offset + lcd_y0,
+                      frame_row_offset + frame_height - 1);
+    }
+    size_t num_pixels = (size_t)(entry->x1 - entry->x0 + 1U) *
+                        (entry->y1 - entry->y0 + 1U);
+    ZLCD_send_repeated(colour, num_pixels);
+    cached_pointer_row = lcd_y1 + 1 < frame_height ? lcd_y1 + 1 : 0xFFFF;
+    ZLCD_STATS(driver_stats.rows_sent += entry->y1 - entry->y0 + 1U;
+               driver_stats.pixels_sent += num_pixels);
+  }
+}
+
+// corners inclusive, current orientation
+typedef struct {
+  int16_t x0, y0, x1, y1;
+  rgb565 colour;
+} ZLCD_solid_rect;
+
+/*
+update_now version of a filled rectangle. The inside and the four border bands
+are sent as separate solid rectangles: drawn into the GRAM, the two side bands
+would make the refresh send every row of the inside again. Drawn into the GRAM
+as a whole if any of them can't be sent directly
+*/
+static void ZLCD_draw_filled_rectangle_now(uint16_t origin_x, uint16_t origin_y,
+                                           uint16_t width_px,
+                                           uint16_t height_px,
+                                           uint16_t border_thickness_px,
+                                           rgb565 border_colour,
+                                           rgb565 fill_colour) {
+  int16_t x0 = origin_x, y0 = origin_y;
+  int16_t x1 = origin_x + width_px - 1, y1 = origin_y + height_px - 1;
+  int16_t t = border_thickness_px == 0 ? 1 : border_thickness_px;
+  bool bordered = border_colour != fill_colour;
+  int16_t inset = bordered ? t : 0;
+  const ZLCD_solid_rect parts[] = {
+      {x0 + inset, y0 + inset, x1 - inset, y1 - inset, fill_colour}, // inside
+      {x0, y0, x1, y0 + t - 1, border_colour},                       // top
+      {x0, y1 - t + 1, x1, y1, border_colour},                       // bottom
+      {x0, y0 + t, x0 + t - 1, y1 - t, border_colour},               // left
+      {x1 - t + 1, y0 + t, x1, y1 - t, border_colour}};              // right
+  size_t num_parts = bordered ? sizeof(parts) / sizeof(parts[0]) : 1;
+  for (size_t i = 0; i < num_parts; i++) {
+    if (!ZLCD_can_fill_now(parts[i].x0, parts[i].y0, parts[i].x1,
+                           parts[i].y1)) {
+      ZLCD_draw_rectangle_xy_internal(origin_x, origin_y, width_px, height_px,
+                                      border_thickness_px, true, border_colour,
+                                      fill_colour);
+      return;
+    }
+  }
+  for (size_t i = 0; i < num_parts; i++) {
+    ZLCD_fill_rect_xy_now(parts[i].x0, parts[i].y0, parts[i].x1, parts[i].y1,
+                          parts[i].colour);
+  }
+}
+
+// debug check: every pixel that differs from the LCD must have been marked
+static void ZLCD_verify_dirty_rows(void) {
+  uint16_t stride = current_kernels->frame_width;
+  for (uint16_t y = 0; y < current_kernels->frame_height; y++) {
+    size_t row_offset = (size_t)y * stride * sizeof(rgb565);
+    int16_t first = -1, last = -1;
+    for (uint16_t x = 0; x < stride; x++) {
+      size_t index = row_offset + x * sizeof(rgb565);
+      if (ZLCD_gram_changed(index)) {
+        if (first < 0) {
+          first = x;
+        }
+        last = x;
+      }
+    }
+    if (first < 0) {
+      continue;
+    }
+    if (dirty_x_end[y] == 0 || first < dirty_x_start[y] ||
+        last >= dirty_x_end[y]) {
+      printf("ZLCD: row %u changed at x %d-%d without being marked dirty\n", y,
+             first, last);
+      ZLCD_STATS(driver_stats.verify_misses++);
+      ZLCD_mark_dirty(first, last, y, y);
+    }
+  }
+}
+
+/*
+ZLCD_BUFFER_HASHED debug check: every tile whose digest no longer matches must
+have been marked. Tiles without a known digest can't be checked, and a change
+the digest misses (see zynq_lcd_hash.h) goes unnoticed here as well.
+*/
+static void ZLCD_verify_dirty_tiles(void) {
+  uint16_t width = current_kernels->frame_width;
+  uint16_t height = current_kernels->frame_height;
+  for (uint16_t tile_y = 0; tile_y < ZLCD_HASH_TILES(height); tile_y++) {
+    uint16_t y0 = tile_y * ZLCD_HASH_TILE_SIZE;
+    uint16_t y1 = y0 + ZLCD_tile_extent(tile_y, height) - 1U;
+    for (uint16_t tile_x = 0; tile_x < ZLCD_HASH_TILES(width); tile_x++) {
+      size_t tile = ZLCD_tile_index(tile_x, tile_y);
+      if (!tile_known[tile] ||
+          ZLCD_hash_frame_tile(tile_x, tile_y) == tile_digest[tile]) {
+        continue;
+      }
+      uint16_t x0 = tile_x * ZLCD_HASH_TILE_SIZE;
+      uint16_t x1 = x0 + ZLCD_tile_extent(tile_x, width) - 1U;
+      bool marked = false;
+      for (uint16_t y = y0; y <= y1 && !marked; y++) {
+        marked = dirty_x_end[y] != 0 && dirty_x_start[y] <= x1 &&
+                 dirty_x_end[y] > x0;
+      }
+      if (!marked) {
+        printf("ZLCD: tile at x %u y %u changed without being marked dirty\n",
+               x0, y0);
+        ZLCD_STATS(driver_stats.verify_misses++);
+        ZLCD_mark_dirty(x0, x1, y0, y1);
+      }
+    }
+  }
+}
+
+/*
+ZLCD_BUFFER_HASHED version of the trimming below. There is no image of the LCD
+to compare against, so every tile the marked spans meet is hashed and the spans
+are trimmed from both ends down to the tiles whose digest changed or is not
+known. Those tiles take the new digest, every marked pixel in them is sent and
+the LCD matches the frame outside the marked spans, so it is the digest of what
+the LCD shows once the refresh is out.
+*/
+static bool ZLCD_prepare_dirty_tiles(void) {
+  bool changed[ZLCD_HASH_TILES(ZLCD_HEIGHT)];
+  bool any_dirty = false;
+  for (uint16_t tile_y = dirty_y_start / ZLCD_HASH_TILE_SIZE;
+       tile_y * ZLCD_HASH_TILE_SIZE < dirty_y_end; tile_y++) {
+    uint16_t y0 = tile_y * ZLCD_HASH_TILE_SIZE;
+    uint16_t y_end = y0 + ZLCD_HASH_TILE_SIZE < dirty_y_end
+                         ? y0 + ZLCD_HASH_TILE_SIZE
+                         : dirty_y_end;
+    // columns the spans of the tile row meet
+    uint16_t x_start = current_kernels->frame_width, x_end = 0;
+    for (uint16_t y = y0; y < y_end; y++) {
+      if (dirty_x_end[y] != 0) {
+        x_start = dirty_x_start[y] < x_start ? dirty_x_start[y] : x_start;
+        x_end = dirty_x_end[y] > x_end ? dirty_x_end[y] : x_end;
+      }
+    }
+    if (x_end == 0) {
+      continue;
+    }
+    for (uint16_t tile_x = x_start / ZLCD_HASH_TILE_SIZE;
+         tile_x * ZLCD_HASH_TILE_SIZE < x_end; tile_x++) {
+      size_t tile = ZLCD_tile_index(tile_x, tile_y);
+      uint32_t digest = ZLCD_hash_frame_tile(tile_x, tile_y);
+      changed[tile_x] = !tile_known[tile] || tile_digest[tile] != digest;
+      tile_digest[tile] = digest;
+      tile_known[tile] = true;
+      ZLCD_STATS(driver_stats.tiles_hashed++;
+                 driver_stats.tiles_unchanged += !changed[tile_x]);
+    }
+    for (uint16_t y = y0; y < y_end; y++) {
+      if (dirty_x_end[y] == 0) {
+        continue;
+      }
+      uint16_t first = dirty_x_start[y];
+      uint16_t end = dirty_x_end[y];
+      while (first < end && !changed[first / ZLCD_HASH_TILE_SIZE]) {
+        first = (first / ZLCD_HASH_TILE_SIZE + 1U) * ZLCD_HASH_TILE_SIZE;
+      }
+      while (end > first && !changed[(end - 1U) / ZLCD_HASH_TILE_SIZE]) {
+        end = (end - 1U) / ZLCD_HASH_TILE_SIZE * ZLCD_HASH_TILE_SIZE;
+      }
+      if (first >= end) {
+        dirty_x_end[y] = 0;
+        continue;
+      }
+      if (ZLCD_pixels_packed()) {
+        // whole pixel pairs, the frame width is even
+        first &= ~1U;
+        end = (end + 1U) & ~1U;
+      }
+      dirty_x_start[y] = first;
+      dirty_x_end[y] = end;
+      any_dirty = true;
+    }
+  }
+  if (!any_dirty) {
+    dirty_y_end = 0;
+  }
+  return any_dirty;
+}
+
+/*
+Shrinks every marked span to the pixels that really differ from what is on the
+LCD and drops rows that turn out unchanged (e.g. something was redrawn in the
+same colour). Returns false when nothing has to be sent. Only the marked spans
+are compared, so the cost follows what was drawn.
+*/
+static ZLCD_HOT_CODE bool ZLCD_prepare_dirty_rows(void) {
+  ZLCD_settle_overwritten_rows();
+  // what drawing did not cover is still missing from GRAM_current
+  ZLCD_repair_all_rows();
+  bool hashed = current_buffer_mode == ZLCD_BUFFER_HASHED;
+  if (current_refresh_mode == ZLCD_REFRESH_VERIFY) {
+    if (hashed) {
+      ZLCD_verify_dirty_tiles();
+    } else {
+      ZLCD_verify_dirty_rows();
+    }
+  }
+  if (dirty_y_end == 0) {
+    return false;
+  }
+  if (hashed) {
+    return ZLCD_prepare_dirty_tiles();
+  }
+  bool any_dirty = false;
+  for (uint16_t y = dirty_y_start; y < dirty_y_end; y++) {
+    if (dirty_x_end[y] == 0) {
+      continue;
+    }
+    size_t row_offset =
+        (size_t)y * current_kernels->frame_width * sizeof(rgb565);
+    uint16_t first = dirty_x_start[y];
+    uint16_t end = dirty_x_end[y];
+    while (first < end &&
+           !ZLCD_gram_changed(row_offset + first * sizeof(rgb565))) {
+      first++;
+    }
+    while (end > first &&
+           !ZLCD_gram_changed(row_offset + (end - 1) * sizeof(rgb565))) {
+      end--;
+    }
+    if (first == end) {
+      dirty_x_end[y] = 0;
+      continue;
+    }
+    if (ZLCD_pixels_packed()) {
+      // whole pixel pairs, the frame width is even
+      first &= ~1U;
+      end = (end + 1U) & ~1U;
+    }
+    dirty_x_start[y] = first;
+    dirty_x_end[y] = end;
+    any_dirty = true;
+  }
+  if (!any_dirty) {
+    dirty_y_end = 0;
+  }
+  return any_dirty;
+}
+
+// what the ST7789 is set up for right now, as seen by the planner
+static ZLCD_plan_state ZLCD_current_plan_state(void) {
+  ZLCD_plan_state state = {.col_start = ZLCD_PLAN_UNKNOWN,
+                           .col_end = ZLCD_PLAN_UNKNOWN,
+                           .row_start = ZLCD_PLAN_UNKNOWN,
+                           .pointer_row = ZLCD_PLAN_UNKNOWN,
+                           .width = current_kernels->frame_width,
+                           .height = current_kernels->frame_height,
+                           .bits_per_pixel = ZLCD_pixels_packed() ? 12 : 16};
+  if (cached_col_start != 0xFFFF && cached_col_end != 0xFFFF) {
+    state.col_start = cached_col_start - frame_col_offset;
+    state.col_end = cached_col_end - frame_col_offset;
+  }
+  // refresh windows are always open ended, see ZLCD_plan_state
+  if (cached_row_end == frame_row_offset + state.height - 1) {
+    state.row_start = cached_row_start - frame_row_offset;
+    state.pointer_row = cached_pointer_row;
+  }
+  return state;
+}
+
+#endif
+
+// LCD RAM row minus screen row for screen row y, see scroll_offset
+static inline int16_t ZLCD_scroll_shift(uint16_t y) {
+  if (y < scroll_top || y - scroll_top >= scroll_height) {
+    return 0;
+  }
+  return y - scroll_top < scroll_height - scroll_offset
+             ? (int16_t)scroll_offset
+             : (int16_t)scroll_offset - (int16_t)scroll_height;
+}
+
+#if !ZLCD_FRAMELESS
+
+// moves the rows of a plan state by delta, rows that fall off become unknown
+static ZLCD_plan_state ZLCD_plan_state_shift(ZLCD_plan_state state,
+                                             int16_t delta) {
+  if (state.row_start != ZLCD_PLAN_UNKNOWN) {
+    int32_t row = (int32_t)state.row_start + delta;
+    state.row_start = row >= 0 ? (uint16_t)row : ZLCD_PLAN_UNKNOWN;
+  }
+  if (state.pointer_row != ZLCD_PLAN_UNKNOWN) {
+    int32_t row = (int32_t)state.pointer_row + delta;
+    state.pointer_row = row >= 0 ? (uint16_t)row : ZLCD_PLAN_UNKNOWN;
+  }
+  state.height += delta;
+  return state;
+}
+
+/*
+Plans the spans of rows y_start to y_end - 1 (see zynq_lcd_planner.h). While scrolled, the screen rows
+of the scroll area map onto the LCD RAM in two pieces, so the planner runs once
+for every stretch of rows with the same shift, with the window state moved into
+that stretch's screen rows. Entries are in screen rows, never cross a stretch
+and get their shift back from ZLCD_scroll_shift(entry->y0).
+*/
+static size_t ZLCD_plan_spans(const uint16_t *x_start, const uint16_t *x_end,
+                              uint16_t y_start, uint16_t y_end,
+                              ZLCD_plan_entry *entries, size_t max_entries) {
+  ZLCD_plan_state state = ZLCD_current_plan_state();
+  size_t num_entries = 0;
+  uint16_t y = y_start;
+  while (y < y_end && num_entries < max_entries) {
+    int16_t shift = ZLCD_scroll_shift(y);
+    uint16_t end = y + 1;
+    while (end < y_end && ZLCD_scroll_shift(end) == shift) {
+      end++;
+    }
+    ZLCD_plan_state local = ZLCD_plan_state_shift(state, -shift);
+    num_entries +=
+        ZLCD_plan_windows(x_start, x_end, y, end, &local,
+                          entries + num_entries, max_entries - num_entries);
+    state = ZLCD_plan_state_shift(local, shift);
+    y = end;
+  }
+  return num_entries;
+}
+
+static inline uint64_t ZLCD_ticks(void) {
+  XTime now;
+  XTime_GetTime(&now);
+  return (uint64_t)now;
+}
+
+/*
+adds a rising TE edge seen at now to the TE clock. When edges were missed in
+between (TE is only polled while waiting) they are counted, the frame period is
+only measured from back to back edges
+*/
+static void ZLCD_vsync_record_edge(uint64_t now) {
+  atomic_fetch_add(&te_sequence, 1U);
+  uint32_t frames = 1;
+  if (te_edges != 0) {
+    uint64_t period = now - te_edge_ticks;
+    if (te_frame_ticks == 0) {
+      te_frame_ticks = (uint32_t)period;
+    } else {
+      frames = (uint32_t)((period + te_frame_ticks / 2U) / te_frame_ticks);
+      if (frames <= 1U) {
+        frames = 1;
+        te_frame_ticks =
+            (uint32_t)((3U * (uint64_t)te_frame_ticks + period) / 4U);
+      }
+    }
+  }
+  te_edge_ticks = now;
+  te_edges += frames;
+  atomic_fetch_add(&te_sequence, 1U);
+}
+
+// ZLCD_VSYNC_TE_GPIO: looks at TE once and records a rising edge
+static void ZLCD_vsync_poll_te(void) {
+  if (current_vsync_mode != ZLCD_VSYNC_TE_GPIO) {
+    return;
+  }
+  bool level = (XGpio_ReadReg(LCD_gpios.BaseAddress, XGPIO_DATA2_OFFSET) >>
+                ZLCD_TE_GPIO_BIT) &
+               0x1;
+  uint64_t now = ZLCD_ticks();
+  // TE only rose now if it was low a moment ago, not when polling resumes in
+  // the middle of a blank
+  uint32_t line_ticks = te_frame_ticks / (ZLCD_HEIGHT + ZLCD_PORCH_LINES);
+  if (level && !te_level &&
+      (line_ticks == 0 || now - te_low_ticks <= line_ticks)) {
+    ZLCD_vsync_record_edge(now);
+  }
+  if (!level) {
+    te_low_ticks = now;
+  }
+  te_level = level;
+}
+
+// a consistent copy of the TE clock, false while no frame period is known
+static bool ZLCD_vsync_read_clock(uint64_t *edge_ticks, uint32_t *edges,
+                                  uint32_t *frame_ticks) {
+  uint32_t sequence;
+  do {
+    sequence = atomic_load(&te_sequence);
+    *edge_ticks = te_edge_ticks;
+    *edges = te_edges;
+    *frame_ticks = te_frame_ticks;
+  } while ((sequence & 1U) != 0 || sequence != atomic_load(&te_sequence));
+  return *frame_ticks != 0;
+}
+
+/*
+Waits until the TE clock can be relied on: an edge within the last few frames
+(TE_GPIO polls for one) or one recently enough with ZLCD_VSYNC_TE_EDGES.
+False if TE stayed quiet for ZLCD_VSYNC_TIMEOUT_MS (or is not running yet).
+*/
+static bool ZLCD_vsync_sync_clock(uint64_t *edge_ticks, uint32_t *edges,
+                                  uint32_t *frame_ticks) {
+  uint64_t start = ZLCD_ticks();
+  for (;;) {
+    ZLCD_vsync_poll_te();
+    uint64_t now = ZLCD_ticks();
+    if (ZLCD_vsync_read_clock(edge_ticks, edges, frame_ticks)) {
+      uint64_t age = now - *edge_ticks;
+      if (current_vsync_mode == ZLCD_VSYNC_TE_GPIO
+              ? age < (uint64_t)*frame_ticks * ZLCD_VSYNC_RESYNC_FRAMES
+              : age < ZLCD_VSYNC_TIMEOUT_TICKS) {
+        return true;
+      }
+    }
+    if (current_vsync_mode != ZLCD_VSYNC_TE_GPIO ||
+        now - start >= ZLCD_VSYNC_TIMEOUT_TICKS) {
+      return false;
+    }
+  }
+}
+
+/*
+Holds back the refresh planned into the first vsync_entries entries of
+refresh_plan until it can go out behind the panel scan, against a later TE edge
+than the refresh before it. Called right before its first byte is sent (or the
+recorded refresh is started). Does nothing with ZLCD_VSYNC_OFF, while sleeping
+(no scanning) or if TE has gone quiet.
+*/
+static void ZLCD_vsync_wait(void) {
+  size_t num_entries = vsync_entries;
+  vsync_entries = 0;
+  vsync_sent_bytes = 0;
+  uint64_t edge_ticks;
+  uint32_t edges, frame_ticks;
+  if (num_entries == 0 || current_sleep_mode == SLEEP_MODE ||
+      !ZLCD_vsync_sync_clock(&edge_ticks, &edges, &frame_ticks)) {
+    return;
+  }
+  uint32_t line_ticks = frame_ticks / (ZLCD_HEIGHT + ZLCD_PORCH_LINES);
+  ZLCD_vsync_timing timing = {
+      .line_ticks = line_ticks,
+      .blank_ticks = frame_ticks - (uint32_t)ZLCD_HEIGHT * line_ticks,
+      .guard_ticks = ZLCD_VSYNC_GUARD_LINES * line_ticks,
+      .lines = ZLCD_HEIGHT};
+  ZLCD_vsync_schedule schedule;
+  ZLCD_vsync_schedule_init(&schedule, &timing);
+
+  // frame rows on the scan lines, see ZLCD_vsync_schedule_rows()
+  bool across = (current_madctl & ST7789_MADCTL_MV) != 0;
+  bool mirrored = (current_madctl & ST7789_MADCTL_MY) != 0;
+  uint32_t bits_per_pixel = ZLCD_pixels_packed() ? 12U : 16U;
+  uint32_t bytes = 0;
+  for (size_t i = 0; i < num_entries; i++) {
+    const ZLCD_plan_entry *entry = &refresh_plan[i];
+    uint32_t width = entry->x1 - entry->x0 + 1U;
+    uint16_t rows = entry->y1 - entry->y0 + 1U;
+    // RAMWRC, or CASET/RASET/RAMWR in one packet
+    uint32_t setup = entry->continue_write ? 1U : 11U;
+    uint32_t row_bytes = width * bits_per_pixel / 8U;
+    bytes += setup + row_bytes * rows;
+    // the slowest case adds the planner's costs for the transfers, rows that
+    // are not one long transfer each pay for their own
+    uint32_t setup_cost =
+        setup + ZLCD_PLAN_TRANSFER_COST + 2U * ZLCD_PLAN_DC_TOGGLE_COST;
+    uint32_t row_cost = row_bytes;
+    if (bits_per_pixel == 16U && width != current_kernels->frame_width) {
+      row_cost += ZLCD_PLAN_TRANSFER_COST;
+    }
+    ZLCD_vsync_ticks setup_ticks = {
+        setup * ZLCD_VSYNC_WIRE_BYTE_TICKS / 256U,
+        setup_cost * vsync_byte_ticks / 256U};
+    ZLCD_vsync_ticks row_ticks = {row_bytes * ZLCD_VSYNC_WIRE_BYTE_TICKS / 256U,
+                                  row_cost * vsync_byte_ticks / 256U};
+    uint16_t line = frame_row_offset + entry->y0;
+    if (across) {
+      ZLCD_vsync_schedule_rows(&schedule, 0, 0, ZLCD_HEIGHT, rows, setup_ticks,
+                               row_ticks);
+    } else {
+      ZLCD_vsync_schedule_rows(&schedule,
+                               mirrored ? ZLCD_HEIGHT - 1U - line : line,
+                               mirrored ? -1 : 1, 1, rows, setup_ticks,
+                               row_ticks);
+    }
+  }
+
+  uint64_t now = ZLCD_ticks();
+  int32_t min_edge = (int32_t)(vsync_last_edge + 1U - edges);
+  int64_t start;
+  uint32_t edge = ZLCD_vsync_pick_start(&schedule, (int64_t)(now - edge_ticks),
+                                        min_edge > 0 ? (uint32_t)min_edge : 0U,
+                                        &start);
+  vsync_last_edge = edges + edge;
+  uint64_t target = edge_ticks + (uint64_t)start;
+  while (ZLCD_ticks() < target) {
+    ZLCD_vsync_poll_te(); // keeps the TE clock in step
+  }
+  vsync_sent_ticks = ZLCD_ticks();
+  vsync_sent_bytes = bytes;
+  ZLCD_STATS(driver_stats.vsync_wait_us +=
+             ZLCD_stats_ticks_to_us(vsync_sent_ticks - now);
+             driver_stats.vsync_unfit += !ZLCD_vsync_schedule_fits(&schedule));
+}
+
+/*
+after a synchronous refresh that ZLCD_vsync_wait() let go: moves the bus time
+estimate towards what the refresh took, overheads (DC, gaps) included
+*/
+static void ZLCD_vsync_sent(void) {
+  if (vsync_sent_bytes < ZLCD_VSYNC_MEASURE_BYTES) {
+    return;
+  }
+  uint64_t measured =
+      (ZLCD_ticks() - vsync_sent_ticks) * 256U / vsync_sent_bytes;
+  vsync_byte_ticks =
+      (uint32_t)((3U * (uint64_t)vsync_byte_ticks + measured) / 4U);
+  if (vsync_byte_ticks < ZLCD_VSYNC_WIRE_BYTE_TICKS) {
+    vsync_byte_ticks = ZLCD_VSYNC_WIRE_BYTE_TICKS;
+  }
+  vsync_sent_bytes = 0;
+}
+
+/*
+ZLCD_VSYNC_TE_GPIO: needs the second channel of AXI GPIO 0 (TE on bit
+ZLCD_TE_GPIO_BIT) and measures the frame period from it
+*/
+static ZLCD_RETURN_STATUS ZLCD_vsync_init(void) {
+  atomic_store(&te_sequence, 0U);
+  te_edges = 0;
+  te_frame_ticks = 0;
+  te_level = true; // an edge only counts once TE was seen low
+  vsync_entries = 0;
+  vsync_sent_bytes = 0;
+  vsync_byte_ticks = ZLCD_VSYNC_WIRE_BYTE_TICKS;
+  if (current_vsync_mode != ZLCD_VSYNC_TE_GPIO) {
+    return ZLCD_SUCCESS;
+  }
+  // with amp_queue CPU1 owns the pins, the second channel is only read here
+  if (LCD_gpios.IsReady != XIL_COMPONENT_IS_READY &&
+      XGpio_Initialize(&LCD_gpios, XPAR_AXI_GPIO_0_BASEADDR) != XST_SUCCESS) {
+    printf("Failed to initialize AXI GPIO 0\n");
+    return ZLCD_FAILURE;
+  }
+  if (!LCD_gpios.IsDual) {
+    printf("ERROR: ZLCD_VSYNC_TE_GPIO needs the second channel of AXI "
+           "GPIO 0\n");
+    return ZLCD_FAILURE;
+  }
+  XGpio_SetDataDirection(&LCD_gpios, 2, 0xFFFFFFFF); // all inputs (1)
+  uint64_t edge_ticks;
+  uint32_t edges, frame_ticks;
+  uint64_t start = ZLCD_ticks();
+  while (!ZLCD_vsync_read_clock(&edge_ticks, &edges, &frame_ticks)) {
+    if (ZLCD_ticks() - start >= ZLCD_VSYNC_TIMEOUT_TICKS) {
+      printf("ERROR: no TE signal on bit %d of AXI GPIO 0 channel 2\n",
+             ZLCD_TE_GPIO_BIT);
+      return ZLCD_FAILURE;
+    }
+    ZLCD_vsync_poll_te();
+  }
+  return ZLCD_SUCCESS;
+}
+
+/*
+Swap modes: the prepared frame in GRAM_current becomes GRAM_previous as it is
+and drawing moves on to a buffer nothing is being sent from. That is the one
+the LCD showed so far, unless it is still going out (a refresh is pending with
+ZLCD_BUFFER_TRIPLE), then the third one. Every buffer but the new
+GRAM_previous is missing the dirty spans from now on.
+*/
+#if ZLCD_MAX_FRAME_BUFFERS > 1
+static void ZLCD_swap_buffers(void) {
+  uint8_t drawn = current_buffer;
+  uint8_t next = atomic_load(&refreshes_pending) == 0
+                     ? previous_buffer
+                     : (uint8_t)(3U - drawn - previous_buffer);
+  for (uint8_t i = 0; i < num_frame_buffers; i++) {
+    if (i == drawn) {
+      continue;
+    }
+    for (uint16_t y = dirty_y_start; y < dirty_y_end; y++) {
+      if (dirty_x_end[y] != 0) {
+        ZLCD_add_stale(i, dirty_x_start[y], dirty_x_end[y] - 1, y, y);
+      }
+    }
+  }
+  current_buffer = next;
+  previous_buffer = drawn;
+  GRAM_current = GRAM_buffer(current_buffer);
+  GRAM_previous = GRAM_buffer(previous_buffer);
+}
+#endif
+
+/*
+the RGB444 formats: the rows of a window packed one after the other into
+fill_stream and sent a few at a time, all within the window's RAMWR. A recorded
+refresh packs the window whole into wire_packed instead, one transfer
+*/
+static void ZLCD_send_packed_window(const ZLCD_plan_entry *entry,
+                                    size_t first_offset, size_t stride_bytes) {
+  size_t width = entry->x1 - entry->x0 + 1U;
+  size_t packed_row = ZLCD_PACK_RGB444_BYTES(width);
+  uint8_t *packed = fill_stream;
+  size_t capacity = ZLCD_FILL_STREAM_BYTES;
+#if ZLCD_ASYNC_REFRESH && ZLCD_ASYNC_RGB444
+  if (async_recording) {
+    packed = &wire_packed[next_slot][wire_packed_bytes];
+    capacity = packed_row * (entry->y1 - entry->y0 + 1U);
+    wire_packed_bytes += capacity;
+  }
+#endif
+  size_t used = 0;
+  for (uint16_t row = entry->y0; row <= entry->y1; row++) {
+    if (used + packed_row > capacity) {
+      ZLCD_send_data(packed, used);
+      used = 0;
+    }
+    ZLCD_pack_pixels(packed + used,
+                     first_offset + (size_t)(row - entry->y0) * stride_bytes,
+                     width, entry->x0, row);
+    used += packed_row;
+  }
+  ZLCD_send_data(packed, used);
+}
+
+/*
+Plans the windows for the dirty spans, copies them into GRAM_previous first
+(ZLCD_BUFFER_COPY, the swap modes swap the whole frame in instead) and sends
+them from there, so GRAM_current is free to be drawn on again as soon as this
+returns (needed by the async refresh, which only records the sends here).
+Clears the dirty state.
+*/
+static void ZLCD_send_dirty_rows(void) {
+#if ZLCD_MAX_FRAME_BUFFERS > 1
+  if (current_buffer_mode == ZLCD_BUFFER_DOUBLE ||
+      current_buffer_mode == ZLCD_BUFFER_TRIPLE) {
+    ZLCD_swap_buffers();
+  }
+#endif
+#if ZLCD_ASYNC_REFRESH && ZLCD_ASYNC_RGB444
+  wire_packed_bytes = 0;
+#endif
+  size_t num_entries =
+      ZLCD_plan_spans(dirty_x_start, dirty_x_end, dirty_y_start, dirty_y_end,
+                      refresh_plan, ZLCD_HEIGHT);
+  uint16_t frame_height = current_kernels->frame_height;
+  size_t stride_bytes = (size_t)current_kernels->frame_width * sizeof(rgb565);
+  if (current_vsync_mode != ZLCD_VSYNC_OFF) {
+    vsync_entries = num_entries; // recorded refreshes wait when submitted
+  }
+
+  for (size_t i = 0; i < num_entries; i++) {
+    const ZLCD_plan_entry *entry = &refresh_plan[i];
+    size_t row_bytes = (size_t)(entry->x1 - entry->x0 + 1) * sizeof(rgb565);
+    size_t first_offset =
+        (size_t)entry->y0 * stride_bytes + entry->x0 * sizeof(rgb565);
+    if (current_buffer_mode == ZLCD_BUFFER_COPY) {
+      for (uint16_t row = entry->y0; row <= entry->y1; row++) {
+        size_t offset =
+            first_offset + (size_t)(row - entry->y0) * stride_bytes;
+        ZLCD_gram_commit(offset, row_bytes);
+      }
+    }
+    if (i == 0 && !async_recording) {
+      ZLCD_vsync_wait();
+    }
+
+    // LCD RAM rows of the entry
+    uint16_t lcd_y0 = entry->y0 + ZLCD_scroll_shift(entry->y0);
+    uint16_t lcd_y1 = lcd_y0 + (entry->y1 - entry->y0);
+    if (entry->continue_write) {
+      ZLCD_send_command(0x3C); // Memory write continue
+    } else {
+      ZLCD_set_window(frame_col_offset + entry->x0,
+                      frame_col_offset + entry->x1, frame_row_offset + lcd_y0,
+                      frame_row_offset + frame_height - 1);
+    }
+    if (ZLCD_pixels_packed()) {
+      ZLCD_send_packed_window(entry, first_offset, stride_bytes);
+    } else if (row_bytes == stride_bytes) {
+      // full width rows are contiguous in the GRAM, so the whole rectangle can
+      // go out as one long (DMA friendly) transfer
+      ZLCD_send_data(ZLCD_gram_wire_bytes(first_offset),
+                     row_bytes * (entry->y1 - entry->y0 + 1));
+    } else {
+      // the write pointer keeps filling the window, rows follow each other
+      ZLCD_send_data_rows(ZLCD_gram_wire_bytes(first_offset), row_bytes,
+                          entry->y1 - entry->y0 + 1, stride_bytes);
+    }
+    // past the last row the pointer wraps around, so it is unknown again
+    cached_pointer_row = lcd_y1 + 1 < frame_height ? lcd_y1 + 1 : 0xFFFF;
+    ZLCD_STATS(driver_stats.rows_sent += entry->y1 - entry->y0 + 1U;
+               driver_stats.pixels_sent +=
+               (uint64_t)(entry->x1 - entry->x0 + 1U) *
+               (entry->y1 - entry->y0 + 1U));
+  }
+  for (uint16_t y = dirty_y_start; y < dirty_y_end; y++) {
+    dirty_x_end[y] = 0;
+  }
+  dirty_y_end = 0;
+}
+
+#if ZLCD_ASYNC_REFRESH
+static ZLCD_RETURN_STATUS ZLCD_start_queued_refresh(void);
+#endif
+
+#endif
+
+// a failed DMA write since the last call (the rest of the refresh still went)
+static ZLCD_RETURN_STATUS ZLCD_take_transport_status(void) {
+  ZLCD_RETURN_STATUS status = transport_status;
+  transport_status = ZLCD_SUCCESS;
+  if (status != ZLCD_SUCCESS) {
+    printf("ERROR: the DMA transport could not send a transfer\n");
+  }
+  return status;
+}
+
+#if !ZLCD_FRAMELESS
+#if ZLCD_ASYNC_REFRESH
+/*
+runs when the engine of a slot is done (interrupt context, or on CPU0 with
+amp_queue), the stats are not in use. Starts the refresh queued behind it
+before the user's callback
+*/
+static void ZLCD_refresh_sent(ZLCD_RETURN_STATUS status, void *user_data) {
+  ZLCD_refresh_slot *slot = user_data;
+  ZLCD_refresh_callback callback = slot->callback;
+  void *callback_data = slot->user_data;
+#if ZLCD_STATS_ENABLED
+  if (slot->record_stats) {
+    uint64_t transmit_ticks = slot->transmit_start != 0
+                                  ? ZLCD_stats_ticks() - slot->transmit_start
+                                  : 0;
+    ZLCD_stats_record_refresh(&driver_stats, slot->compare_ticks,
+                              transmit_ticks);
+  }
+#endif
+  refresh_status = status;
+  atomic_store(&sending_slot, NULL);
+  (void)ZLCD_start_queued_refresh();
+  // the slot may be recorded into again from here on
+  atomic_fetch_sub(&refreshes_pending, 1U);
+  if (callback != NULL) {
+    callback(status, callback_data);
+  }
+}
+
+/*
+Starts the refresh in queued_slot, if any. Both the submitting code and
+ZLCD_refresh_sent() try, whoever takes it out of queued_slot starts it.
+*/
+static ZLCD_RETURN_STATUS ZLCD_start_queued_refresh(void) {
+  ZLCD_refresh_slot *slot = atomic_exchange(&queued_slot, NULL);
+  if (slot == NULL) {
+    return ZLCD_SUCCESS;
+  }
+  atomic_store(&sending_slot, slot);
+  return ZLCD_async_start(&slot->engine, ZLCD_refresh_sent, slot);
+}
+
+/*
+hands the refresh recorded in the next slot to the engine. It starts right
+away if nothing is being sent, otherwise once the refresh in flight is done
+*/
+static ZLCD_RETURN_STATUS ZLCD_submit_refresh(ZLCD_refresh_callback callback,
+                                              void *user_data) {
+  ZLCD_vsync_wait();
+  ZLCD_refresh_slot *slot = &refresh_slots[next_slot];
+  slot->callback = callback;
+  slot->user_data = user_data;
+  next_slot = (uint8_t)((next_slot + 1U) % ZLCD_REFRESH_SLOTS);
+  atomic_fetch_add(&refreshes_pending, 1U);
+  atomic_store(&queued_slot, slot);
+  if (atomic_load(&sending_slot) == NULL) {
+    return ZLCD_start_queued_refresh();
+  }
+  return ZLCD_SUCCESS;
+}
+#endif
+
+ZLCD_RETURN_STATUS ZLCD_refresh_display(void) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+  // GRAM_previous may still be going out over SPI
+  ZLCD_wait_for_bus();
+#if ZLCD_STATS_ENABLED
+  driver_stats.refresh_calls++;
+  uint64_t start = ZLCD_stats_ticks();
+#endif
+  if (!ZLCD_prepare_dirty_rows()) {
+    ZLCD_STATS(driver_stats.refresh_early_exits++;
+               ZLCD_stats_record_refresh(&driver_stats,
+                                         ZLCD_stats_ticks() - start, 0));
+    return ZLCD_SUCCESS;
+  }
+#if ZLCD_STATS_ENABLED
+  uint64_t compared = ZLCD_stats_ticks();
+#endif
+  bool recorded_all = true;
+#if ZLCD_ASYNC_REFRESH
+  // (the RGB444 formats pack through fill_stream without wire_packed)
+  if (amp_client.queue != NULL &&
+      (ZLCD_ASYNC_RGB444 || !ZLCD_pixels_packed())) {
+    // one job for CPU1 instead of a hand over for every window
+    ZLCD_async_reset(ZLCD_recording_engine());
+    ZLCD_STATS(refresh_slots[next_slot].record_stats = false);
+    async_recording = true;
+    ZLCD_send_dirty_rows();
+    async_recording = false;
+    recorded_all = ZLCD_recorded_all();
+    (void)ZLCD_submit_refresh(NULL, NULL);
+    ZLCD_wait_for_bus();
+  } else {
+    ZLCD_send_dirty_rows();
+  }
+#else
+  ZLCD_send_dirty_rows();
+#endif
+  ZLCD_vsync_sent();
+  ZLCD_STATS(ZLCD_stats_record_refresh(&driver_stats, compared - start,
+                                       ZLCD_stats_ticks() - compared));
+  ZLCD_RETURN_STATUS status = ZLCD_take_transport_status();
+  return recorded_all ? status : ZLCD_FAILURE;
+}
+
+ZLCD_RETURN_STATUS ZLCD_refresh_display_async(ZLCD_refresh_callback callback,
+                                              void *user_data) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+  if (!async_refresh_enabled) {
+    printf("Enable async_refresh in the ZLCD_config to use "
+           "ZLCD_refresh_display_async()\n");
+    return ZLCD_FAILURE;
+  }
+#if ZLCD_ASYNC_REFRESH
+  /*
+  the rows in flight are in GRAM_previous, only ZLCD_BUFFER_TRIPLE has a free
+  buffer to move on to while they are, so it queues one refresh behind them
+  (unless refreshes have to wait for the scan, which the interrupt cannot)
+  */
+  ZLCD_wait_for_refreshes(current_buffer_mode == ZLCD_BUFFER_TRIPLE &&
+                                  current_vsync_mode == ZLCD_VSYNC_OFF
+                              ? 1U
+                              : 0U);
+  ZLCD_refresh_slot *slot = &refresh_slots[next_slot];
+  ZLCD_async_reset(&slot->engine);
+#if ZLCD_STATS_ENABLED
+  driver_stats.refresh_calls++;
+  uint64_t start = ZLCD_stats_ticks();
+  slot->record_stats = true;
+  slot->transmit_start = 0;
+#endif
+  if (ZLCD_prepare_dirty_rows()) {
+    ZLCD_STATS(slot->transmit_start = ZLCD_stats_ticks();
+               slot->compare_ticks = slot->transmit_start - start);
+    async_recording = true;
+    ZLCD_send_dirty_rows();
+    async_recording = false;
+  } else {
+    ZLCD_STATS(driver_stats.refresh_early_exits++;
+               slot->compare_ticks = ZLCD_stats_ticks() - start);
+  }
+  bool recorded_all = ZLCD_recorded_all();
+  /*
+  an empty queue finishes (and calls back) as soon as it is started, one that
+  lost steps fails the same way once its turn comes
+  */
+  ZLCD_RETURN_STATUS status = ZLCD_submit_refresh(callback, user_data);
+  return recorded_all ? status : ZLCD_FAILURE;
+#else
+  (void)callback;
+  (void)user_data;
+  return ZLCD_FAILURE; // not reached, init refuses async_refresh
+#endif
+}
+
+bool ZLCD_refresh_in_progress(void) {
+#if ZLCD_ASYNC_REFRESH
+  ZLCD_amp_poll();
+  return atomic_load(&refreshes_pending) != 0;
+#else
+  return false;
+#endif
+}
+
+void ZLCD_vsync_te_edge(void) {
+  if (current_vsync_mode == ZLCD_VSYNC_TE_EDGES) {
+    ZLCD_vsync_record_edge(ZLCD_ticks());
+  }
+}
+
+// update_now of a drawing call: inside a frame scope it only notes the present
+static bool ZLCD_update_now(bool update_now) {
+  if (update_now && frame_depth != 0) {
+    frame_present_pending = true;
+    ZLCD_STATS(driver_stats.updates_coalesced++);
+    return false;
+  }
+  return update_now;
+}
+
+// the refresh a drawing call with update_now ends with
+static ZLCD_RETURN_STATUS ZLCD_present(void) {
+  if (!ZLCD_update_now(true)) {
+    return ZLCD_SUCCESS;
+  }
+  return ZLCD_refresh_display();
+}
+
+ZLCD_RETURN_STATUS ZLCD_set_frame_rate(uint16_t frames_per_second) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+  frame_period_ticks =
+      frames_per_second == 0 ? 0 : COUNTS_PER_SECOND / frames_per_second;
+  frame_next_present = 0;
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_frame_begin(void) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+  if (frame_depth == UINT16_MAX) {
+    printf("ERROR: too many nested ZLCD_frame_begin() calls\n");
+    return ZLCD_FAILURE;
+  }
+  if (frame_depth++ == 0) {
+    frame_present_pending = false;
+    frame_begin_ticks = ZLCD_ticks();
+  }
+  return ZLCD_SUCCESS;
+}
+
+/*
+waits for the next present slot. A frame that comes in after its slot is
+presented right away, slots it missed altogether are dropped and the ones after
+keep their phase
+*/
+static void ZLCD_frame_pace(uint64_t now) {
+  if (frame_period_ticks == 0) {
+    return;
+  }
+  if (frame_next_present == 0) {
+    frame_next_present = now;
+  } else if (now >= frame_next_present + frame_period_ticks) {
+    uint64_t missed = (now - frame_next_present) / frame_period_ticks;
+    ZLCD_STATS(driver_stats.frames_dropped += (uint32_t)missed);
+    frame_next_present += missed * frame_period_ticks;
+  }
+  while (ZLCD_ticks() < frame_next_present) {
+  }
+  frame_next_present += frame_period_ticks;
+}
+
+ZLCD_RETURN_STATUS ZLCD_frame_end(void) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+  if (frame_depth == 0) {
+    printf("ERROR: ZLCD_frame_end() without ZLCD_frame_begin()\n");
+    return ZLCD_FAILURE;
+  }
+  if (--frame_depth != 0) {
+    return ZLCD_SUCCESS;
+  }
+  uint64_t built = ZLCD_ticks();
+  ZLCD_frame_pace(built);
+  ZLCD_RETURN_STATUS status = ZLCD_SUCCESS;
+  uint64_t presented = ZLCD_ticks();
+  if (frame_present_pending) {
+    frame_present_pending = false;
+    status = ZLCD_refresh_display();
+  }
+#if ZLCD_STATS_ENABLED
+  // building the frame and presenting it, the pacing wait left out
+  uint64_t frame_ticks =
+      (built - frame_begin_ticks) + (ZLCD_ticks() - presented);
+  uint64_t frame_us = ZLCD_stats_ticks_to_us(frame_ticks);
+  driver_stats.frames++;
+  driver_stats.frame_us += frame_us;
+  if (frame_us > driver_stats.frame_max_us) {
+    driver_stats.frame_max_us = frame_us;
+  }
+  driver_stats.frame_overruns +=
+      frame_period_ticks != 0 && frame_ticks > frame_period_ticks;
+#else
+  (void)presented;
+#endif
+  return status;
+}
+
+/*
+rotates count rows of row_bytes each up by shift (row shift ends up first),
+moving every row once through a one row buffer
+*/
+static void ZLCD_rotate_rows(uint8_t *rows, size_t row_bytes, uint16_t count,
+                             uint16_t shift) {
+  static uint8_t temp[ZLCD_HEIGHT * sizeof(rgb565)]; // widest frame row
+  if (shift == 0 || shift >= count) {
+    return;
+  }
+  uint16_t cycles = count, b = shift;
+  while (b != 0) { // gcd(count, shift) cycles of count / gcd rows each
+    uint16_t r = cycles % b;
+    cycles = b;
+    b = r;
+  }
+  for (uint16_t start = 0; start < cycles; start++) {
+    memcpy(temp, rows + (size_t)start * row_bytes, row_bytes);
+    uint16_t i = start;
+    while (1) {
+      uint16_t next = i + shift < count ? i + shift : i + shift - count;
+      if (next == start) {
+        break;
+      }
+      memcpy(rows + (size_t)i * row_bytes, rows + (size_t)next * row_bytes,
+             row_bytes);
+      i = next;
+    }
+    memcpy(rows + (size_t)i * row_bytes, temp, row_bytes);
+  }
+}
+
+static void ZLCD_send_scroll_start(void) {
+  uint8_t data[2] = {(uint8_t)((scroll_top + scroll_offset) >> 8),
+                     (uint8_t)((scroll_top + scroll_offset) & 0x00FF)};
+  ZLCD_send_command(0x37); // VSCSAD
+  ZLCD_send_data(data, sizeof(data));
+}
+
+// scrolling follows the LCD RAM rows, which are only frame rows unrotated
+static bool ZLCD_scroll_supported(void) {
+  if (current_madctl != ST7789_MADCTL_RGB) {
+    printf("With ZLCD_ROTATE_MADCTL hardware scrolling only works in "
+           "portrait\n");
+    return false;
+  }
+  return true;
+}
+
+ZLCD_RETURN_STATUS ZLCD_scroll_define(uint16_t top_fixed_rows,
+                                      uint16_t bottom_fixed_rows) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+  if (top_fixed_rows + bottom_fixed_rows >= ZLCD_HEIGHT) {
+    printf("Scroll area needs at least one row, %u + %u fixed rows given\n",
+           top_fixed_rows, bottom_fixed_rows);
+    return ZLCD_FAILURE;
+  }
+  if (!ZLCD_scroll_supported()) {
+    return ZLCD_FAILURE;
+  }
+  // back to offset 0 first, then the LCD RAM matches the screen row for row
+  ZLCD_RETURN_STATUS status = ZLCD_scroll_to(0);
+  if (status != ZLCD_SUCCESS) {
+    return status;
+  }
+  scroll_top = top_fixed_rows;
+  scroll_height = ZLCD_HEIGHT - top_fixed_rows - bottom_fixed_rows;
+  uint8_t data[6] = {(uint8_t)(top_fixed_rows >> 8),
+                     (uint8_t)(top_fixed_rows & 0x00FF),
+                     (uint8_t)(scroll_height >> 8),
+                     (uint8_t)(scroll_height & 0x00FF),
+                     (uint8_t)(bottom_fixed_rows >> 8),
+                     (uint8_t)(bottom_fixed_rows & 0x00FF)};
+  ZLCD_send_command(0x33); // VSCRDEF
+  ZLCD_send_data(data, sizeof(data));
+  ZLCD_send_scroll_start();
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_RETURN_STATUS ZLCD_scroll_to(uint16_t offset) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+  if (offset >= scroll_height) {
+    printf("Scroll offset %u is outside the %u row scroll area\n", offset,
+           scroll_height);
+    return ZLCD_FAILURE;
+  }
+  if (offset == scroll_offset) {
+    return ZLCD_SUCCESS;
+  }
+  if (!ZLCD_scroll_supported()) {
+    return ZLCD_FAILURE;
+  }
+  // GRAM_previous may still be going out over SPI
+  ZLCD_wait_for_bus();
+  ZLCD_settle_overwritten_rows();
+  /*
+  Move the area's rows the way the LCD is about to show them. GRAM_previous
+  matches the screen again afterwards and pending drawing and its dirty spans
+  move along with the rows they are on.
+  */
+  uint16_t shift = (offset + scroll_height - scroll_offset) % scroll_height;
+  size_t row_bytes = (size_t)current_kernels->frame_width * sizeof(rgb565);
+  // the other frame buffers are not moved, they miss the whole area instead
+  ZLCD_repair_all_rows();
+  ZLCD_mark_stale(0, current_kernels->frame_width - 1, scroll_top,
+                  scroll_top + scroll_height - 1);
+  ZLCD_rotate_rows((uint8_t *)GRAM_current + scroll_top * row_bytes, row_bytes,
+                   scroll_height, shift);
+  if (GRAM_previous != GRAM_current) {
+    ZLCD_rotate_rows((uint8_t *)GRAM_previous + scroll_top * row_bytes,
+                     row_bytes, scroll_height, shift);
+  }
+  ZLCD_rotate_rows((uint8_t *)&dirty_x_start[scroll_top], sizeof(uint16_t),
+                   scroll_height, shift);
+  ZLCD_rotate_rows((uint8_t *)&dirty_x_end[scroll_top], sizeof(uint16_t),
+                   scroll_height, shift);
+  if (dirty_y_end != 0) {
+    // the spans moved, find the new first and last dirty row
+    uint16_t y_start = ZLCD_HEIGHT, y_end = 0;
+    for (uint16_t y = 0; y < ZLCD_HEIGHT; y++) {
+      if (dirty_x_end[y] != 0) {
+        y_start = y < y_start ? y : y_start;
+        y_end = y + 1;
+      }
+    }
+    dirty_y_start = y_start;
+    dirty_y_end = y_end;
   }
-  ZLCD_set_background_colour(background_colour);
-  ZLCD_draw_background(); // set pixels and refresh screen
+  scroll_offset = offset;
+  ZLCD_send_scroll_start();
   return ZLCD_SUCCESS;
 }
 
-ZLCD_RETURN_STATUS ZLCD_display_on(void) {
+#endif
+
+ZLCD_RETURN_STATUS ZLCD_get_frame_layout(ZLCD_frame_layout *layout) {
   if (!ZLCD_initialized) {
     printf("Initialize the LCD before calling other ZLCD functions\n");
     return ZLCD_ERR_NOT_INITIALIZED;
   }
-  ZLCD_send_command(0x29); // Display ON
-  msleep(10);
+  if (layout == NULL) {
+    return ZLCD_FAILURE;
+  }
+  *layout = (ZLCD_frame_layout){
+      .width = current_kernels->width,
+      .height = current_kernels->height,
+      .frame_width = current_kernels->frame_width,
+      .frame_height = current_kernels->frame_height,
+      .origin = (int32_t)(current_kernels->index(0, 0) / sizeof(rgb565)),
+      .x_step = current_kernels->x_step,
+      .y_step = current_kernels->y_step,
+      .orientation = current_orientation.orientation_type};
   return ZLCD_SUCCESS;
 }
 
-ZLCD_RETURN_STATUS ZLCD_display_off(void) {
+// the RGB444 formats: rows y to end - 1 packed into fill_stream and sent
+static void ZLCD_send_packed_rows(const uint8_t *rows, uint16_t y,
+                                  uint16_t end) {
+  uint16_t width = current_kernels->frame_width;
+  size_t row_bytes = (size_t)width * sizeof(rgb565);
+  size_t packed_row = ZLCD_PACK_RGB444_BYTES(width);
+  size_t used = 0;
+  for (uint16_t row = y; row < end; row++, rows += row_bytes) {
+    if (used + packed_row > ZLCD_FILL_STREAM_BYTES) {
+      ZLCD_send_data(fill_stream, used);
+      used = 0;
+    }
+    if (current_pixel_format == ZLCD_PIXEL_RGB444_DITHERED) {
+      ZLCD_pack_rgb444_dithered(fill_stream + used, rows, width, 0, row);
+    } else {
+      ZLCD_pack_rgb444(fill_stream + used, rows, width);
+    }
+    used += packed_row;
+  }
+  ZLCD_send_data(fill_stream, used);
+}
+
+ZLCD_RETURN_STATUS ZLCD_write_frame_rows(uint16_t y0, uint16_t num_rows,
+                                         const uint8_t *pixels) {
   if (!ZLCD_initialized) {
     printf("Initialize the LCD before calling other ZLCD functions\n");
     return ZLCD_ERR_NOT_INITIALIZED;
   }
-  ZLCD_send_command(0x28); // Display OFF
-  msleep(10);
-  return ZLCD_SUCCESS;
+  uint16_t width = current_kernels->frame_width;
+  uint16_t frame_height = current_kernels->frame_height;
+  if (pixels == NULL || num_rows == 0 || y0 >= frame_height ||
+      num_rows > frame_height - y0) {
+    printf("ERROR: %u rows from row %u are not in the %u row frame\n",
+           num_rows, y0, frame_height);
+    return ZLCD_FAILURE;
+  }
+  // the LCD and fill_stream may still be busy with an async refresh
+  ZLCD_wait_for_bus();
+  size_t row_bytes = (size_t)width * sizeof(rgb565);
+  uint16_t y_end = y0 + num_rows;
+  // rows with the same scroll shift are one window, as in ZLCD_plan_spans()
+  for (uint16_t y = y0, end; y < y_end; y = end) {
+    int16_t shift = ZLCD_scroll_shift(y);
+    end = y + 1;
+    while (end < y_end && ZLCD_scroll_shift(end) == shift) {
+      end++;
+    }
+    uint16_t lcd_y0 = y + shift;
+    uint16_t lcd_y1 = lcd_y0 + (end - y) - 1;
+    ZLCD_set_window(frame_col_offset, frame_col_offset + width - 1,
+                    frame_row_offset + lcd_y0,
+                    frame_row_offset + frame_height - 1);
+    const uint8_t *rows = pixels + (size_t)(y - y0) * row_bytes;
+    if (ZLCD_pixels_packed()) {
+      ZLCD_send_packed_rows(rows, y, end);
+    } else {
+      ZLCD_send_data(rows, (size_t)(end - y) * row_bytes);
+    }
+    cached_pointer_row = lcd_y1 + 1 < frame_height ? lcd_y1 + 1 : 0xFFFF;
+    ZLCD_STATS(driver_stats.rows_sent += end - y;
+               driver_stats.pixels_sent += (size_t)(end - y) * width);
+  }
+#if !ZLCD_FRAMELESS
+  ZLCD_overwritten_rows(y0, y_end - 1);
+#endif
+  return ZLCD_take_transport_status();
 }
 
-static inline void ZLCD_set_pixel_xy_internal(int16_t x, int16_t y,
-                                              rgb565 colour) {
-  if (x < 0 || x >= current_orientation.horizontal_axis_length_px) {
+#if ZLCD_FRAMELESS
+/*
+clears the whole LCD to colour, where ZLCD_init_with_config() would draw the
+background. Dithered pixels depend on their position, so with
+ZLCD_PIXEL_RGB444_DITHERED the rows are packed one by one
+*/
+static void ZLCD_clear_lcd(rgb565 colour) {
+  static uint8_t row[ZLCD_HEIGHT * sizeof(rgb565)]; // widest frame row
+  uint16_t width = current_kernels->frame_width;
+  uint16_t height = current_kernels->frame_height;
+  ZLCD_set_window(frame_col_offset, frame_col_offset + width - 1,
+                  frame_row_offset, frame_row_offset + height - 1);
+  if (current_pixel_format != ZLCD_PIXEL_RGB444_DITHERED) {
+    ZLCD_send_repeated(colour, (size_t)width * height);
     return;
   }
-  if (y < 0 || y >= current_orientation.vertical_axis_length_px) {
-    return;
+  ZLCD_fill_span((ZLCD_fill_pixel *)row, ZLCD_wire_pattern(colour), width);
+  for (uint16_t y = 0; y < height; y++) {
+    ZLCD_send_packed_rows(row, y, y + 1);
   }
-  size_t index = current_transform_fun(x, y);
-  GRAM_current[index] = (uint8_t)(colour >> 8); // MSB first
-  GRAM_current[index + 1] = (uint8_t)(colour & 0x00FF);
 }
+#endif
 
-// static void ZLCD_set_pixel_internal(ZLCD_internal_coordinate p, rgb565
-// colour) { 	return ZLCD_set_pixel_xy_internal(p.x, p.y, colour);
-// }
-
-ZLCD_RETURN_STATUS ZLCD_set_pixel_xy(uint16_t x, uint16_t y, rgb565 colour,
-                                     bool update_now) {
+#if !ZLCD_FRAMELESS
+size_t ZLCD_plan_refresh(ZLCD_plan_entry *entries, size_t max_entries) {
   if (!ZLCD_initialized) {
     printf("Initialize the LCD before calling other ZLCD functions\n");
-    return ZLCD_ERR_NOT_INITIALIZED;
-  }
-
-  // inlined version of the ZLCD_verify_coordinate_is_valid_xy() function
-  if (x >= current_orientation.horizontal_axis_length_px) {
-    char error_message[100];
-    snprintf(error_message, sizeof(error_message) - 1,
-             "Error: coordinate %d exceeds maximum allowed value of %d", x,
-             current_orientation.horizontal_axis_length_px - 1);
-    log_error_message(error_message);
-    return ZLCD_FAILURE;
+    return 0;
   }
-  if (y >= current_orientation.vertical_axis_length_px) {
-    char error_message[100];
-    snprintf(error_message, sizeof(error_message) - 1,
-             "Error: y coordinate %d exceeds maximum allowed value of %d", y,
-             current_orientation.vertical_axis_length_px - 1);
-    log_error_message(error_message);
-    return ZLCD_FAILURE;
+  if (entries == NULL || max_entries == 0) {
+    return 0;
   }
-
-  // convert x and y to portrait coordinates
-  uint16_t converted_x, converted_y;
-  switch (current_orientation.orientation_type) {
-  case ZLCD_PORTRAIT_ORIENTATION:
-    converted_x = x;
-    converted_y = y;
-    break;
-  case ZLCD_LANDSCAPE_ORIENTATION:
-    // 90 degrees clockwise relative to portrait
-    converted_x = ZLCD_WIDTH - 1 - (y);
-    converted_y = x;
-    break;
-  case ZLCD_INVERTED_PORTRAIT_ORIENTATION:
-    // 180 degrees clockwise relative to portrait
-    converted_x = ZLCD_WIDTH - x - 1;
-    converted_y = ZLCD_HEIGHT - y - 1;
-    break;
-  case ZLCD_INVERTED_LANDSCAPE_ORIENTATION:
-    // 90 degrees counter-clockwise relative to portrait
-    converted_x = y;
-    converted_y = (ZLCD_HEIGHT - 1 - x);
-    break;
-  default:; // for no statement warning
-    char error_message[100] = "";
-    snprintf(error_message, sizeof(error_message) - 1,
-             "ERROR: invalid orientation type %d found",
-             current_orientation.orientation_type);
-    log_error_message(error_message);
-    return ZLCD_FAILURE;
+  ZLCD_wait_for_bus();
+  // trimming only narrows the spans, the next refresh sends the same thing
+  if (!ZLCD_prepare_dirty_rows()) {
+    return 0;
   }
-  size_t index = (converted_y * ZLCD_WIDTH + converted_x) * 2;
-  GRAM_current[index] = (uint8_t)(colour >> 8); // MSB first
-  GRAM_current[index + 1] = (uint8_t)(colour & 0x00FF);
-
-  if (update_now) {
-    ZLCD_set_window(ZLCD_X_OFFSET + converted_x, ZLCD_X_OFFSET + converted_x,
-                    converted_y, converted_y);
-    ZLCD_send_data(&GRAM_current[index], sizeof(rgb565));
-    memcpy(&GRAM_previous[index], &GRAM_current[index], sizeof(rgb565));
+  if (current_buffer_mode == ZLCD_BUFFER_HASHED) {
+    // the tiles left to send took their new digests, the refresh must see them
+    for (uint16_t y = dirty_y_start; y < dirty_y_end; y++) {
+      if (dirty_x_end[y] != 0) {
+        ZLCD_forget_tiles(dirty_x_start[y], dirty_x_end[y] - 1, y, y);
+      }
+    }
   }
-  return ZLCD_SUCCESS;
-}
-
-ZLCD_RETURN_STATUS ZLCD_set_pixel(ZLCD_pixel_coordinate coordinate,
-                                  rgb565 colour, bool update_now) {
-  return ZLCD_set_pixel_xy(coordinate.x, coordinate.y, colour, update_now);
+  /*
+  planned in full as the refresh would (a shorter list makes the planner merge
+  windows), only the first max_entries are handed out
+  */
+  size_t num_entries =
+      ZLCD_plan_spans(dirty_x_start, dirty_x_end, dirty_y_start, dirty_y_end,
+                      refresh_plan, ZLCD_HEIGHT);
+  memcpy(entries, refresh_plan,
+         (num_entries < max_entries ? num_entries : max_entries) *
+             sizeof(*entries));
+  return num_entries;
 }
 
-// todo: PWM for backlight
-// ZLCD_RETURN_STATUS ZLCD_set_brightness(uint16_t brightness) {
-//   if (!ZLCD_initialized) {
-//     printf("Initialize the LCD before calling other ZLCD functions\n");
-//     return ZLCD_ERR_NOT_INITIALIZED;
-//   }
-//   if (brightness == current_brightness) {
-//     return ZLCD_SUCCESS;
-//   }
-//   // use FPGA fabric to control backlight with PWM instead
-//   XGpio_DiscreteWrite(&LCD_backlight_duty_cycle_16_bit, 1, brightness);
-//   printf("Reading of backlight: %u\n", (XGpio_DiscreteRead(&LCD_gpios, 1) >>
-//   LCD_BACKLIGHT) & 0x1); printf("Reading of duty cycle: %u\n",
-//   XGpio_DiscreteRead(&LCD_backlight_duty_cycle_16_bit, 1));
-//   current_brightness = brightness;
-//   return ZLCD_SUCCESS;
-// }
-
-ZLCD_RETURN_STATUS ZLCD_refresh_display(void) {
+ZLCD_RETURN_STATUS ZLCD_wait_refresh(void) {
   if (!ZLCD_initialized) {
     printf("Initialize the LCD before calling other ZLCD functions\n");
     return ZLCD_ERR_NOT_INITIALIZED;
   }
-  // see which pages need to be updated by checking the previous GDDRAM buffer
-  // state
-  bool exit_early = true;
-  bool dirty_rows[ZLCD_HEIGHT] = {false};
-  for (uint16_t y = 0; y < ZLCD_HEIGHT; y++) {
-    size_t row_offset = (ZLCD_WIDTH * y) * sizeof(rgb565);
-    if (memcmp(&GRAM_current[row_offset], &GRAM_previous[row_offset],
-               ZLCD_WIDTH * sizeof(rgb565)) != 0) {
-      exit_early = false;
-      dirty_rows[y] = true;
-    }
-  }
-  if (exit_early) {
-    return ZLCD_SUCCESS;
-  }
-  for (uint16_t y = 0; y < ZLCD_HEIGHT; y++) {
-    if (!dirty_rows[y])
-      continue;
-    // calculate the index of the pixel, then multiply by 2
-    size_t row_offset = (ZLCD_WIDTH * y) * sizeof(rgb565);
-    // send the 172 pixel row
-    ZLCD_set_window(ZLCD_X_OFFSET, ZLCD_X_OFFSET + ZLCD_WIDTH - 1, y, y);
-    ZLCD_send_data(&GRAM_current[row_offset], ZLCD_WIDTH * sizeof(rgb565));
+  ZLCD_wait_for_bus();
+  return refresh_status;
+}
 
-    memcpy(&GRAM_previous[row_offset], &GRAM_current[row_offset],
-           ZLCD_WIDTH * sizeof(rgb565));
+#endif
+
+ZLCD_RETURN_STATUS ZLCD_get_stats(ZLCD_stats *stats) {
+#if ZLCD_STATS_ENABLED
+  if (stats == NULL) {
+    return ZLCD_FAILURE;
   }
-  // memcpy(GRAM_previous, GRAM_current, sizeof(GRAM_current)); // flat 108 us
+  ZLCD_wait_for_bus();
+  *stats = driver_stats;
+  stats->transmit_interrupts = dma_transfer.interrupts;
+  stats->interrupt_us = ZLCD_stats_ticks_to_us(dma_transfer.interrupt_ticks);
+  return ZLCD_SUCCESS;
+#else
+  (void)stats;
+  printf("ZLCD statistics are compiled out (ZLCD_STATS_ENABLED is 0)\n");
+  return ZLCD_FAILURE;
+#endif
+}
+
+ZLCD_RETURN_STATUS ZLCD_reset_stats(void) {
+#if ZLCD_STATS_ENABLED
+  ZLCD_wait_for_bus();
+  driver_stats = (ZLCD_stats){0};
+  dma_transfer.interrupts = 0;
+  dma_transfer.interrupt_ticks = 0;
   return ZLCD_SUCCESS;
+#else
+  printf("ZLCD statistics are compiled out (ZLCD_STATS_ENABLED is 0)\n");
+  return ZLCD_FAILURE;
+#endif
 }
 
 ZLCD_RETURN_STATUS ZLCD_verify_coordinate_is_valid_xy(uint16_t x, uint16_t y) {
@@ -793,6 +3891,7 @@ ZLCD_verify_coordinate_is_valid(ZLCD_pixel_coordinate coordinate) {
   return ZLCD_verify_coordinate_is_valid_xy(coordinate.x, coordinate.y);
 }
 
+#if !ZLCD_FRAMELESS
 ZLCD_RETURN_STATUS ZLCD_draw_line(ZLCD_pixel_coordinate p1,
                                   ZLCD_pixel_coordinate p2, rgb565 colour,
                                   bool update_now) {
@@ -820,32 +3919,11 @@ ZLCD_RETURN_STATUS ZLCD_draw_line_xy(uint16_t x1, uint16_t y1, uint16_t x2,
     return ZLCD_draw_hline(y1, x1, x2, colour, update_now);
   }
 
-  // Implement Bresenham's line algorithm
-
-  int dx = abs(x2 - x1);
-  int dy = -abs(y2 - y1);
-  int sx = x1 < x2 ? 1 : -1;
-  int sy = y1 < y2 ? 1 : -1;
-  int err = dx + dy;
-
-  while (1) {
-    ZLCD_set_pixel_xy_internal(x1, y1, colour);
-    if (x1 == x2 && y1 == y2)
-      break;
-
-    int e2 = 2 * err;
-    if (e2 >= dy) {
-      err += dy;
-      x1 += sx;
-    }
-    if (e2 <= dx) {
-      err += dx;
-      y1 += sy;
-    }
-  }
+  // Bresenham's line algorithm
+  current_kernels->line(x1, y1, x2, y2, colour);
   if (update_now) {
     // will send one 172 pixel long row (slow)
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -866,7 +3944,7 @@ ZLCD_RETURN_STATUS ZLCD_draw_hline(uint16_t y, uint16_t x1, uint16_t x2,
   }
   ZLCD_draw_hline_internal(y, x1, x2, colour);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -887,7 +3965,7 @@ ZLCD_RETURN_STATUS ZLCD_draw_vline(uint16_t x, uint16_t y1, uint16_t y2,
   }
   ZLCD_draw_vline_internal(x, y1, y2, colour);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -901,14 +3979,11 @@ ZLCD_RETURN_STATUS ZLCD_clear(void) {
     printf("Initialize the LCD before calling other ZLCD functions\n");
     return ZLCD_ERR_NOT_INITIALIZED;
   }
-  ZLCD_ORIENTATION temp = current_orientation.orientation_type;
-  // switch to portrait mode briefly
-  ZLCD_set_orientation(ZLCD_PORTRAIT_ORIENTATION);
-  ZLCD_draw_rectangle_xy_internal(0, 0, ZLCD_WIDTH, ZLCD_HEIGHT, 1, true,
-                                  current_background_colour,
-                                  current_background_colour);
-  // restore user orientation
-  ZLCD_set_orientation(temp);
+  // the whole screen, which is the whole frame in any orientation
+  ZLCD_draw_rectangle_xy_internal(
+      0, 0, current_orientation.horizontal_axis_length_px,
+      current_orientation.vertical_axis_length_px, 1, true,
+      current_background_colour, current_background_colour);
   printf_x = 0;
   printf_y = printf_font.font_size;
   return ZLCD_SUCCESS;
@@ -919,12 +3994,11 @@ ZLCD_RETURN_STATUS ZLCD_draw_background(void) {
     printf("Initialize the LCD before calling other ZLCD functions\n");
     return ZLCD_ERR_NOT_INITIALIZED;
   }
-  ZLCD_ORIENTATION temp = current_orientation.orientation_type;
-  ZLCD_set_orientation(ZLCD_PORTRAIT_ORIENTATION);
-  ZLCD_draw_filled_rectangle_xy(0, 0, ZLCD_WIDTH, ZLCD_HEIGHT, 1,
+  ZLCD_draw_filled_rectangle_xy(0, 0,
+                                current_orientation.horizontal_axis_length_px,
+                                current_orientation.vertical_axis_length_px, 1,
                                 current_background_colour,
                                 current_background_colour, true);
-  ZLCD_set_orientation(temp);
   printf_x = 0;
   printf_y = printf_font.font_size;
   return ZLCD_SUCCESS;
@@ -944,41 +4018,13 @@ static void ZLCD_draw_hline_internal(int16_t y, int16_t x1, int16_t x2,
   if (end >= current_orientation.horizontal_axis_length_px) {
     end = current_orientation.horizontal_axis_length_px - 1;
   }
-  size_t start_index = current_transform_fun(start, y);
-  uint16_t length = end - start + 1;
-  switch (current_orientation.orientation_type) {
-  case ZLCD_PORTRAIT_ORIENTATION:
-    for (int i = 0; i < length; i++) {
-      GRAM_current[start_index + (i * 2)] = (uint8_t)(colour >> 8);
-      GRAM_current[start_index + (i * 2) + 1] = (uint8_t)(colour & 0xFF);
-    }
-    break;
-
-  case ZLCD_LANDSCAPE_ORIENTATION:
-    for (int i = 0; i < length; i++) {
-      GRAM_current[start_index + (i * ZLCD_WIDTH * 2)] = (uint8_t)(colour >> 8);
-      GRAM_current[start_index + (i * ZLCD_WIDTH * 2) + 1] =
-          (uint8_t)(colour & 0xFF);
-    }
-    break;
-
-  case ZLCD_INVERTED_PORTRAIT_ORIENTATION:
-    for (int i = 0; i < length; i++) {
-      GRAM_current[start_index - (i * 2)] = (uint8_t)(colour >> 8);
-      GRAM_current[start_index - (i * 2) + 1] = (uint8_t)(colour & 0xFF);
-    }
-    break;
-
-  case ZLCD_INVERTED_LANDSCAPE_ORIENTATION:
-    for (int i = 0; i < length; i++) {
-      GRAM_current[start_index - (i * ZLCD_WIDTH * 2)] = (uint8_t)(colour >> 8);
-      GRAM_current[start_index - (i * ZLCD_WIDTH * 2) + 1] =
-          (uint8_t)(colour & 0xFF);
-    }
-    break;
-  default:
-    break;
+  if (start > end) {
+    return; // fully off screen
   }
+  ZLCD_mark_covered_rect_xy(start, y, end, y);
+  size_t start_index = current_kernels->index(start, y);
+  uint16_t length = end - start + 1;
+  ZLCD_gram_fill_run(start_index, length, current_kernels->x_step, colour);
 }
 
 static void ZLCD_draw_vline_internal(int16_t x, int16_t y1, int16_t y2,
@@ -996,41 +4042,13 @@ static void ZLCD_draw_vline_internal(int16_t x, int16_t y1, int16_t y2,
   if (end >= current_orientation.vertical_axis_length_px) {
     end = current_orientation.vertical_axis_length_px - 1;
   }
-  size_t start_index = current_transform_fun(x, start);
-  uint16_t length = end - start + 1;
-  switch (current_orientation.orientation_type) {
-  case ZLCD_PORTRAIT_ORIENTATION:
-    for (int i = 0; i < length; i++) {
-      GRAM_current[start_index + (i * ZLCD_WIDTH * 2)] = (uint8_t)(colour >> 8);
-      GRAM_current[start_index + (i * ZLCD_WIDTH * 2) + 1] =
-          (uint8_t)(colour & 0xFF);
-    }
-    break;
-
-  case ZLCD_LANDSCAPE_ORIENTATION:
-    for (int i = 0; i < length; i++) {
-      GRAM_current[start_index - (i * 2)] = (uint8_t)(colour >> 8);
-      GRAM_current[start_index - (i * 2) + 1] = (uint8_t)(colour & 0xFF);
-    }
-    break;
-
-  case ZLCD_INVERTED_PORTRAIT_ORIENTATION:
-    for (int i = 0; i < length; i++) {
-      GRAM_current[start_index - (i * ZLCD_WIDTH * 2)] = (uint8_t)(colour >> 8);
-      GRAM_current[start_index - (i * ZLCD_WIDTH * 2) + 1] =
-          (uint8_t)(colour & 0xFF);
-    }
-    break;
-
-  case ZLCD_INVERTED_LANDSCAPE_ORIENTATION:
-    for (int i = 0; i < length; i++) {
-      GRAM_current[start_index + (i * 2)] = (uint8_t)(colour >> 8);
-      GRAM_current[start_index + (i * 2) + 1] = (uint8_t)(colour & 0xFF);
-    }
-    break;
-  default:
-    break;
+  if (start > end) {
+    return; // fully off screen
   }
+  ZLCD_mark_covered_rect_xy(x, start, x, end);
+  size_t start_index = current_kernels->index(x, start);
+  uint16_t length = end - start + 1;
+  ZLCD_gram_fill_run(start_index, length, current_kernels->y_step, colour);
 }
 
 static void ZLCD_draw_line_xy_internal(int16_t x1, int16_t y1, int16_t x2,
@@ -1043,30 +4061,8 @@ static void ZLCD_draw_line_xy_internal(int16_t x1, int16_t y1, int16_t x2,
     return;
   }
 
-  // Implement Bresenham's line algorithm
-
-  int dx = abs(x2 - x1);
-  int dy = -abs(y2 - y1);
-  int sx = x1 < x2 ? 1 : -1;
-  int sy = y1 < y2 ? 1 : -1;
-  int err = dx + dy;
-
-  while (1) {
-    // pixel set function will fail if coordinates are not valid
-    ZLCD_set_pixel_xy_internal(x1, y1, colour);
-    if (x1 == x2 && y1 == y2)
-      break;
-
-    int e2 = 2 * err;
-    if (e2 >= dy) {
-      err += dy;
-      x1 += sx;
-    }
-    if (e2 <= dx) {
-      err += dx;
-      y1 += sy;
-    }
-  }
+  // Bresenham's line algorithm, pixels off the screen are skipped
+  current_kernels->line(x1, y1, x2, y2, colour);
 }
 
 static void ZLCD_draw_line_internal(ZLCD_internal_coordinate p1,
@@ -1091,11 +4087,8 @@ ZLCD_draw_rectangle_xy_internal(uint16_t origin_x, uint16_t origin_y,
     return;
   }
   if (fill) {
-    for (uint16_t y_current = origin_y; y_current < origin_y + height_px;
-         y_current++) {
-      ZLCD_draw_hline_internal(y_current, origin_x, origin_x + width_px - 1,
-                               fill_colour);
-    }
+    ZLCD_fill_rect_xy_internal(origin_x, origin_y, origin_x + width_px - 1,
+                               origin_y + height_px - 1, fill_colour);
   }
   // Draw borders of thickness border_thickness_px
   for (uint16_t t = 0; t < border_thickness_px; t++) {
@@ -1142,7 +4135,7 @@ ZLCD_draw_unfilled_rectangle(ZLCD_pixel_coordinate origin, uint16_t width_px,
                                   border_thickness_px, false, border_colour,
                                   0x0);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1173,7 +4166,7 @@ ZLCD_RETURN_STATUS ZLCD_draw_unfilled_rectangle_xy(
                                   border_thickness_px, false, border_colour,
                                   0x0);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1202,12 +4195,16 @@ ZLCD_draw_filled_rectangle(ZLCD_pixel_coordinate origin, uint16_t width_px,
            border_thickness_px, smaller_side / 2);
     return ZLCD_FAILURE;
   }
+  if (ZLCD_update_now(update_now)) {
+    ZLCD_draw_filled_rectangle_now(origin.x, origin.y, width_px, height_px,
+                                   border_thickness_px, border_colour,
+                                   fill_colour);
+    // anything else drawn since the last refresh
+    return ZLCD_refresh_display();
+  }
   ZLCD_draw_rectangle_xy_internal(origin.x, origin.y, width_px, height_px,
                                   border_thickness_px, true, border_colour,
                                   fill_colour);
-  if (update_now) {
-    return ZLCD_refresh_display();
-  }
   return ZLCD_SUCCESS;
 }
 
@@ -1234,12 +4231,16 @@ ZLCD_RETURN_STATUS ZLCD_draw_filled_rectangle_xy(
            border_thickness_px, smaller_side / 2);
     return ZLCD_FAILURE;
   }
+  if (ZLCD_update_now(update_now)) {
+    ZLCD_draw_filled_rectangle_now(origin_x, origin_y, width_px, height_px,
+                                   border_thickness_px, border_colour,
+                                   fill_colour);
+    // anything else drawn since the last refresh
+    return ZLCD_refresh_display();
+  }
   ZLCD_draw_rectangle_xy_internal(origin_x, origin_y, width_px, height_px,
                                   border_thickness_px, true, border_colour,
                                   fill_colour);
-  if (update_now) {
-    return ZLCD_refresh_display();
-  }
   return ZLCD_SUCCESS;
 }
 
@@ -1368,7 +4369,7 @@ ZLCD_draw_triangle_internal(ZLCD_pixel_coordinate p1, ZLCD_pixel_coordinate p2,
   ZLCD_draw_line_internal(p2_temp, p3_temp, border_colour);
   ZLCD_draw_line_internal(p1_temp, p3_temp, border_colour);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1461,37 +4462,10 @@ ZLCD_draw_circle_xy_internal(uint16_t origin_x, uint16_t origin_y,
   }
 
   // draw circle border
-  int x = 0;
-  int y = radius_px;
-  int d = 3 - (2 * radius_px);
-  while (x <= y) {
-    // draw all 8 symmetric points
-    ZLCD_set_pixel_xy_internal(origin_x_signed + x, origin_y_signed + y,
-                               border_colour);
-    ZLCD_set_pixel_xy_internal(origin_x_signed - x, origin_y_signed + y,
-                               border_colour);
-    ZLCD_set_pixel_xy_internal(origin_x_signed + x, origin_y_signed - y,
-                               border_colour);
-    ZLCD_set_pixel_xy_internal(origin_x_signed - x, origin_y_signed - y,
-                               border_colour);
-    ZLCD_set_pixel_xy_internal(origin_x_signed + y, origin_y_signed + x,
-                               border_colour);
-    ZLCD_set_pixel_xy_internal(origin_x_signed - y, origin_y_signed + x,
-                               border_colour);
-    ZLCD_set_pixel_xy_internal(origin_x_signed + y, origin_y_signed - x,
-                               border_colour);
-    ZLCD_set_pixel_xy_internal(origin_x_signed - y, origin_y_signed - x,
-                               border_colour);
-    if (d < 0) {
-      d += (4 * x) + 6;
-    } else {
-      d += 4 * (x - y) + 10;
-      y--;
-    }
-    x++;
-  }
+  current_kernels->circle(origin_x_signed, origin_y_signed, radius_px,
+                          border_colour);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1532,6 +4506,8 @@ ZLCD_draw_filled_circle_xy(uint16_t origin_x, uint16_t origin_y,
                                       update_now);
 }
 
+#endif
+
 ZLCD_ORIENTATION ZLCD_get_orientation(void) {
   if (!ZLCD_initialized) {
     printf("Initialize the LCD before calling other ZLCD functions\n");
@@ -1540,6 +4516,7 @@ ZLCD_ORIENTATION ZLCD_get_orientation(void) {
   return current_orientation.orientation_type;
 }
 
+#if !ZLCD_FRAMELESS
 ZLCD_RETURN_STATUS ZLCD_draw_char_xy(char character, uint16_t base_x,
                                      uint16_t base_y, rgb565 colour,
                                      const ZLCD_font *f, bool update_now) {
@@ -1553,7 +4530,7 @@ ZLCD_RETURN_STATUS ZLCD_draw_char_xy(char character, uint16_t base_x,
   }
   ZLCD_draw_char_xy_internal(character, base_x, base_y, colour, false, 0x00, f);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1571,7 +4548,7 @@ ZLCD_RETURN_STATUS ZLCD_draw_char(char character, ZLCD_pixel_coordinate base,
   }
   ZLCD_draw_char_xy_internal(character, base.x, base.y, colour, false, 0x00, f);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1590,7 +4567,7 @@ ZLCD_RETURN_STATUS ZLCD_draw_char_on_background_xy(
   ZLCD_draw_char_xy_internal(character, base_x, base_y, colour, true,
                              background_colour, f);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1610,7 +4587,7 @@ ZLCD_draw_char_on_background(char character, ZLCD_pixel_coordinate base,
   ZLCD_draw_char_xy_internal(character, base.x, base.y, colour, true,
                              background_colour, f);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1621,7 +4598,7 @@ static void ZLCD_draw_char_xy_internal(char character, uint16_t base_x,
                                        rgb565 background_colour,
                                        const ZLCD_font *f) {
   // assume pointers are valid if we've reached this point
-  if (character < 32 || character > 127) {
+  if (!ZLCD_font_has_glyph(character)) {
     return;
   }
   // subtract 31 not 32 because of the reserved spot
@@ -1634,34 +4611,23 @@ static void ZLCD_draw_char_xy_internal(char character, uint16_t base_x,
   int ofs_x = dsc->ofs_x;
   int ofs_y = dsc->ofs_y;
 
-  uint16_t bit_index;
-  uint8_t byte_index, bit_offset;
-
   int glyph_x0 = base_x + ofs_x;
   int glyph_y0 = base_y - box_h - ofs_y;
 
+  // mark the whole cell once instead of every pixel that gets set
   if (draw_background) {
     int cell_w = dsc->adv_w >> 4;
     int cell_h = f->font_size;
 
     int8_t offset_y = dsc->ofs_y;
-    for (int y = base_y - offset_y; y > (base_y - cell_h); y--) {
-      for (int x = base_x; x < (base_x + cell_w); x++) {
-        ZLCD_set_pixel_xy_internal(x, y, background_colour);
-      }
-    }
+    ZLCD_fill_rect_xy_internal(base_x, base_y - cell_h + 1, base_x + cell_w - 1,
+                               base_y - offset_y, background_colour);
   }
 
-  for (int16_t row = 0; row < box_h; row++) {
-    for (int16_t column = 0; column < box_w; column++) {
-      bit_index = (row * box_w) + column;
-      byte_index = bit_index / 8;
-      bit_offset = 7 - (bit_index % 8);
-      if ((current_character_bitmap[byte_index] >> bit_offset) & 0x1) {
-        ZLCD_set_pixel_xy_internal(glyph_x0 + column, glyph_y0 + row, colour);
-      }
-    }
-  }
+  ZLCD_mark_dirty_rect_xy(glyph_x0, glyph_y0, glyph_x0 + box_w - 1,
+                          glyph_y0 + box_h - 1);
+  current_kernels->glyph(current_character_bitmap, glyph_x0, glyph_y0, box_w,
+                         box_h, colour);
 }
 
 static void ZLCD_print_string_xy_internal(const char *string, uint16_t base_x,
@@ -1676,7 +4642,7 @@ static void ZLCD_print_string_xy_internal(const char *string, uint16_t base_x,
   // all characters must be drawable
   for (size_t i = 0; i < strlen(string); i++) {
     char c = *(string + i);
-    if (c > 127 || c < 32) {
+    if (!ZLCD_font_has_glyph(c)) {
       // special case: newlines are ok
       if (c == '\n' || c == '\r') {
         continue;
@@ -1761,7 +4727,7 @@ static void ZLCD_print_wrapped_string_xy_internal(
   // all characters must be drawable
   for (size_t i = 0; i < strlen(string); i++) {
     char c = *(string + i);
-    if (c > 127 || c < 32) {
+    if (!ZLCD_font_has_glyph(c)) {
       // special case: newlines are ok
       if (c == '\n' || c == '\r') {
         continue;
@@ -1855,7 +4821,7 @@ ZLCD_RETURN_STATUS ZLCD_print_wrapped_string_xy(
   ZLCD_print_wrapped_string_xy_internal(string, base_x, base_y, left_margin,
                                         right_margin, colour, false, 0x0, f);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1875,7 +4841,7 @@ ZLCD_print_wrapped_string(const char *string, ZLCD_pixel_coordinate base,
   ZLCD_print_wrapped_string_xy_internal(string, base.x, base.y, left_margin,
                                         right_margin, colour, false, 0x0, f);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1896,7 +4862,7 @@ ZLCD_RETURN_STATUS ZLCD_print_wrapped_string_on_background(
                                         right_margin, colour, true,
                                         background_colour, f);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1917,7 +4883,7 @@ ZLCD_RETURN_STATUS ZLCD_print_wrapped_string_on_background_xy(
                                         right_margin, colour, true,
                                         background_colour, f);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1935,7 +4901,7 @@ ZLCD_RETURN_STATUS ZLCD_print_string_xy(const char *string, uint16_t base_x,
   }
   ZLCD_print_string_xy_internal(string, base_x, base_y, colour, false, 0x0, f);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1953,7 +4919,7 @@ ZLCD_RETURN_STATUS ZLCD_print_string(const char *string,
   }
   ZLCD_print_string_xy_internal(string, base.x, base.y, colour, false, 0x0, f);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1973,7 +4939,7 @@ ZLCD_print_string_on_background(const char *string, ZLCD_pixel_coordinate base,
   ZLCD_print_string_xy_internal(string, base.x, base.y, colour, true,
                                 background_colour, f);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -1995,7 +4961,7 @@ ZLCD_print_string_on_background_xy(const char *string, uint16_t base_x,
   ZLCD_print_string_xy_internal(string, base_x, base_y, colour, true,
                                 background_colour, f);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -2037,65 +5003,14 @@ ZLCD_RETURN_STATUS ZLCD_draw_image(ZLCD_pixel_coordinate image_origin,
   uint16_t end_y = (start_y + draw_h <= max_y) ? (start_y + draw_h) : max_y;
 
   const uint8_t *map = image->map;
-
-  switch (current_orientation.orientation_type) {
-  case ZLCD_PORTRAIT_ORIENTATION:
-    for (uint16_t y = 0; y < draw_h; y++) {
-      const uint8_t *src = &map[((offset_y + y) * width + offset_x) * 2];
-      uint8_t *dst = &GRAM_current[((start_y + y) * ZLCD_WIDTH + start_x) * 2];
-      for (uint16_t i = 0; i < draw_w; i++) {
-        dst[2 * i] = src[2 * i + 1];
-        dst[2 * i + 1] = src[2 * i];
-      }
-    }
-    break;
-
-  case ZLCD_LANDSCAPE_ORIENTATION:;
-    for (uint16_t y = start_y; y < end_y; y++) {
-      size_t LCD_index = (ZLCD_WIDTH - y - 1) * 2;
-      size_t image_index = ((offset_y + y) * width + offset_x) * 2;
-      for (uint16_t x = start_x; x < end_x; x++) {
-        GRAM_current[LCD_index] = map[image_index + 1]; // MSB
-        GRAM_current[LCD_index + 1] = map[image_index]; // LSB
-
-        LCD_index += ZLCD_WIDTH * 2;
-        image_index += 2;
-      }
-    }
-    break;
-  case ZLCD_INVERTED_PORTRAIT_ORIENTATION:
-    for (uint16_t y = start_y; y < end_y; y++) {
-      size_t LCD_index =
-          ((ZLCD_HEIGHT - y - 1) * ZLCD_WIDTH + (ZLCD_WIDTH - 1)) * 2;
-      size_t image_index = ((offset_y + y) * width + offset_x) * 2;
-      for (uint16_t x = start_x; x < end_x; x++) {
-        GRAM_current[LCD_index] = map[image_index + 1]; // MSB
-        GRAM_current[LCD_index + 1] = map[image_index]; // LSB
-        LCD_index -= 2;
-        image_index += 2;
-      }
-    }
-    break;
-  case ZLCD_INVERTED_LANDSCAPE_ORIENTATION:
-    for (uint16_t y = start_y; y < end_y; y++) {
-      size_t LCD_index = ((ZLCD_HEIGHT - 1) * ZLCD_WIDTH + y) * 2;
-      size_t image_index = ((offset_y + y) * width + offset_x) * 2;
-
-      for (uint16_t x = start_x; x < end_x; x++) {
-        GRAM_current[LCD_index] = map[image_index + 1]; // MSB
-        GRAM_current[LCD_index + 1] = map[image_index]; // LSB
-
-        LCD_index -= (ZLCD_WIDTH)*2;
-        image_index += 2;
-      }
-    }
-    break;
-  default:
-    printf("ERROR: invalid orientation type detected\n");
-    break;
-  }
+  // the clamped size, the blit must stay inside the marked area
+  draw_w = end_x - start_x;
+  draw_h = end_y - start_y;
+  ZLCD_mark_covered_rect_xy(start_x, start_y, end_x - 1, end_y - 1);
+  current_kernels->blit(map, width, offset_x, offset_y, start_x, start_y, draw_w,
+                        draw_h);
   if (update_now) {
-    return ZLCD_refresh_display();
+    return ZLCD_present();
   }
   return ZLCD_SUCCESS;
 }
@@ -2169,7 +5084,7 @@ static void ZLCD_print_aligned_string_internal(
       token = strtok(NULL, "\n");
     }
     if (update_now) {
-      ZLCD_refresh_display();
+      ZLCD_present();
     }
     break;
   default:
@@ -2240,6 +5155,8 @@ ZLCD_print_aligned_string_on_background(const char *string, uint16_t base_y,
   }
 }
 
+#endif
+
 ZLCD_image lvgl_image_to_ZLCD(const lv_image_dsc_t *lv_struct, uint16_t x_off,
                               uint16_t y_off) {
   if (lv_struct == NULL) {
@@ -2270,27 +5187,7 @@ ZLCD_font lvgl_font_to_ZLCD(const glyph_dsc_t *lv_struct,
   return font;
 }
 
-static size_t pixel_coordinate_to_internal_index_portrait(uint16_t x,
-                                                          uint16_t y) {
-  return ((size_t)y * ZLCD_WIDTH + x) * 2;
-}
-
-static size_t pixel_coordinate_to_internal_index_inverted_portrait(uint16_t x,
-                                                                   uint16_t y) {
-  size_t converted_x, converted_y;
-  converted_x = ZLCD_WIDTH - x - 1;
-  converted_y = ZLCD_HEIGHT - y - 1;
-  return (converted_y * ZLCD_WIDTH + converted_x) * 2;
-}
-
-static size_t pixel_coordinate_to_internal_index_landscape(uint16_t x,
-                                                           uint16_t y) {
-  size_t converted_x, converted_y;
-  converted_x = ZLCD_WIDTH - y - 1;
-  converted_y = x;
-  return (converted_y * ZLCD_WIDTH + converted_x) * 2;
-}
-
+#if !ZLCD_FRAMELESS
 ZLCD_RETURN_STATUS ZLCD_printf(const char *format, ...) {
   if (!ZLCD_initialized) {
     printf("Initialize the LCD before calling other ZLCD functions\n");
@@ -2314,7 +5211,7 @@ ZLCD_RETURN_STATUS ZLCD_printf(const char *format, ...) {
   // all characters must be drawable
   for (size_t i = 0; i < strlen(buffer); i++) {
     char c = *(buffer + i);
-    if (c > 127 || c < 32) {
+    if (!ZLCD_font_has_glyph(c)) {
       // special case: newlines are ok
       if (c == '\n' || c == '\r') {
         continue;
@@ -2400,15 +5297,7 @@ ZLCD_RETURN_STATUS ZLCD_printf(const char *format, ...) {
     printf_x = starting_x_value;
     printf_y = starting_y_value;
   }
-  return ZLCD_refresh_display();
-}
-
-static size_t
-pixel_coordinate_to_internal_index_inverted_landscape(uint16_t x, uint16_t y) {
-  size_t converted_x, converted_y;
-  converted_x = y;
-  converted_y = ZLCD_HEIGHT - x - 1;
-  return (converted_y * ZLCD_WIDTH + converted_x) * 2;
+  return ZLCD_present();
 }
 
 static uint16_t get_font_height(const char *string, const ZLCD_font *f,
@@ -2459,6 +5348,27 @@ ZLCD_RETURN_STATUS ZLCD_set_printf_mode(ZLCD_PRINTF_MODE mode) {
   return ZLCD_SUCCESS;
 }
 
+ZLCD_RETURN_STATUS ZLCD_set_refresh_mode(ZLCD_REFRESH_MODE mode) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_ERR_NOT_INITIALIZED;
+  }
+  if (mode != ZLCD_REFRESH_TRACKED && mode != ZLCD_REFRESH_VERIFY) {
+    printf("invalid refresh mode selected!\n");
+    return ZLCD_FAILURE;
+  }
+  current_refresh_mode = mode;
+  return ZLCD_SUCCESS;
+}
+
+ZLCD_REFRESH_MODE ZLCD_get_refresh_mode(void) {
+  if (!ZLCD_initialized) {
+    printf("Initialize the LCD before calling other ZLCD functions\n");
+    return ZLCD_REFRESH_MODE_UNKNOWN;
+  }
+  return current_refresh_mode;
+}
+
 ZLCD_PRINTF_MODE ZLCD_get_printf_mode(void) {
   if (!ZLCD_initialized) {
     printf("Initialize the LCD before calling other ZLCD functions\n");
@@ -2496,6 +5406,8 @@ ZLCD_RETURN_STATUS ZLCD_set_printf_cursor_xy(uint16_t cursor_x,
   return ZLCD_SUCCESS;
 }
 
+#endif
+
 ZLCD_image ZLCD_read_BMP(const uint8_t *BMP_data, size_t BMP_data_length,
                          uint8_t *map_destination_arr,
                          size_t map_destination_size) {
@@ -2670,6 +5582,7 @@ ZLCD_image ZLCD_read_BMP(const uint8_t *BMP_data, size_t BMP_data_length,
   return image_to_return;
 }
 
+#if !ZLCD_FRAMELESS
 void print_output(const char *fmt, ...) {
   if (!ZLCD_initialized) {
     printf("Initialize the LCD before calling other ZLCD functions\n");
@@ -2684,4 +5597,5 @@ void print_output(const char *fmt, ...) {
 
   printf("%s", buffer);      // Print to UART
   ZLCD_printf("%s", buffer); // Print to LCD
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
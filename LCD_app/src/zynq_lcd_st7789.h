@@ -19,6 +19,7 @@ A comprehensive library for drawing on the built in LCD of the Smart Zynq SP
 #include <xspips.h>      // LCD uses SPI communication
 
 #include "lvgl_compat.h" // LVGL compatibility layer
+#include "zynq_lcd_place.h" // OCM / L2 placement of the working set
 
 /*******************************************************************************************
 NOTE : "ZLCD" refers to the ST7789VW controlled ZJY-LBS147TC-IG01 on the
@@ -63,6 +64,57 @@ typedef enum {
   ZLCD_PRINTF_MODE_UNKNOWN = -1
 } ZLCD_PRINTF_MODE;
 
+// how ZLCD_refresh_display() finds out what changed
+typedef enum {
+  ZLCD_REFRESH_TRACKED, // only the spans marked by the drawing functions
+  ZLCD_REFRESH_VERIFY,  // also compares every row to the previous frame (every
+                        // tile digest with ZLCD_BUFFER_HASHED) and reports
+                        // changes that were not marked (debugging)
+  ZLCD_REFRESH_MODE_UNKNOWN = -1
+} ZLCD_REFRESH_MODE;
+
+// how pixel data is pushed into the SPI TX FIFO
+typedef enum {
+  ZLCD_TRANSMIT_POLLED, // CPU writes every byte (XSpiPs_PolledTransfer)
+  ZLCD_TRANSMIT_DMA,    // PL330 DMA copies pixel data into the TX FIFO
+  ZLCD_TRANSMIT_FIFO    // CPU writes the TX FIFO registers itself, no driver
+} ZLCD_TRANSMIT_MODE;
+
+// who turns the frame in RAM into the orientation the user picked
+typedef enum {
+  ZLCD_ROTATE_SOFTWARE, // frame is always portrait, drawing transforms every
+                        // pixel (strided writes in landscape)
+  ZLCD_ROTATE_MADCTL    // frame is kept in the user's orientation and the
+                        // ST7789 rotates it (MADCTL MV/MX/MY bits)
+} ZLCD_ROTATION_MODE;
+
+// how pixels are sent to the ST7789 (COLMOD), the frame is always RGB565
+typedef enum {
+  ZLCD_PIXEL_RGB565,         // 16 bits per pixel, sent as stored
+  ZLCD_PIXEL_RGB444,         // 12 bits per pixel, 2 pixels packed in 3 bytes
+  ZLCD_PIXEL_RGB444_DITHERED // RGB444 with ordered dithering
+} ZLCD_PIXEL_FORMAT;
+
+// how a refresh gets the frame it sends away from the drawing functions
+typedef enum {
+  ZLCD_BUFFER_COPY,   // the changed rows are copied into a second frame and
+                      // sent from there
+  ZLCD_BUFFER_DOUBLE, // the drawn frame is sent as it is and drawing goes on
+                      // in the other one, nothing is copied
+  ZLCD_BUFFER_TRIPLE, // like DOUBLE with a third frame, so an async refresh
+                      // can be queued behind the one in flight
+  ZLCD_BUFFER_HASHED  // a single frame, sent as it is, changes are found by
+                      // comparing tile digests (see zynq_lcd_hash.h)
+} ZLCD_BUFFER_MODE;
+
+// where refreshes learn about the frames the ST7789 scans out (its TE pin)
+typedef enum {
+  ZLCD_VSYNC_OFF,     // refreshes go out as soon as they are called
+  ZLCD_VSYNC_TE_GPIO, // TE is polled on AXI GPIO 0 channel 2
+  ZLCD_VSYNC_TE_EDGES // the application calls ZLCD_vsync_te_edge() on every
+                      // rising TE edge (e.g. from a GPIO interrupt)
+} ZLCD_VSYNC_MODE;
+
 /****************************************************
 Use LVGL format to import fonts easily
 Download fonts from a .ttf file using  https://www.dafont.com/
@@ -79,6 +131,13 @@ typedef struct {
   const glyph_dsc_t *glyph_descriptors;
 } ZLCD_font;
 
+// true for 32-127, the characters the fonts have glyphs for; plain char is
+// signed on the host and unsigned on the A9, so the byte value is checked
+static inline bool ZLCD_font_has_glyph(char c) {
+  unsigned char byte = (unsigned char)c;
+  return byte >= 32 && byte <= 127;
+}
+
 ZLCD_font lvgl_font_to_ZLCD(const glyph_dsc_t *lv_struct,
                             const uint8_t *glyph_bitmap, const char *name,
                             size_t font_size);
@@ -131,6 +190,41 @@ typedef uint16_t rgb565;
 #define ZLCD_WIDTH (uint16_t)172  // in pixels
 #define ZLCD_HEIGHT (uint16_t)320 // in pixels
 
+/*
+Layout of the frame the drawing functions write to. 0 keeps the MSB-first byte
+stream the ST7789 expects. 1 stores native (little endian) rgb565 words, so a
+pixel is a single store and fills can use wide stores, and the bytes are swapped
+once while the changed rows are copied out for sending. The bytes on the wire
+are the same either way.
+*/
+#ifndef ZLCD_NATIVE_ENDIAN_GRAM
+#define ZLCD_NATIVE_ENDIAN_GRAM 0
+#endif
+
+/*
+Frames compiled in for ZLCD_config.buffer_mode, 110.08 Kbytes each. 2 is
+enough for ZLCD_BUFFER_COPY and ZLCD_BUFFER_DOUBLE and also drops the second
+async refresh that ZLCD_BUFFER_TRIPLE queues, 1 only leaves ZLCD_BUFFER_HASHED.
+0 builds the driver without a frame (ZLCD_FRAMELESS): the drawing functions,
+refreshes, scrolling and the frame scope are left out and the LCD is only
+written through ZLCD_write_frame_rows(), by the band renderer
+(zynq_lcd_band.h) or the indexed canvas (zynq_lcd_indexed.h).
+*/
+#ifndef ZLCD_MAX_FRAME_BUFFERS
+#define ZLCD_MAX_FRAME_BUFFERS 3
+#endif
+#define ZLCD_FRAMELESS (ZLCD_MAX_FRAME_BUFFERS == 0)
+
+/*
+1 compiles in the packing buffers async_refresh needs to send RGB444
+(ZLCD_config.pixel_format), 80.6 Kbytes per refresh slot. Without them
+ZLCD_init_with_config() refuses async_refresh with the RGB444 formats and
+amp_queue sends their refreshes window by window.
+*/
+#ifndef ZLCD_ASYNC_RGB444
+#define ZLCD_ASYNC_RGB444 0
+#endif
+
 // marco for error checking ZLCD functions that return @ZLCD_RETURN_STATUS
 #define ZLCD_ERROR_CHECK(call)                                                 \
   do {                                                                         \
@@ -165,23 +259,284 @@ ZLCD_pixel_coordinate ZLCD_create_coordinate(uint16_t x, uint16_t y);
 rgb565 ZLCD_construct_rgb565(uint8_t red, uint8_t green, uint8_t blue);
 rgb565 ZLCD_RGB_to_rgb565(uint32_t rgb);
 
+// the LCD pins a transport drives besides the SPI bus
+typedef enum {
+  ZLCD_PIN_DC,   // low for commands, high for parameters and pixels
+  ZLCD_PIN_RESET // active low
+} ZLCD_PIN;
+
+/*
+Everything the driver sends to the LCD goes through a transport. begin() and
+end() frame a group of writes (chip select), DC may change between the writes
+of a frame and write() only returns once its bytes have left the bus. The built
+in transports (one per ZLCD_TRANSMIT_MODE) drive SPI0 and AXI GPIO 0, others
+can be passed in the ZLCD_config, e.g. to run on a host or capture the output.
+*/
+typedef struct {
+  ZLCD_RETURN_STATUS (*init)(void *context); // called by ZLCD_init()
+  void (*begin)(void *context);
+  void (*write)(void *context, const uint8_t *bytes, size_t num_bytes);
+  void (*end)(void *context);
+  void (*set_pin)(void *context, ZLCD_PIN pin, bool level);
+  void (*delay_ms)(void *context, uint32_t milliseconds);
+  void *context;
+} ZLCD_transport;
+
+/*
+Define as one ZLCD_TRANSMIT_MODE, e.g. -DZLCD_STATIC_TRANSPORT=ZLCD_TRANSMIT_FIFO,
+to build the driver for that built in transport only. It is then called
+directly instead of through the function pointers, transmit_mode has to match
+and ZLCD_config.transport has to be NULL.
+*/
+// #define ZLCD_STATIC_TRANSPORT ZLCD_TRANSMIT_FIFO
+
+// shared with the CPU1 display pump, see zynq_lcd_amp.h
+typedef struct ZLCD_amp_queue ZLCD_amp_queue;
+
+/*
+options that can only be chosen once, when the LCD is initialized
+create with ZLCD_create_config() so new options always get a sane default
+*/
+typedef struct {
+  ZLCD_ORIENTATION orientation;
+  rgb565 background_colour;
+  ZLCD_TRANSMIT_MODE transmit_mode;
+  // hook the SPI interrupt into the GIC for ZLCD_refresh_display_async()
+  bool async_refresh;
+  /*
+  ZLCD_ROTATE_MADCTL makes ZLCD_set_orientation() rearrange the frame in RAM
+  and reprogram the ST7789, so change orientation between frames, not per draw
+  */
+  ZLCD_ROTATION_MODE rotation_mode;
+  /*
+  the RGB444 formats send 25% fewer bytes per pixel at the cost of colour depth.
+  Refresh windows are widened to whole pixel pairs (even columns)
+  */
+  ZLCD_PIXEL_FORMAT pixel_format;
+  /*
+  NULL for the built in transport of transmit_mode, otherwise used instead of
+  it and must stay valid while the LCD is in use. async_refresh needs SPI0, so
+  it only works with the built in transports
+  */
+  const ZLCD_transport *transport;
+  /*
+  set (e.g. to ZLCD_AMP_QUEUE) to have CPU1 do all of the sending, see
+  zynq_lcd_amp.h. transmit_mode is then up to the pump and transport must be
+  NULL. Refreshes go to CPU1 in one piece, async ones without waiting
+  */
+  ZLCD_amp_queue *amp_queue;
+  /*
+  ZLCD_BUFFER_DOUBLE/TRIPLE only bring the rows the new frame is missing up to
+  date where they are not drawn over. They need ZLCD_NATIVE_ENDIAN_GRAM 0 and
+  enough ZLCD_MAX_FRAME_BUFFERS. ZLCD_BUFFER_HASHED also needs
+  ZLCD_NATIVE_ENDIAN_GRAM 0 and works without async_refresh only (drawing
+  would change the frame on its way out)
+  */
+  ZLCD_BUFFER_MODE buffer_mode;
+  /*
+  anything but ZLCD_VSYNC_OFF turns on the TE output (TEON) and starts every
+  refresh where its rows stay behind the panel scan, at most one per panel
+  frame. Refreshes wait for that on the calling CPU, so ZLCD_BUFFER_TRIPLE no
+  longer queues a second one. update_now writes are not synchronised
+  */
+  ZLCD_VSYNC_MODE vsync_mode;
+  // ZLCD_frame_end() presents at most this many frames per second, 0 for no
+  // pacing (see ZLCD_set_frame_rate())
+  uint16_t frame_rate;
+} ZLCD_config;
+
+/*
+called once an asynchronous refresh has left the SPI FIFO. Runs in interrupt
+context: keep it short and do not call ZLCD functions that send to the LCD
+(queueing the next ZLCD_refresh_display_async() is allowed). With amp_queue it
+runs on CPU0 from the first ZLCD call that sees CPU1 is done instead
+*/
+typedef void (*ZLCD_refresh_callback)(ZLCD_RETURN_STATUS status,
+                                      void *user_data);
+
+ZLCD_config ZLCD_create_config(ZLCD_ORIENTATION desired_orientation,
+                               rgb565 background_colour);
+
 ZLCD_RETURN_STATUS ZLCD_init(ZLCD_ORIENTATION desired_orientation,
                              rgb565 background_colour);
+ZLCD_RETURN_STATUS ZLCD_init_with_config(const ZLCD_config *config);
+// the built in transport of mode, to wrap (see zynq_lcd_transport.h), or NULL
+const ZLCD_transport *ZLCD_get_builtin_transport(ZLCD_TRANSMIT_MODE mode);
 ZLCD_ORIENTATION ZLCD_get_orientation(void);
+ZLCD_RETURN_STATUS ZLCD_set_orientation(ZLCD_ORIENTATION desired_orientation);
+#if !ZLCD_FRAMELESS
 ZLCD_RETURN_STATUS ZLCD_set_pixel(ZLCD_pixel_coordinate coordinate,
                                   rgb565 colour, bool update_now);
 ZLCD_RETURN_STATUS ZLCD_set_pixel_xy(uint16_t x, uint16_t y, rgb565 colour,
                                      bool update_now);
-ZLCD_RETURN_STATUS ZLCD_set_orientation(ZLCD_ORIENTATION desired_orientation);
 void ZLCD_set_background_colour(rgb565 background_colour);
 /*
 draws the background in RAM but does not send the pixel data to the LCD
 */
 ZLCD_RETURN_STATUS ZLCD_clear(void);
 ZLCD_RETURN_STATUS ZLCD_refresh_display(void);
+/*
+starts sending the changed rows and returns right away. The rows are copied
+(or the frame is swapped out, see ZLCD_BUFFER_MODE) before this returns, so
+drawing into the frame can continue while the transfer runs. callback may be
+NULL. Anything else that talks to the LCD waits for the transfer to finish
+first. With ZLCD_BUFFER_TRIPLE a second call does not wait for the first
+transfer either, it is started from its completion.
+*/
+ZLCD_RETURN_STATUS ZLCD_refresh_display_async(ZLCD_refresh_callback callback,
+                                              void *user_data);
+bool ZLCD_refresh_in_progress(void);
+/*
+ZLCD_VSYNC_TE_EDGES: call on every rising edge of TE (interrupt context is
+fine). Ignored in the other modes
+*/
+void ZLCD_vsync_te_edge(void);
+/*
+Frame scope: update_now requests of the drawing calls between
+ZLCD_frame_begin() and ZLCD_frame_end() (ZLCD_printf() included) are held back
+and presented with a single refresh by ZLCD_frame_end(), which first waits for
+the next present slot of the frame rate. Drawing without update_now is left
+for the next refresh as usual. Scopes nest, only the outermost end presents.
+*/
+ZLCD_RETURN_STATUS ZLCD_frame_begin(void);
+ZLCD_RETURN_STATUS ZLCD_frame_end(void);
+// presents per second for ZLCD_frame_end(), 0 to present right away
+ZLCD_RETURN_STATUS ZLCD_set_frame_rate(uint16_t frames_per_second);
+/*
+Hardware vertical scrolling (VSCRDEF/VSCSAD) along the 320 pixel axis, counted
+in rows of the portrait frame: top_fixed_rows and bottom_fixed_rows stay put
+and the rows in between form a ring. In landscape those rows are the x axis,
+so the content moves sideways. A new area starts at offset 0. Not available
+with ZLCD_ROTATE_MADCTL outside of portrait.
+*/
+ZLCD_RETURN_STATUS ZLCD_scroll_define(uint16_t top_fixed_rows,
+                                      uint16_t bottom_fixed_rows);
+/*
+shows row offset of the scroll area at its top. Everything in the area moves up
+by the change and the rows that wrap round to the bottom keep their pixels, so
+the next refresh only sends what is drawn over them (one VSCSAD instead of
+resending the area)
+*/
+ZLCD_RETURN_STATUS ZLCD_scroll_to(uint16_t offset);
+#endif
+
+/*
+Where the screen of the current orientation sits in the frame the LCD is
+written from: pixel (x, y) is frame pixel origin + x * x_step + y * y_step,
+counted row by row in rows of frame_width pixels. For drawing without the GRAM
+(zynq_lcd_band.h)
+*/
+typedef struct {
+  uint16_t width, height; // screen size in the current orientation
+  uint16_t frame_width, frame_height;
+  int32_t origin;
+  int32_t x_step, y_step;
+  // with ZLCD_ROTATE_MADCTL the same frame lands on the glass another way
+  ZLCD_ORIENTATION orientation;
+} ZLCD_frame_layout;
+
+ZLCD_RETURN_STATUS ZLCD_get_frame_layout(ZLCD_frame_layout *layout);
+/*
+sends num_rows whole frame rows from row y0 on straight to the LCD, frame_width
+wire order (MSB first) RGB565 pixels each, packed on the way for the RGB444
+formats. The GRAM is not read or written: the rows are only noted, and the next
+refresh, update_now drawing, scroll or MADCTL rotation marks them to be sent
+from the GRAM again. A ZLCD_FRAMELESS build has no GRAM and
+draws only through here. Not synchronised to the scan
+*/
+ZLCD_RETURN_STATUS ZLCD_write_frame_rows(uint16_t y0, uint16_t num_rows,
+                                         const uint8_t *pixels);
+
+// one window of a refresh, in frame pixels (no address offset), inclusive
+typedef struct {
+  uint16_t x0, x1;
+  uint16_t y0, y1;
+  bool continue_write; // sent with RAMWRC (0x3C), no new window needed
+} ZLCD_plan_entry;
+
+/*
+Driver statistics (ZLCD_get_stats()). Kept unless built with
+-DZLCD_STATS_ENABLED=0, which removes every counter update from the driver.
+*/
+#ifndef ZLCD_STATS_ENABLED
+#define ZLCD_STATS_ENABLED 1
+#endif
+/*
+refresh latency histogram: bucket 0 is below ZLCD_STATS_FIRST_BUCKET_US, every
+following bucket is twice as wide and the last one holds everything slower
+*/
+#define ZLCD_STATS_HISTOGRAM_BUCKETS 12U
+#define ZLCD_STATS_FIRST_BUCKET_US 64U
+
+// counts since init or ZLCD_reset_stats(), times in microseconds
+typedef struct {
+  uint32_t refresh_calls;       // synchronous and asynchronous
+  uint32_t refresh_early_exits; // nothing had changed, nothing was sent
+  uint64_t rows_sent;           // rows of the refresh windows
+  uint64_t pixels_sent;
+  uint64_t spi_bytes; // all bytes put on the bus, commands included
+  uint64_t command_bytes;
+  uint64_t dc_toggles;
+  // ZLCD_set_window(): CASET/RASET skipped because the window was unchanged
+  uint32_t window_column_hits, window_column_misses;
+  uint32_t window_row_hits, window_row_misses;
+  uint64_t compare_us;  // finding and trimming the changed rows
+  uint64_t transmit_us; // sending them, until the last byte left the FIFO
+  // ZLCD_TRANSMIT_DMA: interrupts its transfers took and the time spent in them
+  uint32_t transmit_interrupts;
+  uint64_t interrupt_us;
+  // ZLCD_config.vsync_mode: waiting for the scan, refreshes too long to stay
+  // clear of it (they start behind the scan and may show a frame early)
+  uint64_t vsync_wait_us;
+  uint32_t vsync_unfit;
+  // ZLCD_BUFFER_HASHED: tiles hashed by refreshes and those found unchanged
+  uint32_t tiles_hashed, tiles_unchanged;
+  // ZLCD_REFRESH_VERIFY: rows and tiles changed without being marked dirty
+  uint32_t verify_misses;
+  // ZLCD_frame_end(): frames, update_now requests they folded into one present
+  // each, frames longer than the frame rate allows and present slots missed
+  uint32_t frames;
+  uint32_t updates_coalesced;
+  uint32_t frame_overruns;
+  uint32_t frames_dropped;
+  // building the frame and presenting it, without the pacing wait
+  uint64_t frame_us;
+  uint64_t frame_max_us;
+  uint32_t latency_histogram[ZLCD_STATS_HISTOGRAM_BUCKETS];
+} ZLCD_stats;
+
+/*
+debugging aid: fills entries with the windows the next refresh would send,
+without sending anything. Returns how many windows that is (0 if nothing
+changed); only the first max_entries are written when it is more. Not free of
+side effects, it prepares the refresh the way the refresh itself would: waits
+for an async refresh in flight, copies rows that drawing left stale back into
+the working frame, trims the dirty spans to the pixels that differ from the LCD
+(ZLCD_BUFFER_HASHED: hashes the tiles they meet) and in ZLCD_REFRESH_VERIFY
+reports unmarked changes. The next refresh still sends exactly these windows,
+the statistics count the work twice.
+*/
+#if !ZLCD_FRAMELESS
+size_t ZLCD_plan_refresh(ZLCD_plan_entry *entries, size_t max_entries);
+ZLCD_RETURN_STATUS ZLCD_set_refresh_mode(ZLCD_REFRESH_MODE mode);
+ZLCD_REFRESH_MODE ZLCD_get_refresh_mode(void);
+// blocks until the asynchronous refresh is done and returns its result
+ZLCD_RETURN_STATUS ZLCD_wait_refresh(void);
+#endif
+/*
+copy out / clear the driver statistics. Both wait for an asynchronous refresh
+to finish first so the numbers add up. ZLCD_FAILURE if compiled out
+*/
+ZLCD_RETURN_STATUS ZLCD_get_stats(ZLCD_stats *stats);
+ZLCD_RETURN_STATUS ZLCD_reset_stats(void);
 ZLCD_RETURN_STATUS
 ZLCD_verify_coordinate_is_valid(ZLCD_pixel_coordinate coordinate);
 ZLCD_RETURN_STATUS ZLCD_verify_coordinate_is_valid_xy(uint16_t x, uint16_t y);
+ZLCD_RETURN_STATUS ZLCD_sleep(void);
+ZLCD_RETURN_STATUS ZLCD_sleep_wake(void);
+ZLCD_RETURN_STATUS ZLCD_display_on(void);
+ZLCD_RETURN_STATUS ZLCD_display_off(void);
+#if !ZLCD_FRAMELESS
 ZLCD_RETURN_STATUS ZLCD_draw_line(ZLCD_pixel_coordinate p1,
                                   ZLCD_pixel_coordinate p2, rgb565 colour,
                                   bool update_now);
@@ -200,6 +555,11 @@ ZLCD_RETURN_STATUS ZLCD_draw_unfilled_rectangle_xy(
     uint16_t origin_x, uint16_t origin_y, uint16_t width_px, uint16_t height_px,
     uint16_t border_thickness_px, rgb565 border_colour, bool update_now);
 
+/*
+with update_now the rectangle is streamed straight to the LCD (only the rows
+that change) instead of going through the refresh, then anything else drawn
+since the last refresh is sent
+*/
 ZLCD_RETURN_STATUS
 ZLCD_draw_filled_rectangle(ZLCD_pixel_coordinate origin, uint16_t width_px,
                            uint16_t height_px, uint16_t border_thickness_px,
@@ -320,14 +680,11 @@ ZLCD_RETURN_STATUS ZLCD_print_wrapped_string_on_background_xy(
     uint16_t right_margin, rgb565 colour, rgb565 background_colour,
     const ZLCD_font *f, bool update_now);
 
-ZLCD_RETURN_STATUS ZLCD_sleep(void);
 /*
-draws the background and clears the screen right away
+draws the background and clears the screen right away (an update_now filled
+rectangle over the whole screen)
 */
 ZLCD_RETURN_STATUS ZLCD_draw_background(void);
-ZLCD_RETURN_STATUS ZLCD_sleep_wake(void);
-ZLCD_RETURN_STATUS ZLCD_display_on(void);
-ZLCD_RETURN_STATUS ZLCD_display_off(void);
 ZLCD_RETURN_STATUS ZLCD_printf(const char *format, ...);
 ZLCD_RETURN_STATUS ZLCD_set_printf_mode(ZLCD_PRINTF_MODE mode);
 ZLCD_RETURN_STATUS ZLCD_set_printf_cursor(ZLCD_pixel_coordinate coord);
@@ -335,6 +692,7 @@ ZLCD_RETURN_STATUS ZLCD_set_printf_cursor_xy(uint16_t cursor_x, uint16_t cursor_
 ZLCD_PRINTF_MODE ZLCD_get_printf_mode(void);
 // print to both stdout and the LCD
 void print_output(const char *fmt, ...);
+#endif
 
 /*
 read a BMP file and return a ZLCD_image with the relevant data
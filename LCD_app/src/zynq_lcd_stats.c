@@ -0,0 +1,40 @@
+#include "zynq_lcd_stats.h"
+#include <xiltimer.h>
+
+#if ZLCD_STATS_ENABLED
+
+/*************************************************
+  statistics helpers for the ST7789VW driver
+**************************************************/
+
+uint64_t ZLCD_stats_ticks(void) {
+  XTime now;
+  XTime_GetTime(&now);
+  return (uint64_t)now;
+}
+
+uint64_t ZLCD_stats_ticks_to_us(uint64_t ticks) {
+  return ticks * 1000000ULL / (uint64_t)COUNTS_PER_SECOND;
+}
+
+size_t ZLCD_stats_latency_bucket(uint64_t microseconds) {
+  size_t bucket = 0;
+  uint64_t limit = ZLCD_STATS_FIRST_BUCKET_US;
+  while (microseconds >= limit && bucket < ZLCD_STATS_HISTOGRAM_BUCKETS - 1) {
+    bucket++;
+    limit <<= 1;
+  }
+  return bucket;
+}
+
+void ZLCD_stats_record_refresh(ZLCD_stats *stats, uint64_t compare_ticks,
+                               uint64_t transmit_ticks) {
+  uint64_t compare_us = ZLCD_stats_ticks_to_us(compare_ticks);
+  uint64_t transmit_us = ZLCD_stats_ticks_to_us(transmit_ticks);
+  stats->compare_us += compare_us;
+  stats->transmit_us += transmit_us;
+  stats->latency_histogram[ZLCD_stats_latency_bucket(compare_us +
+                                                     transmit_us)]++;
+}
+
+#endif // ZLCD_STATS_ENABLED
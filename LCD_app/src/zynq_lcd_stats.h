@@ -0,0 +1,37 @@
+#ifndef ZYNQ_LCD_STATS_H
+#define ZYNQ_LCD_STATS_H
+/****************************************************************************
+Helpers behind ZLCD_get_stats(). With ZLCD_STATS_ENABLED set to 0 the ZLCD_STATS
+macro drops every counter update, so the driver carries no statistics code.
+*****************************************************************************/
+
+#include "zynq_lcd_st7789.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#if ZLCD_STATS_ENABLED
+#define ZLCD_STATS(statement)                                                  \
+  do {                                                                         \
+    statement;                                                                 \
+  } while (0)
+#else
+#define ZLCD_STATS(statement)                                                  \
+  do {                                                                         \
+  } while (0)
+#endif
+
+// free running global timer (XTime_GetTime()), COUNTS_PER_SECOND ticks/s
+uint64_t ZLCD_stats_ticks(void);
+uint64_t ZLCD_stats_ticks_to_us(uint64_t ticks);
+
+// bucket of ZLCD_stats.latency_histogram that a refresh of microseconds is in
+size_t ZLCD_stats_latency_bucket(uint64_t microseconds);
+
+/*
+Adds one refresh to stats: compare_ticks finding and trimming the changed rows,
+transmit_ticks until the last byte left the FIFO (0 for an early exit).
+*/
+void ZLCD_stats_record_refresh(ZLCD_stats *stats, uint64_t compare_ticks,
+                               uint64_t transmit_ticks);
+
+#endif // ZYNQ_LCD_STATS_H
@@ -0,0 +1,77 @@
+#include "zynq_lcd_transport.h"
+#include <string.h>
+
+/*************************************************
+  capture transport for the ST7789VW driver
+**************************************************/
+
+static ZLCD_RETURN_STATUS ZLCD_capture_hook_init(void *context) {
+  ZLCD_capture *capture = context;
+  if (capture->inner == NULL) {
+    return ZLCD_SUCCESS;
+  }
+  return capture->inner->init(capture->inner->context);
+}
+
+static void ZLCD_capture_begin(void *context) {
+  ZLCD_capture *capture = context;
+  capture->stats.frames++;
+  if (capture->inner != NULL) {
+    capture->inner->begin(capture->inner->context);
+  }
+}
+
+static void ZLCD_capture_write(void *context, const uint8_t *bytes,
+                               size_t num_bytes) {
+  ZLCD_capture *capture = context;
+  if (capture->dc) {
+    capture->stats.data_bytes += num_bytes;
+  } else {
+    capture->stats.command_bytes += num_bytes;
+  }
+  if (capture->inner != NULL) {
+    capture->inner->write(capture->inner->context, bytes, num_bytes);
+  }
+}
+
+static void ZLCD_capture_end(void *context) {
+  ZLCD_capture *capture = context;
+  if (capture->inner != NULL) {
+    capture->inner->end(capture->inner->context);
+  }
+}
+
+static void ZLCD_capture_set_pin(void *context, ZLCD_PIN pin, bool level) {
+  ZLCD_capture *capture = context;
+  if (pin == ZLCD_PIN_DC && level != capture->dc) {
+    capture->dc = level;
+    capture->stats.dc_toggles++;
+  }
+  if (capture->inner != NULL) {
+    capture->inner->set_pin(capture->inner->context, pin, level);
+  }
+}
+
+static void ZLCD_capture_delay_ms(void *context, uint32_t milliseconds) {
+  ZLCD_capture *capture = context;
+  capture->stats.delay_ms += milliseconds;
+  if (capture->inner != NULL) {
+    capture->inner->delay_ms(capture->inner->context, milliseconds);
+  }
+}
+
+void ZLCD_capture_init(ZLCD_capture *capture, const ZLCD_transport *inner) {
+  memset(capture, 0, sizeof(*capture));
+  capture->inner = inner;
+  capture->transport = (ZLCD_transport){.init = ZLCD_capture_hook_init,
+                                        .begin = ZLCD_capture_begin,
+                                        .write = ZLCD_capture_write,
+                                        .end = ZLCD_capture_end,
+                                        .set_pin = ZLCD_capture_set_pin,
+                                        .delay_ms = ZLCD_capture_delay_ms,
+                                        .context = capture};
+}
+
+void ZLCD_capture_reset_stats(ZLCD_capture *capture) {
+  memset(&capture->stats, 0, sizeof(capture->stats));
+}
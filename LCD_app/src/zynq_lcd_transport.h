@@ -0,0 +1,38 @@
+#ifndef ZYNQ_LCD_TRANSPORT_H
+#define ZYNQ_LCD_TRANSPORT_H
+/****************************************************************************
+Transports for the ZLCD driver besides the built in ones (see ZLCD_transport in
+zynq_lcd_st7789.h). The capture transport counts what the driver sends, for
+example the bytes of one frame, and passes it on to another transport.
+*****************************************************************************/
+
+#include "zynq_lcd_st7789.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  uint64_t frames;        // chip select frames (begin() calls)
+  uint64_t command_bytes; // written with DC low
+  uint64_t data_bytes;    // written with DC high (parameters and pixels)
+  uint64_t dc_toggles;    // changes of the DC pin
+  uint64_t delay_ms;      // total time the driver asked to wait
+} ZLCD_capture_stats;
+
+typedef struct {
+  const ZLCD_transport *inner; // NULL: count only, nothing is sent
+  bool dc;
+  ZLCD_capture_stats stats;
+  ZLCD_transport transport; // pass this one in ZLCD_config.transport
+} ZLCD_capture;
+
+/*
+Sets up capture->transport to count and forward to inner, e.g.
+ZLCD_get_builtin_transport(ZLCD_TRANSMIT_POLLED). capture has to stay valid
+while the LCD is in use.
+*/
+void ZLCD_capture_init(ZLCD_capture *capture, const ZLCD_transport *inner);
+
+void ZLCD_capture_reset_stats(ZLCD_capture *capture);
+
+#endif // ZYNQ_LCD_TRANSPORT_H
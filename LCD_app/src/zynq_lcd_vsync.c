@@ -0,0 +1,80 @@
+#include "zynq_lcd_vsync.h"
+
+/*************************************************
+  TE scheduling for the ST7789VW driver
+**************************************************/
+
+void ZLCD_vsync_schedule_init(ZLCD_vsync_schedule *schedule,
+                              const ZLCD_vsync_timing *timing) {
+  schedule->timing = *timing;
+  schedule->elapsed = (ZLCD_vsync_ticks){0, 0};
+  schedule->earliest = INT64_MIN;
+  schedule->latest = INT64_MAX;
+}
+
+/*
+Row i is written from w to w + row_ticks after the start. It has to start once
+the scan is past its last line (assuming it got there as fast as it could) and
+be done before the next scan reaches its first line (as slow as it could be),
+both bounds on the start are linear in i, so the first and the last row of the
+run are the only ones that can be the tightest
+*/
+static void ZLCD_vsync_schedule_row(ZLCD_vsync_schedule *schedule,
+                                    int32_t first_line, uint16_t span,
+                                    int64_t written_fastest,
+                                    int64_t done_slowest) {
+  const ZLCD_vsync_timing *timing = &schedule->timing;
+  int64_t first_scan =
+      timing->blank_ticks + (int64_t)first_line * timing->line_ticks;
+  int64_t last_scan_done = first_scan + (int64_t)span * timing->line_ticks;
+  int64_t earliest = last_scan_done + timing->guard_ticks - written_fastest;
+  int64_t latest = first_scan + ZLCD_vsync_frame_ticks(timing) -
+                   timing->guard_ticks - done_slowest;
+  if (earliest > schedule->earliest) {
+    schedule->earliest = earliest;
+  }
+  if (latest < schedule->latest) {
+    schedule->latest = latest;
+  }
+}
+
+void ZLCD_vsync_schedule_rows(ZLCD_vsync_schedule *schedule,
+                              uint16_t first_line, int8_t line_step,
+                              uint16_t span, uint16_t count,
+                              ZLCD_vsync_ticks setup_ticks,
+                              ZLCD_vsync_ticks row_ticks) {
+  ZLCD_vsync_ticks *elapsed = &schedule->elapsed;
+  elapsed->fastest += setup_ticks.fastest;
+  elapsed->slowest += setup_ticks.slowest;
+  if (count == 0) {
+    return;
+  }
+  ZLCD_vsync_schedule_row(schedule, first_line, span, elapsed->fastest,
+                          (int64_t)elapsed->slowest + row_ticks.slowest);
+  if (count > 1) {
+    uint16_t last = count - 1U;
+    ZLCD_vsync_schedule_row(
+        schedule, (int32_t)first_line + (int32_t)line_step * last, span,
+        elapsed->fastest + (int64_t)last * row_ticks.fastest,
+        elapsed->slowest + (int64_t)count * row_ticks.slowest);
+  }
+  elapsed->fastest += (uint32_t)count * row_ticks.fastest;
+  elapsed->slowest += (uint32_t)count * row_ticks.slowest;
+}
+
+uint32_t ZLCD_vsync_pick_start(const ZLCD_vsync_schedule *schedule,
+                               int64_t now, uint32_t min_edge, int64_t *start) {
+  int64_t frame = ZLCD_vsync_frame_ticks(&schedule->timing);
+  int64_t earliest = schedule->earliest;
+  int64_t latest =
+      schedule->latest > earliest ? schedule->latest : earliest;
+  // the first edge whose window still reaches now
+  uint32_t edge = now > latest ? (uint32_t)((now - latest + frame - 1) / frame)
+                               : 0U;
+  if (edge < min_edge) {
+    edge = min_edge;
+  }
+  int64_t first = (int64_t)edge * frame + earliest;
+  *start = first > now ? first : now;
+  return edge;
+}
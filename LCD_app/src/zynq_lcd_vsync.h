@@ -0,0 +1,87 @@
+#ifndef ZYNQ_LCD_VSYNC_H
+#define ZYNQ_LCD_VSYNC_H
+/****************************************************************************
+Tearing free refresh scheduling for the ZLCD driver. With TEON the ST7789 raises
+TE at the start of every vertical blank, waits out the porches and then scans
+its lines top to bottom. A refresh does not tear if every row it writes lands
+between the same two scans of its line: after the scan has passed the line in
+the frame that starts at a TE edge and before it comes round in the next one.
+Given how long the rows of a refresh take on the bus, the schedule below is the
+window of start times (after a TE edge) for which that holds. Nothing here
+touches hardware and times are ticks of any clock, the driver uses XTime.
+*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// bit of AXI GPIO 0 channel 2 the TE pin is wired to (ZLCD_VSYNC_TE_GPIO)
+#ifndef ZLCD_TE_GPIO_BIT
+#define ZLCD_TE_GPIO_BIT 0
+#endif
+// lines kept clear of the scan on both sides, covers the timing estimates
+#ifndef ZLCD_VSYNC_GUARD_LINES
+#define ZLCD_VSYNC_GUARD_LINES 4U
+#endif
+// no TE edge for this long and refreshes go out unsynchronised
+#ifndef ZLCD_VSYNC_TIMEOUT_MS
+#define ZLCD_VSYNC_TIMEOUT_MS 100U
+#endif
+
+typedef struct {
+  uint32_t line_ticks;  // scanning one line
+  uint32_t blank_ticks; // TE edge to the start of the first line (porches)
+  uint32_t guard_ticks; // margin kept on both sides of the scan
+  uint16_t lines;       // lines per frame
+} ZLCD_vsync_timing;
+
+// TE edge to TE edge
+static inline uint32_t ZLCD_vsync_frame_ticks(const ZLCD_vsync_timing *timing) {
+  return timing->blank_ticks + (uint32_t)timing->lines * timing->line_ticks;
+}
+
+// bounds on a bus time: rows never arrive sooner than fastest or later than
+// slowest, so the estimates only ever cost waiting, not a tear
+typedef struct {
+  uint32_t fastest, slowest;
+} ZLCD_vsync_ticks;
+
+typedef struct {
+  ZLCD_vsync_timing timing;
+  ZLCD_vsync_ticks elapsed; // bus time of everything added so far
+  // start times after a TE edge that keep every row added so far tear free
+  int64_t earliest, latest;
+} ZLCD_vsync_schedule;
+
+void ZLCD_vsync_schedule_init(ZLCD_vsync_schedule *schedule,
+                              const ZLCD_vsync_timing *timing);
+
+/*
+Adds count rows that go out one after the other after setup_ticks of commands,
+row_ticks each. Row i touches lines first_line + i * line_step up to span - 1
+lines below that: line_step is 1 for frame rows in scan order, -1 when the
+frame is mirrored (MADCTL MY) and 0 (with span = all lines) when every frame
+row runs across the scan lines (MADCTL MV).
+*/
+void ZLCD_vsync_schedule_rows(ZLCD_vsync_schedule *schedule,
+                              uint16_t first_line, int8_t line_step,
+                              uint16_t span, uint16_t count,
+                              ZLCD_vsync_ticks setup_ticks,
+                              ZLCD_vsync_ticks row_ticks);
+
+// whether the rows fit between two scans at all (longer refreshes tear)
+static inline bool ZLCD_vsync_schedule_fits(const ZLCD_vsync_schedule *s) {
+  return s->earliest <= s->latest;
+}
+
+/*
+Picks the start for a refresh, now ticks after TE edge 0 (now >= 0). Edge k
+comes k frames after edge 0 and the refresh is sent against the first edge
+from min_edge on whose window has not passed yet, as early in it as possible.
+A refresh that does not fit starts at the earliest time, so the write never
+overtakes the scan and only the end of it can show a frame early. Returns the
+edge and sets *start (ticks after edge 0, at least now).
+*/
+uint32_t ZLCD_vsync_pick_start(const ZLCD_vsync_schedule *schedule,
+                               int64_t now, uint32_t min_edge, int64_t *start);
+
+#endif // ZYNQ_LCD_VSYNC_H